@@ -7,6 +7,7 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <execinfo.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <getopt.h>
@@ -39,6 +40,15 @@
 /* Environment variable for time offset */
 #define ENV_TIME_OFFSET "UBOOT_SB_TIME_OFFSET"
 
+/* Program counter of the code interrupted by a signal */
+#if defined(__x86_64__)
+#define OS_CONTEXT_PC(context)	((context)->uc_mcontext.gregs[REG_RIP])
+#elif defined(__aarch64__)
+#define OS_CONTEXT_PC(context)	((context)->uc_mcontext.pc)
+#elif defined(__riscv)
+#define OS_CONTEXT_PC(context)	((context)->uc_mcontext.__gregs[REG_PC])
+#endif
+
 /* Operating System Interface */
 
 struct os_mem_hdr {
@@ -147,6 +157,67 @@ void os_raise_sigalrm(void)
 	raise(SIGALRM);
 }
 
+/* Function to call with each profiling sample */
+static void (*os_sample_func)(void *const *addrs, int count);
+
+static void os_sample_handler(int sig, siginfo_t *info, void *con)
+{
+	/* Allow for this handler and the signal trampoline */
+	void *addrs[40];
+	ucontext_t __maybe_unused *context = con;
+	void __maybe_unused *pc;
+	int count, i;
+
+	if (!os_sample_func)
+		return;
+	count = backtrace(addrs, 40);
+#ifdef OS_CONTEXT_PC
+	pc = (void *)OS_CONTEXT_PC(context);
+
+	/* Skip the frames for the signal handling */
+	for (i = 0; i < count && addrs[i] != pc; i++)
+		;
+	if (i == count) {
+		/* The stack could not be unwound, so just use the PC */
+		addrs[0] = pc;
+		i = 0;
+		count = 1;
+	}
+#else
+	i = count < 2 ? count : 2;
+#endif
+	os_sample_func(addrs + i, count - i);
+}
+
+int os_set_sample_handler(unsigned int interval_us,
+			  void (*handler)(void *const *addrs, int count))
+{
+	struct itimerval timer = {};
+	struct sigaction act;
+	void *addr;
+
+	if (handler) {
+		/*
+		 * backtrace() loads libgcc on first use, which is not safe in
+		 * a signal handler, so get that out of the way
+		 */
+		backtrace(&addr, 1);
+		act.sa_sigaction = os_sample_handler;
+		sigemptyset(&act.sa_mask);
+		act.sa_flags = SA_SIGINFO | SA_RESTART;
+		if (sigaction(SIGPROF, &act, NULL))
+			return -1;
+		timer.it_interval.tv_sec = interval_us / 1000000;
+		timer.it_interval.tv_usec = interval_us % 1000000;
+		timer.it_value = timer.it_interval;
+	}
+	if (setitimer(ITIMER_PROF, &timer, NULL))
+		return -1;
+	os_sample_func = handler;
+
+	return 0;
+}
+
 int os_write_file(const char *fname, const void *buf, int size)
 {
 	int fd;
@@ -289,12 +360,8 @@ static void os_signal_handler(int sig, siginfo_t *info, void *con)
 	ucontext_t __maybe_unused *context = con;
 	unsigned long pc;
 
-#if defined(__x86_64__)
-	pc = context->uc_mcontext.gregs[REG_RIP];
-#elif defined(__aarch64__)
-	pc = context->uc_mcontext.pc;
-#elif defined(__riscv)
-	pc = context->uc_mcontext.__gregs[REG_PC];
+#ifdef OS_CONTEXT_PC
+	pc = OS_CONTEXT_PC(context);
 #else
 	const char msg[] =
 		"\nUnsupported architecture, cannot read program counter\n";
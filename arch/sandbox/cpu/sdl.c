@@ -188,7 +188,7 @@ int sandbox_sdl_init_display(int width, int height, int log2_bpp,
 	return 0;
 }
 
-static int copy_to_texture(void *lcd_base)
+static int copy_to_texture(void *lcd_base, SDL_Rect *area)
 {
 	char *dest;
 	int pitch, x, y;
@@ -198,7 +198,9 @@ static int copy_to_texture(void *lcd_base)
 	int ret;
 
 	if (sdl.src_depth == sdl.depth) {
-		SDL_UpdateTexture(sdl.texture, NULL, lcd_base, sdl.pitch);
+		src = lcd_base + area->y * sdl.pitch +
+			area->x * sdl.depth / 8;
+		SDL_UpdateTexture(sdl.texture, area, src, sdl.pitch);
 		return 0;
 	}
 
@@ -211,7 +213,7 @@ static int copy_to_texture(void *lcd_base)
 		return -EINVAL;
 	}
 
-	ret = SDL_LockTexture(sdl.texture, NULL, &pixels, &pitch);
+	ret = SDL_LockTexture(sdl.texture, area, &pixels, &pitch);
 	if (ret) {
 		printf("SDL lock %d: %s\n", ret, SDL_GetError());
 		return ret;
@@ -219,12 +221,12 @@ static int copy_to_texture(void *lcd_base)
 
 	/* Copy the pixels one by one */
 	src_pitch = sdl.width * sdl.src_depth / 8;
-	for (y = 0; y < sdl.height; y++) {
+	for (y = 0; y < area->h; y++) {
 		char val;
 
 		dest = pixels + y * pitch;
-		src = lcd_base + src_pitch * y;
-		for (x = 0; x < sdl.width; x++, dest += 4) {
+		src = lcd_base + src_pitch * (area->y + y) + area->x;
+		for (x = 0; x < area->w; x++, dest += 4) {
 			val = *src++;
 			dest[0] = val;
 			dest[1] = val;
@@ -237,7 +239,8 @@ static int copy_to_texture(void *lcd_base)
 	return 0;
 }
 
-int sandbox_sdl_sync(void *lcd_base)
+int sandbox_sdl_sync(void *lcd_base, int xstart, int ystart, int xend,
+		     int yend)
 {
 	struct SDL_Rect rect;
 	int ret;
@@ -245,10 +248,19 @@ int sandbox_sdl_sync(void *lcd_base)
 	if (!sdl.texture)
 		return 0;
 	SDL_RenderClear(sdl.renderer);
-	ret = copy_to_texture(lcd_base);
-	if (ret) {
-		printf("copy_to_texture: %d: %s\n", ret, SDL_GetError());
-		return -EIO;
+
+	/* The texture keeps its contents, so only update what has changed */
+	if (xend > xstart && yend > ystart) {
+		rect.x = xstart;
+		rect.y = ystart;
+		rect.w = xend - xstart;
+		rect.h = yend - ystart;
+		ret = copy_to_texture(lcd_base, &rect);
+		if (ret) {
+			printf("copy_to_texture: %d: %s\n", ret,
+			       SDL_GetError());
+			return -EIO;
+		}
 	}
 	ret = SDL_RenderCopy(sdl.renderer, sdl.texture, NULL, NULL);
 	if (ret) {
@@ -36,12 +36,18 @@ int sandbox_sdl_remove_display(void);
  * sandbox_sdl_sync() - Sync current U-Boot LCD frame buffer to SDL
  *
  * This must be called periodically to update the screen for SDL so that the
- * user can see it.
+ * user can see it. Only the given area is copied from the frame buffer; the
+ * rest of the screen keeps what was there before.
  *
  * @lcd_base: Base of frame buffer
+ * @xstart: X position of the area to update in pixels from the left
+ * @ystart: Y position of the area to update in pixels from the top
+ * @xend: X position of the end of the area (exclusive)
+ * @yend: Y position of the end of the area (exclusive)
  * Return: 0 if screen was updated, -ENODEV is there is no screen.
  */
-int sandbox_sdl_sync(void *lcd_base);
+int sandbox_sdl_sync(void *lcd_base, int xstart, int ystart, int xend,
+		     int yend);
 
 /**
  * sandbox_sdl_scan_keys() - scan for pressed keys
@@ -99,7 +105,8 @@ static inline int sandbox_sdl_remove_display(void)
 	return -ENODEV;
 }
 
-static inline int sandbox_sdl_sync(void *lcd_base)
+static inline int sandbox_sdl_sync(void *lcd_base, int xstart, int ystart,
+				   int xend, int yend)
 {
 	return -ENODEV;
 }
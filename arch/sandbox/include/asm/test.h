@@ -382,4 +382,22 @@ bool sandbox_sf_bootdev_enabled(void);
  */
 void sandbox_sf_set_enable_bootdevs(bool enable);
 
+/**
+ * sandbox_mmc_get_cqe_stats() - Get command-queue statistics
+ *
+ * @dev: MMC device
+ * @tasksp: Returns the number of tasks run through the command queue engine
+ * @max_queuedp: Returns the largest number of tasks queued at once
+ */
+void sandbox_mmc_get_cqe_stats(struct udevice *dev, uint *tasksp,
+			       uint *max_queuedp);
+
+/**
+ * sandbox_mmc_set_cqe_present() - Select whether the host has a queue engine
+ *
+ * @dev: MMC device
+ * @present: true to report an engine (the default), false to report none
+ */
+void sandbox_mmc_set_cqe_present(struct udevice *dev, bool present);
+
 #endif
@@ -698,6 +698,15 @@ int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 		ret = bootdev_hunt_prio(BOOTDEVP_1_PRE_SCAN, show);
 		if (ret)
 			return log_msg_ret("pre", ret);
+
+		if (iter->flags & BOOTFLOWIF_HUNT_AHEAD) {
+			struct bootstd_priv *std;
+
+			ret = bootstd_get_priv(&std);
+			if (ret)
+				return log_msg_ret("std", ret);
+			std->hunters_ahead = 0;
+		}
 	}
 
 	/* Handle scanning a single device */
@@ -838,6 +847,42 @@ int bootdev_hunt_prio(enum bootdev_prio_t prio, bool show)
 	return result;
 }
 
+void bootdev_hunt_ahead(void)
+{
+	struct bootdev_hunter *start, *best = NULL;
+	struct bootstd_priv *std;
+	int n_ent, i, seq = 0;
+	uint skip;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_HUNT_AHEAD) || bootstd_get_priv(&std))
+		return;
+
+	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
+	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
+	skip = std->hunters_used | std->hunters_ahead;
+
+	for (i = 0; i < n_ent; i++) {
+		struct bootdev_hunter *info = start + i;
+
+		if (skip & BIT(i))
+			continue;
+		if (!best || info->prio < best->prio) {
+			best = info;
+			seq = i;
+		}
+	}
+	if (!best)
+		return;
+
+	/*
+	 * If this fails, the hunter is run again when the scan reaches its
+	 * priority, so the error is reported then
+	 */
+	std->hunters_ahead |= BIT(seq);
+	log_debug("Hunting ahead with: %s\n", uclass_get_name(best->uclass));
+	bootdev_hunt_drv(best, seq, false);
+}
+
 void bootdev_list_hunters(struct bootstd_priv *std)
 {
 	struct bootdev_hunter *orig, *start;
@@ -261,6 +261,9 @@ static int iter_incr(struct bootflow_iter *iter)
 				ret = bootdev_next_label(iter, &dev,
 							 &method_flags);
 			} else {
+				/* Use one more hunter each time we move on */
+				if (iter->flags & BOOTFLOWIF_HUNT_AHEAD)
+					bootdev_hunt_ahead();
 				ret = bootdev_next_prio(iter, &dev);
 				method_flags = 0;
 			}
@@ -427,9 +427,22 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
-	err = image_decomp(os.comp, load, os.image_start, os.type,
-			   load_buf, image_buf, image_len,
-			   CONFIG_SYS_BOOTM_LEN, &load_end);
+	if (CONFIG_IS_ENABLED(FIT_VERIFY_ON_LOAD) && images->fit_verify_os) {
+		err = fit_image_decomp(images->fit_hdr_os,
+				       images->fit_noffset_os, os.comp, load,
+				       os.image_start, os.type, load_buf,
+				       image_buf, image_len,
+				       CONFIG_SYS_BOOTM_LEN, &load_end);
+		if (err == -EACCES) {
+			bootstage_error(BOOTSTAGE_ID_FIT_KERNEL_START +
+					BOOTSTAGE_SUB_HASH);
+			return err;
+		}
+	} else {
+		err = image_decomp(os.comp, load, os.image_start, os.type,
+				   load_buf, image_buf, image_len,
+				   CONFIG_SYS_BOOTM_LEN, &load_end);
+	}
 	if (err) {
 		err = handle_decomp_error(os.comp, load_end - load,
 					  CONFIG_SYS_BOOTM_LEN, err);
@@ -805,6 +818,15 @@ int do_bootm_states(struct cmd_tbl *cmdtp, int flag, int argc,
 		return ret;
 	}
 
+	/* Pass on the log records which have not been shown */
+	if (!ret && (states & BOOTM_STATE_OS_GO) &&
+	    CONFIG_IS_ENABLED(LOG_RING_HANDOFF)) {
+		int err = log_ring_handoff();
+
+		if (err)
+			log_warning("Cannot pass log to OS (err=%d)\n", err);
+	}
+
 	/* Now run the OS! We hope this doesn't return */
 	if (!ret && (states & BOOTM_STATE_OS_GO))
 		ret = boot_selected_os(argc, argv, BOOTM_STATE_OS_GO,
@@ -10,6 +10,7 @@
 #include <blk.h>
 #include <bootflow.h>
 #include <bootmeth.h>
+#include <bootstage.h>
 #include <bootstd.h>
 #include <dm.h>
 #include <env_internal.h>
@@ -43,11 +44,16 @@ int bootmeth_check(struct udevice *dev, struct bootflow_iter *iter)
 int bootmeth_read_bootflow(struct udevice *dev, struct bootflow *bflow)
 {
 	const struct bootmeth_ops *ops = bootmeth_get_ops(dev);
+	int span, ret;
 
 	if (!ops->read_bootflow)
 		return -ENOSYS;
 
-	return ops->read_bootflow(dev, bflow);
+	span = bootstage_span_start(BOOTSTAGE_SPAN_BOOTMETH, dev->name);
+	ret = ops->read_bootflow(dev, bflow);
+	bootstage_span_end(span);
+
+	return ret;
 }
 
 int bootmeth_set_bootflow(struct udevice *dev, struct bootflow *bflow,
@@ -64,33 +70,49 @@ int bootmeth_set_bootflow(struct udevice *dev, struct bootflow *bflow,
 int bootmeth_boot(struct udevice *dev, struct bootflow *bflow)
 {
 	const struct bootmeth_ops *ops = bootmeth_get_ops(dev);
+	int span, ret;
 
 	if (!ops->boot)
 		return -ENOSYS;
 
-	return ops->boot(dev, bflow);
+	/* If this succeeds, the span is still open when the OS starts */
+	span = bootstage_span_start(BOOTSTAGE_SPAN_BOOTMETH, dev->name);
+	ret = ops->boot(dev, bflow);
+	bootstage_span_end(span);
+
+	return ret;
 }
 
 int bootmeth_read_file(struct udevice *dev, struct bootflow *bflow,
 		       const char *file_path, ulong addr, ulong *sizep)
 {
 	const struct bootmeth_ops *ops = bootmeth_get_ops(dev);
+	int span, ret;
 
 	if (!ops->read_file)
 		return -ENOSYS;
 
-	return ops->read_file(dev, bflow, file_path, addr, sizep);
+	span = bootstage_span_start(BOOTSTAGE_SPAN_BOOTMETH, dev->name);
+	ret = ops->read_file(dev, bflow, file_path, addr, sizep);
+	bootstage_span_end(span);
+
+	return ret;
 }
 
 int bootmeth_get_bootflow(struct udevice *dev, struct bootflow *bflow)
 {
 	const struct bootmeth_ops *ops = bootmeth_get_ops(dev);
+	int span, ret;
 
 	if (!ops->read_bootflow)
 		return -ENOSYS;
 	bootflow_init(bflow, NULL, dev);
 
-	return ops->read_bootflow(dev, bflow);
+	span = bootstage_span_start(BOOTSTAGE_SPAN_BOOTMETH, dev->name);
+	ret = ops->read_bootflow(dev, bflow);
+	bootstage_span_end(span);
+
+	return ret;
 }
 
 int bootmeth_setup_iter_order(struct bootflow_iter *iter, bool include_global)
@@ -26,6 +26,7 @@
 #include <malloc.h>
 #include <memalign.h>
 #include <asm/global_data.h>
+#include <cyclic.h>
 #ifdef CONFIG_DM_HASH
 #include <dm.h>
 #include <u-boot/hash.h>
@@ -1294,14 +1295,46 @@ int calculate_hash(const void *data, int data_len, const char *name,
 	return 0;
 }
 
+/**
+ * fit_image_compare_hash() - Compare a hash value with the one in a hash node
+ *
+ * @fit: FIT to check
+ * @noffset: Offset of the hash node
+ * @value: Calculated hash value
+ * @value_len: Length of @value in bytes
+ * @err_msgp: Returns an error message on failure
+ * Return: 0 if the values match, -1 if not
+ */
+static int fit_image_compare_hash(const void *fit, int noffset,
+				  const uint8_t *value, int value_len,
+				  char **err_msgp)
+{
+	uint8_t *fit_value;
+	int fit_value_len;
+
+	if (fit_image_hash_get_value(fit, noffset, &fit_value,
+				     &fit_value_len)) {
+		*err_msgp = "Can't get hash value property";
+		return -1;
+	}
+
+	if (value_len != fit_value_len) {
+		*err_msgp = "Bad hash value len";
+		return -1;
+	} else if (memcmp(value, fit_value, value_len) != 0) {
+		*err_msgp = "Bad hash value";
+		return -1;
+	}
+
+	return 0;
+}
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 				size_t size, char **err_msgp)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(uint8_t, value, FIT_MAX_HASH_LEN);
 	int value_len;
 	const char *algo;
-	uint8_t *fit_value;
-	int fit_value_len;
 	int ignore;
 
 	*err_msgp = NULL;
@@ -1320,31 +1353,18 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		}
 	}
 
-	if (fit_image_hash_get_value(fit, noffset, &fit_value,
-				     &fit_value_len)) {
-		*err_msgp = "Can't get hash value property";
-		return -1;
-	}
-
 	if (calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
 
-	if (value_len != fit_value_len) {
-		*err_msgp = "Bad hash value len";
-		return -1;
-	} else if (memcmp(value, fit_value, value_len) != 0) {
-		*err_msgp = "Bad hash value";
-		return -1;
-	}
-
-	return 0;
+	return fit_image_compare_hash(fit, noffset, value, value_len,
+				      err_msgp);
 }
 
-int fit_image_verify_with_data(const void *fit, int image_noffset,
-			       const void *key_blob, const void *data,
-			       size_t size)
+static int _fit_image_verify_with_data(const void *fit, int image_noffset,
+				       const void *key_blob, const void *data,
+				       size_t size)
 {
 	int		noffset = 0;
 	char		*err_msg = "";
@@ -1407,6 +1427,21 @@ error:
 	return 0;
 }
 
+int fit_image_verify_with_data(const void *fit, int image_noffset,
+			       const void *key_blob, const void *data,
+			       size_t size)
+{
+	int span, ret;
+
+	span = bootstage_span_start(BOOTSTAGE_SPAN_VERIFY,
+				    fit_get_name(fit, image_noffset, NULL));
+	ret = _fit_image_verify_with_data(fit, image_noffset, key_blob, data,
+					  size);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
@@ -2051,6 +2086,254 @@ static const char *fit_get_image_type_property(int type)
 	return "unknown";
 }
 
+/* Most images have one or two hashes */
+#define FIT_MAX_LOAD_HASHES	4
+
+/**
+ * struct fit_load_hash - Hashes of an image, calculated as it is loaded
+ *
+ * @fit: FIT containing the image
+ * @image_noffset: Offset of the image node
+ * @done: Number of bytes hashed so far
+ * @count: Number of hashes being calculated
+ * @noffset: Offset of the hash node for each hash
+ * @hs: Each hash being calculated
+ */
+struct fit_load_hash {
+	const void *fit;
+	int image_noffset;
+	ulong done;
+	int count;
+	int noffset[FIT_MAX_LOAD_HASHES];
+	struct hash_stream hs[FIT_MAX_LOAD_HASHES];
+};
+
+/**
+ * fit_has_required_keys() - Check for keys which must have signed the FIT
+ *
+ * Keys with required = "conf" sign the configuration, which covers the image
+ * hashes, so the hashes must be checked before the data is used, just as
+ * for keys with required = "image".
+ *
+ * @key_blob: FDT containing the public keys
+ * Return: true if any key is required, whatever it must sign
+ */
+static bool fit_has_required_keys(const void *key_blob)
+{
+	int key_node, noffset;
+
+	if (!key_blob)
+		return false;
+	key_node = fdt_subnode_offset(key_blob, 0, FIT_SIG_NODENAME);
+	if (key_node < 0)
+		return false;
+
+	fdt_for_each_subnode(noffset, key_blob, key_node) {
+		if (fdt_getprop(key_blob, noffset, FIT_KEY_REQUIRED, NULL))
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * fit_image_verify_on_load() - Check if hashes can be checked while loading
+ *
+ * This is not possible if something else needs all of the image data, i.e.
+ * a signature, or if a hash cannot be calculated progressively. It is also
+ * not allowed if any key is required, since then the data must not reach a
+ * decompressor before its hash is known to be good. Those images are
+ * verified before they are loaded, as before.
+ *
+ * @fit: FIT containing the image
+ * @image_noffset: Offset of the image node
+ * Return: true if the hashes can be checked while the image is loaded
+ */
+static bool fit_image_verify_on_load(const void *fit, int image_noffset)
+{
+	const char *name = fit_get_name(fit, image_noffset, NULL);
+	struct hash_algo *algo;
+	int count = 0;
+	int noffset;
+
+	if (tools_build() || !CONFIG_IS_ENABLED(FIT_VERIFY_ON_LOAD))
+		return false;
+
+	/* Leave fit_image_verify() to report this */
+	if (IS_ENABLED(CONFIG_FIT_SIGNATURE) && strchr(name, '@'))
+		return false;
+	if (FIT_IMAGE_ENABLE_VERIFY && fit_has_required_keys(gd_fdt_blob()))
+		return false;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *algo_name;
+		int ignore = 0;
+
+		name = fit_get_name(fit, noffset, NULL);
+		if (!strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+			return false;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (ignore)
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo_name) ||
+		    hash_progressive_lookup_algo(algo_name, &algo) ||
+		    ++count > FIT_MAX_LOAD_HASHES)
+			return false;
+	}
+
+	return noffset != -FDT_ERR_TRUNCATED &&
+		noffset != -FDT_ERR_BADSTRUCTURE;
+}
+
+static void fit_load_hash_abort(struct fit_load_hash *lh)
+{
+	while (lh->count)
+		hash_stream_finish(&lh->hs[--lh->count], NULL, NULL);
+}
+
+static int fit_load_hash_start(struct fit_load_hash *lh, const void *fit,
+			       int image_noffset)
+{
+	int noffset;
+
+	lh->fit = fit;
+	lh->image_noffset = image_noffset;
+	lh->done = 0;
+	lh->count = 0;
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+		const char *algo;
+		int ignore = 0;
+
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (ignore)
+			continue;
+		if (lh->count == FIT_MAX_LOAD_HASHES ||
+		    fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    hash_stream_init(&lh->hs[lh->count], algo)) {
+			fit_load_hash_abort(lh);
+			return -EPROTONOSUPPORT;
+		}
+		lh->noffset[lh->count++] = noffset;
+	}
+
+	return 0;
+}
+
+static int fit_load_hash_update(void *priv, const void *buf, ulong size,
+				bool last)
+{
+	struct fit_load_hash *lh = priv;
+	int ret;
+	int i;
+
+	for (i = 0; i < lh->count; i++) {
+		ret = hash_stream_update(&lh->hs[i], buf, size, last);
+		if (ret)
+			return ret;
+	}
+	lh->done += size;
+#ifndef USE_HOSTCC
+	schedule();
+#endif
+
+	return 0;
+}
+
+/**
+ * fit_load_hash_check() - Finish the hashes and check them against the FIT
+ *
+ * This prints the result in the same way as fit_image_verify()
+ *
+ * @lh: Hashes to check, which are finished on return
+ * Return: 0 if all match, -EACCES if not
+ */
+static int fit_load_hash_check(struct fit_load_hash *lh)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	char *err_msg = NULL;
+	int noffset = 0;
+	int i;
+
+	for (i = 0; i < lh->count; i++) {
+		int value_len = sizeof(value);
+		const char *algo;
+
+		if (err_msg) {
+			hash_stream_finish(&lh->hs[i], NULL, NULL);
+			continue;
+		}
+		noffset = lh->noffset[i];
+		fit_image_hash_get_algo(lh->fit, noffset, &algo);
+		printf("%s", algo);
+		if (hash_stream_finish(&lh->hs[i], value, &value_len))
+			err_msg = "Can't calculate hash value";
+		else if (!fit_image_compare_hash(lh->fit, noffset, value,
+						 value_len, &err_msg))
+			puts("+ ");
+	}
+	lh->count = 0;
+
+	if (err_msg) {
+		printf(" error!\n%s for '%s' hash node in '%s' image node\n",
+		       err_msg, fit_get_name(lh->fit, noffset, NULL),
+		       fit_get_name(lh->fit, lh->image_noffset, NULL));
+		return -EACCES;
+	}
+
+	return 0;
+}
+
+int fit_image_decomp(const void *fit, int noffset, int comp, ulong load,
+		     ulong image_start, int type, void *load_buf,
+		     void *image_buf, ulong image_len, uint unc_len,
+		     ulong *load_end)
+{
+	struct fit_load_hash lh;
+	int ret;
+
+	if (!fit_image_verify_on_load(fit, noffset) ||
+	    fit_load_hash_start(&lh, fit, noffset)) {
+		puts("   Verifying Hash Integrity ... ");
+		if (!fit_image_verify(fit, noffset)) {
+			puts("Bad Data Hash\n");
+			return -EACCES;
+		}
+		puts("OK\n");
+
+		return image_decomp(comp, load, image_start, type, load_buf,
+				    image_buf, image_len, unc_len, load_end);
+	}
+
+	ret = image_decomp_fn(comp, load, image_start, type, load_buf,
+			      image_buf, image_len, unc_len, load_end,
+			      fit_load_hash_update, &lh);
+
+	/*
+	 * Corrupt data often fails to decompress, so finish the hashes anyway
+	 * to report it as such
+	 */
+	if (ret && lh.done < image_len &&
+	    fit_load_hash_update(&lh, image_buf + lh.done,
+				 image_len - lh.done, true)) {
+		fit_load_hash_abort(&lh);
+		return ret;
+	}
+
+	puts("   Verifying Hash Integrity ... ");
+	if (fit_load_hash_check(&lh)) {
+		puts("Bad Data Hash\n");
+		return -EACCES;
+	}
+	puts("OK\n");
+
+	return ret;
+}
+
 int fit_image_load(struct bootm_headers *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int ph_type, int bootstage_id,
@@ -2069,6 +2352,7 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 	ulong load, load_end, data, len;
 	uint8_t os, comp;
 	const char *prop_name;
+	bool verify_on_load;
 	int ret;
 
 	fit = map_sysmem(addr, 0);
@@ -2142,7 +2426,16 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
 
-	ret = fit_image_select(fit, noffset, images->verify);
+	/*
+	 * If possible, check the hashes while the data is copied or
+	 * decompressed below, so that it is only read once
+	 */
+	verify_on_load = images->verify &&
+		fit_image_verify_on_load(fit, noffset);
+	if (image_type == IH_TYPE_KERNEL)
+		images->fit_verify_os = false;
+	ret = fit_image_select(fit, noffset,
+			       images->verify && !verify_on_load);
 	if (ret) {
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
 		return ret;
@@ -2274,13 +2567,36 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 		} else {
 			loadbuf = map_sysmem(load, max_decomp_len);
 		}
-		if (image_decomp(comp, load, data, image_type,
-				loadbuf, buf, len, max_decomp_len, &load_end)) {
+		if (verify_on_load)
+			ret = fit_image_decomp(fit, noffset, comp, load, data,
+					       image_type, loadbuf, buf, len,
+					       max_decomp_len, &load_end);
+		else
+			ret = image_decomp(comp, load, data, image_type,
+					   loadbuf, buf, len, max_decomp_len,
+					   &load_end);
+		if (ret == -EACCES) {
+			bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
+			return ret;
+		} else if (ret) {
 			printf("Error decompressing %s\n", prop_name);
 
 			return -ENOEXEC;
 		}
 		len = load_end - load;
+	} else if (verify_on_load && load_op == FIT_LOAD_IGNORED &&
+		   (image_type == IH_TYPE_KERNEL ||
+		    image_type == IH_TYPE_KERNEL_NOLOAD)) {
+		/* The caller loads this, so checks the hashes then */
+		images->fit_verify_os = true;
+	} else if (verify_on_load) {
+		loadbuf = map_sysmem(load, len);
+		if (fit_image_decomp(fit, noffset, IH_COMP_NONE, load, data,
+				     image_type, loadbuf, buf, len, len,
+				     &load_end)) {
+			bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
+			return -EACCES;
+		}
 	} else if (load != data) {
 		loadbuf = map_sysmem(load, len);
 		memcpy(loadbuf, buf, len);
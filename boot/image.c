@@ -54,6 +54,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
 #include <abuf.h>
+#include <bootstage.h>
 #include <bzlib.h>
 #include <display_options.h>
 #include <gzip.h>
@@ -440,15 +441,183 @@ int image_decomp_type(const unsigned char *buf, ulong len)
 	return cmagic->comp_id;
 }
 
-int image_decomp(int comp, ulong load, ulong image_start, int type,
-		 void *load_buf, void *image_buf, ulong image_len,
-		 uint unc_len, ulong *load_end)
+/**
+ * image_pass_input() - Pass image data to a function, a chunk at a time
+ *
+ * @buf:	Image data
+ * @len:	Number of bytes in @buf
+ * @func:	Function to call
+ * @priv:	Private data for @func
+ * Return: 0 if OK, else the error returned by @func
+ */
+static int image_pass_input(const void *buf, ulong len,
+			    int (*func)(void *priv, const void *buf, ulong size,
+					bool last),
+			    void *priv)
+{
+	ulong pos, chunk;
+	int ret;
+
+	for (pos = 0; pos < len; pos += chunk) {
+		chunk = len - pos > CHUNKSZ ? CHUNKSZ : len - pos;
+		ret = func(priv, buf + pos, chunk, pos + chunk == len);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * image_copy_fn() - Copy image data, passing each chunk to a function first
+ *
+ * If the destination overlaps the end of the source, the copy must go
+ * backwards, so all the data is passed to @func before it starts.
+ *
+ * @to:		Destination
+ * @from:	Image data
+ * @len:	Number of bytes to copy
+ * @func:	Function to call
+ * @priv:	Private data for @func
+ * Return: 0 if OK, else the error returned by @func
+ */
+static int image_copy_fn(void *to, void *from, ulong len,
+			 int (*func)(void *priv, const void *buf, ulong size,
+				     bool last),
+			 void *priv)
+{
+	ulong pos, chunk;
+	int ret;
+
+	if (to > from && to < from + len) {
+		ret = image_pass_input(from, len, func, priv);
+		if (ret)
+			return ret;
+		memmove_wd(to, from, len, CHUNKSZ);
+		return 0;
+	}
+
+	for (pos = 0; pos < len; pos += chunk) {
+		chunk = len - pos > CHUNKSZ ? CHUNKSZ : len - pos;
+		ret = func(priv, from + pos, chunk, pos + chunk == len);
+		if (ret)
+			return ret;
+		memmove_wd(to + pos, from + pos, chunk, CHUNKSZ);
+	}
+
+	return 0;
+}
+
+/**
+ * image_lz4_fn() - Decompress LZ4 data, passing each chunk to a function first
+ *
+ * The input is passed to @func in chunks. Each field of the stream is then
+ * decompressed straight from @from as soon as @func has seen all of it, so a
+ * block larger than a chunk is not copied first.
+ *
+ * @to:		Destination
+ * @unc_len:	Size of destination
+ * @from:	Compressed data
+ * @lenp:	Length of compressed data, returns the uncompressed length
+ * @func:	Function to call
+ * @priv:	Private data for @func
+ * Return: 0 if OK, the error returned by @func, or an error as for ulz4fn()
+ */
+static int image_lz4_fn(void *to, ulong unc_len, void *from, ulong *lenp,
+			int (*func)(void *priv, const void *buf, ulong size,
+				    bool last),
+			void *priv)
+{
+	struct ulz4_stream strm;
+	ulong pos, chunk, done = 0;
+	size_t want = 0;
+	int ret = 0;
+
+	ulz4_stream_init(&strm, to, unc_len);
+	for (pos = 0; pos < *lenp; pos += chunk) {
+		chunk = *lenp - pos > CHUNKSZ ? CHUNKSZ : *lenp - pos;
+		ret = func(priv, from + pos, chunk, pos + chunk == *lenp);
+		if (ret)
+			goto out;
+
+		want = ulz4_stream_want(&strm);
+		while (want && done + want <= pos + chunk) {
+			ret = ulz4_stream_decompress(&strm, from + done, want);
+			if (ret < 0)
+				goto out;
+			done += want;
+			want = ulz4_stream_want(&strm);
+		}
+	}
+
+	/* Anything left over is a truncated field */
+	if (want && done < *lenp)
+		ret = ulz4_stream_decompress(&strm, from + done, *lenp - done);
+	if (ret > 0 || (!ret && !strm.frames))
+		ret = -EINVAL;	/* input overrun */
+out:
+	*lenp = ulz4_stream_end(&strm);
+
+	return ret;
+}
+
+static int _image_decomp_fn(int comp, ulong load, ulong image_start, int type,
+			    void *load_buf, void *image_buf, ulong image_len,
+			    uint unc_len, ulong *load_end,
+			    int (*func)(void *priv, const void *buf, ulong size,
+					bool last),
+			    void *priv)
 {
 	int ret = -ENOSYS;
 
 	*load_end = load;
 	print_decomp_msg(comp, type, load == image_start);
 
+	/*
+	 * Where the input can be consumed in pieces, each one is passed to
+	 * func() just before it is used, while it is still in the cache. The
+	 * other decompressors work on whole blocks or frames, so all of the
+	 * input is passed to func() first.
+	 */
+	if (func && !tools_build()) {
+		switch (comp) {
+		case IH_COMP_NONE:
+			if (load == image_start)
+				return image_pass_input(image_buf, image_len,
+							func, priv);
+			if (image_len > unc_len)
+				return -ENOSPC;
+			ret = image_copy_fn(load_buf, image_buf, image_len,
+					    func, priv);
+			if (ret)
+				return ret;
+			*load_end = load + image_len;
+			return 0;
+		case IH_COMP_GZIP:
+			if (!CONFIG_IS_ENABLED(GZIP))
+				break;
+			ret = gunzip_fn(load_buf, unc_len, image_buf,
+					&image_len, func, priv);
+			if (ret)
+				return ret;
+			*load_end = load + image_len;
+			return 0;
+		case IH_COMP_LZ4:
+			if (!CONFIG_IS_ENABLED(LZ4))
+				break;
+			ret = image_lz4_fn(load_buf, unc_len, image_buf,
+					   &image_len, func, priv);
+			if (ret)
+				return ret;
+			*load_end = load + image_len;
+			return 0;
+		}
+		ret = image_pass_input(image_buf, image_len, func, priv);
+		if (ret)
+			return ret;
+		ret = -ENOSYS;
+	}
+
 	/*
 	 * Load the image to the right place, decompressing if needed. After
 	 * this, image_len will be set to the number of uncompressed bytes
@@ -533,6 +702,34 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 	return 0;
 }
 
+int image_decomp_fn(int comp, ulong load, ulong image_start, int type,
+		    void *load_buf, void *image_buf, ulong image_len,
+		    uint unc_len, ulong *load_end,
+		    int (*func)(void *priv, const void *buf, ulong size,
+				bool last),
+		    void *priv)
+{
+	int span, ret;
+
+	span = bootstage_span_start(BOOTSTAGE_SPAN_DECOMP,
+				    genimg_get_comp_name(comp));
+	ret = _image_decomp_fn(comp, load, image_start, type, load_buf,
+			       image_buf, image_len, unc_len, load_end, func,
+			       priv);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
+int image_decomp(int comp, ulong load, ulong image_start, int type,
+		 void *load_buf, void *image_buf, ulong image_len,
+		 uint unc_len, ulong *load_end)
+{
+	return image_decomp_fn(comp, load, image_start, type, load_buf,
+			       image_buf, image_len, unc_len, load_end, NULL,
+			       NULL);
+}
+
 const table_entry_t *get_table_entry(const table_entry_t *table, int id)
 {
 	for (; table->id >= 0; ++table) {
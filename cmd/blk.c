@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Block-device statistics
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <dm.h>
+#include <part.h>
+#include <linux/math64.h>
+
+static void blk_show_hist(const u32 *hist)
+{
+	int i;
+
+	printf("    latency:");
+	for (i = 0; i < BLK_STATS_HIST_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		if (!i)
+			printf(" 0us:%u", hist[i]);
+		else if (i == BLK_STATS_HIST_BUCKETS - 1)
+			printf(" >=%uus:%u", 1U << (i - 1), hist[i]);
+		else
+			printf(" <%uus:%u", 1U << i, hist[i]);
+	}
+	printf("\n");
+}
+
+static void blk_show_stats(struct udevice *dev, const struct blk_stats *stats)
+{
+	enum blk_stats_op op;
+
+	printf("%s: cache hits %llu\n", dev->name, stats->cache_hits);
+	for (op = 0; op < BLK_STATS_OP_COUNT; op++) {
+		const struct blk_op_stats *ost = &stats->op[op];
+
+		if (!ost->ops)
+			continue;
+		printf("  %s: %llu ops, %llu blocks, %llu bytes, %llu us (max %llu us",
+		       blk_stats_op_name(op), ost->ops, ost->blocks, ost->bytes,
+		       ost->time_us, ost->max_us);
+		if (ost->time_us)
+			printf(", %llu KiB/s",
+			       div64_u64((ost->bytes * 1000000) >> 10,
+					 ost->time_us));
+		printf(")\n");
+		printf("    sequential %llu, random %llu, errors %llu\n",
+		       ost->seq, ost->random, ost->errors);
+		blk_show_hist(ost->lat_hist);
+	}
+}
+
+static int do_blk_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct blk_stats *stats;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	struct uclass *uc;
+	bool reset = false;
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		reset = true;
+	} else if (argc == 3) {
+		if (blk_get_device_by_str(argv[1], argv[2], &desc) < 0)
+			return CMD_RET_FAILURE;
+		stats = blk_get_stats(desc->bdev);
+		if (stats)
+			blk_show_stats(desc->bdev, stats);
+		return 0;
+	} else if (argc != 1) {
+		return CMD_RET_USAGE;
+	}
+
+	uclass_id_foreach_dev(UCLASS_BLK, dev, uc) {
+		stats = blk_get_stats(dev);
+		if (!stats)
+			continue;
+		if (reset)
+			blk_stats_reset(dev);
+		else if (blk_stats_used(stats))
+			blk_show_stats(dev, stats);
+	}
+
+	return 0;
+}
+
+static char blk_help_text[] =
+	"stats [<interface> <dev>] - show I/O statistics for block devices\n"
+	"blk stats reset - reset I/O statistics for all block devices";
+
+U_BOOT_CMD_WITH_SUBCMDS(blk, "Block devices", blk_help_text,
+	U_BOOT_SUBCMD_MKENT(stats, 3, 1, do_blk_stats));
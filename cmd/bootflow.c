@@ -96,7 +96,7 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 	struct udevice *dev = NULL;
 	struct bootflow bflow;
 	bool all = false, boot = false, errors = false, no_global = false;
-	bool list = false, no_hunter = false;
+	bool list = false, no_hunter = false, hunt_ahead = false;
 	int num_valid = 0;
 	const char *label = NULL;
 	bool has_args;
@@ -116,6 +116,7 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 			no_global = strchr(argv[1], 'G');
 			list = strchr(argv[1], 'l');
 			no_hunter = strchr(argv[1], 'H');
+			hunt_ahead = strchr(argv[1], 'p');
 			argc--;
 			argv++;
 		}
@@ -142,6 +143,8 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 		flags |= BOOTFLOWIF_SKIP_GLOBAL;
 	if (!no_hunter)
 		flags |= BOOTFLOWIF_HUNT;
+	if (hunt_ahead)
+		flags |= BOOTFLOWIF_HUNT_AHEAD;
 
 	/*
 	 * If we have a device, just scan for bootflows attached to that device
@@ -422,7 +425,7 @@ static int do_bootflow_menu(struct cmd_tbl *cmdtp, int flag, int argc,
 #ifdef CONFIG_SYS_LONGHELP
 static char bootflow_help_text[] =
 #ifdef CONFIG_CMD_BOOTFLOW_FULL
-	"scan [-abeGl] [bdev]  - scan for valid bootflows (-l list, -a all, -e errors, -b boot, -G no global)\n"
+	"scan [-abeGlp] [bdev]  - scan for valid bootflows (-l list, -a all, -e errors, -b boot, -G no global, -p hunt ahead)\n"
 	"bootflow list [-e]             - list scanned bootflows (-e errors)\n"
 	"bootflow select [<num>|<name>] - select a bootflow\n"
 	"bootflow info [-d]             - show info on current bootflow (-d dump bootflow)\n"
@@ -6,6 +6,8 @@
 #include <common.h>
 #include <bootstage.h>
 #include <command.h>
+#include <env.h>
+#include <mapmem.h>
 
 static int do_bootstage_report(struct cmd_tbl *cmdtp, int flag, int argc,
 			       char *const argv[])
@@ -59,10 +61,51 @@ static int do_bootstage_stash(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_bootstage_chrome(struct cmd_tbl *cmdtp, int flag, int argc,
+			       char *const argv[])
+{
+	ulong base, size;
+	char *buf;
+	int ret;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+	base = hextoul(argv[1], NULL);
+	size = hextoul(argv[2], NULL);
+
+	buf = map_sysmem(base, size);
+	ret = bootstage_chrome_trace(buf, size);
+	unmap_sysmem(buf);
+	if (ret < 0) {
+		printf("Not enough space for trace (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+	printf("Chrome trace written to %lx, size %x\n", base, ret);
+	env_set_hex("filesize", ret);
+
+	return 0;
+}
+
+static int do_bootstage_clear(struct cmd_tbl *cmdtp, int flag, int argc,
+			      char *const argv[])
+{
+	int ret;
+
+	ret = bootstage_span_clear();
+	if (ret) {
+		printf("Cannot clear spans (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
 static struct cmd_tbl cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
+	U_BOOT_CMD_MKENT(chrome, 3, 0, do_bootstage_chrome, "", ""),
+	U_BOOT_CMD_MKENT(clear, 1, 0, do_bootstage_clear, "", ""),
 };
 
 /*
@@ -92,5 +135,7 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
-	"unstash [<start> [<size>]]  - Unstash data from memory"
+	"unstash [<start> [<size>]]  - Unstash data from memory\n"
+	"chrome <start> <size>       - Write a Chrome trace to memory\n"
+	"clear                       - Clear the recorded spans"
 );
@@ -58,6 +58,24 @@ static int do_cyclic_demo(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static void cyclic_show_hist(const char *name, const u32 *hist)
+{
+	int i;
+
+	printf("    %s:", name);
+	for (i = 0; i < CYCLIC_HIST_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		if (!i)
+			printf(" 0us:%u", hist[i]);
+		else if (i == CYCLIC_HIST_BUCKETS - 1)
+			printf(" >=%uus:%u", 1U << (i - 1), hist[i]);
+		else
+			printf(" <%uus:%u", 1U << i, hist[i]);
+	}
+	printf("\n");
+}
+
 static int do_cyclic_list(struct cmd_tbl *cmdtp, int flag, int argc,
 			  char *const argv[])
 {
@@ -71,6 +89,12 @@ static int do_cyclic_list(struct cmd_tbl *cmdtp, int flag, int argc,
 		printf("function: %s, cpu-time: %lld us, frequency: %lld.%02d times/s\n",
 		       cyclic->name, cyclic->cpu_time_us,
 		       lldiv(freq, 100), do_div(freq, 100));
+		if (cyclic->run_cnt < 2)
+			continue;
+		cyclic_show_hist("latency", cyclic->latency_hist);
+		printf("    max latency: %lld us\n", cyclic->max_latency_us);
+		if (cyclic->run_cnt > 2)
+			cyclic_show_hist("jitter", cyclic->jitter_hist);
 	}
 
 	return 0;
@@ -78,7 +102,8 @@ static int do_cyclic_list(struct cmd_tbl *cmdtp, int flag, int argc,
 
 static char cyclic_help_text[] =
 	"cyclic demo <cycletime_ms> <delay_us> - register cyclic demo function\n"
-	"cyclic list - list cyclic functions\n";
+	"cyclic list - list cyclic functions, with histograms of how late\n"
+	"    each is called (latency) and how much that varies (jitter)\n";
 
 U_BOOT_CMD_WITH_SUBCMDS(cyclic, "Cyclic", cyclic_help_text,
 	U_BOOT_SUBCMD_MKENT(demo, 3, 1, do_cyclic_demo),
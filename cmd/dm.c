@@ -9,6 +9,7 @@
 #include <common.h>
 #include <command.h>
 #include <dm/root.h>
+#include <dm/timing.h>
 #include <dm/util.h>
 
 static int do_dm_dump_driver_compat(struct cmd_tbl *cmdtp, int flag, int argc,
@@ -56,6 +57,25 @@ static int do_dm_dump_static_driver_info(struct cmd_tbl *cmdtp, int flag,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_TIMING)
+static int do_dm_dump_timing(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	int count = 10;
+
+	if (argc > 1) {
+		if (!strcmp(argv[1], "reset")) {
+			dm_timing_reset();
+			return 0;
+		}
+		count = dectoul(argv[1], NULL);
+	}
+	dm_dump_timing(count);
+
+	return 0;
+}
+#endif /* DM_TIMING */
+
 static int do_dm_dump_tree(struct cmd_tbl *cmdtp, int flag, int argc,
 			   char *const argv[])
 {
@@ -84,6 +104,15 @@ static int do_dm_dump_uclass(struct cmd_tbl *cmdtp, int flag, int argc,
 #define DM_MEM
 #endif
 
+#if CONFIG_IS_ENABLED(DM_TIMING)
+#define DM_TIMING_HELP	"dm timing [<n>]  Show the n slowest probes (default 10) and totals\n" \
+			"dm timing reset  Reset timing for all devices\n"
+#define DM_TIMING	U_BOOT_SUBCMD_MKENT(timing, 2, 1, do_dm_dump_timing),
+#else
+#define DM_TIMING_HELP
+#define DM_TIMING
+#endif
+
 #if IS_ENABLED(CONFIG_SYS_LONGHELP)
 static char dm_help_text[] =
 	"compat        Dump list of drivers with compatibility strings\n"
@@ -91,6 +120,7 @@ static char dm_help_text[] =
 	"dm drivers       Dump list of drivers with uclass and instances\n"
 	DM_MEM_HELP
 	"dm static        Dump list of drivers with static platform data\n"
+	DM_TIMING_HELP
 	"dm tree [-s]     Dump tree of driver model devices (-s=sort)\n"
 	"dm uclass        Dump list of instances for each uclass"
 	;
@@ -102,5 +132,6 @@ U_BOOT_CMD_WITH_SUBCMDS(dm, "Driver model low level access", dm_help_text,
 	U_BOOT_SUBCMD_MKENT(drivers, 1, 1, do_dm_dump_drivers),
 	DM_MEM
 	U_BOOT_SUBCMD_MKENT(static, 1, 1, do_dm_dump_static_driver_info),
+	DM_TIMING
 	U_BOOT_SUBCMD_MKENT(tree, 2, 1, do_dm_dump_tree),
 	U_BOOT_SUBCMD_MKENT(uclass, 1, 1, do_dm_dump_uclass));
@@ -78,15 +78,43 @@ static int do_font_size(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_font_cache(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	struct vidconsole_cache_stats stats;
+	struct udevice *dev;
+	ulong total;
+	int ret;
+
+	if (uclass_first_device_err(UCLASS_VIDEO_CONSOLE, &dev))
+		return CMD_RET_FAILURE;
+	ret = vidconsole_get_cache_stats(dev, &stats);
+	if (ret) {
+		printf("Failed (error %d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	total = stats.hits + stats.misses;
+	printf("Glyphs:    %u\n", stats.count);
+	printf("Memory:    %lx / %lx bytes\n", stats.used, stats.budget);
+	printf("Hits:      %lu (%lu%%)\n", stats.hits,
+	       total ? stats.hits * 100 / total : 0);
+	printf("Misses:    %lu\n", stats.misses);
+	printf("Evictions: %lu\n", stats.evictions);
+
+	return 0;
+}
 
 #ifdef CONFIG_SYS_LONGHELP
 static char font_help_text[] =
 	"list       - list available fonts\n"
 	"font select <name> [<size>] - select font to use\n"
-	"font size <size> - select font size to";
+	"font size <size> - select font size to\n"
+	"font cache - show glyph-cache statistics";
 #endif
 
 U_BOOT_CMD_WITH_SUBCMDS(font, "Fonts", font_help_text,
 	U_BOOT_SUBCMD_MKENT(list, 1, 1, do_font_list),
 	U_BOOT_SUBCMD_MKENT(select, 3, 1, do_font_select),
-	U_BOOT_SUBCMD_MKENT(size, 2, 1, do_font_size));
+	U_BOOT_SUBCMD_MKENT(size, 2, 1, do_font_size),
+	U_BOOT_SUBCMD_MKENT(cache, 1, 1, do_font_cache));
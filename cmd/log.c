@@ -338,6 +338,47 @@ static int do_log_format(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_log_dump(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	struct log_ring_stats stats;
+	bool clear = false, show_stats = false;
+	struct getopt_state gs;
+	int opt;
+
+	getopt_init_state(&gs);
+	while ((opt = getopt(&gs, argc, argv, "cs")) > 0) {
+		switch (opt) {
+		case 'c':
+			clear = true;
+			break;
+		case 's':
+			show_stats = true;
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+	if (gs.index != argc)
+		return CMD_RET_USAGE;
+
+	if (!IS_ENABLED(CONFIG_LOG_RING) || log_ring_get_stats(&stats)) {
+		printf("No log ring\n");
+		return CMD_RET_FAILURE;
+	}
+	if (show_stats) {
+		printf("Records:     %lu\n", stats.count);
+		printf("Overwritten: %lu\n", stats.dropped);
+		printf("Memory:      %lx / %lx bytes\n", stats.used, stats.size);
+	} else {
+		log_ring_dump();
+	}
+	if (clear)
+		log_ring_clear();
+
+	return 0;
+}
+
 static int do_log_rec(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
@@ -400,6 +441,9 @@ static char log_help_text[] =
 	"\t-a - Remove ALL filters\n"
 	"\t-d <driver> - Specify the log driver to remove the filter from;\n"
 	"\t              defaults to console\n"
+	"log dump [OPTIONS] - show the records held by the 'ring' driver\n"
+	"\t-c - Remove the records afterwards\n"
+	"\t-s - Show statistics instead of the records\n"
 	"log format <fmt> - set log output format. <fmt> is a string where\n"
 	"\teach letter indicates something that should be displayed:\n"
 	"\tc=category, l=level, F=file, L=line number, f=function, m=msg\n"
@@ -417,6 +461,7 @@ U_BOOT_CMD_WITH_SUBCMDS(log, "log system", log_help_text,
 	U_BOOT_SUBCMD_MKENT(filter-add, CONFIG_SYS_MAXARGS, 1,
 			    do_log_filter_add),
 	U_BOOT_SUBCMD_MKENT(filter-remove, 4, 1, do_log_filter_remove),
+	U_BOOT_SUBCMD_MKENT(dump, 3, 1, do_log_dump),
 	U_BOOT_SUBCMD_MKENT(format, 2, 1, do_log_format),
 	U_BOOT_SUBCMD_MKENT(rec, 7, 1, do_log_rec),
 );
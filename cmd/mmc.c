@@ -63,6 +63,17 @@ static void print_mmcinfo(struct mmc *mmc)
 	print_size(((u64)mmc->erase_grp_size) << 9, "\n");
 #endif
 
+	if (mmc->cmdq_depth) {
+		printf("Command Queue: %d tasks", mmc->cmdq_depth);
+		if (!(mmc->host_caps & MMC_CAP_CQE))
+			printf(" (not supported by host)");
+#if CONFIG_IS_ENABLED(MMC_CQE)
+		else if (!mmc_cqe_present(mmc))
+			printf(" (host has no queue engine)");
+#endif
+		printf("\n");
+	}
+
 	if (!IS_SD(mmc) && mmc->version >= MMC_VERSION_4_41) {
 		bool has_enh = (mmc->part_support & ENHNCD_SUPPORT) != 0;
 		bool usr_enh = has_enh && (mmc->part_attr & EXT_CSD_ENH_USR);
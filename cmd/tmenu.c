@@ -266,6 +266,8 @@ next:
 	while (1) {
 		if (redraw) {
 			ui_draw(ui_items, n_items, &p);
+			video_damage(vdev, 0, 0, video_get_xsize(vdev),
+				     video_get_ysize(vdev));
 			video_sync(vdev, true);
 			redraw = 0;
 		}
@@ -550,6 +552,8 @@ next:
 	while (1) {
 		if (redraw) {
 			ui_draw(ui_items, n_items, &p);
+			video_damage(vdev, 0, 0, video_get_xsize(vdev),
+				     video_get_ysize(vdev));
 			video_sync(vdev, true);
 			redraw = 0;
 		}
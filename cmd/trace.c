@@ -76,6 +76,58 @@ static int create_call_list(int argc, char *const argv[])
 	return 0;
 }
 
+static int create_sample_list(int argc, char *const argv[])
+{
+	size_t buff_size, avail, buff_ptr, needed, used;
+	char *buff;
+	int err;
+
+	if (get_args(argc, argv, &buff, &buff_ptr, &buff_size))
+		return -1;
+
+	avail = buff_size - buff_ptr;
+	err = trace_list_samples(buff + buff_ptr, avail, &needed);
+	if (err)
+		printf("Error: truncated (%#zx bytes needed)\n", needed);
+	used = min(avail, (size_t)needed);
+	printf("Sample list dumped to %08lx, size %#zx\n",
+	       (ulong)map_to_sysmem(buff + buff_ptr), used);
+
+	env_set_hex("profbase", map_to_sysmem(buff));
+	env_set_hex("profsize", buff_size);
+	env_set_hex("profoffset", buff_ptr + used);
+
+	return 0;
+}
+
+static int do_trace_sample(int argc, char *const argv[])
+{
+	const char *cmd = argc < 3 ? NULL : argv[2];
+	uint interval_us;
+	int ret;
+
+	if (!cmd)
+		return CMD_RET_USAGE;
+	if (!strcmp(cmd, "start")) {
+		interval_us = argc > 3 ? dectoul(argv[3], NULL) : 1000;
+		ret = trace_sample_start(interval_us);
+		if (ret) {
+			printf("Cannot start sampling (err=%d)\n", ret);
+			return CMD_RET_FAILURE;
+		}
+	} else if (!strcmp(cmd, "stop")) {
+		trace_sample_stop();
+	} else if (!strcmp(cmd, "dump")) {
+		/* Skip 'sample' so that the address and size are found */
+		if (create_sample_list(argc - 1, argv + 1))
+			return CMD_RET_USAGE;
+	} else {
+		return CMD_RET_USAGE;
+	}
+
+	return 0;
+}
+
 int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
@@ -98,6 +150,8 @@ int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 			return cmd_usage(cmdtp);
 		break;
 	case 's':
+		if (IS_ENABLED(CONFIG_TRACE_SAMPLE) && !strncmp(cmd, "sa", 2))
+			return do_trace_sample(argc, argv);
 		trace_print_stats();
 		break;
 	default:
@@ -108,7 +162,7 @@ int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 }
 
 U_BOOT_CMD(
-	trace,	4,	1,	do_trace,
+	trace,	5,	1,	do_trace,
 	"trace utility commands",
 	"stats                        - display tracing statistics\n"
 	"trace pause                        - pause tracing\n"
@@ -116,4 +170,9 @@ U_BOOT_CMD(
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
 		"- dump function call trace into buffer"
+#ifdef CONFIG_TRACE_SAMPLE
+	"\ntrace sample start [<interval_us>] - start sampling the PC\n"
+	"trace sample stop                  - stop sampling\n"
+	"trace sample dump [<addr> <size>]  - dump samples into buffer"
+#endif
 );
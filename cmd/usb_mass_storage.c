@@ -10,22 +10,70 @@
 #include <blk.h>
 #include <command.h>
 #include <console.h>
+#include <display_options.h>
 #include <errno.h>
 #include <g_dnl.h>
 #include <malloc.h>
 #include <part.h>
+#include <time.h>
 #include <usb.h>
 #include <usb_mass_storage.h>
 #include <watchdog.h>
 #include <linux/delay.h>
+#include <linux/math64.h>
+
+/**
+ * struct ums_stats - Transfer statistics for one 'ums' session
+ *
+ * @read_bytes:	Bytes read from the storage devices
+ * @write_bytes: Bytes written to the storage devices
+ * @first:	Time of the first access in ms, 0 if none yet
+ * @last:	Time of the latest access in ms
+ */
+static struct ums_stats {
+	u64 read_bytes;
+	u64 write_bytes;
+	ulong first;
+	ulong last;
+} ums_stats;
+
+static void ums_account(u64 *bytes, lbaint_t blkcnt)
+{
+	*bytes += (u64)blkcnt * SECTOR_SIZE;
+	ums_stats.last = get_timer(0);
+	if (!ums_stats.first)
+		ums_stats.first = ums_stats.last ?: 1;
+}
+
+static void ums_show_stats(void)
+{
+	u64 total = ums_stats.read_bytes + ums_stats.write_bytes;
+	ulong ms = ums_stats.last - ums_stats.first;
+
+	if (!total)
+		return;
+	puts("UMS: read ");
+	print_size(ums_stats.read_bytes, ", wrote ");
+	print_size(ums_stats.write_bytes, "");
+	printf(" in %lu.%03lu s", ms / 1000, ms % 1000);
+	if (ms) {
+		puts(" (");
+		print_size(div_u64(total * 1000, ms), "/s)");
+	}
+	putc('\n');
+}
 
 static int ums_read_sector(struct ums *ums_dev,
 			   ulong start, lbaint_t blkcnt, void *buf)
 {
 	struct blk_desc *block_dev = &ums_dev->block_dev;
 	lbaint_t blkstart = start + ums_dev->start_sector;
+	ulong ret;
+
+	ret = blk_dread(block_dev, blkstart, blkcnt, buf);
+	ums_account(&ums_stats.read_bytes, ret);
 
-	return blk_dread(block_dev, blkstart, blkcnt, buf);
+	return ret;
 }
 
 static int ums_write_sector(struct ums *ums_dev,
@@ -33,8 +81,12 @@ static int ums_write_sector(struct ums *ums_dev,
 {
 	struct blk_desc *block_dev = &ums_dev->block_dev;
 	lbaint_t blkstart = start + ums_dev->start_sector;
+	ulong ret;
+
+	ret = blk_dwrite(block_dev, blkstart, blkcnt, buf);
+	ums_account(&ums_stats.write_bytes, ret);
 
-	return blk_dwrite(block_dev, blkstart, blkcnt, buf);
+	return ret;
 }
 
 static struct ums *ums;
@@ -161,6 +213,7 @@ static int do_usb_mass_storage(struct cmd_tbl *cmdtp, int flag,
 	rc = ums_init(devtype, devnum);
 	if (rc < 0)
 		return CMD_RET_FAILURE;
+	memset(&ums_stats, '\0', sizeof(ums_stats));
 
 	controller_index = (unsigned int)(simple_strtoul(
 				usb_controller,	NULL, 0));
@@ -245,6 +298,7 @@ static int do_usb_mass_storage(struct cmd_tbl *cmdtp, int flag,
 	}
 
 cleanup_register:
+	ums_show_stats();
 	g_dnl_unregister();
 cleanup_board:
 	usb_gadget_release(controller_index);
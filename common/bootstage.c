@@ -12,6 +12,7 @@
 #define LOG_CATEGORY	LOGC_BOOT
 
 #include <common.h>
+#include <blk.h>
 #include <bootstage.h>
 #include <hang.h>
 #include <log.h>
@@ -19,6 +20,7 @@
 #include <sort.h>
 #include <spl.h>
 #include <asm/global_data.h>
+#include <dm/timing.h>
 #include <linux/compiler.h>
 #include <linux/libfdt.h>
 
@@ -36,10 +38,33 @@ struct bootstage_record {
 	enum bootstage_id id;
 };
 
+/**
+ * struct bootstage_data - Bootstage records and spans
+ *
+ * @rec_count: Number of records in use
+ * @next_id: Next ID to allocate for BOOTSTAGE_ID_ALLOC
+ * @record: Records
+ * @span: Spans, allocated when the first span is started, since the
+ *	pre-relocation malloc() pool is normally too small for them
+ * @span_count: Number of spans in use
+ * @span_dropped: Number of spans not recorded because @span was full
+ * @cur_span: Index of the innermost open span, or -1 if none
+ * @in_span: true while starting a span, used to ignore spans started by
+ *	probing the timer
+ * @delay_us: Total time spent in udelay()
+ */
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	struct bootstage_span *span;
+	uint span_count;
+	uint span_dropped;
+	int cur_span;
+	bool in_span;
+	ulong delay_us;
+#endif
 };
 
 enum {
@@ -218,6 +243,244 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+/*
+ * Header for the spans, which follow the name strings in the stash, if there
+ * are any
+ */
+struct bootstage_span_hdr {
+	u32 magic;		/* BOOTSTAGE_SPAN_MAGIC */
+	u32 count;		/* Number of spans */
+};
+
+#define BOOTSTAGE_SPAN_MAGIC	0xb0075a45
+
+static const char *const span_type_name[BOOTSTAGE_SPAN_TYPE_COUNT] = {
+	[BOOTSTAGE_SPAN_OTHER]		= "other",
+	[BOOTSTAGE_SPAN_DM_PROBE]	= "dm",
+	[BOOTSTAGE_SPAN_BOOTMETH]	= "bootmeth",
+	[BOOTSTAGE_SPAN_FS_LOAD]	= "fs",
+	[BOOTSTAGE_SPAN_DECOMP]		= "decomp",
+	[BOOTSTAGE_SPAN_HASH]		= "hash",
+	[BOOTSTAGE_SPAN_VERIFY]		= "verify",
+};
+
+/**
+ * alloc_spans() - Allocate space for the spans
+ *
+ * This is not done before relocation, since the pre-relocation malloc() pool
+ * is normally too small
+ *
+ * @data: Bootstage data
+ * Return: 0 if OK, -EAGAIN if it is too early, -ENOMEM if out of memory
+ */
+static int alloc_spans(struct bootstage_data *data)
+{
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return -EAGAIN;
+	data->span = calloc(CONFIG_BOOTSTAGE_SPAN_COUNT, sizeof(*data->span));
+	if (!data->span)
+		return -ENOMEM;
+
+	return 0;
+}
+
+int bootstage_span_start(enum bootstage_span_type type, const char *name)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+	int idx;
+
+	/* Reading the timer may probe it, which would start another span */
+	if (!data || data->in_span)
+		return -EBUSY;
+	if (!data->span && alloc_spans(data))
+		return -EAGAIN;
+	if (data->span_count == CONFIG_BOOTSTAGE_SPAN_COUNT) {
+		data->span_dropped++;
+		return -ENOSPC;
+	}
+
+	data->in_span = true;
+	idx = data->span_count++;
+	span = &data->span[idx];
+	strlcpy(span->name, name, sizeof(span->name));
+	span->type = type;
+	span->parent = data->cur_span;
+	span->depth = span->parent >= 0 ? data->span[span->parent].depth + 1 :
+		0;
+	span->start_us = timer_get_boot_us();
+	data->cur_span = idx;
+	data->in_span = false;
+
+	return idx;
+}
+
+void bootstage_span_end(int idx)
+{
+	struct bootstage_data *data = gd->bootstage;
+	ulong now;
+	int i;
+
+	if (!data || idx < 0)
+		return;
+
+	/* Check that the span is still open */
+	for (i = data->cur_span; i >= 0 && i != idx; i = data->span[i].parent)
+		;
+	if (i < 0)
+		return;
+
+	/* End it along with any inner spans left open, e.g. on error paths */
+	now = timer_get_boot_us();
+	for (i = data->cur_span; i != idx; i = data->span[i].parent)
+		data->span[i].end_us = now;
+	data->span[idx].end_us = now;
+	data->cur_span = data->span[idx].parent;
+}
+
+const struct bootstage_span *bootstage_get_span(int idx)
+{
+	struct bootstage_data *data = gd->bootstage;
+
+	if (!data || idx < 0 || idx >= data->span_count)
+		return NULL;
+
+	return &data->span[idx];
+}
+
+int bootstage_span_clear(void)
+{
+	struct bootstage_data *data = gd->bootstage;
+
+	if (!data)
+		return -ENOENT;
+
+	/* The open spans would be lost and their indices reused */
+	if (data->cur_span >= 0)
+		return -EBUSY;
+	data->span_count = 0;
+	data->span_dropped = 0;
+
+	return 0;
+}
+
+void bootstage_add_delay(ulong us)
+{
+	struct bootstage_data *data = gd->bootstage;
+
+	if (!data)
+		return;
+	data->delay_us += us;
+	if (data->cur_span >= 0)
+		data->span[data->cur_span].delay_us += us;
+}
+
+/**
+ * span_duration() - Get the duration of a span
+ *
+ * @span: Span to check
+ * @now: Current time, used as the end of a span which is still open
+ * Return: duration in microseconds
+ */
+static uint32_t span_duration(const struct bootstage_span *span, ulong now)
+{
+	return (span->end_us ? span->end_us : now) - span->start_us;
+}
+
+/**
+ * span_subtree_end() - Find the end of a span's descendants
+ *
+ * @data: Bootstage data
+ * @idx: Span index
+ * Return: index of the first span after @idx which is not a descendant of it
+ */
+static uint span_subtree_end(const struct bootstage_data *data, uint idx)
+{
+	uint end;
+
+	for (end = idx + 1; end < data->span_count &&
+	     data->span[end].depth > data->span[idx].depth; end++)
+		;
+
+	return end;
+}
+
+/**
+ * span_total_delay() - Get the time spent in udelay() by a span
+ *
+ * @data: Bootstage data
+ * @idx: Span index
+ * Return: delay in microseconds, including the span's descendants
+ */
+static uint32_t span_total_delay(const struct bootstage_data *data, uint idx)
+{
+	uint end = span_subtree_end(data, idx);
+	uint32_t delay = 0;
+
+	for (; idx < end; idx++)
+		delay += data->span[idx].delay_us;
+
+	return delay;
+}
+
+static void print_span(const struct bootstage_data *data, uint idx, ulong now)
+{
+	const struct bootstage_span *span = &data->span[idx];
+
+	print_grouped_ull(span->start_us, BOOTSTAGE_DIGITS);
+	print_grouped_ull(span_duration(span, now), BOOTSTAGE_DIGITS);
+	print_grouped_ull(span_total_delay(data, idx), BOOTSTAGE_DIGITS);
+	printf("  %*s%s %s%s\n", span->depth * 2, "", span_type_name[span->type],
+	       span->name, span->end_us ? "" : " (open)");
+}
+
+/**
+ * report_spans() - Show the spans, the critical path and the time in delays
+ *
+ * The critical path starts at the longest top-level span and at each level
+ * follows the longest child. This shows the chain of nested activity which
+ * accounts for most of the boot time.
+ *
+ * @data: Bootstage data
+ */
+static void report_spans(struct bootstage_data *data)
+{
+	ulong now = timer_get_boot_us();
+	uint i, start, end, best;
+	int depth;
+
+	printf("\nSpans (%d", data->span_count);
+	if (data->span_dropped)
+		printf(", %d dropped", data->span_dropped);
+	printf("):\n%11s%11s%11s  %s\n", "Start", "Duration", "Delay", "Span");
+	for (i = 0; i < data->span_count; i++)
+		print_span(data, i, now);
+
+	puts("\nCritical path:\n");
+	for (start = 0, end = data->span_count, depth = 0; start < end;
+	     depth++) {
+		best = end;
+		for (i = start; i < end; i++) {
+			if (data->span[i].depth != depth)
+				continue;
+			if (best == end ||
+			    span_duration(&data->span[i], now) >
+			    span_duration(&data->span[best], now))
+				best = i;
+		}
+		if (best == end)
+			break;
+		print_span(data, best, now);
+		start = best + 1;
+		end = span_subtree_end(data, best);
+	}
+
+	printf("\nTime in delay: %lu us, busy: %lu us\n", data->delay_us,
+	       now - data->delay_us);
+}
+#endif /* BOOTSTAGE_SPANS */
+
 /**
  * Get a record name as a printable string
  *
@@ -315,6 +578,14 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 			return -EINVAL;
 	}
 
+	/* Add I/O statistics for each block device used */
+	if (blk_stats_add_fdt(blob, bootstage))
+		return -EINVAL;
+
+	/* Add the time spent in driver model for each uclass and driver */
+	if (dm_timing_add_fdt(blob, bootstage))
+		return -EINVAL;
+
 	return 0;
 }
 
@@ -357,6 +628,97 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	report_spans(data);
+#endif
+}
+
+/**
+ * Append formatted text to a memory buffer
+ *
+ * Like append_data(), the buffer pointer is incremented even if there is no
+ * space
+ *
+ * @param ptrp	Pointer to buffer, updated by this function
+ * @param end	Pointer to end of buffer
+ * @param fmt	printf() format string
+ */
+static void append_printf(char **ptrp, char *end, const char *fmt, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(*ptrp, *ptrp < end ? end - *ptrp : 0, fmt, args);
+	va_end(args);
+	*ptrp += len;
+}
+
+/**
+ * Append a JSON string to a memory buffer, escaping it as needed
+ *
+ * @param ptrp	Pointer to buffer, updated by this function
+ * @param end	Pointer to end of buffer
+ * @param str	String to append
+ */
+static void append_json_str(char **ptrp, char *end, const char *str)
+{
+	append_printf(ptrp, end, "\"");
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			append_printf(ptrp, end, "\\%c", *str);
+		else if ((uchar)*str < ' ')
+			append_printf(ptrp, end, "\\u%04x", *str);
+		else
+			append_printf(ptrp, end, "%c", *str);
+	}
+	append_printf(ptrp, end, "\"");
+}
+
+int bootstage_chrome_trace(char *buf, int size)
+{
+	const struct bootstage_data *data = gd->bootstage;
+	const struct bootstage_record *rec;
+	char *ptr = buf, *end = buf + size;
+	__maybe_unused ulong now = timer_get_boot_us();
+	const char *sep = "";
+	char name[20];
+	int i;
+
+	append_printf(&ptr, end, "{\"traceEvents\":[");
+	for (rec = data->record, i = 0; i < data->rec_count; i++, rec++) {
+		if (rec->start_us ||
+		    (rec->id != BOOTSTAGE_ID_AWAKE && !rec->time_us))
+			continue;
+		append_printf(&ptr, end, "%s\n{\"name\":", sep);
+		append_json_str(&ptr, end,
+				get_record_name(name, sizeof(name), rec));
+		append_printf(&ptr, end,
+			      ",\"cat\":\"mark\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lu,\"pid\":1,\"tid\":1}",
+			      rec->time_us);
+		sep = ",";
+	}
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	for (i = 0; i < data->span_count; i++) {
+		const struct bootstage_span *span = &data->span[i];
+
+		append_printf(&ptr, end, "%s\n{\"name\":", sep);
+		append_json_str(&ptr, end, span->name);
+		append_printf(&ptr, end,
+			      ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":1,\"tid\":1,\"args\":{\"delay_us\":%u}}",
+			      span_type_name[span->type], span->start_us,
+			      span_duration(span, now), span->delay_us);
+		sep = ",";
+	}
+#endif
+	append_printf(&ptr, end, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	/* Leave room for the terminator */
+	if (ptr >= end)
+		return -ENOSPC;
+
+	return ptr - buf;
 }
 
 /**
@@ -416,6 +778,19 @@ int bootstage_stash(void *base, int size)
 		append_data(&ptr, end, name, strlen(name) + 1);
 	}
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	/* Write the spans, if any */
+	if (data->span_count) {
+		struct bootstage_span_hdr shdr;
+
+		shdr.magic = BOOTSTAGE_SPAN_MAGIC;
+		shdr.count = data->span_count;
+		append_data(&ptr, end, &shdr, sizeof(shdr));
+		append_data(&ptr, end, data->span,
+			    data->span_count * sizeof(*data->span));
+	}
+#endif
+
 	/* Check for buffer overflow */
 	if (ptr > end) {
 		debug("%s: Not enough space for bootstage stash\n", __func__);
@@ -494,6 +869,32 @@ int bootstage_unstash(const void *base, int size)
 		ptr += strlen(ptr) + 1;
 	}
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	/* Read the spans, if any, placing them after our own */
+	if (ptr + sizeof(struct bootstage_span_hdr) <=
+	    (char *)base + hdr->size) {
+		struct bootstage_span_hdr shdr;
+		struct bootstage_span *span;
+		uint first;
+
+		memcpy(&shdr, ptr, sizeof(shdr));
+		ptr += sizeof(shdr);
+		first = data->span_count;
+		if (shdr.magic == BOOTSTAGE_SPAN_MAGIC &&
+		    (data->span || !alloc_spans(data)) &&
+		    first + shdr.count <= CONFIG_BOOTSTAGE_SPAN_COUNT) {
+			memcpy(data->span + first, ptr,
+			       shdr.count * sizeof(*span));
+			for (i = 0, span = data->span + first; i < shdr.count;
+			     i++, span++) {
+				if (span->parent >= 0)
+					span->parent += first;
+			}
+			data->span_count += shdr.count;
+		}
+	}
+#endif
+
 	/* Mark the records as read */
 	data->rec_count += hdr->count;
 	data->next_id = hdr->next_id;
@@ -527,6 +928,9 @@ int bootstage_init(bool first)
 		return -ENOMEM;
 	data = gd->bootstage;
 	memset(data, '\0', size);
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	data->cur_span = -1;
+#endif
 	if (first) {
 		data->next_id = BOOTSTAGE_ID_USER;
 		bootstage_add_record(BOOTSTAGE_ID_AWAKE, "reset", 0, 0);
@@ -12,7 +12,10 @@
 #include <log.h>
 #include <malloc.h>
 #include <time.h>
+#include <trace.h>
+#include <linux/bitops.h>
 #include <linux/errno.h>
+#include <linux/kernel.h>
 #include <linux/list.h>
 #include <asm/global_data.h>
 
@@ -26,6 +29,70 @@ struct hlist_head *cyclic_get_list(void)
 	return (struct hlist_head *)&gd->cyclic_list;
 }
 
+/**
+ * cyclic_insert() - Add a cyclic function to the list
+ *
+ * The list is kept sorted by next_call, so that the first entry is always the
+ * next one due. A function goes after any others due at the same time.
+ *
+ * @cyclic: Cyclic function to add
+ */
+static void cyclic_insert(struct cyclic_info *cyclic)
+{
+	struct hlist_head *head = cyclic_get_list();
+	struct cyclic_info *pos, *prev = NULL;
+
+	hlist_for_each_entry(pos, head, list) {
+		if (time_after64(pos->next_call, cyclic->next_call))
+			break;
+		prev = pos;
+	}
+	if (prev)
+		hlist_add_after(&prev->list, &cyclic->list);
+	else
+		hlist_add_head(&cyclic->list, head);
+}
+
+/**
+ * cyclic_hist_bucket() - Get the histogram bucket for a time
+ *
+ * @us: Time in us
+ * Return: bucket index, see CYCLIC_HIST_BUCKETS
+ */
+static uint cyclic_hist_bucket(uint64_t us)
+{
+	return min_t(uint, fls(min_t(uint64_t, us, U32_MAX)),
+		     CYCLIC_HIST_BUCKETS - 1);
+}
+
+/**
+ * cyclic_account_latency() - Record how late a cyclic function is called
+ *
+ * @cyclic: Cyclic function about to be called
+ * @now: Current time in us
+ */
+static void cyclic_account_latency(struct cyclic_info *cyclic, uint64_t now)
+{
+	uint64_t latency, jitter;
+
+	/* The first call has no deadline to be late for */
+	if (!cyclic->run_cnt)
+		return;
+
+	latency = now - cyclic->next_call;
+	cyclic->latency_hist[cyclic_hist_bucket(latency)]++;
+	if (latency > cyclic->max_latency_us)
+		cyclic->max_latency_us = latency;
+
+	if (cyclic->run_cnt > 1) {
+		jitter = latency > cyclic->last_latency_us ?
+			latency - cyclic->last_latency_us :
+			cyclic->last_latency_us - latency;
+		cyclic->jitter_hist[cyclic_hist_bucket(jitter)]++;
+	}
+	cyclic->last_latency_us = latency;
+}
+
 struct cyclic_info *cyclic_register(cyclic_func_t func, uint64_t delay_us,
 				    const char *name, void *ctx)
 {
@@ -43,7 +110,7 @@ struct cyclic_info *cyclic_register(cyclic_func_t func, uint64_t delay_us,
 	cyclic->name = strdup(name);
 	cyclic->delay_us = delay_us;
 	cyclic->start_time_us = timer_get_us();
-	hlist_add_head(&cyclic->list, cyclic_get_list());
+	cyclic_insert(cyclic);
 
 	return cyclic;
 }
@@ -58,42 +125,69 @@ int cyclic_unregister(struct cyclic_info *cyclic)
 
 void cyclic_run(void)
 {
+	struct hlist_head *head = cyclic_get_list();
 	struct cyclic_info *cyclic;
-	struct hlist_node *tmp;
+	struct hlist_node *tail = NULL;
 	uint64_t now, cpu_time;
+	HLIST_HEAD(due);
 
 	/* Prevent recursion */
 	if (gd->flags & GD_FLG_CYCLIC_RUNNING)
 		return;
 
+	/* The first function in the list is the next one due */
+	if (hlist_empty(head))
+		return;
+	now = timer_get_us();
+	cyclic = hlist_entry(head->first, struct cyclic_info, list);
+	if (time_before64(now, cyclic->next_call))
+		return;
+
 	gd->flags |= GD_FLG_CYCLIC_RUNNING;
-	hlist_for_each_entry_safe(cyclic, tmp, cyclic_get_list(), list) {
-		/*
-		 * Check if this cyclic function needs to get called, e.g.
-		 * do not call the cyclic func too often
-		 */
+
+	/*
+	 * Move the functions which are due onto a separate list, so that each
+	 * one is called at most once, even if its new next_call has passed
+	 * by the time it is put back
+	 */
+	while (!hlist_empty(head)) {
+		cyclic = hlist_entry(head->first, struct cyclic_info, list);
+		if (time_before64(now, cyclic->next_call))
+			break;
+		hlist_del(&cyclic->list);
+		if (tail)
+			hlist_add_after(tail, &cyclic->list);
+		else
+			hlist_add_head(&cyclic->list, &due);
+		tail = &cyclic->list;
+	}
+
+	while (!hlist_empty(&due)) {
+		cyclic = hlist_entry(due.first, struct cyclic_info, list);
+		hlist_del(&cyclic->list);
+
+		/* Call cyclic function and account it's cpu-time */
 		now = timer_get_us();
-		if (time_after_eq64(now, cyclic->next_call)) {
-			/* Call cyclic function and account it's cpu-time */
-			cyclic->next_call = now + cyclic->delay_us;
-			cyclic->func(cyclic->ctx);
-			cyclic->run_cnt++;
-			cpu_time = timer_get_us() - now;
-			cyclic->cpu_time_us += cpu_time;
-
-			/* Check if cpu-time exceeds max allowed time */
-			if ((cpu_time > CONFIG_CYCLIC_MAX_CPU_TIME_US) &&
-			    (!cyclic->already_warned)) {
-				pr_err("cyclic function %s took too long: %lldus vs %dus max\n",
-				       cyclic->name, cpu_time,
-				       CONFIG_CYCLIC_MAX_CPU_TIME_US);
-
-				/*
-				 * Don't disable this function, just warn once
-				 * about this exceeding CPU time usage
-				 */
-				cyclic->already_warned = true;
-			}
+		cyclic_account_latency(cyclic, now);
+		cyclic->next_call = now + cyclic->delay_us;
+		cyclic_insert(cyclic);
+		cyclic->func(cyclic->ctx);
+		cyclic->run_cnt++;
+		cpu_time = timer_get_us() - now;
+		cyclic->cpu_time_us += cpu_time;
+
+		/* Check if cpu-time exceeds max allowed time */
+		if ((cpu_time > CONFIG_CYCLIC_MAX_CPU_TIME_US) &&
+		    (!cyclic->already_warned)) {
+			pr_err("cyclic function %s took too long: %lldus vs %dus max\n",
+			       cyclic->name, cpu_time,
+			       CONFIG_CYCLIC_MAX_CPU_TIME_US);
+
+			/*
+			 * Don't disable this function, just warn once
+			 * about this exceeding CPU time usage
+			 */
+			cyclic->already_warned = true;
 		}
 	}
 	gd->flags &= ~GD_FLG_CYCLIC_RUNNING;
@@ -105,6 +199,10 @@ void schedule(void)
 	if (IS_ENABLED(CONFIG_HW_WATCHDOG))
 		hw_watchdog_reset();
 
+	/* Sandbox takes samples from a timer instead */
+	if (IS_ENABLED(CONFIG_TRACE_SAMPLE) && !IS_ENABLED(CONFIG_SANDBOX))
+		trace_sample_poll(__builtin_return_address(0));
+
 	/*
 	 * schedule() might get called very early before the cyclic IF is
 	 * ready. Make sure to only call cyclic_run() when it's initalized.
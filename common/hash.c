@@ -11,6 +11,7 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
+#include <bootstage.h>
 #include <command.h>
 #include <env.h>
 #include <log.h>
@@ -43,6 +44,33 @@ DECLARE_GLOBAL_DATA_PTR;
 
 static void reloc_update(void);
 
+static int __maybe_unused hash_init_md5(struct hash_algo *algo, void **ctxp)
+{
+	struct MD5Context *ctx = malloc(sizeof(struct MD5Context));
+	MD5Init(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int __maybe_unused hash_update_md5(struct hash_algo *algo, void *ctx,
+					  const void *buf, unsigned int size,
+					  int is_last)
+{
+	MD5Update((struct MD5Context *)ctx, buf, size);
+	return 0;
+}
+
+static int __maybe_unused hash_finish_md5(struct hash_algo *algo, void *ctx,
+					  void *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	MD5Final(dest_buf, (struct MD5Context *)ctx);
+	free(ctx);
+	return 0;
+}
+
 static int __maybe_unused hash_init_sha1(struct hash_algo *algo, void **ctxp)
 {
 	sha1_context *ctx = malloc(sizeof(sha1_context));
@@ -170,10 +198,14 @@ static int hash_update_crc16_ccitt(struct hash_algo *algo, void *ctx,
 static int hash_finish_crc16_ccitt(struct hash_algo *algo, void *ctx,
 				   void *dest_buf, int size)
 {
+	uint16_t crc;
+
 	if (size < algo->digest_size)
 		return -1;
 
-	*((uint16_t *)dest_buf) = *((uint16_t *)ctx);
+	/* Big-endian, as with crc16_ccitt_wd_buf() */
+	crc = cpu_to_be16(*((uint16_t *)ctx));
+	memcpy(dest_buf, &crc, sizeof(crc));
 	free(ctx);
 	return 0;
 }
@@ -197,10 +229,14 @@ static int __maybe_unused hash_update_crc32(struct hash_algo *algo, void *ctx,
 static int __maybe_unused hash_finish_crc32(struct hash_algo *algo, void *ctx,
 					    void *dest_buf, int size)
 {
+	uint32_t crc;
+
 	if (size < algo->digest_size)
 		return -1;
 
-	*((uint32_t *)dest_buf) = *((uint32_t *)ctx);
+	/* Big-endian, as with crc32_wd_buf() */
+	crc = cpu_to_be32(*((uint32_t *)ctx));
+	memcpy(dest_buf, &crc, sizeof(crc));
 	free(ctx);
 	return 0;
 }
@@ -217,6 +253,9 @@ static struct hash_algo hash_algo[] = {
 		.digest_size	= MD5_SUM_LEN,
 		.chunk_size	= CHUNKSZ_MD5,
 		.hash_func_ws	= md5_wd,
+		.hash_init	= hash_init_md5,
+		.hash_update	= hash_update_md5,
+		.hash_finish	= hash_finish_md5,
 	},
 #endif
 #if CONFIG_IS_ENABLED(SHA1)
@@ -390,6 +429,59 @@ int hash_progressive_lookup_algo(const char *algo_name,
 	return -EPROTONOSUPPORT;
 }
 
+int hash_stream_init(struct hash_stream *hs, const char *algo_name)
+{
+	int ret;
+
+	hs->ctx = NULL;
+	ret = hash_progressive_lookup_algo(algo_name, &hs->algo);
+	if (ret)
+		return ret;
+	if (hs->algo->hash_init(hs->algo, &hs->ctx)) {
+		hs->ctx = NULL;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int hash_stream_update(struct hash_stream *hs, const void *buf, uint size,
+		       bool is_last)
+{
+	if (!hs->ctx)
+		return -EIO;
+	if (hs->algo->hash_update(hs->algo, hs->ctx, buf, size, is_last)) {
+		/* hash_update() frees the context on error */
+		hs->ctx = NULL;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int hash_stream_finish(struct hash_stream *hs, uint8_t *output,
+		       int *output_size)
+{
+	uint8_t value[HASH_MAX_DIGEST_SIZE];
+	int size = hs->algo->digest_size;
+	int ret;
+
+	if (!hs->ctx)
+		return -EIO;
+	ret = hs->algo->hash_finish(hs->algo, hs->ctx, value, sizeof(value));
+	hs->ctx = NULL;
+	if (ret)
+		return -EIO;
+	if (!output)
+		return 0;
+	if (*output_size < size)
+		return -ENOSPC;
+	memcpy(output, value, size);
+	*output_size = size;
+
+	return 0;
+}
+
 #ifndef USE_HOSTCC
 int hash_parse_string(const char *algo_name, const char *str, uint8_t *result)
 {
@@ -572,6 +664,7 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 		u8 *output;
 		uint8_t vsum[HASH_MAX_DIGEST_SIZE];
 		void *buf;
+		int span;
 
 		if (hash_lookup_algo(algo_name, &algo)) {
 			printf("Unknown hash algorithm '%s'\n", algo_name);
@@ -587,9 +680,11 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 		output = memalign(ARCH_DMA_MINALIGN,
 				  sizeof(uint32_t) * HASH_MAX_DIGEST_SIZE);
 
+		span = bootstage_span_start(BOOTSTAGE_SPAN_HASH, algo->name);
 		buf = map_sysmem(addr, len);
 		algo->hash_func_ws(buf, len, output, algo->chunk_size);
 		unmap_sysmem(buf);
+		bootstage_span_end(span);
 
 		/* Try to avoid code bloat when verify is not needed */
 #if defined(CONFIG_CRC32_VERIFY) || defined(CONFIG_SHA1SUM_VERIFY) || \
@@ -206,6 +206,7 @@ static int log_dispatch(struct log_rec *rec, const char *fmt, va_list args)
 {
 	struct log_device *ldev;
 	char buf[CONFIG_SYS_CBSIZE];
+	bool unformatted = false;
 
 	/*
 	 * When a log driver writes messages (e.g. via the network stack) this
@@ -220,16 +221,35 @@ static int log_dispatch(struct log_rec *rec, const char *fmt, va_list args)
 	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
 		if ((ldev->flags & LOGDF_ENABLE) &&
 		    log_passes_filters(ldev, rec)) {
+			va_list copy;
+
+			/* Drivers which can format the message later get it raw */
+			if (ldev->drv->emit_fmt) {
+				va_copy(copy, args);
+				ldev->drv->emit_fmt(ldev, rec, fmt, copy);
+				va_end(copy);
+				unformatted = true;
+				continue;
+			}
 			if (!rec->msg) {
 				int len;
 
-				len = vsnprintf(buf, sizeof(buf), fmt, args);
+				va_copy(copy, args);
+				len = vsnprintf(buf, sizeof(buf), fmt, copy);
+				va_end(copy);
 				rec->msg = buf;
 				gd->log_cont = len && buf[len - 1] != '\n';
 			}
 			ldev->drv->emit(ldev, rec);
 		}
 	}
+
+	/* Without the formatted message, check the format string instead */
+	if (unformatted && !rec->msg) {
+		int len = strlen(fmt);
+
+		gd->log_cont = len && fmt[len - 1] != '\n';
+	}
 	gd->processing_msg = false;
 	return 0;
 }
@@ -452,6 +472,13 @@ int log_init(void)
 		ldev->flags = drv->flags;
 		list_add_tail(&ldev->sibling_node,
 			      (struct list_head *)&gd->log_head);
+		if (drv->probe) {
+			int ret = drv->probe(ldev);
+
+			if (ret)
+				debug("%s: Cannot probe log driver '%s' (err=%d)\n",
+				      __func__, drv->name, ret);
+		}
 		drv++;
 	}
 	gd->flags |= GD_FLG_LOG_READY;
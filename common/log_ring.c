@@ -0,0 +1,737 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Log driver which keeps records in a ring buffer without formatting them
+ *
+ * Each record holds the timestamp, category, level, a copy of the source
+ * location, a pointer to the printf() format string and a copy of the
+ * arguments. The message is only formatted when the ring is dumped or handed
+ * off to the OS, so verbose logging costs little more than copying the
+ * arguments. The filename and function name are copied since, as with the
+ * 'log rec' command, they need not outlive the call.
+ */
+
+#include <common.h>
+#include <bloblist.h>
+#include <bootstage.h>
+#include <log.h>
+#include <malloc.h>
+#include <vsprintf.h>
+#include <asm/global_data.h>
+#include <linux/ctype.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	/* Maximum size of a record, including its header and arguments */
+	LOG_RING_MAX_REC	= 512,
+
+	/* Space allowed for each of the filename and function name */
+	LOG_RING_MAX_NAME	= LOG_RING_MAX_REC / 4,
+
+	/* Category used to mark padding at the end of the buffer */
+	LOG_RING_PAD		= 0xffff,
+};
+
+/**
+ * enum log_ring_arg - Type of argument used by a conversion specification
+ *
+ * @LRA_NONE: No argument (%%)
+ * @LRA_INT: int, or smaller type promoted to int
+ * @LRA_LONG: long
+ * @LRA_LLONG: long long
+ * @LRA_SIZE: size_t
+ * @LRA_PTRDIFF: ptrdiff_t
+ * @LRA_PTR: Pointer (%p without an extension)
+ * @LRA_STR: String; the characters are copied into the record
+ * @LRA_OTHER: Something which cannot be stored, such as %p with an extension,
+ *	so the message must be formatted straight away
+ */
+enum log_ring_arg {
+	LRA_NONE,
+	LRA_INT,
+	LRA_LONG,
+	LRA_LLONG,
+	LRA_SIZE,
+	LRA_PTRDIFF,
+	LRA_PTR,
+	LRA_STR,
+	LRA_OTHER,
+};
+
+/**
+ * struct log_ring_spec - A conversion specification in a format string
+ *
+ * @start: Pointer to the '%' which starts the specification
+ * @len: Length of the specification, including the conversion character
+ * @stars: Number of '*' in the specification, each taking an int argument
+ * @type: Type of the argument for the conversion
+ */
+struct log_ring_spec {
+	const char *start;
+	int len;
+	int stars;
+	enum log_ring_arg type;
+};
+
+/**
+ * struct log_ring_rec - Header of a record in the ring
+ *
+ * This is followed by the source filename and function name, then the
+ * arguments, in the order they appear in the format string. Integers and
+ * pointers are stored as a u64 each, including '*' widths and precisions.
+ * Strings are stored as their characters and a nul terminator, padded to a
+ * multiple of 8 bytes.
+ *
+ * @size: Size of the record in bytes, including the header and arguments, a
+ *	multiple of 8
+ * @cat: Category (enum log_category_t), or LOG_RING_PAD if this is padding to
+ *	the end of the buffer. The fields below are not valid for padding
+ * @level: Level (enum log_level_t)
+ * @flags: Flags (enum log_rec_flags)
+ * @line: Source line number
+ * @time: Time the record was emitted, in microseconds since boot
+ * @fmt: printf() format string for the message
+ */
+struct log_ring_rec {
+	u16 size;
+	u16 cat;
+	u8 level;
+	u8 flags;
+	u16 line;
+	u64 time;
+	const char *fmt;
+};
+
+#define LOG_RING_HDR_SIZE	ALIGN(sizeof(struct log_ring_rec), sizeof(u64))
+
+/**
+ * struct log_ring - Ring buffer holding the records
+ *
+ * Records are never split across the end of the buffer; the space left at
+ * the end is filled with a padding record instead. The head and tail are
+ * offsets which only ever increase, so the buffer size must be a power of
+ * two
+ *
+ * @buf: Buffer holding the records
+ * @size: Size of @buf in bytes
+ * @head: Offset at which the next record is written
+ * @tail: Offset of the oldest record
+ * @count: Number of records in the ring
+ * @dropped: Number of records overwritten to make space for newer ones
+ */
+struct log_ring {
+	void *buf;
+	ulong size;
+	ulong head;
+	ulong tail;
+	ulong count;
+	ulong dropped;
+};
+
+static struct log_ring_rec *log_ring_ptr(struct log_ring *ring, ulong ofs)
+{
+	return ring->buf + (ofs & (ring->size - 1));
+}
+
+/**
+ * log_ring_next_spec() - Find the next conversion specification
+ *
+ * This follows the syntax accepted by vsnprintf(), so that each argument is
+ * read with the same type that vsnprintf() would use
+ *
+ * @fmt: Format string to search
+ * @spec: Returns information about the specification
+ * Return: pointer to the '%' of the specification, or NULL if none
+ */
+static const char *log_ring_next_spec(const char *fmt,
+				      struct log_ring_spec *spec)
+{
+	const char *p;
+	int qualifier = 0;
+
+	fmt = strchr(fmt, '%');
+	if (!fmt)
+		return NULL;
+	spec->start = fmt;
+	spec->stars = 0;
+
+	p = fmt + 1;
+	while (*p && strchr("-+ #0", *p))
+		p++;
+	if (*p == '*') {
+		spec->stars++;
+		p++;
+	} else {
+		while (isdigit(*p))
+			p++;
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->stars++;
+			p++;
+		} else {
+			while (isdigit(*p))
+				p++;
+		}
+	}
+	if (*p && strchr("hlLZzt", *p)) {
+		qualifier = *p++;
+		if (qualifier == 'l' && *p == 'l') {
+			qualifier = 'L';
+			p++;
+		}
+	}
+
+	switch (*p) {
+	case '%':
+		spec->type = LRA_NONE;
+		break;
+	case 'd':
+		/* %dE shows an error string */
+		if (p[1] == 'E') {
+			spec->type = LRA_OTHER;
+			break;
+		}
+		fallthrough;
+	case 'c':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		switch (qualifier) {
+		case 'l':
+			spec->type = LRA_LONG;
+			break;
+		case 'L':
+			spec->type = LRA_LLONG;
+			break;
+		case 'Z':
+		case 'z':
+			spec->type = LRA_SIZE;
+			break;
+		case 't':
+			spec->type = LRA_PTRDIFF;
+			break;
+		default:
+			spec->type = LRA_INT;
+			break;
+		}
+		break;
+	case 's':
+		spec->type = qualifier ? LRA_OTHER : LRA_STR;
+		break;
+	case 'p':
+		spec->type = isalnum(p[1]) ? LRA_OTHER : LRA_PTR;
+		break;
+	default:
+		spec->type = LRA_OTHER;
+		break;
+	}
+	if (*p)
+		p++;
+	spec->len = p - fmt;
+
+	return fmt;
+}
+
+static void *log_ring_put_num(void *ptr, void *end, u64 val)
+{
+	if (!ptr || ptr + sizeof(u64) > end)
+		return NULL;
+	*(u64 *)ptr = val;
+
+	return ptr + sizeof(u64);
+}
+
+static void *log_ring_put_str(void *ptr, void *end, const char *str)
+{
+	int len;
+
+	if (!ptr || ptr >= end)
+		return NULL;
+	if (!str)
+		str = "<NULL>";
+
+	/* Truncate the string if it does not fit */
+	len = strnlen(str, end - ptr - 1);
+	memcpy(ptr, str, len);
+	((char *)ptr)[len] = '\0';
+
+	return ptr + ALIGN(len + 1, sizeof(u64));
+}
+
+/**
+ * log_ring_encode() - Store the arguments for a format string
+ *
+ * @buf: Buffer to write the arguments to, 8-byte aligned
+ * @end: End of buffer, 8-byte aligned
+ * @fmt: Format string
+ * @args: Arguments to store
+ * Return: number of bytes written, -ENOSYS if the format string has a
+ * specification which cannot be stored, -ENOSPC if the arguments do not fit
+ */
+static int log_ring_encode(void *buf, void *end, const char *fmt,
+			   va_list args)
+{
+	struct log_ring_spec spec;
+	void *ptr = buf;
+	const char *p;
+	int i;
+
+	for (p = fmt; (p = log_ring_next_spec(p, &spec)); p += spec.len) {
+		if (spec.type == LRA_OTHER)
+			return -ENOSYS;
+		for (i = 0; i < spec.stars; i++)
+			ptr = log_ring_put_num(ptr, end, va_arg(args, int));
+		switch (spec.type) {
+		case LRA_NONE:
+		case LRA_OTHER:
+			break;
+		case LRA_INT:
+			ptr = log_ring_put_num(ptr, end, va_arg(args, int));
+			break;
+		case LRA_LONG:
+			ptr = log_ring_put_num(ptr, end, va_arg(args, long));
+			break;
+		case LRA_LLONG:
+			ptr = log_ring_put_num(ptr, end,
+					       va_arg(args, long long));
+			break;
+		case LRA_SIZE:
+			ptr = log_ring_put_num(ptr, end, va_arg(args, size_t));
+			break;
+		case LRA_PTRDIFF:
+			ptr = log_ring_put_num(ptr, end,
+					       va_arg(args, ptrdiff_t));
+			break;
+		case LRA_PTR:
+			ptr = log_ring_put_num(ptr, end,
+					       (ulong)va_arg(args, void *));
+			break;
+		case LRA_STR:
+			ptr = log_ring_put_str(ptr, end,
+					       va_arg(args, const char *));
+			break;
+		}
+		if (!ptr)
+			return -ENOSPC;
+	}
+
+	return ptr - buf;
+}
+
+static u64 log_ring_get_num(const void **ptrp)
+{
+	u64 val = *(u64 *)*ptrp;
+
+	*ptrp += sizeof(u64);
+
+	return val;
+}
+
+static const char *log_ring_get_str(const void **ptrp)
+{
+	const char *str = *ptrp;
+
+	*ptrp += ALIGN(strlen(str) + 1, sizeof(u64));
+
+	return str;
+}
+
+/**
+ * log_ring_format() - Format the message in a record
+ *
+ * @rec: Record to format
+ * @ptr: Arguments stored in the record
+ * @buf: Buffer for the message
+ * @size: Size of @buf, which must be at least 1
+ * Return: number of characters written, excluding the nul terminator
+ */
+static int log_ring_format(const struct log_ring_rec *rec, const void *ptr,
+			   char *buf, int size)
+{
+	struct log_ring_spec spec;
+	const char *p, *start;
+	char *out = buf;
+	char *end = buf + size;
+
+	for (p = rec->fmt; (start = log_ring_next_spec(p, &spec));
+	     p = start + spec.len) {
+		const char *s;
+		char conv[32];
+		int i;
+
+		out += scnprintf(out, end - out, "%.*s", (int)(start - p), p);
+
+		/* Put the stored widths and precisions in place of each '*' */
+		for (i = 0, s = start; s < start + spec.len; s++) {
+			if (*s == '*') {
+				int val = log_ring_get_num(&ptr);
+
+				/* A negative precision is ignored */
+				if (s[-1] == '.' && val < 0)
+					i--;
+				else
+					i += scnprintf(conv + i,
+						       sizeof(conv) - i, "%d",
+						       val);
+			} else if (i < sizeof(conv) - 1) {
+				conv[i++] = *s;
+			}
+		}
+		conv[i] = '\0';
+
+		switch (spec.type) {
+		case LRA_NONE:
+			out += scnprintf(out, end - out, "%%");
+			break;
+		case LRA_INT:
+			out += scnprintf(out, end - out, conv,
+					 (int)log_ring_get_num(&ptr));
+			break;
+		case LRA_LONG:
+			out += scnprintf(out, end - out, conv,
+					 (long)log_ring_get_num(&ptr));
+			break;
+		case LRA_LLONG:
+			out += scnprintf(out, end - out, conv,
+					 (long long)log_ring_get_num(&ptr));
+			break;
+		case LRA_SIZE:
+			out += scnprintf(out, end - out, conv,
+					 (size_t)log_ring_get_num(&ptr));
+			break;
+		case LRA_PTRDIFF:
+			out += scnprintf(out, end - out, conv,
+					 (ptrdiff_t)log_ring_get_num(&ptr));
+			break;
+		case LRA_PTR:
+			out += scnprintf(out, end - out, conv,
+					 (void *)(ulong)log_ring_get_num(&ptr));
+			break;
+		case LRA_STR:
+			out += scnprintf(out, end - out, conv,
+					 log_ring_get_str(&ptr));
+			break;
+		case LRA_OTHER:
+			/* Such records are formatted when emitted */
+			break;
+		}
+	}
+	out += scnprintf(out, end - out, "%s", p);
+
+	return out - buf;
+}
+
+/**
+ * log_ring_format_rec() - Format a record as a line of text
+ *
+ * The fields shown are selected by gd->log_fmt, as with the console driver,
+ * preceded by the time since boot
+ *
+ * @rec: Record to format
+ * @buf: Buffer for the text
+ * @size: Size of @buf
+ * Return: number of characters written, excluding the nul terminator
+ */
+static int log_ring_format_rec(const struct log_ring_rec *rec, char *buf,
+			       int size)
+{
+	const void *ptr = (void *)rec + LOG_RING_HDR_SIZE;
+	const char *file = log_ring_get_str(&ptr);
+	const char *func = log_ring_get_str(&ptr);
+	int fmt = gd->log_fmt;
+	char *out = buf;
+	char *end = buf + size;
+
+	if (!(rec->flags & LOGRECF_CONT)) {
+		out += scnprintf(out, end - out, "[%5lu.%06lu] ",
+				 (ulong)(rec->time / 1000000),
+				 (ulong)(rec->time % 1000000));
+		if (fmt & BIT(LOGF_LEVEL))
+			out += scnprintf(out, end - out, "%s.",
+					 log_get_level_name(rec->level));
+		if (fmt & BIT(LOGF_CAT))
+			out += scnprintf(out, end - out, "%s,",
+					 log_get_cat_name(rec->cat));
+		if (fmt & BIT(LOGF_FILE))
+			out += scnprintf(out, end - out, "%s:", file);
+		if (fmt & BIT(LOGF_LINE))
+			out += scnprintf(out, end - out, "%d-", rec->line);
+		if (fmt & BIT(LOGF_FUNC))
+			out += scnprintf(out, end - out, "%*s()",
+					 CONFIG_LOGF_FUNC_PAD, func);
+		if (fmt != BIT(LOGF_MSG))
+			out += scnprintf(out, end - out, " ");
+	}
+	if (fmt & BIT(LOGF_MSG))
+		out += log_ring_format(rec, ptr, out, end - out);
+
+	return out - buf;
+}
+
+/* Drop the oldest records until there is @size bytes free at the head */
+static void log_ring_make_space(struct log_ring *ring, ulong size)
+{
+	while (ring->head + size - ring->tail > ring->size) {
+		struct log_ring_rec *rec = log_ring_ptr(ring, ring->tail);
+
+		if (rec->cat != LOG_RING_PAD) {
+			ring->count--;
+			ring->dropped++;
+		}
+		ring->tail += rec->size;
+	}
+}
+
+static void log_ring_add(struct log_ring *ring, const void *rec, int size)
+{
+	ulong space = ring->size - (ring->head & (ring->size - 1));
+
+	if (space < size) {
+		struct log_ring_rec *pad;
+
+		log_ring_make_space(ring, space);
+		pad = log_ring_ptr(ring, ring->head);
+		pad->size = space;
+		pad->cat = LOG_RING_PAD;
+		ring->head += space;
+	}
+	log_ring_make_space(ring, size);
+	memcpy(log_ring_ptr(ring, ring->head), rec, size);
+	ring->head += size;
+	ring->count++;
+}
+
+static int log_ring_emit_fmt(struct log_device *ldev, struct log_rec *rec,
+			     const char *fmt, va_list args)
+{
+	struct log_ring *ring = ldev->priv;
+	u64 buf[LOG_RING_MAX_REC / sizeof(u64)];
+	struct log_ring_rec *hdr = (struct log_ring_rec *)buf;
+	void *start = (void *)buf + LOG_RING_HDR_SIZE;
+	void *end = (void *)buf + sizeof(buf);
+	va_list copy;
+	int len;
+
+	if (!ring)
+		return -ENOSYS;
+
+	hdr->cat = rec->cat;
+	hdr->level = rec->level;
+	hdr->flags = rec->flags;
+	hdr->line = rec->line;
+	hdr->time = timer_get_boot_us();
+	hdr->fmt = fmt;
+
+	/* The names are copied, truncated if needed, leaving room for the rest */
+	start = log_ring_put_str(start, start + LOG_RING_MAX_NAME, rec->file);
+	start = log_ring_put_str(start, start + LOG_RING_MAX_NAME, rec->func);
+
+	va_copy(copy, args);
+	len = log_ring_encode(start, end, fmt, copy);
+	va_end(copy);
+	if (len < 0) {
+		/* The arguments cannot be stored, so format the message now */
+		vscnprintf(start, end - start, fmt, args);
+		hdr->fmt = "%s";
+		len = ALIGN(strlen(start) + 1, sizeof(u64));
+	}
+	hdr->size = start - (void *)buf + len;
+	log_ring_add(ring, hdr, hdr->size);
+
+	return 0;
+}
+
+static int log_ring_probe(struct log_device *ldev)
+{
+	struct log_ring *ring;
+	int ret;
+
+	/*
+	 * The ring must not hold pointers into the pre-relocation image, so
+	 * only start recording once relocated
+	 */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return 0;
+
+	/* Record messages up to our own level, whatever the console shows */
+	ret = log_add_filter(ldev->drv->name, NULL, CONFIG_LOG_RING_LEVEL,
+			     NULL);
+	if (ret < 0)
+		return ret;
+
+	ring = calloc(1, sizeof(*ring));
+	if (!ring)
+		return -ENOMEM;
+	ring->size = rounddown_pow_of_two(CONFIG_LOG_RING_SIZE);
+	ring->buf = malloc(ring->size);
+	if (!ring->buf) {
+		free(ring);
+		return -ENOMEM;
+	}
+	ldev->priv = ring;
+
+	return 0;
+}
+
+static struct log_ring *log_ring_get(void)
+{
+	struct log_device *ldev = log_device_find_by_name("ring");
+
+	return ldev ? ldev->priv : NULL;
+}
+
+/**
+ * log_ring_walk() - Format each record in the ring, oldest first
+ *
+ * @ring: Ring to walk
+ * @from: Offset of the first record to format, e.g. @ring->tail
+ * @func: Function to call with each formatted record
+ * @priv: Private data to pass to @func
+ */
+static void log_ring_walk(struct log_ring *ring, ulong from,
+			  void (*func)(void *priv, const char *str, int len),
+			  void *priv)
+{
+	char buf[CONFIG_SYS_CBSIZE];
+	ulong ofs;
+
+	for (ofs = from; ofs != ring->head;) {
+		struct log_ring_rec *rec = log_ring_ptr(ring, ofs);
+
+		ofs += rec->size;
+		if (rec->cat != LOG_RING_PAD)
+			func(priv, buf, log_ring_format_rec(rec, buf,
+							    sizeof(buf)));
+	}
+}
+
+static void log_ring_show(void *priv, const char *str, int len)
+{
+	puts(str);
+}
+
+int log_ring_dump(void)
+{
+	struct log_ring *ring = log_ring_get();
+
+	if (!ring)
+		return -ENOENT;
+	log_ring_walk(ring, ring->tail, log_ring_show, NULL);
+
+	return 0;
+}
+
+int log_ring_clear(void)
+{
+	struct log_ring *ring = log_ring_get();
+
+	if (!ring)
+		return -ENOENT;
+	ring->tail = ring->head;
+	ring->count = 0;
+	ring->dropped = 0;
+
+	return 0;
+}
+
+int log_ring_get_stats(struct log_ring_stats *stats)
+{
+	struct log_ring *ring = log_ring_get();
+
+	if (!ring)
+		return -ENOENT;
+	stats->count = ring->count;
+	stats->dropped = ring->dropped;
+	stats->used = ring->head - ring->tail;
+	stats->size = ring->size;
+
+	return 0;
+}
+
+static void log_ring_measure(void *priv, const char *str, int len)
+{
+	*(int *)priv += len;
+}
+
+static void log_ring_copy(void *priv, const char *str, int len)
+{
+	char **ptrp = priv;
+
+	memcpy(*ptrp, str, len);
+	*ptrp += len;
+}
+
+/**
+ * log_ring_trim() - Find the oldest record whose text fits in the space
+ *
+ * @ring: Ring to check
+ * @sizep: Size of the text of all the records, plus the nul terminator;
+ *	returns the size of the text from the record found
+ * @room: Space available for the text
+ * Return: offset of the oldest record such that it and all the records after
+ *	it fit in @room, or @ring->head if even the newest does not fit
+ */
+static ulong log_ring_trim(struct log_ring *ring, int *sizep, int room)
+{
+	char buf[CONFIG_SYS_CBSIZE];
+	ulong ofs;
+
+	for (ofs = ring->tail; ofs != ring->head && *sizep > room;) {
+		struct log_ring_rec *rec = log_ring_ptr(ring, ofs);
+
+		ofs += rec->size;
+		if (rec->cat != LOG_RING_PAD)
+			*sizep -= log_ring_format_rec(rec, buf, sizeof(buf));
+	}
+
+	return ofs;
+}
+
+int log_ring_handoff(void)
+{
+	struct log_ring *ring = log_ring_get();
+	ulong base, total, alloced, from;
+	char *blob, *ptr;
+	int size = 1;
+	int room;
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(BLOBLIST))
+		return -ENOSYS;
+	if (!ring)
+		return -ENOENT;
+	log_ring_walk(ring, ring->tail, log_ring_measure, &size);
+
+	/* The ring is usually much larger, so pass on the newest records */
+	bloblist_get_stats(&base, &total, &alloced);
+	room = total - alloced - sizeof(struct bloblist_rec) - BLOBLIST_ALIGN;
+	if (room <= 1)
+		return -ENOSPC;
+	from = log_ring_trim(ring, &size, room);
+
+	ret = bloblist_ensure_size(BLOBLISTT_U_BOOT_LOG, size, 0,
+				   (void **)&blob);
+	if (ret == -ESPIPE) {
+		ret = bloblist_resize(BLOBLISTT_U_BOOT_LOG, size);
+		blob = bloblist_find(BLOBLISTT_U_BOOT_LOG, size);
+	}
+	if (ret)
+		return log_msg_ret("blob", ret);
+	ptr = blob;
+	log_ring_walk(ring, from, log_ring_copy, &ptr);
+	*ptr = '\0';
+
+	return 0;
+}
+
+LOG_DRIVER(ring) = {
+	.name	= "ring",
+	.emit_fmt = log_ring_emit_fmt,
+	.probe	= log_ring_probe,
+	.flags	= LOGDF_ENABLE,
+};
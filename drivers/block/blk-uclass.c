@@ -12,6 +12,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <part.h>
+#include <time.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
@@ -449,14 +450,20 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
 	ulong blks_read;
+	u64 start_us;
 
 	if (!ops->read)
 		return -ENOSYS;
 
 	if (blkcache_read(desc->uclass_id, desc->devnum,
-			  start, blkcnt, desc->blksz, buf))
+			  start, blkcnt, desc->blksz, buf)) {
+		blk_stats_cache_hit(dev);
 		return blkcnt;
+	}
+	start_us = CONFIG_IS_ENABLED(BLK_STATS) ? timer_get_us() : 0;
 	blks_read = ops->read(dev, start, blkcnt, buf);
+	blk_stats_account(dev, BLK_STATS_READ, start, blkcnt, blks_read,
+			  start_us);
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start, blkcnt,
 			      desc->blksz, buf);
@@ -464,31 +471,55 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	return blks_read;
 }
 
+/* Number of writes, erases and removals of block devices */
+static uint blk_generation;
+
+uint blk_get_generation(void)
+{
+	return blk_generation;
+}
+
 long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 	       const void *buf)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_written;
+	u64 start_us;
 
 	if (!ops->write)
 		return -ENOSYS;
 
+	blk_generation++;
 	blkcache_invalidate(desc->uclass_id, desc->devnum);
 
-	return ops->write(dev, start, blkcnt, buf);
+	start_us = CONFIG_IS_ENABLED(BLK_STATS) ? timer_get_us() : 0;
+	blks_written = ops->write(dev, start, blkcnt, buf);
+	blk_stats_account(dev, BLK_STATS_WRITE, start, blkcnt, blks_written,
+			  start_us);
+
+	return blks_written;
 }
 
 long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_erased;
+	u64 start_us;
 
 	if (!ops->erase)
 		return -ENOSYS;
 
+	blk_generation++;
 	blkcache_invalidate(desc->uclass_id, desc->devnum);
 
-	return ops->erase(dev, start, blkcnt);
+	start_us = CONFIG_IS_ENABLED(BLK_STATS) ? timer_get_us() : 0;
+	blks_erased = ops->erase(dev, start, blkcnt);
+	blk_stats_account(dev, BLK_STATS_ERASE, start, blkcnt, blks_erased,
+			  start_us);
+
+	return blks_erased;
 }
 
 ulong blk_dread(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
@@ -768,6 +799,8 @@ int blk_unbind_all(int uclass_id)
 
 static int blk_post_probe(struct udevice *dev)
 {
+	blk_stats_reset(dev);
+
 	if (CONFIG_IS_ENABLED(PARTITIONS) && blk_enabled()) {
 		struct blk_desc *desc = dev_get_uclass_plat(dev);
 
@@ -781,9 +814,21 @@ static int blk_post_probe(struct udevice *dev)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	/* Anything read from this device must not be used after removal */
+	blk_generation++;
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
 	.post_probe	= blk_post_probe,
+	.pre_remove	= blk_pre_remove,
 	.per_device_plat_auto	= sizeof(struct blk_desc),
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	.per_device_auto	= sizeof(struct blk_stats),
+#endif
 };
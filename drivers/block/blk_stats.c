@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Per-device I/O statistics for block devices
+ */
+
+#define LOG_CATEGORY UCLASS_BLK
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <time.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+#include <linux/libfdt.h>
+
+static const char *const op_name[BLK_STATS_OP_COUNT] = {
+	[BLK_STATS_READ]	= "read",
+	[BLK_STATS_WRITE]	= "write",
+	[BLK_STATS_ERASE]	= "erase",
+};
+
+const char *blk_stats_op_name(enum blk_stats_op op)
+{
+	return op_name[op];
+}
+
+/**
+ * blk_stats_hist_bucket() - Get the histogram bucket for a time
+ *
+ * @us: Time in us
+ * Return: bucket index, see BLK_STATS_HIST_BUCKETS
+ */
+static uint blk_stats_hist_bucket(u64 us)
+{
+	return min_t(uint, fls(min_t(u64, us, U32_MAX)),
+		     BLK_STATS_HIST_BUCKETS - 1);
+}
+
+void blk_stats_account(struct udevice *dev, enum blk_stats_op op,
+		       lbaint_t start, lbaint_t blkcnt, long done,
+		       u64 start_us)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	struct blk_stats *stats = dev_get_uclass_priv(dev);
+	struct blk_op_stats *ost = &stats->op[op];
+	u64 us = timer_get_us() - start_us;
+
+	ost->ops++;
+	ost->time_us += us;
+	if (us > ost->max_us)
+		ost->max_us = us;
+	ost->lat_hist[blk_stats_hist_bucket(us)]++;
+
+	if (start == stats->next_lba)
+		ost->seq++;
+	else
+		ost->random++;
+	stats->next_lba = start + blkcnt;
+
+	if (done != blkcnt)
+		ost->errors++;
+	if (done > 0) {
+		ost->blocks += done;
+		ost->bytes += (u64)done * desc->blksz;
+	}
+}
+
+void blk_stats_cache_hit(struct udevice *dev)
+{
+	struct blk_stats *stats = dev_get_uclass_priv(dev);
+
+	stats->cache_hits++;
+}
+
+struct blk_stats *blk_get_stats(struct udevice *dev)
+{
+	return dev_get_uclass_priv(dev);
+}
+
+void blk_stats_reset(struct udevice *dev)
+{
+	struct blk_stats *stats = dev_get_uclass_priv(dev);
+
+	memset(stats, '\0', sizeof(*stats));
+
+	/* Nothing has been accessed yet, so the first access is random */
+	stats->next_lba = (lbaint_t)-1;
+}
+
+/* Counters added to the FDT for each operation, prefixed by its name */
+static const struct {
+	const char *name;
+	size_t offset;
+} fdt_props[] = {
+	{ "ops", offsetof(struct blk_op_stats, ops) },
+	{ "blocks", offsetof(struct blk_op_stats, blocks) },
+	{ "bytes", offsetof(struct blk_op_stats, bytes) },
+	{ "time-us", offsetof(struct blk_op_stats, time_us) },
+	{ "max-us", offsetof(struct blk_op_stats, max_us) },
+	{ "sequential", offsetof(struct blk_op_stats, seq) },
+	{ "random", offsetof(struct blk_op_stats, random) },
+	{ "errors", offsetof(struct blk_op_stats, errors) },
+};
+
+/**
+ * add_op_stats() - Add the properties for one operation type to a node
+ *
+ * @blob: Device tree to update
+ * @node: Node offset for the device
+ * @name: Name of the operation, used as a prefix for each property
+ * @ost: Statistics to add
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+static int add_op_stats(void *blob, int node, const char *name,
+			const struct blk_op_stats *ost)
+{
+	fdt32_t hist[BLK_STATS_HIST_BUCKETS];
+	char prop[30];
+	int ret, i;
+
+	for (i = 0; i < ARRAY_SIZE(fdt_props); i++) {
+		const u64 *val = (void *)ost + fdt_props[i].offset;
+
+		snprintf(prop, sizeof(prop), "%s-%s", name, fdt_props[i].name);
+		ret = fdt_setprop_u64(blob, node, prop, *val);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < BLK_STATS_HIST_BUCKETS; i++)
+		hist[i] = cpu_to_fdt32(ost->lat_hist[i]);
+	snprintf(prop, sizeof(prop), "%s-latency-hist", name);
+
+	return fdt_setprop(blob, node, prop, hist, sizeof(hist));
+}
+
+/**
+ * add_dev_stats() - Add a node holding the statistics for a device
+ *
+ * If the node cannot be completed, it is removed again.
+ *
+ * @blob: Device tree to update
+ * @parent: Node offset of the 'blk' node
+ * @name: Name of the device
+ * @stats: Statistics to add
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+static int add_dev_stats(void *blob, int parent, const char *name,
+			 const struct blk_stats *stats)
+{
+	enum blk_stats_op op;
+	int node, ret;
+
+	node = fdt_add_subnode(blob, parent, name);
+	if (node < 0)
+		return node;
+
+	ret = fdt_setprop_u64(blob, node, "cache-hits", stats->cache_hits);
+	for (op = 0; !ret && op < BLK_STATS_OP_COUNT; op++) {
+		if (stats->op[op].ops)
+			ret = add_op_stats(blob, node, op_name[op],
+					   &stats->op[op]);
+	}
+	if (ret)
+		fdt_del_node(blob, node);
+
+	return ret;
+}
+
+int blk_stats_add_fdt(void *blob, int parent)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int blk = -1;
+	int ret = 0;
+
+	uclass_id_foreach_dev(UCLASS_BLK, dev, uc) {
+		struct blk_stats *stats = blk_get_stats(dev);
+
+		if (!stats || !blk_stats_used(stats))
+			continue;
+
+		if (blk < 0) {
+			blk = fdt_subnode_offset(blob, parent, "blk");
+			if (blk == -FDT_ERR_NOTFOUND)
+				blk = fdt_add_subnode(blob, parent, "blk");
+			if (blk < 0) {
+				ret = blk;
+				break;
+			}
+		}
+		ret = add_dev_stats(blob, blk, dev->name, stats);
+
+		/* Keep the statistics if they were added before */
+		if (ret == -FDT_ERR_EXISTS)
+			ret = 0;
+		if (ret)
+			break;
+	}
+
+	/*
+	 * The device tree is not enlarged, since it may be followed by other
+	 * images, so leave out the devices which do not fit
+	 */
+	if (ret == -FDT_ERR_NOSPACE)
+		return 0;
+
+	return ret;
+}
@@ -16,6 +16,7 @@
 #include <malloc.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
+#include <dm/timing.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -196,17 +197,21 @@ static int flags_remove(uint flags, uint drv_flags)
 	return 0;
 }
 
-int device_remove(struct udevice *dev, uint flags)
+/**
+ * device_do_remove() - Remove a device which is active
+ *
+ * This is the body of device_remove(), which handles timing
+ *
+ * @dev: Device to remove
+ * @flags: Flags for selective device removal (DM_REMOVE_...)
+ * Return: 0 if OK, -EKEYREJECTED if not removed due to flags, other -ve on
+ * error
+ */
+static int device_do_remove(struct udevice *dev, uint flags)
 {
 	const struct driver *drv;
 	int ret;
 
-	if (!dev)
-		return -EINVAL;
-
-	if (!(dev_get_flags(dev) & DM_FLAG_ACTIVATED))
-		return 0;
-
 	ret = device_notify(dev, EVT_DM_PRE_REMOVE);
 	if (ret)
 		return ret;
@@ -273,3 +278,21 @@ err_remove:
 
 	return ret;
 }
+
+int device_remove(struct udevice *dev, uint flags)
+{
+	struct dm_timing_state timing;
+	int ret;
+
+	if (!dev)
+		return -EINVAL;
+
+	if (!(dev_get_flags(dev) & DM_FLAG_ACTIVATED))
+		return 0;
+
+	dm_timing_start(&timing);
+	ret = device_do_remove(dev, flags);
+	dm_timing_end(&timing, ret ? NULL : dev, DM_TIMING_REMOVE);
+
+	return ret;
+}
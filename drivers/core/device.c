@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <event.h>
 #include <log.h>
@@ -26,6 +27,7 @@
 #include <dm/pinctrl.h>
 #include <dm/platdata.h>
 #include <dm/read.h>
+#include <dm/timing.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -36,10 +38,9 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-static int device_bind_common(struct udevice *parent, const struct driver *drv,
-			      const char *name, void *plat,
-			      ulong driver_data, ofnode node,
-			      uint of_plat_size, struct udevice **devp)
+static int device_do_bind(struct udevice *parent, const struct driver *drv,
+			  const char *name, void *plat, ulong driver_data,
+			  ofnode node, uint of_plat_size, struct udevice **devp)
 {
 	struct udevice *dev;
 	struct uclass *uc;
@@ -236,6 +237,25 @@ fail_alloc1:
 	return ret;
 }
 
+static int device_bind_common(struct udevice *parent, const struct driver *drv,
+			      const char *name, void *plat,
+			      ulong driver_data, ofnode node,
+			      uint of_plat_size, struct udevice **devp)
+{
+	struct dm_timing_state timing;
+	struct udevice *dev = NULL;
+	int ret;
+
+	dm_timing_start(&timing);
+	ret = device_do_bind(parent, drv, name, plat, driver_data, node,
+			     of_plat_size, &dev);
+	dm_timing_end(&timing, dev, DM_TIMING_BIND);
+	if (devp)
+		*devp = dev;
+
+	return ret;
+}
+
 int device_bind_with_driver_data(struct udevice *parent,
 				 const struct driver *drv, const char *name,
 				 ulong driver_data, ofnode node,
@@ -477,17 +497,17 @@ static int device_get_dma_constraints(struct udevice *dev)
 	return 0;
 }
 
-int device_probe(struct udevice *dev)
+/**
+ * device_do_probe() - Probe a device which is not yet activated
+ *
+ * @dev: Device to probe
+ * Return: 0 if OK, -ve on error
+ */
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
 	int ret;
 
-	if (!dev)
-		return -EINVAL;
-
-	if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
-		return 0;
-
 	ret = device_notify(dev, EVT_DM_PRE_PROBE);
 	if (ret)
 		return ret;
@@ -614,6 +634,26 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	struct dm_timing_state timing;
+	int span, ret;
+
+	if (!dev)
+		return -EINVAL;
+
+	if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
+		return 0;
+
+	span = bootstage_span_start(BOOTSTAGE_SPAN_DM_PROBE, dev->name);
+	dm_timing_start(&timing);
+	ret = device_do_probe(dev);
+	dm_timing_end(&timing, ret ? NULL : dev, DM_TIMING_PROBE);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
 void *dev_get_plat(const struct udevice *dev)
 {
 	if (!dev) {
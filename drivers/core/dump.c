@@ -9,6 +9,7 @@
 #include <mapmem.h>
 #include <sort.h>
 #include <dm/root.h>
+#include <dm/timing.h>
 #include <dm/util.h>
 #include <dm/uclass-internal.h>
 
@@ -298,3 +299,92 @@ void dm_dump_mem(struct dm_stats *stats)
 	printf("Drop device name (not SRAM): %x (%d)\n", stats->dev_name_size,
 	       stats->dev_name_size);
 }
+
+#if CONFIG_IS_ENABLED(DM_TIMING)
+static int h_cmp_probe_self(const void *d1, const void *d2)
+{
+	const struct udevice *const *dev1 = d1;
+	const struct udevice *const *dev2 = d2;
+	u32 t1 = (*dev1)->timing.probe_self_us;
+	u32 t2 = (*dev2)->timing.probe_self_us;
+
+	return t1 < t2 ? 1 : t1 > t2 ? -1 : 0;
+}
+
+static void show_timing_totals(const char *name,
+			       const struct dm_timing_totals *totals)
+{
+	printf("%-20.20s %5u %9lu %9lu %9lu %9lu\n", name, totals->count,
+	       totals->probe_self_us, totals->probe_us, totals->bind_us,
+	       totals->remove_us);
+}
+
+static void show_timing_header(const char *title)
+{
+	printf("\n%-20s %5s %9s %9s %9s %9s\n", title, "Devs", "Self",
+	       "Probe", "Bind", "Remove");
+	printf("------------------------------------------------------------------\n");
+}
+
+void dm_dump_timing(int count)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct dm_timing_totals totals;
+	int dev_count, uclasses, id, i;
+	struct udevice **devs;
+	struct udevice *dev;
+	struct driver *entry;
+	struct uclass *uc;
+
+	dm_get_stats(&dev_count, &uclasses);
+	devs = calloc(dev_count, sizeof(struct udevice *));
+	if (!devs) {
+		printf("(out of memory)\n");
+		return;
+	}
+
+	i = 0;
+	for (id = 0; id < UCLASS_COUNT; id++) {
+		uc = uclass_find(id);
+		if (!uc)
+			continue;
+		uclass_foreach_dev(dev, uc) {
+			if (i < dev_count)
+				devs[i++] = dev;
+		}
+	}
+	dev_count = i;
+	qsort(devs, dev_count, sizeof(struct udevice *), h_cmp_probe_self);
+
+	printf("Times in microseconds; 'Self' excludes probing parents and suppliers\n\n");
+	printf("%-20s %-12s %9s %9s %9s %9s\n", "Device", "Uclass", "Self",
+	       "Probe", "Bind", "Remove");
+	printf("------------------------------------------------------------------------\n");
+	for (i = 0; i < dev_count && i < count; i++) {
+		const struct dm_dev_timing *timing = &devs[i]->timing;
+
+		printf("%-20.20s %-12.12s %9u %9u %9u %9u\n", devs[i]->name,
+		       devs[i]->uclass->uc_drv->name, timing->probe_self_us,
+		       timing->probe_us, timing->bind_us, timing->remove_us);
+	}
+	free(devs);
+
+	show_timing_header("Uclass");
+	for (id = 0; id < UCLASS_COUNT; id++) {
+		uc = uclass_find(id);
+		if (!uc)
+			continue;
+		dm_timing_get_uclass(uc, &totals);
+		if (totals.count)
+			show_timing_totals(uc->uc_drv->name, &totals);
+	}
+
+	show_timing_header("Driver");
+	for (entry = drv; entry < drv + n_ents; entry++) {
+		dm_timing_get_driver(entry, &totals);
+		if (totals.count)
+			show_timing_totals(entry->name, &totals);
+	}
+}
+#endif /* DM_TIMING */
@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Time spent binding, probing and removing devices
+ */
+
+#define LOG_CATEGORY	LOGC_DM
+
+#include <common.h>
+#include <bootstage.h>
+#include <dm.h>
+#include <malloc.h>
+#include <sort.h>
+#include <asm/global_data.h>
+#include <dm/timing.h>
+#include <dm/uclass-internal.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Maximum number of uclasses, or of drivers, added to the devicetree */
+#define DM_TIMING_FDT_MAX	16
+
+/**
+ * struct dm_timing_ent - Timing totals for a uclass or driver
+ *
+ * @name: Name of the uclass or driver
+ * @totals: Totals for all its devices
+ */
+struct dm_timing_ent {
+	const char *name;
+	struct dm_timing_totals totals;
+};
+
+/* Time spent in operations nested inside the current one */
+static ulong nested_us;
+
+/* Set while reading the timer, in case that probes a device */
+static bool reading_timer;
+
+void dm_timing_start(struct dm_timing_state *state)
+{
+	state->active = false;
+
+	/* Writable data is not available before relocation */
+	if (!(gd->flags & GD_FLG_RELOC) || reading_timer)
+		return;
+
+	reading_timer = true;
+	state->start_us = timer_get_boot_us();
+	reading_timer = false;
+	state->outer_nested_us = nested_us;
+	state->active = true;
+	nested_us = 0;
+}
+
+void dm_timing_end(struct dm_timing_state *state, struct udevice *dev,
+		   enum dm_timing_op op)
+{
+	struct dm_dev_timing *timing;
+	ulong total, self;
+
+	if (!state->active)
+		return;
+
+	total = timer_get_boot_us() - state->start_us;
+	self = total > nested_us ? total - nested_us : 0;
+
+	/* The enclosing operation does not count this time as its own */
+	nested_us = state->outer_nested_us + total;
+	if (!dev)
+		return;
+
+	timing = &dev->timing;
+	switch (op) {
+	case DM_TIMING_BIND:
+		timing->bind_us = self;
+		break;
+	case DM_TIMING_PROBE:
+		timing->probe_us = total;
+		timing->probe_self_us = self;
+		break;
+	case DM_TIMING_REMOVE:
+		timing->remove_us = self;
+		break;
+	}
+}
+
+static void add_totals(struct dm_timing_totals *totals,
+		       const struct udevice *dev)
+{
+	const struct dm_dev_timing *timing = &dev->timing;
+
+	totals->count++;
+	totals->bind_us += timing->bind_us;
+	totals->probe_us += timing->probe_us;
+	totals->probe_self_us += timing->probe_self_us;
+	totals->remove_us += timing->remove_us;
+}
+
+void dm_timing_get_uclass(struct uclass *uc, struct dm_timing_totals *totals)
+{
+	struct udevice *dev;
+
+	memset(totals, '\0', sizeof(*totals));
+	uclass_foreach_dev(dev, uc)
+		add_totals(totals, dev);
+}
+
+void dm_timing_get_driver(const struct driver *drv,
+			  struct dm_timing_totals *totals)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+
+	memset(totals, '\0', sizeof(*totals));
+
+	/* Avoid uclass_get() since that creates the uclass if needed */
+	uc = uclass_find(drv->id);
+	if (!uc)
+		return;
+	uclass_foreach_dev(dev, uc) {
+		if (dev->driver == drv)
+			add_totals(totals, dev);
+	}
+}
+
+void dm_timing_reset(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+
+	list_for_each_entry(uc, gd->uclass_root, sibling_node) {
+		uclass_foreach_dev(dev, uc)
+			memset(&dev->timing, '\0', sizeof(dev->timing));
+	}
+}
+
+/**
+ * add_totals_fdt() - Add a node holding timing totals
+ *
+ * If the node cannot be completed, it is removed again.
+ *
+ * @blob: Devicetree to update
+ * @parent: Offset of parent node
+ * @name: Name of the node to add
+ * @totals: Totals to add
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+static int add_totals_fdt(void *blob, int parent, const char *name,
+			  const struct dm_timing_totals *totals)
+{
+	int node, ret;
+
+	node = fdt_add_subnode(blob, parent, name);
+	if (node < 0)
+		return node;
+	ret = fdt_setprop_u32(blob, node, "count", totals->count);
+	if (!ret)
+		ret = fdt_setprop_u32(blob, node, "bind-us", totals->bind_us);
+	if (!ret)
+		ret = fdt_setprop_u32(blob, node, "probe-us", totals->probe_us);
+	if (!ret)
+		ret = fdt_setprop_u32(blob, node, "probe-self-us",
+				      totals->probe_self_us);
+	if (!ret)
+		ret = fdt_setprop_u32(blob, node, "remove-us",
+				      totals->remove_us);
+	if (ret)
+		fdt_del_node(blob, node);
+
+	return ret;
+}
+
+static int h_compare_ent(const void *e1, const void *e2)
+{
+	const struct dm_timing_totals *t1 = &((struct dm_timing_ent *)e1)->totals;
+	const struct dm_timing_totals *t2 = &((struct dm_timing_ent *)e2)->totals;
+	ulong us1 = t1->bind_us + t1->probe_self_us + t1->remove_us;
+	ulong us2 = t2->bind_us + t2->probe_self_us + t2->remove_us;
+
+	return us1 < us2 ? 1 : us1 > us2 ? -1 : 0;
+}
+
+/**
+ * add_list_fdt() - Add a node holding the slowest uclasses or drivers
+ *
+ * @blob: Devicetree to update
+ * @parent: Offset of parent node
+ * @name: Name of the node to add
+ * @ents: Totals for each uclass or driver, sorted by this function
+ * @count: Number of entries in @ents
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+static int add_list_fdt(void *blob, int parent, const char *name,
+			struct dm_timing_ent *ents, int count)
+{
+	int node, ret, i;
+
+	node = fdt_subnode_offset(blob, parent, name);
+	if (node == -FDT_ERR_NOTFOUND)
+		node = fdt_add_subnode(blob, parent, name);
+	if (node < 0)
+		return node;
+
+	qsort(ents, count, sizeof(*ents), h_compare_ent);
+	for (i = 0; i < min(count, DM_TIMING_FDT_MAX); i++) {
+		ret = add_totals_fdt(blob, node, ents[i].name,
+				     &ents[i].totals);
+		/* Drivers in different uclasses can have the same name */
+		if (ret && ret != -FDT_ERR_EXISTS)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * add_dm_fdt() - Add the timing for uclasses and drivers to a devicetree
+ *
+ * @blob: Devicetree to update
+ * @parent: Offset of parent node
+ * @ents: Space for the totals of each uclass or driver
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+static int add_dm_fdt(void *blob, int parent, struct dm_timing_ent *ents)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+	struct uclass *uc;
+	int dm, count, ret;
+
+	dm = fdt_subnode_offset(blob, parent, "dm");
+	if (dm == -FDT_ERR_NOTFOUND)
+		dm = fdt_add_subnode(blob, parent, "dm");
+	if (dm < 0)
+		return dm;
+
+	count = 0;
+	list_for_each_entry(uc, gd->uclass_root, sibling_node) {
+		dm_timing_get_uclass(uc, &ents[count].totals);
+		ents[count].name = uc->uc_drv->name;
+		if (ents[count].totals.count)
+			count++;
+	}
+	ret = add_list_fdt(blob, dm, "uclass", ents, count);
+	if (ret)
+		return ret;
+
+	count = 0;
+	for (entry = drv; entry < drv + n_ents; entry++) {
+		dm_timing_get_driver(entry, &ents[count].totals);
+		ents[count].name = entry->name;
+		if (ents[count].totals.count)
+			count++;
+	}
+
+	return add_list_fdt(blob, dm, "driver", ents, count);
+}
+
+int dm_timing_add_fdt(void *blob, int parent)
+{
+	const int n_drivers = ll_entry_count(struct driver, driver);
+	struct dm_timing_ent *ents;
+	struct uclass *uc;
+	int count, ret;
+
+	/* Allow for either all uclasses or all drivers */
+	count = 0;
+	list_for_each_entry(uc, gd->uclass_root, sibling_node)
+		count++;
+	ents = malloc(max(count, n_drivers) * sizeof(*ents));
+	if (!ents)
+		return -ENOMEM;
+	ret = add_dm_fdt(blob, parent, ents);
+	free(ents);
+
+	/*
+	 * The devicetree is not enlarged, since it may be followed by other
+	 * images. The slowest entries are added first, so leave out the rest.
+	 */
+	if (ret == -FDT_ERR_NOSPACE)
+		return 0;
+
+	return ret;
+}
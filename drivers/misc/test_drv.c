@@ -7,6 +7,7 @@
 #include <dm.h>
 #include <dm/test.h>
 #include <asm/global_data.h>
+#include <linux/delay.h>
 
 /* Records the last testbus device that was removed */
 static struct udevice *testbus_removed;
@@ -141,10 +142,20 @@ static int testfdt_of_to_plat(struct udevice *dev)
 	return 0;
 }
 
+/* Time to wait in each probe of a testfdt device */
+static ulong testfdt_probe_delay_us;
+
+void testfdt_set_probe_delay(ulong delay_us)
+{
+	testfdt_probe_delay_us = delay_us;
+}
+
 static int testfdt_drv_probe(struct udevice *dev)
 {
 	struct dm_test_priv *priv = dev_get_priv(dev);
 
+	if (testfdt_probe_delay_us)
+		udelay(testfdt_probe_delay_us);
 	priv->ping_total += DM_TEST_START_TOTAL;
 
 	/*
@@ -0,0 +1,319 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * eMMC command queue host controller interface (CQHCI) for SDHCI hosts
+ *
+ * Each tag owns a slot in the task descriptor list holding a task descriptor
+ * followed by a link to that tag's transfer descriptors. All tasks of a batch
+ * are issued with one doorbell write and completion is polled.
+ *
+ * Based on the JEDEC eMMC 5.1 specification and the Linux cqhci driver
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <errno.h>
+#include <log.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <sdhci.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <asm/io.h>
+#include <linux/bitops.h>
+#include <linux/dma-mapping.h>
+#include <linux/sizes.h>
+
+/* Registers, relative to the CQHCI base */
+#define CQHCI_CFG		0x08
+#define  CQHCI_ENABLE		BIT(0)
+#define  CQHCI_TASK_DESC_SZ	BIT(8)
+#define CQHCI_CTL		0x0c
+#define  CQHCI_HALT		BIT(0)
+#define  CQHCI_CLEAR_ALL_TASKS	BIT(8)
+#define CQHCI_IS		0x10
+#define  CQHCI_IS_HAC		BIT(0)
+#define  CQHCI_IS_TCC		BIT(1)
+#define  CQHCI_IS_RED		BIT(2)
+#define  CQHCI_IS_TCL		BIT(3)
+#define  CQHCI_IS_MASK		(CQHCI_IS_HAC | CQHCI_IS_TCC | \
+				 CQHCI_IS_RED | CQHCI_IS_TCL)
+#define CQHCI_ISTE		0x14
+#define CQHCI_TDLBA		0x20
+#define CQHCI_TDLBAU		0x24
+#define CQHCI_TDBR		0x28
+#define CQHCI_TCN		0x2c
+#define CQHCI_SSC2		0x44
+#define CQHCI_TERRI		0x54
+#define  CQHCI_TERRI_DATA_TASK(x)	(((x) >> 24) & 0x1f)
+#define  CQHCI_TERRI_DATA_VALID		BIT(31)
+
+/* Descriptor attributes, common to all descriptor types */
+#define CQHCI_VALID		BIT(0)
+#define CQHCI_END		BIT(1)
+#define CQHCI_INT		BIT(2)
+#define CQHCI_ACT(x)		((x) << 3)
+#define  CQHCI_ACT_TRAN		0x4
+#define  CQHCI_ACT_TASK		0x5
+#define  CQHCI_ACT_LINK		0x6
+#define CQHCI_DAT_LENGTH(x)	(((x) & 0xffff) << 16)
+
+/* Task descriptor fields */
+#define CQHCI_DATA_DIR		BIT_ULL(12)
+#define CQHCI_BLK_COUNT(x)	((u64)((x) & 0xffff) << 16)
+#define CQHCI_BLK_ADDR(x)	((u64)(x) << 32)
+
+#define CQHCI_NUM_SLOTS		MMC_CQE_MAX_DEPTH
+#define CQHCI_SEG_LEN		SZ_32K
+#define CQHCI_MAX_SEGS		64
+#define CQHCI_TIMEOUT_MS	10000
+
+static inline u32 cqhci_readl(struct sdhci_host *host, int reg)
+{
+	return readl(host->cqe_base + reg);
+}
+
+static inline void cqhci_writel(struct sdhci_host *host, u32 val, int reg)
+{
+	writel(val, host->cqe_base + reg);
+}
+
+/* Descriptors carry 64-bit addresses when the host does 64-bit ADMA */
+static bool cqhci_dma64(struct sdhci_host *host)
+{
+	return host->flags & USE_ADMA64;
+}
+
+static uint cqhci_desc_len(struct sdhci_host *host)
+{
+	return cqhci_dma64(host) ? 16 : 8;
+}
+
+static void *cqhci_slot(struct sdhci_host *host, int tag)
+{
+	return host->cqe_desc + tag * 2 * cqhci_desc_len(host);
+}
+
+static void *cqhci_trans(struct sdhci_host *host, int tag)
+{
+	return host->cqe_trans + tag * CQHCI_MAX_SEGS * cqhci_desc_len(host);
+}
+
+static void cqhci_set_desc(struct sdhci_host *host, void *desc, u32 attr,
+			   dma_addr_t addr)
+{
+	u32 *word = desc;
+
+	word[0] = cpu_to_le32(attr);
+	word[1] = cpu_to_le32(lower_32_bits(addr));
+	if (cqhci_dma64(host)) {
+		word[2] = cpu_to_le32(upper_32_bits(addr));
+		word[3] = 0;
+	}
+}
+
+static int cqhci_alloc(struct sdhci_host *host)
+{
+	uint len = cqhci_desc_len(host);
+
+	if (!host->cqe_desc) {
+		/* The task descriptor list must be 1KiB-aligned */
+		host->cqe_desc = memalign(SZ_1K, CQHCI_NUM_SLOTS * 2 * len);
+		if (!host->cqe_desc)
+			return -ENOMEM;
+	}
+	if (!host->cqe_trans) {
+		host->cqe_trans = memalign(ARCH_DMA_MINALIGN, CQHCI_NUM_SLOTS *
+					   CQHCI_MAX_SEGS * len);
+		if (!host->cqe_trans)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int cqhci_halt(struct sdhci_host *host)
+{
+	ulong start = get_timer(0);
+
+	cqhci_writel(host, CQHCI_HALT, CQHCI_CTL);
+	while (!(cqhci_readl(host, CQHCI_CTL) & CQHCI_HALT)) {
+		if (get_timer(start) > CQHCI_TIMEOUT_MS)
+			return -ETIMEDOUT;
+	}
+	cqhci_writel(host, CQHCI_IS_HAC, CQHCI_IS);
+
+	return 0;
+}
+
+int sdhci_cqe_enable(struct sdhci_host *host, bool enable)
+{
+	dma_addr_t addr;
+	u32 cfg;
+	u8 ctrl;
+	int ret;
+
+	if (!host->cqe_base)
+		return -ENOSYS;
+
+	if (!enable) {
+		ret = cqhci_halt(host);
+		cqhci_writel(host, 0, CQHCI_CFG);
+		cqhci_writel(host, 0, CQHCI_CTL);
+		sdhci_writel(host, SDHCI_INT_DATA_MASK | SDHCI_INT_CMD_MASK,
+			     SDHCI_INT_ENABLE);
+
+		return ret;
+	}
+
+	ret = cqhci_alloc(host);
+	if (ret)
+		return ret;
+
+	/* CQHCI moves data with ADMA2 in 512-byte blocks */
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	ctrl |= cqhci_dma64(host) ? SDHCI_CTRL_ADMA64 : SDHCI_CTRL_ADMA32;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+	sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
+					    MMC_MAX_BLOCK_LEN),
+		     SDHCI_BLOCK_SIZE);
+	sdhci_writel(host, SDHCI_INT_CQE | SDHCI_INT_ERROR_MASK,
+		     SDHCI_INT_ENABLE);
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+
+	cfg = cqhci_dma64(host) ? CQHCI_TASK_DESC_SZ : 0;
+	cqhci_writel(host, cfg, CQHCI_CFG);
+
+	addr = virt_to_phys(host->cqe_desc);
+	cqhci_writel(host, lower_32_bits(addr), CQHCI_TDLBA);
+	cqhci_writel(host, upper_32_bits(addr), CQHCI_TDLBAU);
+	cqhci_writel(host, host->mmc->rca, CQHCI_SSC2);
+
+	/* Completion is polled, so only the status bits are enabled */
+	cqhci_writel(host, CQHCI_IS_MASK, CQHCI_ISTE);
+	cqhci_writel(host, CQHCI_IS_MASK, CQHCI_IS);
+	cqhci_writel(host, cfg | CQHCI_ENABLE, CQHCI_CFG);
+	cqhci_writel(host, 0, CQHCI_CTL);
+
+	return 0;
+}
+
+static int cqhci_prep_task(struct sdhci_host *host, struct mmc_cqe_task *task,
+			   dma_addr_t *dma)
+{
+	uint size = task->blkcnt * MMC_MAX_BLOCK_LEN;
+	uint nsegs = DIV_ROUND_UP(size, CQHCI_SEG_LEN);
+	uint len = cqhci_desc_len(host);
+	void *slot = cqhci_slot(host, task->tag);
+	void *trans = cqhci_trans(host, task->tag);
+	dma_addr_t addr;
+	u64 attr;
+	uint i;
+
+	if (!task->blkcnt || nsegs > CQHCI_MAX_SEGS ||
+	    task->tag >= CQHCI_NUM_SLOTS)
+		return -EINVAL;
+
+	*dma = dma_map_single(task->buf, size, task->write ? DMA_TO_DEVICE :
+			      DMA_FROM_DEVICE);
+	for (i = 0, addr = *dma; i < nsegs; i++, addr += CQHCI_SEG_LEN) {
+		uint seg = min_t(uint, size - i * CQHCI_SEG_LEN,
+				 CQHCI_SEG_LEN);
+
+		cqhci_set_desc(host, trans + i * len, CQHCI_VALID |
+			       (i == nsegs - 1 ? CQHCI_END : 0) |
+			       CQHCI_ACT(CQHCI_ACT_TRAN) |
+			       CQHCI_DAT_LENGTH(seg), addr);
+	}
+
+	attr = CQHCI_VALID | CQHCI_END | CQHCI_INT | CQHCI_ACT(CQHCI_ACT_TASK) |
+		CQHCI_BLK_COUNT(task->blkcnt) | CQHCI_BLK_ADDR(task->start);
+	if (!task->write)
+		attr |= CQHCI_DATA_DIR;
+	memset(slot, '\0', len);
+	*(u64 *)slot = cpu_to_le64(attr);
+	cqhci_set_desc(host, slot + len, CQHCI_VALID | CQHCI_ACT(CQHCI_ACT_LINK),
+		       virt_to_phys(trans));
+
+	flush_dcache_range((ulong)trans, ALIGN((ulong)trans + nsegs * len,
+					       ARCH_DMA_MINALIGN));
+
+	return 0;
+}
+
+int sdhci_cqe_run(struct sdhci_host *host, struct mmc_cqe_task *tasks,
+		  int count)
+{
+	uint len = cqhci_desc_len(host);
+	dma_addr_t dma[CQHCI_NUM_SLOTS];
+	u32 issued = 0, done = 0;
+	int ret = 0, err_tag = -1;
+	ulong start;
+	int i;
+
+	if (count > CQHCI_NUM_SLOTS)
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		tasks[i].status = cqhci_prep_task(host, &tasks[i], &dma[i]);
+		if (!tasks[i].status)
+			issued |= BIT(tasks[i].tag);
+	}
+	if (!issued)
+		return 0;
+	flush_dcache_range((ulong)host->cqe_desc,
+			   ALIGN((ulong)host->cqe_desc +
+				 CQHCI_NUM_SLOTS * 2 * len, ARCH_DMA_MINALIGN));
+
+	/* Let the card fetch and order all of the tasks itself */
+	cqhci_writel(host, issued, CQHCI_TDBR);
+
+	start = get_timer(0);
+	while (done != issued) {
+		u32 status = cqhci_readl(host, CQHCI_IS);
+		u32 tcn = cqhci_readl(host, CQHCI_TCN);
+
+		if (tcn) {
+			cqhci_writel(host, tcn, CQHCI_TCN);
+			done |= tcn;
+		}
+		if (status & (CQHCI_IS_RED | CQHCI_IS_TCL)) {
+			u32 terri = cqhci_readl(host, CQHCI_TERRI);
+
+			if (terri & CQHCI_TERRI_DATA_VALID)
+				err_tag = CQHCI_TERRI_DATA_TASK(terri);
+			log_debug("Task error: IS %x TERRI %x\n", status,
+				  terri);
+			ret = -EIO;
+			break;
+		}
+		cqhci_writel(host, status, CQHCI_IS);
+		if (get_timer(start) > CQHCI_TIMEOUT_MS) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	if (ret) {
+		/* Drop whatever is still pending so the queue is reusable */
+		cqhci_halt(host);
+		cqhci_writel(host, CQHCI_CLEAR_ALL_TASKS | CQHCI_HALT,
+			     CQHCI_CTL);
+		cqhci_writel(host, CQHCI_IS_MASK, CQHCI_IS);
+		cqhci_writel(host, 0, CQHCI_CTL);
+	}
+
+	for (i = 0; i < count; i++) {
+		struct mmc_cqe_task *task = &tasks[i];
+
+		if (task->status)
+			continue;
+		dma_unmap_single(dma[i], task->blkcnt * MMC_MAX_BLOCK_LEN,
+				 task->write ? DMA_TO_DEVICE : DMA_FROM_DEVICE);
+		if (task->tag == err_tag || !(done & BIT(task->tag)))
+			task->status = ret ? ret : -EIO;
+	}
+
+	/* A timeout leaves the engine state unknown */
+	return ret == -ETIMEDOUT ? ret : 0;
+}
@@ -160,6 +160,51 @@ int mmc_hs400_prepare_ddr(struct mmc *mmc)
 	return dm_mmc_hs400_prepare_ddr(mmc->dev);
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static bool dm_mmc_cqe_present(struct udevice *dev)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->cqe_present)
+		return true;
+	return ops->cqe_present(dev);
+}
+
+bool mmc_cqe_present(struct mmc *mmc)
+{
+	return dm_mmc_cqe_present(mmc->dev);
+}
+
+static int dm_mmc_cqe_enable(struct udevice *dev, bool enable)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->cqe_enable)
+		return -ENOSYS;
+	return ops->cqe_enable(dev, enable);
+}
+
+int mmc_cqe_enable(struct mmc *mmc, bool enable)
+{
+	return dm_mmc_cqe_enable(mmc->dev, enable);
+}
+
+static int dm_mmc_cqe_run(struct udevice *dev, struct mmc_cqe_task *tasks,
+			  int count)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->cqe_run)
+		return -ENOSYS;
+	return ops->cqe_run(dev, tasks, count);
+}
+
+int mmc_cqe_run(struct mmc *mmc, struct mmc_cqe_task *tasks, int count)
+{
+	return dm_mmc_cqe_run(mmc->dev, tasks, count);
+}
+#endif
+
 static int dm_mmc_host_power_cycle(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -266,6 +311,9 @@ int mmc_of_parse(struct udevice *dev, struct mmc_config *cfg)
 			cfg->host_caps |= MMC_CAP_NEEDS_POLL;
 	}
 
+	if (dev_read_bool(dev, "supports-cqe"))
+		cfg->host_caps |= MMC_CAP_CQE;
+
 	if (dev_read_bool(dev, "no-1-8-v")) {
 		cfg->host_caps &= ~(UHS_CAPS | MMC_MODE_HS200 |
 				    MMC_MODE_HS400 | MMC_MODE_HS400_ES);
@@ -398,11 +398,60 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 }
 #endif
 
+/**
+ * mmc_can_cmd23() - check whether multi-block transfers can use CMD23
+ *
+ * With CMD23 (SET_BLOCK_COUNT) the number of blocks is given up front, so the
+ * transfer ends by itself and no CMD12 (STOP_TRANSMISSION) is needed. Both
+ * the host and the card must support it: SD cards report it in the SCR and
+ * eMMC devices support it from version 4.3.
+ *
+ * @mmc:	MMC device
+ * Return: true if CMD23 can be used
+ */
+static bool mmc_can_cmd23(struct mmc *mmc)
+{
+	if (!(mmc->cfg->host_caps & MMC_CAP_CMD23))
+		return false;
+
+	if (IS_SD(mmc))
+		return mmc->scr[0] & SD_CMD23_SUPPORT;
+
+	return mmc->version >= MMC_VERSION_4_3;
+}
+
+/* Send CMD12 (STOP_TRANSMISSION) to end a multi-block read */
+static int mmc_read_stop(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int ret;
+
+	cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+	cmd.cmdarg = 0;
+	cmd.resp_type = MMC_RSP_R1b;
+	ret = mmc_send_cmd(mmc, &cmd, NULL);
+#if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
+	if (ret)
+		pr_err("mmc fail to send stop cmd\n");
+#endif
+
+	return ret;
+}
+
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 			   lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	bool sbc = blkcnt > 1 && mmc_can_cmd23(mmc);
+
+	if (sbc) {
+		cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+		cmd.cmdarg = blkcnt & 0xffff;
+		cmd.resp_type = MMC_RSP_R1;
+		if (mmc_send_cmd(mmc, &cmd, NULL))
+			return 0;
+	}
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -421,21 +470,19 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	data.blocksize = mmc->read_bl_len;
 	data.flags = MMC_DATA_READ;
 
-	if (mmc_send_cmd(mmc, &cmd, &data))
+	if (mmc_send_cmd(mmc, &cmd, &data)) {
+		/*
+		 * A failed transfer does not end by itself, even with CMD23,
+		 * so stop it to put the card back in the transfer state
+		 */
+		if (blkcnt > 1)
+			mmc_read_stop(mmc);
 		return 0;
-
-	if (blkcnt > 1) {
-		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
-		cmd.cmdarg = 0;
-		cmd.resp_type = MMC_RSP_R1b;
-		if (mmc_send_cmd(mmc, &cmd, NULL)) {
-#if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
-			pr_err("mmc fail to send stop cmd\n");
-#endif
-			return 0;
-		}
 	}
 
+	if (blkcnt > 1 && !sbc && mmc_read_stop(mmc))
+		return 0;
+
 	return blkcnt;
 }
 
@@ -492,7 +539,17 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 	}
 
+	if (mmc_cqe_usable(mmc, blkcnt)) {
+		long done = mmc_cqe_rw(mmc, start, blkcnt, dst, false);
+
+		if (done >= 0)
+			return done == blkcnt ? blkcnt : 0;
+	}
+
 	b_max = mmc_get_b_max(mmc, dst, blkcnt);
+	/* CMD23 carries a 16-bit block count */
+	if (mmc_can_cmd23(mmc))
+		b_max = min_t(uint, b_max, 0xffff);
 
 	do {
 		cur = (blocks_todo > b_max) ? b_max : blocks_todo;
@@ -2312,6 +2369,11 @@ static int mmc_startup_v4(struct mmc *mmc)
 	if (mmc->version >= MMC_VERSION_4_5)
 		mmc->gen_cmd6_time = ext_csd[EXT_CSD_GENERIC_CMD6_TIME];
 
+	mmc->cmdq_depth = 0;
+	if (mmc->version >= MMC_VERSION_5_1 &&
+	    (ext_csd[EXT_CSD_CMDQ_SUPPORT] & 0x1))
+		mmc->cmdq_depth = (ext_csd[EXT_CSD_CMDQ_DEPTH] & 0x1f) + 1;
+
 	/* The partition data may be non-zero but it is only
 	 * effective if PARTITION_SETTING_COMPLETED is set in
 	 * EXT_CSD, so ignore any data if this bit is not set,
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * eMMC command queueing
+ *
+ * Large transfers are split into tasks which are queued on the host's command
+ * queue engine together, so the card can fetch and reorder them internally
+ * instead of seeing one multi-block command at a time.
+ */
+
+#define LOG_CATEGORY UCLASS_MMC
+
+#include <common.h>
+#include <dm.h>
+#include <log.h>
+#include <mmc.h>
+#include <linux/kernel.h>
+#include "mmc_private.h"
+
+/* Blocks per task: 128KiB keeps a deep queue busy for typical image sizes */
+#define MMC_CQE_TASK_BLKS	256
+
+/* Attempts at taking the card out of queue mode before resetting it */
+#define MMC_CQE_LEAVE_TRIES	3
+
+static uint mmc_cqe_task_blks(struct mmc *mmc)
+{
+	return min_t(uint, MMC_CQE_TASK_BLKS, mmc->cfg->b_max);
+}
+
+bool mmc_cqe_usable(struct mmc *mmc, lbaint_t blkcnt)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+
+	if (!mmc->cmdq_depth || !(mmc->host_caps & MMC_CAP_CQE))
+		return false;
+	/* Tasks are addressed in 512-byte blocks */
+	if (!mmc->high_capacity || mmc->read_bl_len != MMC_MAX_BLOCK_LEN)
+		return false;
+	if (!ops->cqe_enable || !ops->cqe_run)
+		return false;
+	/* "supports-cqe" is no use if the host has no engine to drive */
+	if (!mmc_cqe_present(mmc))
+		return false;
+
+	/* Entering and leaving queue mode costs two CMD6s */
+	return blkcnt > mmc_cqe_task_blks(mmc);
+}
+
+static int mmc_cqe_set_mode(struct mmc *mmc, bool enable)
+{
+	int ret;
+
+	if (!enable) {
+		ret = mmc_cqe_enable(mmc, false);
+		if (ret)
+			return ret;
+	}
+
+	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN,
+			 enable);
+	if (ret)
+		return ret;
+
+	if (enable) {
+		ret = mmc_cqe_enable(mmc, true);
+		if (ret) {
+			mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
+				   EXT_CSD_CMDQ_MODE_EN, 0);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+long mmc_cqe_rw(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt, void *buf,
+		bool write)
+{
+	struct mmc_cqe_task tasks[MMC_CQE_MAX_DEPTH];
+	uint task_blks = mmc_cqe_task_blks(mmc);
+	int depth = min_t(int, mmc->cmdq_depth, MMC_CQE_MAX_DEPTH);
+	lbaint_t done = 0;
+	int ret, i;
+
+	ret = mmc_cqe_set_mode(mmc, true);
+	if (ret) {
+		log_debug("Cannot enter queue mode (err=%d)\n", ret);
+		return ret;
+	}
+
+	while (done < blkcnt) {
+		lbaint_t pos = done;
+		int count;
+
+		for (count = 0; count < depth && pos < blkcnt; count++) {
+			struct mmc_cqe_task *task = &tasks[count];
+
+			task->start = start + pos;
+			task->blkcnt = min_t(lbaint_t, task_blks, blkcnt - pos);
+			task->buf = buf + pos * MMC_MAX_BLOCK_LEN;
+			task->write = write;
+			task->tag = count;
+			task->status = -EINPROGRESS;
+			pos += task->blkcnt;
+		}
+
+		ret = mmc_cqe_run(mmc, tasks, count);
+		if (ret) {
+			log_debug("Queue failed (err=%d)\n", ret);
+			break;
+		}
+
+		/* Only report the blocks before the first failed task */
+		for (i = 0; i < count && !tasks[i].status; i++)
+			done += tasks[i].blkcnt;
+		if (i < count) {
+			log_debug("Task %d failed (err=%d)\n", i,
+				  tasks[i].status);
+			break;
+		}
+	}
+
+	for (i = 0; i < MMC_CQE_LEAVE_TRIES; i++) {
+		ret = mmc_cqe_set_mode(mmc, false);
+		if (!ret)
+			return done;
+		log_debug("Cannot leave queue mode (err=%d)\n", ret);
+	}
+
+	/*
+	 * The card would reject every normal command from now on, so start
+	 * again from reset. The blocks already transferred are still good.
+	 */
+	mmc->has_init = 0;
+	ret = mmc_init(mmc);
+	if (ret) {
+		log_err("Cannot reset card after queue mode (err=%d)\n", ret);
+		return ret;
+	}
+
+	return done;
+}
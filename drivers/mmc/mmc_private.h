@@ -69,6 +69,48 @@ static inline ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start,
 
 #endif /* CONFIG_SPL_BUILD */
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+/**
+ * mmc_cqe_usable() - Check whether a transfer should use the command queue
+ *
+ * @mmc:	MMC device
+ * @blkcnt:	Number of blocks in the transfer
+ * Return: true if both card and host support command queueing and the
+ *	transfer is large enough to benefit from it
+ */
+bool mmc_cqe_usable(struct mmc *mmc, lbaint_t blkcnt);
+
+/**
+ * mmc_cqe_rw() - Transfer blocks as a set of queued tasks
+ *
+ * The card is switched into command-queue mode for the duration of the
+ * transfer, which is split into tasks that are queued to the host's command
+ * queue engine in batches of up to the card's queue depth.
+ *
+ * @mmc:	MMC device
+ * @start:	First block to transfer
+ * @blkcnt:	Number of blocks to transfer
+ * @buf:	Buffer to read into or write from
+ * @write:	true to write, false to read
+ * Return: number of blocks transferred before the first error, or -ve if
+ *	queue mode could not be entered, in which case the caller may fall
+ *	back to normal commands
+ */
+long mmc_cqe_rw(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt, void *buf,
+		bool write);
+#else
+static inline bool mmc_cqe_usable(struct mmc *mmc, lbaint_t blkcnt)
+{
+	return false;
+}
+
+static inline long mmc_cqe_rw(struct mmc *mmc, lbaint_t start,
+			      lbaint_t blkcnt, void *buf, bool write)
+{
+	return -ENOSYS;
+}
+#endif
+
 #ifdef CONFIG_MMC_TRACE
 void mmmc_trace_before_send(struct mmc *mmc, struct mmc_cmd *cmd);
 void mmmc_trace_after_send(struct mmc *mmc, struct mmc_cmd *cmd, int ret);
@@ -222,6 +222,13 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
+	if (mmc_cqe_usable(mmc, blkcnt) && start + blkcnt <= block_dev->lba) {
+		long done = mmc_cqe_rw(mmc, start, blkcnt, (void *)src, true);
+
+		if (done >= 0)
+			return done == blkcnt ? blkcnt : 0;
+	}
+
 	do {
 		cur = (blocks_todo > mmc->cfg->b_max) ?
 			mmc->cfg->b_max : blocks_todo;
@@ -31,6 +31,12 @@ struct sandbox_mmc_priv {
 	char *buf;
 	int csize;	/* CSIZE value to report */
 	int size;
+	uint blk_count;	/* Block count set by CMD23, 0 if none */
+	bool cmdq_mode;	/* Card is in command-queue mode */
+	bool no_cqe;	/* Host reports that it has no queue engine */
+	bool cqe_on;	/* Host command queue engine is enabled */
+	uint cqe_tasks;	/* Number of tasks run through the engine */
+	uint cqe_max_queued;	/* Largest number of tasks queued at once */
 };
 
 /**
@@ -45,6 +51,10 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
 	static ulong erase_start, erase_end;
 
+	/* Normal commands cannot be sent while the queue engine is on */
+	if (priv->cqe_on)
+		return -EBUSY;
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		memset(cmd->response, '\0', sizeof(cmd->response));
@@ -57,7 +67,7 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		cmd->response[0] = 0xaa;
 		break;
 	case MMC_CMD_SEND_STATUS:
-		cmd->response[0] = MMC_STATUS_RDY_FOR_DATA;
+		cmd->response[0] = MMC_STATUS_RDY_FOR_DATA | MMC_STATE_TRANS;
 		break;
 	case MMC_CMD_SELECT_CARD:
 		break;
@@ -69,8 +79,12 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		cmd->response[3] = 0;
 		break;
 	case SD_CMD_SWITCH_FUNC: {
-		if (!data)
+		/* Without data this is an eMMC EXT_CSD write */
+		if (!data) {
+			if (((cmd->cmdarg >> 16) & 0xff) == EXT_CSD_CMDQ_MODE_EN)
+				priv->cmdq_mode = (cmd->cmdarg >> 8) & 1;
 			break;
+		}
 		u32 *resp = (u32 *)data->dest;
 		resp[3] = 0;
 		resp[7] = cpu_to_be32(SD_HIGHSPEED_BUSY);
@@ -78,8 +92,18 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 			resp[4] = (cmd->cmdarg & 0xF) << 24;
 		break;
 	}
-	case MMC_CMD_READ_SINGLE_BLOCK:
+	case MMC_CMD_SET_BLOCK_COUNT:
+		priv->blk_count = cmd->cmdarg & 0xffff;
+		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
+		/* A pre-defined transfer must match the CMD23 block count */
+		if (priv->blk_count && priv->blk_count != data->blocks) {
+			priv->blk_count = 0;
+			return -EIO;
+		}
+		priv->blk_count = 0;
+		fallthrough;
+	case MMC_CMD_READ_SINGLE_BLOCK:
 		memcpy(data->dest, &priv->buf[cmd->cmdarg * data->blocksize],
 		       data->blocks * data->blocksize);
 		break;
@@ -118,7 +142,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, with CMD23 support */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_CMD23_SUPPORT);
 		break;
 	}
 	default:
@@ -139,10 +164,87 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 	return 1;
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static bool sandbox_mmc_cqe_present(struct udevice *dev)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	return !priv->no_cqe;
+}
+
+static int sandbox_mmc_cqe_enable(struct udevice *dev, bool enable)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	if (enable && !priv->cmdq_mode)
+		return -EPERM;
+	priv->cqe_on = enable;
+
+	return 0;
+}
+
+/**
+ * sandbox_mmc_cqe_run() - Emulate a command queue engine
+ *
+ * Tasks are executed last-queued first, as a card which reorders its queue
+ * might do, so that the caller cannot rely on completion order.
+ */
+static int sandbox_mmc_cqe_run(struct udevice *dev, struct mmc_cqe_task *tasks,
+			       int count)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	int i;
+
+	if (!priv->cqe_on)
+		return -EPERM;
+	priv->cqe_max_queued = max_t(uint, priv->cqe_max_queued, count);
+
+	for (i = count - 1; i >= 0; i--) {
+		struct mmc_cqe_task *task = &tasks[i];
+		ulong offset = task->start * 512;
+		ulong size = task->blkcnt * 512;
+
+		if (offset + size > priv->size) {
+			task->status = -EIO;
+			continue;
+		}
+		if (task->write)
+			memcpy(&priv->buf[offset], task->buf, size);
+		else
+			memcpy(task->buf, &priv->buf[offset], size);
+		task->status = 0;
+		priv->cqe_tasks++;
+	}
+
+	return 0;
+}
+
+void sandbox_mmc_get_cqe_stats(struct udevice *dev, uint *tasksp,
+			       uint *max_queuedp)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	*tasksp = priv->cqe_tasks;
+	*max_queuedp = priv->cqe_max_queued;
+}
+
+void sandbox_mmc_set_cqe_present(struct udevice *dev, bool present)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	priv->no_cqe = !present;
+}
+#endif
+
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	.cqe_present = sandbox_mmc_cqe_present,
+	.cqe_enable = sandbox_mmc_cqe_enable,
+	.cqe_run = sandbox_mmc_cqe_run,
+#endif
 };
 
 static int sandbox_mmc_of_to_plat(struct udevice *dev)
@@ -157,6 +259,9 @@ static int sandbox_mmc_of_to_plat(struct udevice *dev)
 	ret = mmc_of_parse(dev, cfg);
 	if (ret)
 		return ret;
+	cfg->host_caps |= MMC_CAP_CMD23;
+	if (CONFIG_IS_ENABLED(MMC_CQE))
+		cfg->host_caps |= MMC_CAP_CQE;
 	blk = mmc_get_blk_desc(&plat->mmc);
 	if (blk)
 		blk->removable = !(cfg->host_caps & MMC_CAP_NONREMOVABLE);
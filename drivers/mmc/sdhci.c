@@ -71,11 +71,14 @@ static void sdhci_transfer_pio(struct sdhci_host *host, struct mmc_data *data)
 }
 
 #if (CONFIG_IS_ENABLED(MMC_SDHCI_SDMA) || CONFIG_IS_ENABLED(MMC_SDHCI_ADMA))
+/*
+ * Map the data buffer and fill in the ADMA descriptor table. This does not
+ * touch the controller, so it can be done while the card is still busy with
+ * the previous command.
+ */
 static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 			      int *is_aligned, int trans_bytes)
 {
-	dma_addr_t dma_addr;
-	unsigned char ctrl;
 	void *buf;
 
 	if (data->flags == MMC_DATA_READ)
@@ -83,14 +86,6 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 	else
 		buf = (void *)data->src;
 
-	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
-	ctrl &= ~SDHCI_CTRL_DMA_MASK;
-	if (host->flags & USE_ADMA64)
-		ctrl |= SDHCI_CTRL_ADMA64;
-	else if (host->flags & USE_ADMA)
-		ctrl |= SDHCI_CTRL_ADMA32;
-	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
-
 	if (host->flags & USE_SDMA &&
 	    (host->force_align_buffer ||
 	     (host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR &&
@@ -104,15 +99,33 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 	host->start_addr = dma_map_single(buf, trans_bytes,
 					  mmc_get_dma_dir(data));
 
+#if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
+	if (host->flags & (USE_ADMA | USE_ADMA64))
+		sdhci_prepare_adma_table(host->adma_desc_table, data,
+					 host->start_addr);
+#endif
+}
+
+/* Point the controller at the buffer set up by sdhci_prepare_dma() */
+static void sdhci_start_dma(struct sdhci_host *host)
+{
+	dma_addr_t dma_addr;
+	unsigned char ctrl;
+
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	if (host->flags & USE_ADMA64)
+		ctrl |= SDHCI_CTRL_ADMA64;
+	else if (host->flags & USE_ADMA)
+		ctrl |= SDHCI_CTRL_ADMA32;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+
 	if (host->flags & USE_SDMA) {
 		dma_addr = dev_phys_to_bus(mmc_to_dev(host->mmc), host->start_addr);
 		sdhci_writel(host, dma_addr, SDHCI_DMA_ADDRESS);
 	}
 #if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
 	else if (host->flags & (USE_ADMA | USE_ADMA64)) {
-		sdhci_prepare_adma_table(host->adma_desc_table, data,
-					 host->start_addr);
-
 		sdhci_writel(host, lower_32_bits(host->adma_addr),
 			     SDHCI_ADMA_ADDRESS);
 		if (host->flags & USE_ADMA64)
@@ -121,10 +134,23 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 	}
 #endif
 }
+
+/* Release the buffer mapped by sdhci_prepare_dma() */
+static void sdhci_unmap_dma(struct sdhci_host *host, struct mmc_data *data)
+{
+	dma_unmap_single(host->start_addr, data->blocks * data->blocksize,
+			 mmc_get_dma_dir(data));
+}
 #else
 static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 			      int *is_aligned, int trans_bytes)
 {}
+
+static void sdhci_unmap_dma(struct sdhci_host *host, struct mmc_data *data)
+{}
+
+static void sdhci_start_dma(struct sdhci_host *host)
+{}
 #endif
 static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
 {
@@ -177,10 +203,7 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
 		}
 	} while (!(stat & SDHCI_INT_DATA_END));
 
-#if (CONFIG_IS_ENABLED(MMC_SDHCI_SDMA) || CONFIG_IS_ENABLED(MMC_SDHCI_ADMA))
-	dma_unmap_single(host->start_addr, data->blocks * data->blocksize,
-			 mmc_get_dma_dir(data));
-#endif
+	sdhci_unmap_dma(host, data);
 
 	return 0;
 }
@@ -220,6 +243,17 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	/* Timeout unit - ms */
 	static unsigned int cmd_timeout = SDHCI_CMD_DEFAULT_TIMEOUT;
 
+	/*
+	 * Set up the DMA buffer before waiting for the controller, so that
+	 * cache maintenance and descriptor setup overlap with the card
+	 * finishing the previous command.
+	 */
+	if (data) {
+		trans_bytes = data->blocks * data->blocksize;
+		if (host->flags & USE_DMA)
+			sdhci_prepare_dma(host, data, &is_aligned, trans_bytes);
+	}
+
 	mask = SDHCI_CMD_INHIBIT | SDHCI_DATA_INHIBIT;
 
 	/* We shouldn't wait for data inihibit for stop commands, even
@@ -238,6 +272,8 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 				       cmd_timeout);
 			} else {
 				puts("timeout.\n");
+				if (data && (host->flags & USE_DMA))
+					sdhci_unmap_dma(host, data);
 				return -ECOMM;
 			}
 		}
@@ -276,7 +312,6 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 
 		if (!(host->quirks & SDHCI_QUIRK_SUPPORT_SINGLE))
 			mode = SDHCI_TRNS_BLK_CNT_EN;
-		trans_bytes = data->blocks * data->blocksize;
 		if (data->blocks > 1)
 			mode |= SDHCI_TRNS_MULTI | SDHCI_TRNS_BLK_CNT_EN;
 
@@ -285,7 +320,7 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 
 		if (host->flags & USE_DMA) {
 			mode |= SDHCI_TRNS_DMA;
-			sdhci_prepare_dma(host, data, &is_aligned, trans_bytes);
+			sdhci_start_dma(host);
 		}
 
 		sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
@@ -837,6 +872,31 @@ static int sdhci_set_enhanced_strobe(struct udevice *dev)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_SDHCI_CQE)
+static bool sdhci_dm_cqe_present(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	return host->cqe_base;
+}
+
+static int sdhci_dm_cqe_enable(struct udevice *dev, bool enable)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+	return sdhci_cqe_enable(mmc->priv, enable);
+}
+
+static int sdhci_dm_cqe_run(struct udevice *dev, struct mmc_cqe_task *tasks,
+			    int count)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+	return sdhci_cqe_run(mmc->priv, tasks, count);
+}
+#endif
+
 const struct dm_mmc_ops sdhci_ops = {
 	.send_cmd	= sdhci_send_command,
 	.set_ios	= sdhci_set_ios,
@@ -849,6 +909,11 @@ const struct dm_mmc_ops sdhci_ops = {
 #if CONFIG_IS_ENABLED(MMC_HS400_ES_SUPPORT)
 	.set_enhanced_strobe = sdhci_set_enhanced_strobe,
 #endif
+#if CONFIG_IS_ENABLED(MMC_SDHCI_CQE)
+	.cqe_present	= sdhci_dm_cqe_present,
+	.cqe_enable	= sdhci_dm_cqe_enable,
+	.cqe_run	= sdhci_dm_cqe_run,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
@@ -1007,6 +1072,9 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 	if (caps_1 & SDHCI_SUPPORT_DDR50)
 		cfg->host_caps |= MMC_CAP(UHS_DDR50);
 
+	if (!(host->quirks & SDHCI_QUIRK_NO_CMD23))
+		cfg->host_caps |= MMC_CAP_CMD23;
+
 	if (host->host_caps)
 		cfg->host_caps |= host->host_caps;
 
@@ -18,15 +18,35 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		CONFIG_NVME_IO_QUEUE_DEPTH
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
-#define NVME_CQ_ALLOCATION	ALIGN(NVME_CQ_SIZE(NVME_Q_DEPTH), \
-				      ARCH_DMA_MINALIGN)
+#define NVME_CQ_ALLOCATION(depth)	ALIGN(NVME_CQ_SIZE(depth), \
+					      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
+
+/**
+ * struct nvme_io_batch - commands outstanding on the I/O queue
+ *
+ * Each outstanding read/write command is identified by a tag, which is used
+ * both as its command ID and as the index of its slot in the PRP list pool.
+ *
+ * @cmd:	Template for the next command to queue
+ * @tag_slba:	Starting LBA of the command owning each tag
+ * @free_tags:	Bitmap of tags which are not in use
+ * @inflight:	Number of commands submitted but not yet completed
+ * @err_slba:	Lowest starting LBA of a failed command, or the end LBA of the
+ *		transfer if none failed
+ */
+struct nvme_io_batch {
+	struct nvme_command cmd;
+	u64 tag_slba[NVME_Q_DEPTH];
+	ulong free_tags;
+	int inflight;
+	u64 err_slba;
+};
 
 static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 {
@@ -45,12 +65,12 @@ static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+static int nvme_setup_prps(struct nvme_dev *dev, int slot, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
-	u64 *prp_pool;
+	u64 *prp_list, *prp_pool;
 	int length = total_len;
 	int i, nprps;
 	u32 prps_per_page = page_size >> 3;
@@ -74,41 +94,61 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	nprps = DIV_ROUND_UP(length, page_size);
 	num_pages = DIV_ROUND_UP(nprps - 1, prps_per_page - 1);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
+	if (num_pages * page_size > dev->prp_slot_size) {
+		printf("Error: transfer too large for PRP list (%d bytes)\n",
+		       total_len);
+		return -E2BIG;
 	}
 
-	prp_pool = dev->prp_pool;
+	prp_list = (void *)dev->prp_pool + slot * dev->prp_slot_size;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
 		if ((i == (prps_per_page - 1)) && nprps > 1) {
 			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
+	flush_dcache_range((ulong)prp_list, (ulong)prp_list +
 			   num_pages * page_size);
 
 	return 0;
 }
 
+/**
+ * nvme_alloc_prp_pool() - allocate the PRP lists used by the I/O queue
+ *
+ * One PRP list slot is reserved for each I/O queue entry, large enough to
+ * describe a maximum-size transfer starting at any offset within a page. The
+ * pool is allocated once, so read/write commands never allocate memory.
+ *
+ * @dev:	NVMe device, with page_size and max_transfer_shift already set
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int nvme_alloc_prp_pool(struct nvme_dev *dev)
+{
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = page_size >> 3;
+	u32 nprps, num_pages;
+
+	nprps = DIV_ROUND_UP(1ULL << dev->max_transfer_shift, page_size);
+	num_pages = DIV_ROUND_UP(nprps, prps_per_page - 1);
+
+	dev->prp_slot_size = num_pages * page_size;
+	dev->prp_pool = memalign(page_size, dev->prp_slot_size * dev->q_depth);
+	if (!dev->prp_pool)
+		return -ENOMEM;
+
+	return 0;
+}
+
 static __le16 nvme_get_cmd_id(void)
 {
 	static unsigned short cmdid;
@@ -125,20 +165,28 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 	 * as the cache line should never become dirty.
 	 */
 	ulong start = (ulong)&nvmeq->cqes[0];
-	ulong stop = start + NVME_CQ_ALLOCATION;
+	ulong stop = start + NVME_CQ_ALLOCATION(nvmeq->q_depth);
 
 	invalidate_dcache_range(start, stop);
 
 	return readw(&(nvmeq->cqes[index].status));
 }
 
+static struct nvme_ops *nvme_get_ops(struct nvme_dev *dev)
+{
+	return (struct nvme_ops *)dev->udev->driver->ops;
+}
+
 /**
- * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ * nvme_queue_cmd() - copy a command into a queue without ringing the doorbell
+ *
+ * Controllers with their own submit_cmd() operation are handed the command
+ * straight away.
  *
  * @nvmeq:	The queue to use
  * @cmd:	The command to send
  */
-static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 {
 	struct nvme_ops *ops;
 	u16 tail = nvmeq->sq_tail;
@@ -147,7 +195,7 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 	flush_dcache_range((ulong)&nvmeq->sq_cmds[tail],
 			   (ulong)&nvmeq->sq_cmds[tail] + sizeof(*cmd));
 
-	ops = (struct nvme_ops *)nvmeq->dev->udev->driver->ops;
+	ops = nvme_get_ops(nvmeq->dev);
 	if (ops && ops->submit_cmd) {
 		ops->submit_cmd(nvmeq, cmd);
 		return;
@@ -155,10 +203,36 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 
 	if (++tail == nvmeq->q_depth)
 		tail = 0;
-	writel(tail, nvmeq->q_db);
 	nvmeq->sq_tail = tail;
 }
 
+/**
+ * nvme_ring_sq_doorbell() - tell the controller about all queued commands
+ *
+ * @nvmeq:	The queue to use
+ */
+static void nvme_ring_sq_doorbell(struct nvme_queue *nvmeq)
+{
+	struct nvme_ops *ops = nvme_get_ops(nvmeq->dev);
+
+	if (ops && ops->submit_cmd)
+		return;
+
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
+/**
+ * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	nvme_queue_cmd(nvmeq, cmd);
+	nvme_ring_sq_doorbell(nvmeq);
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -184,7 +258,7 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 			return -ETIMEDOUT;
 	}
 
-	ops = (struct nvme_ops *)nvmeq->dev->udev->driver->ops;
+	ops = nvme_get_ops(nvmeq->dev);
 	if (ops && ops->complete_cmd)
 		ops->complete_cmd(nvmeq, cmd);
 
@@ -221,6 +295,10 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 static int nvme_submit_admin_cmd(struct nvme_dev *dev, struct nvme_command *cmd,
 				 u32 *result)
 {
+	/* The queue is freed if the controller cannot be enabled */
+	if (!dev->queues[NVME_ADMIN_Q])
+		return -ENODEV;
+
 	return nvme_submit_sync_cmd(dev->queues[NVME_ADMIN_Q], cmd,
 				    result, ADMIN_TIMEOUT);
 }
@@ -234,7 +312,7 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 		return NULL;
 	memset(nvmeq, 0, sizeof(*nvmeq));
 
-	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION);
+	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION(depth));
 	if (!nvmeq->cqes)
 		goto free_nvmeq;
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(depth));
@@ -254,7 +332,7 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 	dev->queue_count++;
 	dev->queues[qid] = nvmeq;
 
-	ops = (struct nvme_ops *)dev->udev->driver->ops;
+	ops = nvme_get_ops(dev);
 	if (ops && ops->setup_queue)
 		ops->setup_queue(nvmeq);
 
@@ -345,7 +423,8 @@ static void nvme_init_queue(struct nvme_queue *nvmeq, u16 qid)
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(nvmeq->q_depth));
 	flush_dcache_range((ulong)nvmeq->cqes,
-			   (ulong)nvmeq->cqes + NVME_CQ_ALLOCATION);
+			   (ulong)nvmeq->cqes +
+			   NVME_CQ_ALLOCATION(nvmeq->q_depth));
 	dev->online_queues++;
 }
 
@@ -610,6 +689,36 @@ static int nvme_setup_io_queues(struct nvme_dev *dev)
 	return 0;
 }
 
+/**
+ * nvme_reset_ctrl() - reset the controller and recreate its queues
+ *
+ * Disabling the controller aborts every outstanding command, so once this
+ * returns the controller no longer accesses any of their buffers or PRP
+ * lists. The existing queue memory is reused.
+ *
+ * If this fails, the I/O queue is not online, so block I/O fails straight
+ * away until the device is probed again. If the controller cannot be enabled,
+ * its queues are also freed and their pointers cleared.
+ *
+ * @dev:	NVMe device
+ * Return: 0 if OK, -ve on error
+ */
+static int nvme_reset_ctrl(struct nvme_dev *dev)
+{
+	int ret;
+
+	dev->online_queues = 0;
+	ret = nvme_disable_ctrl(dev);
+	if (ret)
+		return ret;
+
+	ret = nvme_configure_admin_queue(dev);
+	if (ret)
+		return ret;
+
+	return nvme_setup_io_queues(dev);
+}
+
 static int nvme_get_info_from_identify(struct nvme_dev *dev)
 {
 	struct nvme_id_ctrl *ctrl;
@@ -728,65 +837,173 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/**
+ * nvme_reap_completions() - process all completions posted on an I/O queue
+ *
+ * The completion queue head doorbell is written once for the whole batch
+ * rather than once per command.
+ *
+ * @nvmeq:	The queue to use
+ * @batch:	Outstanding commands on the queue
+ * Return: number of completions processed
+ */
+static int nvme_reap_completions(struct nvme_queue *nvmeq,
+				 struct nvme_io_batch *batch)
+{
+	struct nvme_ops *ops = nvme_get_ops(nvmeq->dev);
+	u16 head = nvmeq->cq_head;
+	u16 phase = nvmeq->cq_phase;
+	int reaped = 0;
+	u16 status, tag;
+
+	for (;;) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) != phase)
+			break;
+
+		if (ops && ops->complete_cmd)
+			ops->complete_cmd(nvmeq, &batch->cmd);
+
+		tag = readw(&nvmeq->cqes[head].command_id);
+		status >>= 1;
+		/* Ignore stale completions left over from a timed-out batch */
+		if (tag < NVME_Q_DEPTH && !(batch->free_tags & BIT(tag))) {
+			if (status) {
+				printf("ERROR: status = %x, tag = %d, head = %d\n",
+				       status, tag, head);
+				batch->err_slba = min(batch->err_slba,
+						      batch->tag_slba[tag]);
+			}
+			batch->free_tags |= BIT(tag);
+			batch->inflight--;
+		}
+
+		if (++head == nvmeq->q_depth) {
+			head = 0;
+			phase = !phase;
+		}
+		reaped++;
+	}
+
+	if (reaped) {
+		writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
+		nvmeq->cq_head = head;
+		nvmeq->cq_phase = phase;
+	}
+
+	return reaped;
+}
+
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
-	struct nvme_command c;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	struct nvme_ops *ops = nvme_get_ops(dev);
 	struct blk_desc *desc = dev_get_uclass_plat(udev);
-	int status;
-	u64 prp2;
+	struct nvme_io_batch batch;
+	struct nvme_command *c = &batch.cmd;
 	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
 	uintptr_t temp_buffer = (uintptr_t)buffer;
-
 	u64 slba = blknr;
+	u64 end_lba = blknr + blkcnt;
 	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
+	ulong timeout_us = IO_TIMEOUT * 100000;
+	int max_inflight;
+	ulong start_time;
+
+	/* Nothing can be sent if the queue was lost in a failed reset */
+	if (!nvmeq || dev->online_queues <= NVME_IO_Q) {
+		printf("Error: %s: Controller not ready\n", udev->name);
+		return 0;
+	}
 
 	flush_dcache_range((unsigned long)buffer,
 			   (unsigned long)buffer + total_len);
 
-	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
-	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
-		}
+	memset(c, 0, sizeof(*c));
+	c->rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
+	c->rw.nsid = cpu_to_le32(ns->ns_id);
+
+	batch.free_tags = GENMASK(nvmeq->q_depth - 1, 0);
+	batch.inflight = 0;
+	batch.err_slba = end_lba;
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+	/*
+	 * Controllers with their own submission hook expect each command to
+	 * complete before the next is sent. Otherwise keep the queue as full
+	 * as possible: one entry must stay free to tell a full queue from an
+	 * empty one.
+	 */
+	max_inflight = (ops && ops->submit_cmd) ? 1 : nvmeq->q_depth - 1;
+
+	while (batch.inflight ||
+	       (slba < end_lba && batch.err_slba == end_lba)) {
+		int queued = 0;
+
+		while (slba < end_lba && batch.err_slba == end_lba &&
+		       batch.inflight < max_inflight) {
+			u16 count = min_t(u64, lbas, end_lba - slba);
+			int tag = __ffs(batch.free_tags);
+			u64 prp2;
+
+			if (nvme_setup_prps(dev, tag, &prp2,
+					    count << ns->lba_shift,
+					    temp_buffer)) {
+				batch.err_slba = slba;
+				break;
+			}
+			c->rw.command_id = cpu_to_le16(tag);
+			c->rw.slba = cpu_to_le64(slba);
+			c->rw.length = cpu_to_le16(count - 1);
+			c->rw.prp1 = cpu_to_le64(temp_buffer);
+			c->rw.prp2 = cpu_to_le64(prp2);
+			nvme_queue_cmd(nvmeq, c);
+
+			batch.tag_slba[tag] = slba;
+			batch.free_tags &= ~BIT(tag);
+			batch.inflight++;
+			queued++;
+			slba += count;
+			temp_buffer += (ulong)count << ns->lba_shift;
+		}
+		if (queued)
+			nvme_ring_sq_doorbell(nvmeq);
+		if (!batch.inflight)
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
+
+		start_time = timer_get_us();
+		while (!nvme_reap_completions(nvmeq, &batch)) {
+			if (timer_get_us() - start_time >= timeout_us) {
+				int tag;
+
+				printf("Error: %s: I/O timeout\n", udev->name);
+				for (tag = 0; tag < nvmeq->q_depth; tag++) {
+					if (!(batch.free_tags & BIT(tag)))
+						batch.err_slba =
+							min(batch.err_slba,
+							    batch.tag_slba[tag]);
+				}
+				/*
+				 * The controller may still be writing to the
+				 * buffer or reading the PRP lists, so stop it
+				 * before the tags can be used again
+				 */
+				batch.inflight = 0;
+				if (nvme_reset_ctrl(dev))
+					printf("Error: %s: Reset failed\n",
+					       udev->name);
+				break;
+			}
+		}
 	}
 
 	if (read)
 		invalidate_dcache_range((unsigned long)buffer,
 					(unsigned long)buffer + total_len);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return min(batch.err_slba, slba) - blknr;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -845,27 +1062,25 @@ int nvme_init(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
 		goto free_queue;
 
 	nvme_get_info_from_identify(ndev);
 
+	/* Allocate after the page size and maximum transfer size are known */
+	ret = nvme_alloc_prp_pool(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	/* Create a blk device for each namespace */
 
 	id = memalign(ndev->page_size, sizeof(struct nvme_id_ns));
 	if (!id) {
 		ret = -ENOMEM;
-		goto free_queue;
+		goto free_prp;
 	}
 
 	for (int i = 1; i <= ndev->nn; i++) {
@@ -895,8 +1110,10 @@ int nvme_init(struct udevice *udev)
 			goto free_id;
 
 		ret = bootdev_setup_sibling_blk(ns_udev, "nvme_bootdev");
-		if (ret)
-			return log_msg_ret("bootdev", ret);
+		if (ret) {
+			ret = log_msg_ret("bootdev", ret);
+			goto free_id;
+		}
 
 		ret = blk_probe_or_unbind(ns_udev);
 		if (ret)
@@ -908,6 +1125,9 @@ int nvme_init(struct udevice *udev)
 
 free_id:
 	free(id);
+free_prp:
+	free(ndev->prp_pool);
+	ndev->prp_pool = NULL;
 free_queue:
 	free((void *)ndev->queues);
 free_nvme:
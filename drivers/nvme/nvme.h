@@ -619,7 +619,7 @@ struct nvme_dev {
 	u32 page_size;
 	u8 vwc;
 	u64 *prp_pool;
-	u32 prp_entry_num;
+	u32 prp_slot_size;
 	u32 nn;
 };
 
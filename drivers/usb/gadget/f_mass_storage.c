@@ -303,6 +303,16 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	buffhds[FSG_NUM_BUFFERS];
 
+	/*
+	 * Read-ahead: after a READ, ra_lun/ra_offset/ra_len describe the data
+	 * which follows it. Once that has been read, ra_bh holds it until the
+	 * next command is processed.
+	 */
+	struct fsg_buffhd	*ra_bh;
+	unsigned int		ra_lun;
+	loff_t			ra_offset;
+	u32			ra_len;
+
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
 
@@ -699,6 +709,7 @@ static int do_read(struct fsg_common *common)
 	unsigned int		amount;
 	unsigned int		partial_page;
 	ssize_t			nread;
+	u32			ra = 0;
 
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
@@ -726,6 +737,15 @@ static int do_read(struct fsg_common *common)
 	if (unlikely(amount_left == 0))
 		return -EIO;		/* No default reply */
 
+	/* Start with the read-ahead buffer if it holds what we need */
+	if (common->ra_bh && common->ra_lun == common->lun &&
+	    common->ra_offset == file_offset) {
+		common->next_buffhd_to_fill = common->ra_bh;
+		ra = common->ra_len;
+	}
+	common->ra_bh = NULL;
+	common->ra_len = 0;
+
 	for (;;) {
 
 		/* Figure out how much we need to read:
@@ -761,15 +781,19 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		/* Perform the read */
-		rc = ums[common->lun].read_sector(&ums[common->lun],
-				      file_offset / SECTOR_SIZE,
-				      amount / SECTOR_SIZE,
-				      (char __user *)bh->buf);
-		if (!rc)
-			return -EIO;
+		/* Perform the read, skipping anything already read ahead */
+		nread = min(amount, ra);
+		ra = 0;
+		if (amount > nread) {
+			rc = ums[common->lun].read_sector(&ums[common->lun],
+					(file_offset + nread) / SECTOR_SIZE,
+					(amount - nread) / SECTOR_SIZE,
+					(char __user *)bh->buf + nread);
+			if (!rc)
+				return -EIO;
 
-		nread = rc * SECTOR_SIZE;
+			nread += rc * SECTOR_SIZE;
+		}
 
 		VLDBG(curlun, "file read %u @ %llu -> %d\n", amount,
 				(unsigned long long) file_offset,
@@ -797,8 +821,14 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		if (amount_left == 0)
+		if (amount_left == 0) {
+			/* Hosts mostly read sequentially, so fetch what's next */
+			common->ra_lun = common->lun;
+			common->ra_offset = file_offset;
+			common->ra_len = min(common->data_size_from_cmnd,
+					     FSG_BUFLEN);
 			break;		/* No more left to read */
+		}
 
 		/* Send this buffer and go read some more */
 		bh->inreq->zero = 0;
@@ -808,11 +838,52 @@ static int do_read(struct fsg_common *common)
 			 * common->fsg is NULL */
 			return -EIO;
 		common->next_buffhd_to_fill = bh->next;
+
+		/*
+		 * Give the controller a chance to start on this buffer (or
+		 * retire earlier ones) before the next, possibly slow, read
+		 * from the storage device.
+		 */
+		usb_gadget_handle_interrupts(controller_index);
 	}
 
 	return -EIO;		/* No default reply */
 }
 
+/*
+ * Read the data following a sequential READ into a free buffer, while the
+ * host is still busy with the data and status of that command. This runs
+ * after the status has been queued and fills the buffer which do_read()
+ * would use next, so a hit does not change the order of the ring.
+ * get_next_command() receives the CBW in the buffer after it instead.
+ */
+static void read_ahead(struct fsg_common *common)
+{
+	struct fsg_lun		*curlun = &common->luns[common->ra_lun];
+	struct fsg_buffhd	*bh = common->next_buffhd_to_fill;
+	loff_t			size = (loff_t)curlun->num_sectors << 9;
+	u32			len = common->ra_len;
+	int			rc;
+
+	if (!len || common->ra_bh)
+		return;
+	common->ra_len = 0;
+	if (bh->state != BUF_STATE_EMPTY || common->ra_offset >= size)
+		return;
+	if (common->ra_offset + len > size)
+		len = size - common->ra_offset;
+
+	rc = ums[common->ra_lun].read_sector(&ums[common->ra_lun],
+					     common->ra_offset / SECTOR_SIZE,
+					     len / SECTOR_SIZE,
+					     (char __user *)bh->buf);
+	if (rc <= 0)
+		return;
+
+	common->ra_bh = bh;
+	common->ra_len = min(len, (u32)rc * SECTOR_SIZE);
+}
+
 /*-------------------------------------------------------------------------*/
 
 static int do_write(struct fsg_common *common)
@@ -2117,6 +2188,8 @@ static int get_next_command(struct fsg_common *common)
 
 	/* Wait for the next buffer to become available */
 	bh = common->next_buffhd_to_fill;
+	if (bh == common->ra_bh)
+		bh = bh->next;	/* Keep the read-ahead data */
 	while (bh->state != BUF_STATE_EMPTY) {
 		rc = sleep_thread(common);
 		if (rc)
@@ -2330,6 +2403,8 @@ static void handle_exception(struct fsg_common *common)
 	}
 	common->next_buffhd_to_fill = &common->buffhds[0];
 	common->next_buffhd_to_drain = &common->buffhds[0];
+	common->ra_bh = NULL;
+	common->ra_len = 0;
 	exception_req_tag = common->exception_req_tag;
 	old_state = common->state;
 
@@ -2416,7 +2491,10 @@ int fsg_main_thread(void *common_)
 		if (!exception_in_progress(common))
 			common->state = FSG_STATE_DATA_PHASE;
 
-		if (do_scsi_command(common) || finish_reply(common))
+		ret = do_scsi_command(common);
+		/* Read-ahead data is only good for the command following it */
+		common->ra_bh = NULL;
+		if (ret || finish_reply(common))
 			continue;
 
 		if (!exception_in_progress(common))
@@ -2425,8 +2503,10 @@ int fsg_main_thread(void *common_)
 		if (send_status(common))
 			continue;
 
-		if (!exception_in_progress(common))
+		if (!exception_in_progress(common)) {
 			common->state = FSG_STATE_IDLE;
+			read_ahead(common);
+		}
 	} while (0);
 
 	common->thread_task = NULL;
@@ -2444,6 +2524,9 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	struct fsg_lun *curlun;
 	int nluns, i, rc;
 
+	/* do_read() splits reads at page boundaries within each buffer */
+	BUILD_BUG_ON(FSG_BUFLEN % PAGE_CACHE_SIZE);
+
 	/* Find out how many LUNs there should be */
 	nluns = ums_count;
 	if (nluns < 1 || nluns > FSG_MAX_LUNS) {
@@ -18,28 +18,14 @@ static int console_set_row(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	void *line, *dst, *end;
-	int pixels = fontdata->height * vid_priv->xsize;
 	int ret;
-	int i;
-	int pbytes;
 
 	ret = check_bpix_support(vid_priv->bpix);
 	if (ret)
 		return ret;
 
-	line = vid_priv->fb + row * fontdata->height * vid_priv->line_length;
-	dst = line;
-	pbytes = VNBYTES(vid_priv->bpix);
-	for (i = 0; i < pixels; i++)
-		fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
-	end = dst;
-
-	ret = vidconsole_sync_copy(dev, line, end);
-	if (ret)
-		return ret;
-
-	return 0;
+	return video_fill_rect(dev->parent, 0, row * fontdata->height,
+			       vid_priv->xsize, fontdata->height, clr);
 }
 
 static int console_move_rows(struct udevice *dev, uint rowdst,
@@ -48,19 +34,10 @@ static int console_move_rows(struct udevice *dev, uint rowdst,
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	void *dst;
-	void *src;
-	int size;
-	int ret;
-
-	dst = vid_priv->fb + rowdst * fontdata->height * vid_priv->line_length;
-	src = vid_priv->fb + rowsrc * fontdata->height * vid_priv->line_length;
-	size = fontdata->height * vid_priv->line_length * count;
-	ret = vidconsole_memmove(dev, dst, src, size);
-	if (ret)
-		return ret;
 
-	return 0;
+	return video_copy_rect(dev->parent, 0, rowdst * fontdata->height, 0,
+			       rowsrc * fontdata->height, vid_priv->xsize,
+			       fontdata->height * count);
 }
 
 static int console_putc_xy(struct udevice *dev, uint x_frac, uint y, char ch)
@@ -90,6 +67,7 @@ static int console_putc_xy(struct udevice *dev, uint x_frac, uint y, char ch)
 	if (ret)
 		return ret;
 
+	video_damage(vid, x, y, fontdata->width, fontdata->height);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
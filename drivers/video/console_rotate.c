@@ -18,25 +18,10 @@ static int console_set_row_1(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	int pbytes = VNBYTES(vid_priv->bpix);
-	void *start, *dst, *line;
-	int i, j;
-	int ret;
-
-	start = vid_priv->fb + vid_priv->line_length -
-		(row + 1) * fontdata->height * pbytes;
-	line = start;
-	for (j = 0; j < vid_priv->ysize; j++) {
-		dst = line;
-		for (i = 0; i < fontdata->height; i++)
-			fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
-		line += vid_priv->line_length;
-	}
-	ret = vidconsole_sync_copy(dev, start, line);
-	if (ret)
-		return ret;
 
-	return 0;
+	return video_fill_rect(dev->parent,
+			       vid_priv->xsize - (row + 1) * fontdata->height,
+			       0, fontdata->height, vid_priv->ysize, clr);
 }
 
 static int console_move_rows_1(struct udevice *dev, uint rowdst, uint rowsrc,
@@ -45,26 +30,13 @@ static int console_move_rows_1(struct udevice *dev, uint rowdst, uint rowsrc,
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	int pbytes = VNBYTES(vid_priv->bpix);
-	void *dst;
-	void *src;
-	int j, ret;
-
-	dst = vid_priv->fb + vid_priv->line_length -
-		(rowdst + count) * fontdata->height * pbytes;
-	src = vid_priv->fb + vid_priv->line_length -
-		(rowsrc + count) * fontdata->height * pbytes;
-
-	for (j = 0; j < vid_priv->ysize; j++) {
-		ret = vidconsole_memmove(dev, dst, src,
-					fontdata->height * pbytes * count);
-		if (ret)
-			return ret;
-		src += vid_priv->line_length;
-		dst += vid_priv->line_length;
-	}
-
-	return 0;
+
+	return video_copy_rect(dev->parent,
+			       vid_priv->xsize -
+			       (rowdst + count) * fontdata->height, 0,
+			       vid_priv->xsize -
+			       (rowsrc + count) * fontdata->height, 0,
+			       fontdata->height * count, vid_priv->ysize);
 }
 
 static int console_putc_xy_1(struct udevice *dev, uint x_frac, uint y, char ch)
@@ -91,6 +63,8 @@ static int console_putc_xy_1(struct udevice *dev, uint x_frac, uint y, char ch)
 	if (ret)
 		return ret;
 
+	video_damage(vid, vid_priv->xsize - y - fontdata->height,
+		     VID_TO_PIXEL(x_frac), fontdata->height, fontdata->width);
 	/* We draw backwards from 'start, so account for the first line */
 	ret = vidconsole_sync_copy(dev, start - vid_priv->line_length, line);
 	if (ret)
@@ -105,23 +79,10 @@ static int console_set_row_2(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	void *start, *line, *dst, *end;
-	int pixels = fontdata->height * vid_priv->xsize;
-	int i, ret;
-	int pbytes = VNBYTES(vid_priv->bpix);
-
-	start = vid_priv->fb + vid_priv->ysize * vid_priv->line_length -
-		(row + 1) * fontdata->height * vid_priv->line_length;
-	line = start;
-	dst = line;
-	for (i = 0; i < pixels; i++)
-		fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
-	end = dst;
-	ret = vidconsole_sync_copy(dev, start, end);
-	if (ret)
-		return ret;
 
-	return 0;
+	return video_fill_rect(dev->parent, 0,
+			       vid_priv->ysize - (row + 1) * fontdata->height,
+			       vid_priv->xsize, fontdata->height, clr);
 }
 
 static int console_move_rows_2(struct udevice *dev, uint rowdst, uint rowsrc,
@@ -130,19 +91,13 @@ static int console_move_rows_2(struct udevice *dev, uint rowdst, uint rowsrc,
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	void *dst;
-	void *src;
-	void *end;
-
-	end = vid_priv->fb + vid_priv->ysize * vid_priv->line_length;
-	dst = end - (rowdst + count) * fontdata->height *
-		vid_priv->line_length;
-	src = end - (rowsrc + count) * fontdata->height *
-		vid_priv->line_length;
-	vidconsole_memmove(dev, dst, src,
-			   fontdata->height * vid_priv->line_length * count);
-
-	return 0;
+
+	return video_copy_rect(dev->parent, 0,
+			       vid_priv->ysize -
+			       (rowdst + count) * fontdata->height, 0,
+			       vid_priv->ysize -
+			       (rowsrc + count) * fontdata->height,
+			       vid_priv->xsize, fontdata->height * count);
 }
 
 static int console_putc_xy_2(struct udevice *dev, uint x_frac, uint y, char ch)
@@ -169,6 +124,8 @@ static int console_putc_xy_2(struct udevice *dev, uint x_frac, uint y, char ch)
 	if (ret)
 		return ret;
 
+	video_damage(vid, x - fontdata->width + 1, linenum - fontdata->height + 1,
+		     fontdata->width, fontdata->height);
 	/* Add 4 bytes to allow for the first pixel writen */
 	ret = vidconsole_sync_copy(dev, start + 4, line);
 	if (ret)
@@ -182,23 +139,9 @@ static int console_set_row_3(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	int pbytes = VNBYTES(vid_priv->bpix);
-	void *start, *dst, *line;
-	int i, j, ret;
-
-	start = vid_priv->fb + row * fontdata->height * pbytes;
-	line = start;
-	for (j = 0; j < vid_priv->ysize; j++) {
-		dst = line;
-		for (i = 0; i < fontdata->height; i++)
-			fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
-		line += vid_priv->line_length;
-	}
-	ret = vidconsole_sync_copy(dev, start, line);
-	if (ret)
-		return ret;
 
-	return 0;
+	return video_fill_rect(dev->parent, row * fontdata->height, 0,
+			       fontdata->height, vid_priv->ysize, clr);
 }
 
 static int console_move_rows_3(struct udevice *dev, uint rowdst, uint rowsrc,
@@ -207,24 +150,10 @@ static int console_move_rows_3(struct udevice *dev, uint rowdst, uint rowsrc,
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	int pbytes = VNBYTES(vid_priv->bpix);
-	void *dst;
-	void *src;
-	int j, ret;
-
-	dst = vid_priv->fb + rowdst * fontdata->height * pbytes;
-	src = vid_priv->fb + rowsrc * fontdata->height * pbytes;
-
-	for (j = 0; j < vid_priv->ysize; j++) {
-		ret = vidconsole_memmove(dev, dst, src,
-					fontdata->height * pbytes * count);
-		if (ret)
-			return ret;
-		src += vid_priv->line_length;
-		dst += vid_priv->line_length;
-	}
-
-	return 0;
+
+	return video_copy_rect(dev->parent, rowdst * fontdata->height, 0,
+			       rowsrc * fontdata->height, 0,
+			       fontdata->height * count, vid_priv->ysize);
 }
 
 static int console_putc_xy_3(struct udevice *dev, uint x_frac, uint y, char ch)
@@ -250,6 +179,8 @@ static int console_putc_xy_3(struct udevice *dev, uint x_frac, uint y, char ch)
 	ret = fill_char_horizontally(pfont, &line, vid_priv, fontdata, NORMAL_DIRECTION);
 	if (ret)
 		return ret;
+	video_damage(vid, x, linenum - fontdata->width + 1, fontdata->height,
+		     fontdata->width);
 	/* Add a line to allow for the first pixels writen */
 	ret = vidconsole_sync_copy(dev, start + vid_priv->line_length, line);
 	if (ret)
@@ -6,6 +6,7 @@
 #include <common.h>
 #include <dm.h>
 #include <log.h>
+#include <linux/list.h>
 #include <malloc.h>
 #include <video.h>
 #include <video_console.h>
@@ -121,6 +122,54 @@ struct console_tt_metrics {
 	double scale;
 };
 
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+/* Number of hash buckets in the glyph cache, as a power of two */
+#define GLYPH_HASH_BITS		6
+
+/**
+ * struct tt_glyph - A rendered glyph held in the glyph cache
+ *
+ * @lru:	Node in the cache's LRU list
+ * @hash:	Node in the cache's hash-bucket list
+ * @met:	Font / size which the glyph was rendered with
+ * @ch:		Character
+ * @shift:	Sub-pixel X offset which the glyph was rendered at
+ * @width:	Width of the bitmap in pixels
+ * @height:	Height of the bitmap in pixels
+ * @xoff:	X offset of the bitmap from the cursor position
+ * @yoff:	Y offset of the bitmap from the baseline
+ * @size:	Number of bytes used by this entry, including @bits
+ * @bits:	8bpp bitmap, @width * @height bytes, empty if the glyph has
+ *		no pixels (e.g. ' ')
+ */
+struct tt_glyph {
+	struct list_head lru;
+	struct list_head hash;
+	struct console_tt_metrics *met;
+	char ch;
+	float shift;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	int size;
+	u8 bits[];
+};
+
+/**
+ * struct tt_glyph_cache - LRU cache of rendered glyphs
+ *
+ * @lru:	List of glyphs, most recently used first
+ * @hash:	Hash buckets, each a list of glyphs
+ * @stats:	Statistics, including the memory used and the budget
+ */
+struct tt_glyph_cache {
+	struct list_head lru;
+	struct list_head hash[1 << GLYPH_HASH_BITS];
+	struct vidconsole_cache_stats stats;
+};
+#endif
+
 /**
  * struct console_tt_priv - Private data for this driver
  *
@@ -133,6 +182,7 @@ struct console_tt_metrics {
  *		last character. We record enough characters to go back to the
  *		start of the current command line.
  * @pos_ptr:	Current position in the position history
+ * @cache:	Cache of rendered glyphs
  */
 struct console_tt_priv {
 	struct console_tt_metrics *cur_met;
@@ -140,55 +190,191 @@ struct console_tt_priv {
 	int num_metrics;
 	struct pos_info pos[POS_HISTORY_SIZE];
 	int pos_ptr;
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+	struct tt_glyph_cache cache;
+#endif
 };
 
-static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+static struct list_head *glyph_bucket(struct console_tt_priv *priv,
+				      struct console_tt_metrics *met, char ch,
+				      float shift)
 {
-	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
-	struct console_tt_priv *priv = dev_get_priv(dev);
-	struct console_tt_metrics *met = priv->cur_met;
-	void *end, *line;
-	int ret;
+	uint val;
 
-	line = vid_priv->fb + row * met->font_size * vid_priv->line_length;
-	end = line + met->font_size * vid_priv->line_length;
+	val = met - priv->metrics;
+	val = val * 31 + (u8)ch;
+	val = val * 31 + (uint)(shift * VID_FRAC_DIV);
 
-	switch (vid_priv->bpix) {
-#ifdef CONFIG_VIDEO_BPP8
-	case VIDEO_BPP8: {
-		u8 *dst;
+	return &priv->cache.hash[(val * 0x9e3779b1) >> (32 - GLYPH_HASH_BITS)];
+}
 
-		for (dst = line; dst < (u8 *)end; ++dst)
-			*dst = clr;
-		break;
+static struct tt_glyph *glyph_cache_find(struct console_tt_priv *priv,
+					 struct console_tt_metrics *met,
+					 char ch, float shift)
+{
+	struct tt_glyph_cache *cache = &priv->cache;
+	struct tt_glyph *glyph;
+
+	list_for_each_entry(glyph, glyph_bucket(priv, met, ch, shift), hash) {
+		if (glyph->met == met && glyph->ch == ch &&
+		    glyph->shift == shift) {
+			list_move(&glyph->lru, &cache->lru);
+			cache->stats.hits++;
+			return glyph;
+		}
 	}
-#endif
-#ifdef CONFIG_VIDEO_BPP16
-	case VIDEO_BPP16: {
-		u16 *dst = line;
+	cache->stats.misses++;
+
+	return NULL;
+}
+
+static void glyph_cache_drop(struct tt_glyph_cache *cache,
+			     struct tt_glyph *glyph)
+{
+	list_del(&glyph->lru);
+	list_del(&glyph->hash);
+	cache->stats.used -= glyph->size;
+	cache->stats.count--;
+	free(glyph);
+}
 
-		for (dst = line; dst < (u16 *)end; ++dst)
-			*dst = clr;
-		break;
+static struct tt_glyph *glyph_cache_add(struct console_tt_priv *priv,
+					struct console_tt_metrics *met,
+					char ch, float shift, const u8 *data,
+					int width, int height, int xoff,
+					int yoff)
+{
+	struct tt_glyph_cache *cache = &priv->cache;
+	struct tt_glyph *glyph;
+	int size;
+
+	size = sizeof(*glyph) + (data ? width * height : 0);
+	if (size > cache->stats.budget)
+		return NULL;
+
+	/* Drop the least recently used glyphs to make room */
+	while (cache->stats.used + size > cache->stats.budget) {
+		glyph = list_last_entry(&cache->lru, struct tt_glyph, lru);
+		glyph_cache_drop(cache, glyph);
+		cache->stats.evictions++;
 	}
+
+	glyph = malloc(size);
+	if (!glyph)
+		return NULL;
+	glyph->met = met;
+	glyph->ch = ch;
+	glyph->shift = shift;
+	glyph->width = width;
+	glyph->height = height;
+	glyph->xoff = xoff;
+	glyph->yoff = yoff;
+	glyph->size = size;
+	if (data)
+		memcpy(glyph->bits, data, width * height);
+	list_add(&glyph->lru, &cache->lru);
+	list_add(&glyph->hash, glyph_bucket(priv, met, ch, shift));
+	cache->stats.used += size;
+	cache->stats.count++;
+
+	return glyph;
+}
+
+static void glyph_cache_init(struct console_tt_priv *priv)
+{
+	struct tt_glyph_cache *cache = &priv->cache;
+	int i;
+
+	INIT_LIST_HEAD(&cache->lru);
+	for (i = 0; i < ARRAY_SIZE(cache->hash); i++)
+		INIT_LIST_HEAD(&cache->hash[i]);
+	cache->stats.budget = CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE_SIZE;
+}
+
+static void glyph_cache_flush(struct console_tt_priv *priv)
+{
+	struct tt_glyph_cache *cache = &priv->cache;
+	struct tt_glyph *glyph, *next;
+
+	list_for_each_entry_safe(glyph, next, &cache->lru, lru)
+		glyph_cache_drop(cache, glyph);
+}
 #endif
-#ifdef CONFIG_VIDEO_BPP32
-	case VIDEO_BPP32: {
-		u32 *dst = line;
 
-		for (dst = line; dst < (u32 *)end; ++dst)
-			*dst = clr;
-		break;
+/**
+ * get_glyph() - Get the bitmap for a character
+ *
+ * This looks up the character in the glyph cache, if enabled, and renders it
+ * if it is not there.
+ *
+ * @priv:	Private data for the console
+ * @met:	Font / size to use
+ * @ch:		Character to get
+ * @x_shift:	Sub-pixel X offset to render at, 0 <= x_shift < 1
+ * @widthp:	Returns the width of the bitmap in pixels
+ * @heightp:	Returns the height of the bitmap in pixels
+ * @xoffp:	Returns the X offset of the bitmap from the cursor position
+ * @yoffp:	Returns the Y offset of the bitmap from the baseline
+ * @allocp:	Returns true if the bitmap must be freed by the caller, false
+ *		if it is owned by the cache
+ * Return: 8bpp bitmap, or NULL if the character has no pixels (e.g. ' ')
+ */
+static u8 *get_glyph(struct console_tt_priv *priv,
+		     struct console_tt_metrics *met, char ch, double x_shift,
+		     int *widthp, int *heightp, int *xoffp, int *yoffp,
+		     bool *allocp)
+{
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+	const int shifts = CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE_SHIFTS;
+	struct tt_glyph *glyph;
+	float shift = x_shift;
+	u8 *data;
+
+	if (shifts)
+		shift = (float)tt_floor(x_shift * shifts + 0.5) / shifts;
+	glyph = glyph_cache_find(priv, met, ch, shift);
+	if (!glyph) {
+		data = stbtt_GetCodepointBitmapSubpixel(&met->font, met->scale,
+							met->scale, shift, 0,
+							ch, widthp, heightp,
+							xoffp, yoffp);
+
+		/* A NULL bitmap with a non-zero size means malloc() failed */
+		if (data || !*widthp || !*heightp)
+			glyph = glyph_cache_add(priv, met, ch, shift, data,
+						*widthp, *heightp, *xoffp,
+						*yoffp);
+		if (!glyph) {
+			*allocp = true;
+			return data;
+		}
+		free(data);
 	}
+	*widthp = glyph->width;
+	*heightp = glyph->height;
+	*xoffp = glyph->xoff;
+	*yoffp = glyph->yoff;
+	*allocp = false;
+
+	return glyph->size > sizeof(*glyph) ? glyph->bits : NULL;
+#else
+	*allocp = true;
+
+	return stbtt_GetCodepointBitmapSubpixel(&met->font, met->scale,
+						met->scale, x_shift, 0, ch,
+						widthp, heightp, xoffp, yoffp);
 #endif
-	default:
-		return -ENOSYS;
-	}
-	ret = vidconsole_sync_copy(dev, line, end);
-	if (ret)
-		return ret;
+}
 
-	return 0;
+static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
+{
+	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
+	struct console_tt_priv *priv = dev_get_priv(dev);
+	struct console_tt_metrics *met = priv->cur_met;
+
+	return video_fill_rect(dev->parent, 0, row * met->font_size,
+			       vid_priv->xsize, met->font_size, clr);
 }
 
 static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
@@ -197,14 +383,11 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	struct console_tt_metrics *met = priv->cur_met;
-	void *dst;
-	void *src;
 	int i, diff, ret;
 
-	dst = vid_priv->fb + rowdst * met->font_size * vid_priv->line_length;
-	src = vid_priv->fb + rowsrc * met->font_size * vid_priv->line_length;
-	ret = vidconsole_memmove(dev, dst, src, met->font_size *
-				 vid_priv->line_length * count);
+	ret = video_copy_rect(dev->parent, 0, rowdst * met->font_size, 0,
+			      rowsrc * met->font_size, vid_priv->xsize,
+			      met->font_size * count);
 	if (ret)
 		return ret;
 
@@ -231,6 +414,7 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	int width_frac, linenum;
 	struct pos_info *pos;
 	u8 *bits, *data;
+	bool alloced;
 	int advance;
 	void *start, *end, *line;
 	int row, ret;
@@ -274,9 +458,8 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	 * image of the character. For empty characters, like ' ', data will
 	 * return NULL;
 	 */
-	data = stbtt_GetCodepointBitmapSubpixel(font, met->scale, met->scale,
-						x_shift, 0, ch, &width, &height,
-						&xoff, &yoff);
+	data = get_glyph(priv, met, ch, x_shift, &width, &height, &xoff, &yoff,
+			 &alloced);
 	if (!data)
 		return width_frac;
 
@@ -364,16 +547,20 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 		}
 #endif
 		default:
-			free(data);
+			if (alloced)
+				free(data);
 			return -ENOSYS;
 		}
 
 		line += vid_priv->line_length;
 	}
+	video_damage(vid, VID_TO_PIXEL(x) + xoff,
+		     y + (linenum > 0 ? linenum : 0), width, height);
 	ret = vidconsole_sync_copy(dev, start, line);
+	if (alloced)
+		free(data);
 	if (ret)
 		return ret;
-	free(data);
 
 	return width_frac;
 }
@@ -437,6 +624,7 @@ static int console_truetype_erase(struct udevice *dev, int xstart, int ystart,
 		}
 		line += vid_priv->line_length;
 	}
+	video_damage(dev->parent, xstart, ystart, xend - xstart, yend - ystart);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
@@ -744,6 +932,9 @@ static int console_truetype_probe(struct udevice *dev)
 	int ret;
 
 	debug("%s: start\n", __func__);
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+	glyph_cache_init(priv);
+#endif
 	if (vid_priv->font_size)
 		font_size = vid_priv->font_size;
 	else
@@ -766,6 +957,27 @@ static int console_truetype_probe(struct udevice *dev)
 	return 0;
 }
 
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+static int console_truetype_get_cache_stats(struct udevice *dev,
+					    struct vidconsole_cache_stats *stats)
+{
+	struct console_tt_priv *priv = dev_get_priv(dev);
+
+	*stats = priv->cache.stats;
+
+	return 0;
+}
+
+static int console_truetype_remove(struct udevice *dev)
+{
+	struct console_tt_priv *priv = dev_get_priv(dev);
+
+	glyph_cache_flush(priv);
+
+	return 0;
+}
+#endif
+
 struct vidconsole_ops console_truetype_ops = {
 	.putc_xy	= console_truetype_putc_xy,
 	.move_rows	= console_truetype_move_rows,
@@ -775,6 +987,9 @@ struct vidconsole_ops console_truetype_ops = {
 	.get_font	= console_truetype_get_font,
 	.get_font_size	= console_truetype_get_font_size,
 	.select_font	= truetype_select_font,
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+	.get_cache_stats	= console_truetype_get_cache_stats,
+#endif
 };
 
 U_BOOT_DRIVER(vidconsole_truetype) = {
@@ -782,5 +997,8 @@ U_BOOT_DRIVER(vidconsole_truetype) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_truetype_ops,
 	.probe	= console_truetype_probe,
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+	.remove	= console_truetype_remove,
+#endif
 	.priv_auto	= sizeof(struct console_tt_priv),
 };
@@ -128,6 +128,102 @@ static int sandbox_sdl_bind(struct udevice *dev)
 	return ret;
 }
 
+/*
+ * These operations stand in for a 2D engine, so that the uclass code which
+ * uses them is exercised on sandbox. They work a line at a time, which is how
+ * a simple blitter would do it.
+ */
+static int sandbox_sdl_fill_rect(struct udevice *dev, int x, int y, int width,
+				 int height, u32 colour)
+{
+	struct sandbox_sdl_plat *plat = dev_get_plat(dev);
+	struct video_priv *uc_priv = dev_get_uclass_priv(dev);
+	int pbytes = VNBYTES(uc_priv->bpix);
+	void *line;
+	int i, j;
+
+	if (plat->no_accel)
+		return -ENOSYS;
+	line = uc_priv->fb + y * uc_priv->line_length + x * pbytes;
+	for (i = 0; i < height; i++) {
+		for (j = 0; j < width; j++) {
+			switch (pbytes) {
+			case 2:
+				((u16 *)line)[j] = colour;
+				break;
+			case 4:
+				((u32 *)line)[j] = colour;
+				break;
+			default:
+				return -ENOSYS;
+			}
+		}
+		line += uc_priv->line_length;
+	}
+	plat->accel_count++;
+
+	return 0;
+}
+
+static int sandbox_sdl_copy_rect(struct udevice *dev, int dstx, int dsty,
+				 int srcx, int srcy, int width, int height)
+{
+	struct sandbox_sdl_plat *plat = dev_get_plat(dev);
+	struct video_priv *uc_priv = dev_get_uclass_priv(dev);
+	int pbytes = VNBYTES(uc_priv->bpix);
+	int stride = uc_priv->line_length;
+	void *dst, *src;
+	int i;
+
+	if (plat->no_accel)
+		return -ENOSYS;
+	dst = uc_priv->fb + dsty * stride + dstx * pbytes;
+	src = uc_priv->fb + srcy * stride + srcx * pbytes;
+
+	/* Work upwards if needed, so as not to overwrite the source */
+	if (dsty > srcy) {
+		dst += (height - 1) * stride;
+		src += (height - 1) * stride;
+		stride = -stride;
+	}
+	for (i = 0; i < height; i++) {
+		memmove(dst, src, width * pbytes);
+		dst += stride;
+		src += stride;
+	}
+	plat->accel_count++;
+
+	return 0;
+}
+
+static int sandbox_sdl_blit(struct udevice *dev, int x, int y, int width,
+			    int height, const void *src, int stride)
+{
+	struct sandbox_sdl_plat *plat = dev_get_plat(dev);
+	struct video_priv *uc_priv = dev_get_uclass_priv(dev);
+	int pbytes = VNBYTES(uc_priv->bpix);
+	void *line;
+	int i;
+
+	if (plat->no_accel)
+		return -ENOSYS;
+	line = uc_priv->fb + y * uc_priv->line_length + x * pbytes;
+	for (i = 0; i < height; i++) {
+		memcpy(line, src, width * pbytes);
+		line += uc_priv->line_length;
+		src += stride;
+	}
+	plat->accel_count++;
+
+	return 0;
+}
+
+static const struct video_ops sandbox_sdl_ops = {
+	.fill_rect	= sandbox_sdl_fill_rect,
+	.copy_rect	= sandbox_sdl_copy_rect,
+	.blit		= sandbox_sdl_blit,
+};
+
 static const struct udevice_id sandbox_sdl_ids[] = {
 	{ .compatible = "sandbox,lcd-sdl" },
 	{ }
@@ -137,6 +233,7 @@ U_BOOT_DRIVER(sandbox_lcd_sdl) = {
 	.name	= "sandbox_lcd_sdl",
 	.id	= UCLASS_VIDEO,
 	.of_match = sandbox_sdl_ids,
+	.ops	= &sandbox_sdl_ops,
 	.bind	= sandbox_sdl_bind,
 	.probe	= sandbox_sdl_probe,
 	.remove	= sandbox_sdl_remove,
@@ -596,6 +596,17 @@ int vidconsole_select_font(struct udevice *dev, const char *name, uint size)
 	return ops->select_font(dev, name, size);
 }
 
+int vidconsole_get_cache_stats(struct udevice *dev,
+			       struct vidconsole_cache_stats *stats)
+{
+	struct vidconsole_ops *ops = vidconsole_get_ops(dev);
+
+	if (!ops->get_cache_stats)
+		return -ENOSYS;
+
+	return ops->get_cache_stats(dev, stats);
+}
+
 /* Set up the number of rows and colours (rotated drivers override this) */
 static int vidconsole_pre_probe(struct udevice *dev)
 {
@@ -647,13 +658,6 @@ int vidconsole_sync_copy(struct udevice *dev, void *from, void *to)
 
 	return video_sync_copy(vid, from, to);
 }
-
-int vidconsole_memmove(struct udevice *dev, void *dst, const void *src,
-		       int size)
-{
-	memmove(dst, src, size);
-	return vidconsole_sync_copy(dev, dst, dst + size);
-}
 #endif
 
 int vidconsole_clear_and_reset(struct udevice *dev)
@@ -9,6 +9,7 @@
 #include <console.h>
 #include <cpu_func.h>
 #include <dm.h>
+#include <dma.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
@@ -142,35 +143,256 @@ int video_reserve(ulong *addrp)
 	return 0;
 }
 
-int video_fill(struct udevice *dev, u32 colour)
+/**
+ * video_fill_span() - Fill part of a line of the frame buffer
+ *
+ * Pixels are written one at a time until @dst is word-aligned, then a word at
+ * a time, then one at a time to finish.
+ *
+ * @dst:	Place to start filling
+ * @colour:	Colour to use, in the frame buffer's format
+ * @bpix:	Frame-buffer depth
+ * @size:	Number of bytes to fill
+ */
+static void video_fill_span(void *dst, u32 colour, enum video_log2_bpp bpix,
+			    int size)
 {
-	struct video_priv *priv = dev_get_uclass_priv(dev);
-	int ret;
+	void *end = dst + size;
+	ulong pattern;
 
-	switch (priv->bpix) {
+	switch (bpix) {
 	case VIDEO_BPP16:
 		if (CONFIG_IS_ENABLED(VIDEO_BPP16)) {
-			u16 *ppix = priv->fb;
-			u16 *end = priv->fb + priv->fb_size;
-
-			while (ppix < end)
-				*ppix++ = colour;
+			pattern = (u16)colour * (~0UL / 0xffff);
+			for (; dst < end && ((ulong)dst & (sizeof(ulong) - 1));
+			     dst += 2)
+				*(u16 *)dst = colour;
+			for (; dst + sizeof(ulong) <= end; dst += sizeof(ulong))
+				*(ulong *)dst = pattern;
+			for (; dst < end; dst += 2)
+				*(u16 *)dst = colour;
 			break;
 		}
 	case VIDEO_BPP32:
 		if (CONFIG_IS_ENABLED(VIDEO_BPP32)) {
-			u32 *ppix = priv->fb;
-			u32 *end = priv->fb + priv->fb_size;
-
-			while (ppix < end)
-				*ppix++ = colour;
+			pattern = colour * (~0UL / 0xffffffff);
+			for (; dst < end && ((ulong)dst & (sizeof(ulong) - 1));
+			     dst += 4)
+				*(u32 *)dst = colour;
+			for (; dst + sizeof(ulong) <= end; dst += sizeof(ulong))
+				*(ulong *)dst = pattern;
+			for (; dst < end; dst += 4)
+				*(u32 *)dst = colour;
 			break;
 		}
 	default:
-		memset(priv->fb, colour, priv->fb_size);
+		memset(dst, colour, size);
 		break;
 	}
-	ret = video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
+}
+
+/* Check that a rectangle lies within the display */
+static int video_check_rect(struct video_priv *priv, int x, int y, int width,
+			    int height)
+{
+	if (x < 0 || y < 0 || width < 0 || height < 0 ||
+	    x + width > priv->xsize || y + height > priv->ysize)
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+ * video_rect_sync_copy() - Mark a rectangle as changed
+ *
+ * This records the damage and updates the copy frame buffer, if enabled
+ */
+static int video_rect_sync_copy(struct udevice *dev, int x, int y, int width,
+				int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	void *start;
+
+	video_damage(dev, x, y, width, height);
+	start = priv->fb + y * priv->line_length + x * VNBITS(priv->bpix) / 8;
+
+	return video_sync_copy(dev, start, start +
+			       (height - 1) * priv->line_length +
+			       width * VNBITS(priv->bpix) / 8);
+}
+
+int video_fill_rect(struct udevice *dev, int x, int y, int width, int height,
+		    u32 colour)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	struct video_ops *ops = video_get_ops(dev);
+	int size, ret, i;
+	void *line;
+
+	ret = video_check_rect(priv, x, y, width, height);
+	if (ret)
+		return ret;
+	if (!width || !height)
+		return 0;
+
+	ret = -ENOSYS;
+	if (ops && ops->fill_rect)
+		ret = ops->fill_rect(dev, x, y, width, height, colour);
+	if (ret == -ENOSYS) {
+		line = priv->fb + y * priv->line_length +
+			x * VNBITS(priv->bpix) / 8;
+		size = width * VNBITS(priv->bpix) / 8;
+
+		/* Fill whole lines in one go */
+		if (size == priv->line_length) {
+			video_fill_span(line, colour, priv->bpix,
+					size * height);
+		} else {
+			for (i = 0; i < height; i++) {
+				video_fill_span(line, colour, priv->bpix, size);
+				line += priv->line_length;
+			}
+		}
+	} else if (ret) {
+		return log_msg_ret("fil", ret);
+	}
+
+	return video_rect_sync_copy(dev, x, y, width, height);
+}
+
+#if CONFIG_IS_ENABLED(DMA) && defined(CONFIG_VIDEO_DMA)
+/**
+ * video_dma_move() - Move frame-buffer data using a DMA engine
+ *
+ * The DMA engine cannot be relied upon to handle overlapping areas, so the
+ * data is moved in pieces which do not overlap, starting from the end nearest
+ * the destination. If the DMA engine fails, the CPU moves what is left.
+ *
+ * @dst:	Destination
+ * @src:	Source
+ * @size:	Number of bytes to move
+ */
+static void video_dma_move(void *dst, void *src, ulong size)
+{
+	ulong step = dst > src ? dst - src : src - dst;
+	ulong done, len;
+
+	for (done = 0; done < size; done += len) {
+		len = min(step, size - done);
+		if (dst < src) {
+			if (dma_memcpy(dst + done, src + done, len))
+				break;
+		} else {
+			if (dma_memcpy(dst + size - done - len,
+				       src + size - done - len, len))
+				break;
+		}
+	}
+	if (done < size) {
+		if (dst < src)
+			memmove(dst + done, src + done, size - done);
+		else
+			memmove(dst, src, size - done);
+	}
+}
+#else
+static void video_dma_move(void *dst, void *src, ulong size)
+{
+	memmove(dst, src, size);
+}
+#endif
+
+int video_copy_rect(struct udevice *dev, int dstx, int dsty, int srcx,
+		    int srcy, int width, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	struct video_ops *ops = video_get_ops(dev);
+	int bits = VNBITS(priv->bpix);
+	int size, ret, i;
+	void *dst, *src;
+
+	ret = video_check_rect(priv, dstx, dsty, width, height);
+	if (!ret)
+		ret = video_check_rect(priv, srcx, srcy, width, height);
+	if (ret)
+		return ret;
+	if (!width || !height || (dstx == srcx && dsty == srcy))
+		return 0;
+
+	ret = -ENOSYS;
+	if (ops && ops->copy_rect)
+		ret = ops->copy_rect(dev, dstx, dsty, srcx, srcy, width,
+				     height);
+	if (ret == -ENOSYS) {
+		dst = priv->fb + dsty * priv->line_length + dstx * bits / 8;
+		src = priv->fb + srcy * priv->line_length + srcx * bits / 8;
+		size = width * bits / 8;
+
+		if (size == priv->line_length) {
+			/* Whole lines are contiguous, e.g. when scrolling */
+			video_dma_move(dst, src, size * height);
+		} else if (dsty > srcy) {
+			/* Work upwards, so as not to overwrite the source */
+			dst += (height - 1) * priv->line_length;
+			src += (height - 1) * priv->line_length;
+			for (i = 0; i < height; i++) {
+				memmove(dst, src, size);
+				dst -= priv->line_length;
+				src -= priv->line_length;
+			}
+		} else {
+			for (i = 0; i < height; i++) {
+				memmove(dst, src, size);
+				dst += priv->line_length;
+				src += priv->line_length;
+			}
+		}
+	} else if (ret) {
+		return log_msg_ret("cpy", ret);
+	}
+
+	return video_rect_sync_copy(dev, dstx, dsty, width, height);
+}
+
+int video_blit(struct udevice *dev, int x, int y, int width, int height,
+	       const void *src, int stride)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	struct video_ops *ops = video_get_ops(dev);
+	int size, ret, i;
+	void *line;
+
+	ret = video_check_rect(priv, x, y, width, height);
+	if (ret)
+		return ret;
+	if (!width || !height)
+		return 0;
+
+	ret = -ENOSYS;
+	if (ops && ops->blit)
+		ret = ops->blit(dev, x, y, width, height, src, stride);
+	if (ret == -ENOSYS) {
+		line = priv->fb + y * priv->line_length +
+			x * VNBITS(priv->bpix) / 8;
+		size = width * VNBITS(priv->bpix) / 8;
+		for (i = 0; i < height; i++) {
+			memcpy(line, src, size);
+			line += priv->line_length;
+			src += stride;
+		}
+	} else if (ret) {
+		return log_msg_ret("blt", ret);
+	}
+
+	return video_rect_sync_copy(dev, x, y, width, height);
+}
+
+int video_fill(struct udevice *dev, u32 colour)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	int ret;
+
+	ret = video_fill_rect(dev, 0, 0, priv->xsize, priv->ysize, colour);
 	if (ret)
 		return ret;
 
@@ -270,12 +492,126 @@ void video_set_default_colors(struct udevice *dev, bool invert)
 	priv->colour_bg = video_index_to_colour(priv, back);
 }
 
+#ifdef CONFIG_VIDEO_DAMAGE
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	int xend = min(x + width, (int)priv->xsize);
+	int yend = min(y + height, (int)priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (x >= xend || y >= yend)
+		return;
+
+	if (priv->damage.xend) {
+		priv->damage.xstart = min(priv->damage.xstart, x);
+		priv->damage.ystart = min(priv->damage.ystart, y);
+		priv->damage.xend = max(priv->damage.xend, xend);
+		priv->damage.yend = max(priv->damage.yend, yend);
+	} else {
+		priv->damage.xstart = x;
+		priv->damage.ystart = y;
+		priv->damage.xend = xend;
+		priv->damage.yend = yend;
+	}
+}
+#endif
+
+/**
+ * video_damage_span() - Get the part of each line which is damaged
+ *
+ * @priv:	Video device private data
+ * @startp:	Returns the offset of the first damaged byte in each line
+ * @endp:	Returns the offset after the last damaged byte in each line
+ * Return: true if the damage covers whole lines, so that the damaged area is
+ * contiguous in the frame buffer
+ */
+static bool __maybe_unused video_damage_span(struct video_priv *priv, int *startp, int *endp)
+{
+	int bits = VNBITS(priv->bpix);
+
+	*startp = priv->damage.xstart * bits / 8;
+	*endp = DIV_ROUND_UP(priv->damage.xend * bits, 8);
+
+	return !priv->damage.xstart && priv->damage.xend == priv->xsize;
+}
+
+#ifdef CONFIG_VIDEO_COPY
+/* Copy the damaged area of the frame buffer to the copy frame buffer */
+static void video_flush_copy(struct video_priv *priv)
+{
+	int start, end, offset, y;
+
+	if (!priv->copy_fb)
+		return;
+	if (video_damage_span(priv, &start, &end)) {
+		offset = priv->damage.ystart * priv->line_length;
+		memcpy(priv->copy_fb + offset, priv->fb + offset,
+		       (priv->damage.yend - priv->damage.ystart) *
+		       priv->line_length);
+		return;
+	}
+	for (y = priv->damage.ystart; y < priv->damage.yend; y++) {
+		offset = y * priv->line_length + start;
+		memcpy(priv->copy_fb + offset, priv->fb + offset, end - start);
+	}
+}
+#endif
+
+#if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
+/* Flush the damaged area of the frame buffer from the data cache */
+static void video_flush_dcache(struct video_priv *priv)
+{
+	ulong fb = (ulong)priv->fb;
+	int start, end, y;
+
+	if (video_damage_span(priv, &start, &end)) {
+		flush_dcache_range(ALIGN_DOWN(fb + priv->damage.ystart *
+					      priv->line_length,
+					      CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(fb + priv->damage.yend *
+					 priv->line_length,
+					 CONFIG_SYS_CACHELINE_SIZE));
+		return;
+	}
+	for (y = priv->damage.ystart; y < priv->damage.yend; y++) {
+		ulong line = fb + y * priv->line_length;
+
+		flush_dcache_range(ALIGN_DOWN(line + start,
+					      CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(line + end, CONFIG_SYS_CACHELINE_SIZE));
+	}
+}
+#endif
+
 /* Flush video activity to the caches */
 int video_sync(struct udevice *vid, bool force)
 {
+	struct video_priv *priv = dev_get_uclass_priv(vid);
 	struct video_ops *ops = video_get_ops(vid);
+#ifdef CONFIG_VIDEO_SANDBOX_SDL
+	static ulong last_sync;
+#endif
 	int ret;
 
+	/* Without damage tracking, sync everything */
+	if (!IS_ENABLED(CONFIG_VIDEO_DAMAGE)) {
+		priv->damage.xstart = 0;
+		priv->damage.ystart = 0;
+		priv->damage.xend = priv->xsize;
+		priv->damage.yend = priv->ysize;
+	}
+
+	/*
+	 * With damage tracking, the copy frame buffer is updated here rather
+	 * than as each part of the display is drawn
+	 */
+#ifdef CONFIG_VIDEO_COPY
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE) && priv->damage.xend)
+		video_flush_copy(priv);
+#endif
+
 	if (ops && ops->video_sync) {
 		ret = ops->video_sync(vid);
 		if (ret)
@@ -288,22 +624,21 @@ int video_sync(struct udevice *vid, bool force)
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
-
-	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   ALIGN((ulong)priv->fb + priv->fb_size,
-					 CONFIG_SYS_CACHELINE_SIZE));
-	}
+	if (priv->flush_dcache && priv->damage.xend)
+		video_flush_dcache(priv);
 #elif defined(CONFIG_VIDEO_SANDBOX_SDL)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
-	static ulong last_sync;
-
 	if (force || get_timer(last_sync) > 100) {
-		sandbox_sdl_sync(priv->fb);
+		sandbox_sdl_sync(priv->fb, priv->damage.xstart,
+				 priv->damage.ystart, priv->damage.xend,
+				 priv->damage.yend);
 		last_sync = get_timer(0);
+	} else {
+		/* Keep the damage so that the display is updated next time */
+		return 0;
 	}
 #endif
+	priv->damage.xend = 0;
+
 	return 0;
 }
 
@@ -356,6 +691,10 @@ int video_sync_copy(struct udevice *dev, void *from, void *to)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
+	/* video_sync() copies the damaged area instead */
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return 0;
+
 	if (priv->copy_fb) {
 		long offset, size;
 
@@ -407,6 +746,7 @@ int video_sync_copy_all(struct udevice *dev)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
+	video_damage(dev, 0, 0, priv->xsize, priv->ysize);
 	video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
 
 	return 0;
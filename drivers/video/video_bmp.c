@@ -426,6 +426,7 @@ int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 
 	/* Find the position of the top left of the image in the framebuffer */
 	fb = (uchar *)(priv->fb + y * priv->line_length + x * bpix / 8);
+	video_damage(dev, x, y, width, height);
 	ret = video_sync_copy(dev, start, fb);
 	if (ret)
 		return log_ret(ret);
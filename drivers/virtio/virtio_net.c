@@ -13,7 +13,7 @@
 #include "virtio_net.h"
 
 /* Amount of buffers to keep in the RX virtqueue */
-#define VIRTIO_NET_NUM_RX_BUFS	32
+#define VIRTIO_NET_NUM_RX_BUFS	CONFIG_VIRTIO_NET_RX_BUFS
 
 /*
  * This value comes from the VirtIO spec: 1500 for maximum packet size,
@@ -31,21 +31,38 @@ struct virtio_net_priv {
 	};
 
 	char rx_buff[VIRTIO_NET_NUM_RX_BUFS][VIRTIO_NET_RX_BUF_SIZE];
+	/* Packets spread over several buffers are gathered here */
+	uchar rx_merge[PKTSIZE_ALIGN] __aligned(ARCH_DMA_MINALIGN);
 	bool rx_running;
 	int net_hdr_len;
 };
 
 /*
- * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature.
- * For the VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per spec
- * we should assume the link is always active.
+ * The driver negotiates the VIRTIO_NET_F_MAC feature, plus:
+ *
+ * - VIRTIO_NET_F_MRG_RXBUF, so a packet may span several receive buffers.
+ *   This mostly happens when the device places packets without regard to
+ *   our buffer size.
+ * - VIRTIO_NET_F_GUEST_CSUM, so the device may skip computing the transport
+ *   checksum of packets which it knows are good (e.g. from the host itself).
+ *   Such packets are completed in software before the network stack sees
+ *   them.
+ *
+ * Segmentation offloads (GSO) are not negotiated since the network stack
+ * cannot handle frames larger than PKTSIZE. For the VIRTIO_NET_F_STATUS
+ * feature, we don't negotiate it, hence per spec we should assume the link
+ * is always active.
  */
 static const u32 feature[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
+	VIRTIO_NET_F_GUEST_CSUM,
 };
 
 static const u32 feature_legacy[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
+	VIRTIO_NET_F_GUEST_CSUM,
 };
 
 static int virtio_net_start(struct udevice *dev)
@@ -53,14 +70,18 @@ static int virtio_net_start(struct udevice *dev)
 	struct virtio_net_priv *priv = dev_get_priv(dev);
 	struct virtio_sg sg;
 	struct virtio_sg *sgs[] = { &sg };
-	int i;
+	int i, num;
 
 	if (!priv->rx_running) {
 		/* receive buffer length is always 1526 */
 		sg.length = VIRTIO_NET_RX_BUF_SIZE;
 
+		/* the ring cannot hold more buffers than the virtqueue size */
+		num = min_t(int, VIRTIO_NET_NUM_RX_BUFS,
+			    virtqueue_get_vring_size(priv->rx_vq));
+
 		/* setup the receive buffer address */
-		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++) {
+		for (i = 0; i < num; i++) {
 			sg.addr = priv->rx_buff[i];
 			virtqueue_add(priv->rx_vq, sgs, 0, 1);
 		}
@@ -106,29 +127,122 @@ static int virtio_net_send(struct udevice *dev, void *packet, int length)
 	return 0;
 }
 
+static void virtio_net_return_buf(struct virtio_net_priv *priv, void *buf)
+{
+	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
+	struct virtio_sg *sgs[] = { &sg };
+
+	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+}
+
+/*
+ * Gather a packet spread over @num_buffers receive buffers into rx_merge.
+ * All buffers but the first are given back to the device here.
+ */
+static int virtio_net_merge(struct virtio_net_priv *priv, void *buf,
+			    unsigned int len, int num_buffers)
+{
+	bool overflow = false;
+	int total = 0;
+	int i;
+
+	for (i = 0; i < num_buffers; i++) {
+		void *data = buf;
+
+		if (!i) {
+			data += priv->net_hdr_len;
+			len -= priv->net_hdr_len;
+		} else {
+			data = virtqueue_get_buf(priv->rx_vq, &len);
+			if (!data)
+				return -EIO;
+		}
+
+		if (total + len > sizeof(priv->rx_merge))
+			overflow = true;
+		else
+			memcpy(priv->rx_merge + total, data, len);
+		total += len;
+
+		if (i)
+			virtio_net_return_buf(priv, data);
+	}
+
+	return overflow ? -E2BIG : total;
+}
+
+/* Complete a checksum which the device left for us to fill in */
+static void virtio_net_fixup_csum(struct udevice *dev, uchar *packet, int len,
+				  struct virtio_net_hdr_v1 *hdr)
+{
+	u16 start = virtio16_to_cpu(dev, hdr->csum_start);
+	u16 offset = virtio16_to_cpu(dev, hdr->csum_offset);
+	u16 csum;
+
+	if (start + offset + sizeof(csum) > len)
+		return;
+
+	csum = compute_ip_checksum(packet + start, len - start);
+	/* A transmitted checksum of zero means none for UDP */
+	if (!csum)
+		csum = 0xffff;
+	memcpy(packet + start + offset, &csum, sizeof(csum));
+}
+
 static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct virtio_net_hdr_v1 *hdr;
+	int num_buffers = 1;
 	unsigned int len;
+	uchar *packet;
 	void *buf;
+	int ret;
 
 	buf = virtqueue_get_buf(priv->rx_vq, &len);
 	if (!buf)
 		return -EAGAIN;
 
-	*packetp = buf + priv->net_hdr_len;
-	return len - priv->net_hdr_len;
+	/* The flags and num_buffers fields are common to both layouts */
+	hdr = buf;
+	if (virtio_has_feature(dev, VIRTIO_NET_F_MRG_RXBUF))
+		num_buffers = virtio16_to_cpu(dev, hdr->num_buffers);
+
+	if (num_buffers > 1) {
+		ret = virtio_net_merge(priv, buf, len, num_buffers);
+		/* The first buffer is not needed any more */
+		virtio_net_return_buf(priv, buf);
+		virtqueue_kick(priv->rx_vq);
+		if (ret < 0) {
+			debug("%s: dropped merged packet (%d)\n", dev->name,
+			      ret);
+			return -EAGAIN;
+		}
+		packet = priv->rx_merge;
+		len = ret;
+	} else {
+		packet = buf + priv->net_hdr_len;
+		len -= priv->net_hdr_len;
+	}
+
+	if (hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)
+		virtio_net_fixup_csum(dev, packet, len, hdr);
+
+	*packetp = packet;
+	return len;
 }
 
 static int virtio_net_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
-	void *buf = packet - priv->net_hdr_len;
-	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
-	struct virtio_sg *sgs[] = { &sg };
+
+	/* Merged packets have already had their buffers returned */
+	if (packet == priv->rx_merge)
+		return 0;
 
 	/* Put the buffer back to the rx ring */
-	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+	virtio_net_return_buf(priv, packet - priv->net_hdr_len);
+	virtqueue_kick(priv->rx_vq);
 
 	return 0;
 }
@@ -208,7 +322,7 @@ static int virtio_net_probe(struct udevice *dev)
 	 * VIRTIO_NET_F_MRG_RXBUF was negotiated. Without that feature
 	 * the structure was 2 bytes shorter.
 	 */
-	if (uc_priv->legacy)
+	if (uc_priv->legacy && !virtio_has_feature(dev, VIRTIO_NET_F_MRG_RXBUF))
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr);
 	else
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr_v1);
@@ -274,6 +274,7 @@ void btrfs_close(void)
 		close_ctree_fs_info(current_fs_info);
 		current_fs_info = NULL;
 	}
+	btrfs_decompress_cleanup();
 }
 
 int btrfs_uuid(char *uuid_str)
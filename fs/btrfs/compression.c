@@ -135,14 +135,25 @@ static u32 decompress_zlib(const u8 *_cbuf, u32 clen, u8 *dbuf, u32 dlen)
 #define ZSTD_BTRFS_MAX_WINDOWLOG 17
 #define ZSTD_BTRFS_MAX_INPUT (1 << ZSTD_BTRFS_MAX_WINDOWLOG)
 
+/* Kept between extents, since setting up a context costs more than a block */
+static struct zstd_ctx btrfs_zstd;
+
 static u32 decompress_zstd(const u8 *cbuf, u32 clen, u8 *dbuf, u32 dlen)
 {
 	struct abuf in, out;
 
+	if (!btrfs_zstd.dctx && zstd_ctx_init(&btrfs_zstd, 0))
+		return -1;
+
 	abuf_init_set(&in, (u8 *)cbuf, clen);
 	abuf_init_set(&out, dbuf, dlen);
 
-	return zstd_decompress(&in, &out);
+	return zstd_decompress_ctx(&btrfs_zstd, &in, &out);
+}
+
+void btrfs_decompress_cleanup(void)
+{
+	zstd_ctx_uninit(&btrfs_zstd);
 }
 
 u32 btrfs_decompress(u8 type, const char *c, u32 clen, char *d, u32 dlen)
@@ -10,9 +10,12 @@
 #include <display_options.h>
 #include <errno.h>
 #include <common.h>
+#include <blk.h>
+#include <bootstage.h>
 #include <env.h>
 #include <lmb.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
@@ -37,6 +40,18 @@ static int fs_dev_part;
 static struct disk_partition fs_partition;
 static int fs_type = FS_TYPE_ANY;
 
+/* Number of writes to any file system, to detect out-of-date file streams */
+static uint fs_generation;
+
+/*
+ * Files are also written by drivers which call the file system directly, and
+ * devices are written below the file system or removed. Count all of these.
+ */
+static uint fs_get_generation(void)
+{
+	return fs_generation + blk_get_generation();
+}
+
 void fs_set_type(int type)
 {
 	fs_type = type;
@@ -180,6 +195,18 @@ struct fstype_info {
 	int (*unlink)(const char *filename);
 	int (*mkdir)(const char *dirname);
 	int (*ln)(const char *filename, const char *target);
+	/*
+	 * Open a file for reading. On success return 0 and the file stream
+	 * pointer via 'filep', with its size filled in. On error, return
+	 * -errno. This is optional: if it is NULL, fs_readfile() reads the
+	 * file by its path. See fs_openfile().
+	 */
+	int (*openfile)(const char *filename, struct fs_file_stream **filep);
+	/* see fs_readfile() */
+	int (*readfile)(struct fs_file_stream *file, void *buf, loff_t offset,
+			loff_t len, loff_t *actread);
+	/* see fs_closefile() */
+	void (*closefile)(struct fs_file_stream *file);
 };
 
 static struct fstype_info fstypes[] = {
@@ -208,6 +235,9 @@ static struct fstype_info fstypes[] = {
 		.readdir = fat_readdir,
 		.closedir = fat_closedir,
 		.ln = fs_ln_unsupported,
+		.openfile = fat_openfile,
+		.readfile = fat_readfile,
+		.closefile = fat_closefile,
 	},
 #endif
 
@@ -580,7 +610,7 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 {
 	struct fstype_info *info = fs_get_info(fs_type);
 	void *buf;
-	int ret;
+	int span, ret;
 
 #ifdef CONFIG_LMB
 	if (do_lmb_check) {
@@ -594,9 +624,11 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	 * We don't actually know how many bytes are being read, since len==0
 	 * means read the whole file.
 	 */
+	span = bootstage_span_start(BOOTSTAGE_SPAN_FS_LOAD, filename);
 	buf = map_sysmem(addr, len);
 	ret = info->read(filename, buf, offset, len, actread);
 	unmap_sysmem(buf);
+	bootstage_span_end(span);
 
 	/* If we requested a specific number of bytes, check we got it */
 	if (ret == 0 && len && *actread != len)
@@ -619,6 +651,7 @@ int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	void *buf;
 	int ret;
 
+	fs_generation++;
 	buf = map_sysmem(addr, len);
 	ret = info->write(filename, buf, offset, len, actwrite);
 	unmap_sysmem(buf);
@@ -684,12 +717,122 @@ void fs_closedir(struct fs_dir_stream *dirs)
 	fs_close();
 }
 
+/**
+ * struct fs_file_path - file stream for file systems which cannot open files
+ *
+ * @parent:	file stream
+ * @path:	path of the file
+ */
+struct fs_file_path {
+	struct fs_file_stream parent;
+	char path[];
+};
+
+static int fs_openfile_path(struct fstype_info *info, const char *filename,
+			    struct fs_file_stream **filep)
+{
+	struct fs_file_path *file;
+	loff_t size;
+
+	if (info->size(filename, &size))
+		return -ENOENT;
+	file = malloc(sizeof(*file) + strlen(filename) + 1);
+	if (!file)
+		return -ENOMEM;
+	strcpy(file->path, filename);
+	file->parent.size = size;
+	*filep = &file->parent;
+
+	return 0;
+}
+
+struct fs_file_stream *fs_openfile(const char *filename)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	struct fs_file_stream *file = NULL;
+	int ret;
+
+	if (info->openfile)
+		ret = info->openfile(filename, &file);
+	else
+		ret = fs_openfile_path(info, filename, &file);
+	if (!ret) {
+		file->name = strdup(filename);
+		if (!file->name) {
+			if (info->closefile)
+				info->closefile(file);
+			else
+				free(file);
+			ret = -ENOMEM;
+		}
+	}
+	if (ret) {
+		fs_close();
+		errno = -ret;
+		return NULL;
+	}
+
+	file->desc = fs_dev_desc;
+	file->part = fs_dev_part;
+	file->fstype = fs_type;
+	file->generation = fs_get_generation();
+	fs_close();
+
+	return file;
+}
+
+bool fs_file_stale(struct fs_file_stream *file)
+{
+	return file->generation != fs_get_generation();
+}
+
+int fs_readfile(struct fs_file_stream *file, void *buf, loff_t offset,
+		loff_t len, loff_t *actread)
+{
+	struct fstype_info *info = fs_get_info(file->fstype);
+	int span, ret;
+
+	if (fs_file_stale(file))
+		return -ESTALE;
+
+	span = bootstage_span_start(BOOTSTAGE_SPAN_FS_LOAD, file->name);
+	if (info->readfile) {
+		ret = info->readfile(file, buf, offset, len, actread);
+	} else if (fs_set_blk_dev_with_part(file->desc, file->part)) {
+		ret = -ENODEV;
+	} else {
+		info = fs_get_info(fs_type);
+		ret = info->read(((struct fs_file_path *)file)->path, buf,
+				 offset, len, actread);
+		fs_close();
+	}
+	bootstage_span_end(span);
+
+	return ret;
+}
+
+void fs_closefile(struct fs_file_stream *file)
+{
+	struct fstype_info *info;
+
+	if (!file)
+		return;
+
+	free(file->name);
+	info = fs_get_info(file->fstype);
+	if (info->closefile)
+		info->closefile(file);
+	else
+		free(file);
+}
+
 int fs_unlink(const char *filename)
 {
 	int ret;
 
 	struct fstype_info *info = fs_get_info(fs_type);
 
+	fs_generation++;
 	ret = info->unlink(filename);
 
 	fs_close();
@@ -703,6 +846,7 @@ int fs_mkdir(const char *dirname)
 
 	struct fstype_info *info = fs_get_info(fs_type);
 
+	fs_generation++;
 	ret = info->mkdir(dirname);
 
 	fs_close();
@@ -715,6 +859,7 @@ int fs_ln(const char *fname, const char *target)
 	struct fstype_info *info = fs_get_info(fs_type);
 	int ret;
 
+	fs_generation++;
 	ret = info->ln(fname, target);
 
 	if (ret < 0) {
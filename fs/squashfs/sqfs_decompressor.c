@@ -19,6 +19,7 @@
 #endif
 
 #if IS_ENABLED(CONFIG_ZSTD)
+#include <abuf.h>
 #include <linux/zstd.h>
 #endif
 
@@ -40,10 +41,7 @@ int sqfs_decompressor_init(struct squashfs_ctxt *ctxt)
 #endif
 #if IS_ENABLED(CONFIG_ZSTD)
 	case SQFS_COMP_ZSTD:
-		ctxt->zstd_workspace = malloc(zstd_dctx_workspace_bound());
-		if (!ctxt->zstd_workspace)
-			return -ENOMEM;
-		break;
+		return zstd_ctx_init(&ctxt->zstd, 0);
 #endif
 	default:
 		printf("Error: unknown compression type.\n");
@@ -68,7 +66,7 @@ void sqfs_decompressor_cleanup(struct squashfs_ctxt *ctxt)
 #endif
 #if IS_ENABLED(CONFIG_ZSTD)
 	case SQFS_COMP_ZSTD:
-		free(ctxt->zstd_workspace);
+		zstd_ctx_uninit(&ctxt->zstd);
 		break;
 #endif
 	}
@@ -95,18 +93,12 @@ static void zlib_decompression_status(int ret)
 static int sqfs_zstd_decompress(struct squashfs_ctxt *ctxt, void *dest,
 				unsigned long dest_len, void *source, u32 src_len)
 {
-	ZSTD_DCtx *ctx;
-	size_t wsize;
-	int ret;
-
-	wsize = zstd_dctx_workspace_bound();
+	struct abuf in, out;
 
-	ctx = zstd_init_dctx(ctxt->zstd_workspace, wsize);
-	if (!ctx)
-		return -EINVAL;
-	ret = zstd_decompress_dctx(ctx, dest, dest_len, source, src_len);
+	abuf_init_set(&in, source, src_len);
+	abuf_init_set(&out, dest, dest_len);
 
-	return zstd_is_error(ret);
+	return zstd_decompress_ctx(&ctxt->zstd, &in, &out);
 }
 #endif /* CONFIG_ZSTD */
 
@@ -142,10 +134,10 @@ int sqfs_decompress(struct squashfs_ctxt *ctxt, void *dest,
 #if IS_ENABLED(CONFIG_ZSTD)
 	case SQFS_COMP_ZSTD:
 		ret = sqfs_zstd_decompress(ctxt, dest, *dest_len, source, src_len);
-		if (ret) {
-			printf("ZSTD Error code: %d\n", zstd_get_error_code(ret));
-			return -EINVAL;
-		}
+		if (ret < 0)
+			return ret;
+		*dest_len = ret;
+		ret = 0;
 
 		break;
 #endif
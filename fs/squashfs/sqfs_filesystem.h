@@ -12,6 +12,7 @@
 #include <fs.h>
 #include <part.h>
 #include <stdint.h>
+#include <linux/zstd.h>
 
 #define SQFS_UNCOMPRESSED_DATA 0x0002
 #define SQFS_MAGIC_NUMBER 0x73717368
@@ -78,7 +79,7 @@ struct squashfs_ctxt {
 	struct blk_desc *cur_dev;
 	struct squashfs_super_block *sblk;
 #if IS_ENABLED(CONFIG_ZSTD)
-	void *zstd_workspace;
+	struct zstd_ctx zstd;
 #endif
 };
 
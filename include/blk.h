@@ -199,6 +199,166 @@ static inline void blkcache_free(void) {}
 
 #endif
 
+/* Number of log2 buckets in each latency histogram */
+#define BLK_STATS_HIST_BUCKETS	16
+
+/**
+ * enum blk_stats_op - Types of operation counted by the block statistics
+ *
+ * @BLK_STATS_READ: Reads from the device (not including block-cache hits)
+ * @BLK_STATS_WRITE: Writes to the device
+ * @BLK_STATS_ERASE: Erasures of the device
+ * @BLK_STATS_OP_COUNT: Number of operation types
+ */
+enum blk_stats_op {
+	BLK_STATS_READ,
+	BLK_STATS_WRITE,
+	BLK_STATS_ERASE,
+
+	BLK_STATS_OP_COUNT,
+};
+
+/**
+ * struct blk_op_stats - Statistics for one type of operation on a device
+ *
+ * @ops: Number of operations
+ * @blocks: Number of blocks transferred
+ * @bytes: Number of bytes transferred
+ * @time_us: Total time spent in the driver, in microseconds
+ * @max_us: Longest time taken by a single operation, in microseconds
+ * @seq: Number of operations which started at the block after the end of the
+ *	previous operation on the device
+ * @random: Number of operations which did not
+ * @errors: Number of operations which failed or did not complete fully
+ * @lat_hist: Histogram of operation latencies. Bucket 0 counts operations
+ *	taking less than 1us and bucket n those taking 2^(n-1) to 2^n - 1 us.
+ *	The last bucket also counts anything longer.
+ */
+struct blk_op_stats {
+	u64 ops;
+	u64 blocks;
+	u64 bytes;
+	u64 time_us;
+	u64 max_us;
+	u64 seq;
+	u64 random;
+	u64 errors;
+	u32 lat_hist[BLK_STATS_HIST_BUCKETS];
+};
+
+/**
+ * struct blk_stats - I/O statistics for a block device
+ *
+ * This is the uclass-private data of each block device, when
+ * CONFIG_BLK_STATS is enabled. It is reset when the device is probed.
+ *
+ * @op: Statistics for each operation, indexed by enum blk_stats_op
+ * @cache_hits: Number of reads satisfied by the block cache
+ * @next_lba: Block following the end of the last operation, used to tell
+ *	sequential from random accesses
+ */
+struct blk_stats {
+	struct blk_op_stats op[BLK_STATS_OP_COUNT];
+	u64 cache_hits;
+	lbaint_t next_lba;
+};
+
+/**
+ * blk_stats_used() - Check whether a device has been accessed
+ *
+ * @stats: Statistics for the device
+ * Return: true if any operation has been recorded since the last reset
+ */
+static inline bool blk_stats_used(const struct blk_stats *stats)
+{
+	return stats->cache_hits || stats->op[BLK_STATS_READ].ops ||
+		stats->op[BLK_STATS_WRITE].ops || stats->op[BLK_STATS_ERASE].ops;
+}
+
+#if CONFIG_IS_ENABLED(BLK_STATS)
+
+/**
+ * blk_stats_account() - Record an operation in a device's statistics
+ *
+ * @dev: Block device (UCLASS_BLK)
+ * @op: Type of operation
+ * @start: First block of the operation
+ * @blkcnt: Number of blocks requested
+ * @done: Number of blocks processed by the driver, or -ve error
+ * @start_us: Value of timer_get_us() before the driver was called
+ */
+void blk_stats_account(struct udevice *dev, enum blk_stats_op op,
+		       lbaint_t start, lbaint_t blkcnt, long done,
+		       u64 start_us);
+
+/**
+ * blk_stats_cache_hit() - Record a read satisfied by the block cache
+ *
+ * @dev: Block device (UCLASS_BLK)
+ */
+void blk_stats_cache_hit(struct udevice *dev);
+
+/**
+ * blk_get_stats() - Get the statistics for a block device
+ *
+ * @dev: Block device (UCLASS_BLK)
+ * Return: statistics, or NULL if the device is not probed
+ */
+struct blk_stats *blk_get_stats(struct udevice *dev);
+
+/**
+ * blk_stats_reset() - Reset the statistics for a block device
+ *
+ * @dev: Block device (UCLASS_BLK), which must be probed
+ */
+void blk_stats_reset(struct udevice *dev);
+
+/**
+ * blk_stats_op_name() - Get the name of an operation type
+ *
+ * @op: Type of operation
+ * Return: name, e.g. "read"
+ */
+const char *blk_stats_op_name(enum blk_stats_op op);
+
+/**
+ * blk_stats_add_fdt() - Add the statistics for all probed devices to an FDT
+ *
+ * This adds a 'blk' subnode to @parent, containing a subnode for each
+ * probed block device which has been used. See doc/usage/cmd/blk.rst for the
+ * properties. The device tree is not enlarged, so devices which do not fit
+ * are left out.
+ *
+ * @blob: Device tree to update
+ * @parent: Node offset to add the 'blk' node to
+ * Return: 0 if OK, -ve FDT error on failure
+ */
+int blk_stats_add_fdt(void *blob, int parent);
+
+#else
+
+static inline void blk_stats_account(struct udevice *dev,
+				     enum blk_stats_op op, lbaint_t start,
+				     lbaint_t blkcnt, long done, u64 start_us)
+{
+}
+
+static inline void blk_stats_cache_hit(struct udevice *dev) {}
+
+static inline struct blk_stats *blk_get_stats(struct udevice *dev)
+{
+	return NULL;
+}
+
+static inline void blk_stats_reset(struct udevice *dev) {}
+
+static inline int blk_stats_add_fdt(void *blob, int parent)
+{
+	return 0;
+}
+
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
@@ -314,6 +474,18 @@ long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
  */
 long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
 
+/**
+ * blk_get_generation() - Get the number of changes to any block device
+ *
+ * This is incremented by each write to or erase of a block device, and when a
+ * block device is removed. Callers which keep information read from a device
+ * can compare it with the value seen at the time, to find out whether that
+ * information may be out of date.
+ *
+ * Return: number of changes
+ */
+uint blk_get_generation(void);
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -545,6 +717,12 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
+/* Changes made without driver model are not tracked */
+static inline uint blk_get_generation(void)
+{
+	return 0;
+}
+
 /**
  * struct blk_driver - Driver for block interface types
  *
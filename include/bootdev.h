@@ -320,6 +320,22 @@ int bootdev_hunt(const char *spec, bool show);
  */
 int bootdev_hunt_prio(enum bootdev_prio_t prio, bool show);
 
+/**
+ * bootdev_hunt_ahead() - Use the next unused hunter, ahead of the scan
+ *
+ * This runs the hunter with the lowest priority number which has not been
+ * used yet, nor tried by an earlier call. It is called from the bootflow
+ * iteration each time it moves to another bootdev, so that hunters for slower
+ * media (e.g. USB, network) are used a step earlier than the scan would
+ * otherwise reach them, without affecting the order in which bootdevs are
+ * scanned.
+ *
+ * Errors are ignored, since the hunter is used again when the scan reaches its
+ * priority, which reports them. This does nothing unless
+ * CONFIG_BOOTSTD_HUNT_AHEAD is enabled.
+ */
+void bootdev_hunt_ahead(void);
+
 /**
  * bootdev_hunt_and_find_by_label() - Hunt for bootdevs by label
  *
@@ -114,6 +114,9 @@ struct bootflow {
  * before using it
  * @BOOTFLOWIF_ALL: Return bootflows with errors as well
  * @BOOTFLOWIF_HUNT: Hunt for new bootdevs using the bootdrv hunters
+ * @BOOTFLOWIF_HUNT_AHEAD: Use the next unused hunter each time the scan moves
+ * to another bootdev, rather than each one only when its priority is reached.
+ * Requires CONFIG_BOOTSTD_HUNT_AHEAD, otherwise it is ignored
  *
  * Internal flags:
  * @BOOTFLOWIF_SINGLE_DEV: (internal) Just scan one bootdev
@@ -128,6 +131,7 @@ enum bootflow_iter_flags_t {
 	BOOTFLOWIF_SHOW			= 1 << 1,
 	BOOTFLOWIF_ALL			= 1 << 2,
 	BOOTFLOWIF_HUNT			= 1 << 3,
+	BOOTFLOWIF_HUNT_AHEAD		= 1 << 4,
 
 	/*
 	 * flags used internally by standard boot - do not set these when
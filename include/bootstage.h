@@ -217,6 +217,58 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ALLOC,
 };
 
+/**
+ * enum bootstage_span_type - Types of span, used to group them in reports
+ *
+ * @BOOTSTAGE_SPAN_OTHER: Anything not covered below
+ * @BOOTSTAGE_SPAN_DM_PROBE: Probing a device
+ * @BOOTSTAGE_SPAN_BOOTMETH: Reading or booting a bootflow with a bootmeth
+ * @BOOTSTAGE_SPAN_FS_LOAD: Reading a file from a filesystem
+ * @BOOTSTAGE_SPAN_DECOMP: Decompressing an image
+ * @BOOTSTAGE_SPAN_HASH: Hashing data with the hash command
+ * @BOOTSTAGE_SPAN_VERIFY: Verifying the hashes and signatures of a FIT image
+ * @BOOTSTAGE_SPAN_TYPE_COUNT: Number of span types
+ */
+enum bootstage_span_type {
+	BOOTSTAGE_SPAN_OTHER,
+	BOOTSTAGE_SPAN_DM_PROBE,
+	BOOTSTAGE_SPAN_BOOTMETH,
+	BOOTSTAGE_SPAN_FS_LOAD,
+	BOOTSTAGE_SPAN_DECOMP,
+	BOOTSTAGE_SPAN_HASH,
+	BOOTSTAGE_SPAN_VERIFY,
+
+	BOOTSTAGE_SPAN_TYPE_COUNT,
+};
+
+/* Maximum length of a span name, including the terminator */
+#define BOOTSTAGE_SPAN_NAME_LEN	32
+
+/**
+ * struct bootstage_span - A period of boot activity, which may be nested
+ *
+ * Spans are stored in the order in which they start, so the descendants of a
+ * span are the spans which follow it with a greater @depth
+ *
+ * @name: Name of the span, truncated if necessary
+ * @start_us: Time the span started, in microseconds since boot
+ * @end_us: Time the span ended, or 0 if it is still open
+ * @delay_us: Time spent in udelay() within this span but not in any of its
+ *	children
+ * @parent: Index of the enclosing span, or -1 if none
+ * @type: Type of span (enum bootstage_span_type)
+ * @depth: Nesting depth, 0 for a span with no parent
+ */
+struct bootstage_span {
+	char name[BOOTSTAGE_SPAN_NAME_LEN];
+	uint32_t start_us;
+	uint32_t end_us;
+	uint32_t delay_us;
+	int16_t parent;
+	uint8_t type;
+	uint8_t depth;
+};
+
 /*
  * Return the time since boot in microseconds, This is needed for bootstage
  * and should be defined in CPU- or board-specific code. If undefined then
@@ -364,6 +416,20 @@ int bootstage_stash(void *base, int size);
  */
 int bootstage_unstash(const void *base, int size);
 
+/**
+ * bootstage_chrome_trace() - Write bootstage data as a Chrome trace
+ *
+ * This writes a JSON file in the Chrome trace-event format, which can be
+ * loaded into chrome://tracing or https://ui.perfetto.dev to see a timeline.
+ * Each mark is written as an instant event and each span as a complete event.
+ *
+ * @buf: Buffer to write to
+ * @size: Size of buffer in bytes
+ * Return: number of bytes written, not including the nul terminator, or
+ *	-ENOSPC if the buffer is too small
+ */
+int bootstage_chrome_trace(char *buf, int size);
+
 /**
  * bootstage_get_size() - Get the size of the bootstage data
  *
@@ -452,6 +518,85 @@ static inline int bootstage_init(bool first)
 
 #endif /* ENABLE_BOOTSTAGE */
 
+#if defined(ENABLE_BOOTSTAGE) && CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+
+/**
+ * bootstage_span_start() - Start a span of boot activity
+ *
+ * The span is nested inside the innermost span which is still open. It must
+ * be ended with bootstage_span_end()
+ *
+ * Spans are only recorded once the full malloc() pool is available, i.e.
+ * after relocation.
+ *
+ * @type: Type of span
+ * @name: Name of span, which is copied
+ * Return: index of the new span, or -ve if it was not recorded. This can be
+ *	passed to bootstage_span_end() in any case
+ */
+int bootstage_span_start(enum bootstage_span_type type, const char *name);
+
+/**
+ * bootstage_span_end() - End a span of boot activity
+ *
+ * Any spans inside this one which are still open are ended too
+ *
+ * @span: Span to end, as returned by bootstage_span_start()
+ */
+void bootstage_span_end(int span);
+
+/**
+ * bootstage_get_span() - Get a span
+ *
+ * @span: Index of span
+ * Return: span, or NULL if @span is out of range
+ */
+const struct bootstage_span *bootstage_get_span(int span);
+
+/**
+ * bootstage_span_clear() - Drop all spans recorded so far
+ *
+ * This is useful for timing a single command
+ *
+ * Return: 0 if OK, -ENOENT if bootstage is not set up, -EBUSY if any span is
+ *	still open
+ */
+int bootstage_span_clear(void);
+
+/**
+ * bootstage_add_delay() - Record time spent waiting in udelay()
+ *
+ * This is counted against the innermost open span, as well as in the total
+ * shown by bootstage_report()
+ *
+ * @us: Time spent, in microseconds
+ */
+void bootstage_add_delay(ulong us);
+
+#else
+
+static inline int bootstage_span_start(enum bootstage_span_type type,
+				       const char *name)
+{
+	return -1;
+}
+
+static inline void bootstage_span_end(int span) {}
+
+static inline const struct bootstage_span *bootstage_get_span(int span)
+{
+	return NULL;
+}
+
+static inline int bootstage_span_clear(void)
+{
+	return 0;
+}
+
+static inline void bootstage_add_delay(ulong us) {}
+
+#endif
+
 /* Helper macro for adding a bootstage to a line of code */
 #define BOOTSTAGE_MARKER()	\
 		bootstage_mark_code(__FILE__, __func__, __LINE__)
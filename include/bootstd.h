@@ -35,6 +35,8 @@ struct udevice;
  * @theme: Node containing the theme information
  * @hunters_used: Bitmask of used hunters, indexed by their position in the
  * linker list. The bit is set if the hunter has been used already
+ * @hunters_ahead: Bitmask of hunters which have been tried ahead of the scan,
+ * so that a failing hunter is not retried until its priority is reached
  */
 struct bootstd_priv {
 	const char **prefixes;
@@ -48,6 +50,7 @@ struct bootstd_priv {
 	struct udevice *vbe_bootmeth;
 	ofnode theme;
 	uint hunters_used;
+	uint hunters_ahead;
 };
 
 /**
@@ -14,6 +14,13 @@
 #include <linux/list.h>
 #include <asm/types.h>
 
+/*
+ * Number of buckets in the latency and jitter histograms. Bucket 0 counts
+ * values of 0us, bucket n counts values in [2^(n-1), 2^n) us and the last
+ * bucket counts everything larger.
+ */
+#define CYCLIC_HIST_BUCKETS	16
+
 /**
  * struct cyclic_info - Information about cyclic execution function
  *
@@ -25,7 +32,11 @@
  * @cpu_time_us: Total CPU time of this function
  * @run_cnt: Counter of executions occurances
  * @next_call: Next time in us, when the function shall be executed again
- * @list: List node
+ * @max_latency_us: Largest delay between @next_call and the actual call
+ * @last_latency_us: Delay of the most recent call, used to work out jitter
+ * @latency_hist: Histogram of the delay of each call after @next_call
+ * @jitter_hist: Histogram of the change in delay between successive calls
+ * @list: List node, the list is kept sorted by @next_call
  * @already_warned: Flag that we've warned about exceeding CPU time usage
  */
 struct cyclic_info {
@@ -37,6 +48,10 @@ struct cyclic_info {
 	uint64_t cpu_time_us;
 	uint64_t run_cnt;
 	uint64_t next_call;
+	uint64_t max_latency_us;
+	uint64_t last_latency_us;
+	uint32_t latency_hist[CYCLIC_HIST_BUCKETS];
+	uint32_t jitter_hist[CYCLIC_HIST_BUCKETS];
 	struct hlist_node list;
 	bool already_warned;
 };
@@ -86,6 +101,9 @@ struct hlist_head *cyclic_get_list(void);
  *
  * Interate over all registered cyclic functions and if the it's function
  * needs to be executed, then call into these registered functions.
+ *
+ * The list is sorted by the time of the next call, so when nothing is due
+ * this only reads the timer once and returns.
  */
 void cyclic_run(void);
 
@@ -112,6 +112,26 @@ enum {
 	DM_REMOVE_NO_PD		= 1 << 1,
 };
 
+/**
+ * struct dm_dev_timing - Time spent in driver model for a device
+ *
+ * Times are in microseconds. The 'self' times exclude time spent on other
+ * devices along the way, e.g. probing a parent or a clock which the device
+ * needs.
+ *
+ * @bind_us: Time taken to bind the device (self)
+ * @probe_us: Time taken to probe the device, including probing its parents
+ *	and suppliers
+ * @probe_self_us: Time taken to probe the device (self)
+ * @remove_us: Time taken to remove the device (self)
+ */
+struct dm_dev_timing {
+	u32 bind_us;
+	u32 probe_us;
+	u32 probe_self_us;
+	u32 remove_us;
+};
+
 /**
  * struct udevice - An instance of a driver
  *
@@ -166,6 +186,7 @@ enum {
  * @dma_offset: Offset between the physical address space (CPU's) and the
  *		device's bus address space
  * @iommu: IOMMU device associated with this device
+ * @timing: Time spent binding, probing and removing this device
  */
 struct udevice {
 	const struct driver *driver;
@@ -198,6 +219,9 @@ struct udevice {
 #if CONFIG_IS_ENABLED(IOMMU)
 	struct udevice *iommu;
 #endif
+#if CONFIG_IS_ENABLED(DM_TIMING)
+	struct dm_dev_timing timing;
+#endif
 };
 
 static inline int dm_udevice_size(void)
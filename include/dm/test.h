@@ -155,6 +155,9 @@ extern struct unit_test_state global_dm_test_state;
  *	2=upside down, 3=90 degree counterclockwise)
  * @vidconsole_drv_name: Name of video console driver (set by tests)
  * @font_size: Console font size to select (set by tests)
+ * @no_accel: true to reject the fill / copy / blit operations, so that the
+ *	uclass does them instead (set by tests)
+ * @accel_count: Number of fill / copy / blit operations done by the driver
  */
 struct sandbox_sdl_plat {
 	int xres;
@@ -163,6 +166,8 @@ struct sandbox_sdl_plat {
 	int rot;
 	const char *vidconsole_drv_name;
 	int font_size;
+	bool no_accel;
+	int accel_count;
 };
 
 /**
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Driver-model timing
+ */
+
+#ifndef _DM_TIMING_H
+#define _DM_TIMING_H
+
+struct driver;
+struct uclass;
+struct udevice;
+
+/**
+ * enum dm_timing_op - Driver-model operations which are timed
+ *
+ * @DM_TIMING_BIND: Binding a device
+ * @DM_TIMING_PROBE: Probing a device
+ * @DM_TIMING_REMOVE: Removing a device
+ */
+enum dm_timing_op {
+	DM_TIMING_BIND,
+	DM_TIMING_PROBE,
+	DM_TIMING_REMOVE,
+};
+
+/**
+ * struct dm_timing_state - State of a timed operation
+ *
+ * @active: true if the operation is being timed
+ * @start_us: Time when the operation started, in microseconds
+ * @outer_nested_us: Value of the nested time for the enclosing operation,
+ *	restored when this one ends
+ */
+struct dm_timing_state {
+	bool active;
+	ulong start_us;
+	ulong outer_nested_us;
+};
+
+/**
+ * struct dm_timing_totals - Timing totals for a group of devices
+ *
+ * @count: Number of devices in the group
+ * @bind_us: Total time taken to bind the devices
+ * @probe_us: Total time taken to probe the devices, including probing their
+ *	parents and suppliers
+ * @probe_self_us: Total time taken to probe just the devices themselves
+ * @remove_us: Total time taken to remove the devices
+ */
+struct dm_timing_totals {
+	uint count;
+	ulong bind_us;
+	ulong probe_us;
+	ulong probe_self_us;
+	ulong remove_us;
+};
+
+#if CONFIG_IS_ENABLED(DM_TIMING)
+/**
+ * dm_timing_start() - Start timing a driver-model operation
+ *
+ * Operations can nest, e.g. probing a device may probe its parent. The time
+ * taken by nested operations is not counted as the 'self' time of the
+ * enclosing one.
+ *
+ * Timing is only done after relocation, since the devices bound before
+ * relocation are discarded.
+ *
+ * @state: Returns the state to pass to dm_timing_end()
+ */
+void dm_timing_start(struct dm_timing_state *state);
+
+/**
+ * dm_timing_end() - Finish timing a driver-model operation
+ *
+ * This must be called for every call to dm_timing_start(), even if the
+ * operation fails, so that nested time is accounted correctly.
+ *
+ * @state: State from dm_timing_start()
+ * @dev: Device to record the time against, or NULL to discard it (e.g. if the
+ *	operation failed)
+ * @op: Operation which was timed
+ */
+void dm_timing_end(struct dm_timing_state *state, struct udevice *dev,
+		   enum dm_timing_op op);
+
+/**
+ * dm_timing_get_uclass() - Get the timing totals for a uclass
+ *
+ * @uc: Uclass to check
+ * @totals: Returns the totals for all devices in the uclass
+ */
+void dm_timing_get_uclass(struct uclass *uc, struct dm_timing_totals *totals);
+
+/**
+ * dm_timing_get_driver() - Get the timing totals for a driver
+ *
+ * @drv: Driver to check
+ * @totals: Returns the totals for all devices bound to the driver
+ */
+void dm_timing_get_driver(const struct driver *drv,
+			  struct dm_timing_totals *totals);
+
+/**
+ * dm_timing_reset() - Reset the timing for all devices
+ */
+void dm_timing_reset(void);
+
+/**
+ * dm_timing_add_fdt() - Add driver-model timing to a devicetree
+ *
+ * This adds a 'dm' subnode to @parent, holding a 'uclass' and a 'driver'
+ * subnode. Each of these holds a node for each of the slowest uclasses or
+ * drivers, with properties for the device count and the timing totals. The
+ * devicetree is not enlarged, so entries which do not fit are left out.
+ *
+ * @blob: Devicetree to update
+ * @parent: Offset of parent node (normally /bootstage)
+ * Return: 0 if OK, -ve on error
+ */
+int dm_timing_add_fdt(void *blob, int parent);
+#else
+static inline void dm_timing_start(struct dm_timing_state *state)
+{
+}
+
+static inline void dm_timing_end(struct dm_timing_state *state,
+				 struct udevice *dev, enum dm_timing_op op)
+{
+}
+
+static inline int dm_timing_add_fdt(void *blob, int parent)
+{
+	return 0;
+}
+#endif
+
+#endif
@@ -61,6 +61,16 @@ void dm_dump_static_driver_info(void);
  */
 void dm_dump_mem(struct dm_stats *stats);
 
+/**
+ * dm_dump_timing() - Dump the time spent in driver model
+ *
+ * Shows the devices which took longest to probe, then the totals for each
+ * uclass and driver
+ *
+ * @count: Maximum number of devices to show
+ */
+void dm_dump_timing(int count);
+
 #if CONFIG_IS_ENABLED(OF_PLATDATA_INST) && CONFIG_IS_ENABLED(READ_ONLY)
 void *dm_priv_to_rw(void *priv);
 #else
@@ -136,6 +136,23 @@ struct efi_var_file {
 	struct efi_var_entry var[];
 };
 
+/**
+ * struct efi_var_journal - record of a change to a variable
+ *
+ * Changes to non-volatile variables are appended to the variables file after
+ * the variables in struct efi_var_file. Each record is followed by the
+ * changed variable as struct efi_var_entry, padded to a multiple of 8 bytes.
+ * A variable without data is deleted.
+ *
+ * @length:	length of the record including header and variable
+ * @crc32:	CRC32 of the record without header, continuing from the CRC32 of
+ *		the previous record, or of the variables for the first record
+ */
+struct efi_var_journal {
+	u32 length;
+	u32 crc32;
+};
+
 /**
  * efi_var_to_file() - save non-volatile variables as file
  *
@@ -145,6 +162,21 @@ struct efi_var_file {
  */
 efi_status_t efi_var_to_file(void);
 
+/**
+ * efi_var_file_append() - save a change of a non-volatile variable
+ *
+ * The current value of the variable is appended to the journal in file
+ * ubootefi.var, or the variable is marked as deleted if it no longer exists.
+ * The whole file is written instead if it has not been read or written
+ * before, or if the journal would grow too long.
+ *
+ * @variable_name:	name of the variable
+ * @vendor:		vendor GUID
+ * Return:		status code
+ */
+efi_status_t efi_var_file_append(const u16 *variable_name,
+				 const efi_guid_t *vendor);
+
 /**
  * efi_var_collect() - collect variables in buffer
  *
@@ -172,11 +204,30 @@ efi_status_t __maybe_unused efi_var_collect(struct efi_var_file **bufp, loff_t *
  */
 efi_status_t efi_var_restore(struct efi_var_file *buf, bool safe);
 
+/**
+ * efi_var_replay() - apply the journal in a variables file
+ *
+ * The changes recorded in the journal after the variables in @buf are applied
+ * to these variables. Replay stops at the first record which is incomplete or
+ * does not continue the chain of CRC32 values. This is the end of the journal,
+ * or a record which was not completely written, e.g. due to a power failure.
+ * Anything after it is left over from before the file was last written in
+ * full.
+ *
+ * @buf:	buffer with the contents of the file, EFI_VAR_BUF_SIZE bytes
+ * @len:	length of the file
+ * @crcp:	returns the CRC32 of the last valid record
+ * Return:	offset of the end of the valid journal, or 0 if the variables
+ *		are invalid
+ */
+loff_t efi_var_replay(struct efi_var_file *buf, loff_t len, u32 *crcp);
+
 /**
  * efi_var_from_file() - read variables from file
  *
  * File ubootefi.var is read from the EFI system partitions and the variables
- * stored in the file are created.
+ * stored in the file are created, with the changes recorded in its journal
+ * applied.
  *
  * In case the file does not exist yet or a variable cannot be set EFI_SUCCESS
  * is returned.
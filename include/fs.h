@@ -237,6 +237,74 @@ struct fs_dirent *fs_readdir(struct fs_dir_stream *dirs);
  */
 void fs_closedir(struct fs_dir_stream *dirs);
 
+/**
+ * struct fs_file_stream - file opened for reading
+ *
+ * Only @size may be used outside the fs layer. File systems which support
+ * opening files embed this as the first member of their own structure.
+ *
+ * @size:	size of the file in bytes
+ * @name:	path of the file as opened (private to fs layer)
+ * @desc:	block device (private to fs layer)
+ * @part:	partition number (private to fs layer)
+ * @fstype:	file system type (private to fs layer)
+ * @generation:	number of writes to any file system or block device before
+ *		the file was opened (private to fs layer)
+ */
+struct fs_file_stream {
+	loff_t size;
+	char *name;
+	struct blk_desc *desc;
+	int part;
+	int fstype;
+	uint generation;
+};
+
+/**
+ * fs_openfile() - open a file for reading
+ *
+ * The file is looked up once. It can then be read many times with
+ * fs_readfile(), without probing the file system or looking up the file
+ * again, where the file system supports this.
+ *
+ * @filename:	path of the file to open
+ * Return: file stream, or NULL on error with errno set appropriately
+ */
+struct fs_file_stream *fs_openfile(const char *filename);
+
+/**
+ * fs_file_stale() - check whether a file stream is out of date
+ *
+ * A file stream cannot be used any more once a file system or block device
+ * has been written to, since the file may have changed, or once a block device
+ * has been removed. It must be closed and the file opened again.
+ *
+ * @file:	file stream
+ * Return: true if the file stream is out of date
+ */
+bool fs_file_stale(struct fs_file_stream *file);
+
+/**
+ * fs_readfile() - read from a file stream
+ *
+ * @file:	file stream
+ * @buf:	buffer to read into
+ * @offset:	offset in the file to read from
+ * @len:	number of bytes to read, or 0 to read to the end of the file
+ * @actread:	returns the number of bytes read
+ * Return: 0 on success, -ESTALE if the file stream is out of date, other
+ *	-ve on error
+ */
+int fs_readfile(struct fs_file_stream *file, void *buf, loff_t offset,
+		loff_t len, loff_t *actread);
+
+/**
+ * fs_closefile() - close a file stream
+ *
+ * @file:	file stream, may be NULL
+ */
+void fs_closefile(struct fs_file_stream *file);
+
 /*
  * fs_unlink - delete a file or directory
  *
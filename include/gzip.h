@@ -31,6 +31,28 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
  */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 
+/**
+ * gunzip_fn() - Decompress gzipped data, showing each piece to a function
+ *
+ * This is the same as gunzip() except that the input is decompressed in
+ * pieces, each of which is first passed to @func. This allows the input to be
+ * hashed while it is being decompressed, instead of in a separate pass. All
+ * of the input is passed to @func, including the gzip header and trailer.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @src: Source data to decompress
+ * @lenp: On entry, length of data at @src. On exit, length of uncompressed
+ *	data
+ * @func: Function to call with each piece of @src before it is used. It
+ *	should return 0 to continue, or -ve to stop
+ * @priv: Private data for @func
+ * Return: 0 if OK, -1 on error, or the error returned by @func
+ */
+int gunzip_fn(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
+	      int (*func)(void *priv, const void *buf, ulong size, bool last),
+	      void *priv);
+
 /**
  * zunzip() - Uncompress blocks compressed with zlib without headers
  *
@@ -149,6 +149,58 @@ int hash_lookup_algo(const char *algo_name, struct hash_algo **algop);
 int hash_progressive_lookup_algo(const char *algo_name,
 				 struct hash_algo **algop);
 
+/**
+ * struct hash_stream - A hash calculated over data supplied in pieces
+ *
+ * This wraps the progressive functions of a hash_algo so that data can be
+ * hashed as it is produced or consumed, rather than in a separate pass once
+ * it is all in memory. The result is the same as from hash_func_ws().
+ *
+ * @algo: Algorithm in use
+ * @ctx: Context from algo->hash_init(), NULL once the hash is finished
+ */
+struct hash_stream {
+	struct hash_algo *algo;
+	void *ctx;
+};
+
+/**
+ * hash_stream_init() - Start a streaming hash
+ *
+ * @hs: Stream to set up
+ * @algo_name: Hash algorithm to use
+ * Return: 0 if ok, -EPROTONOSUPPORT if the algorithm is unknown or does not
+ * support progressive hashing, -EIO if it could not be started
+ */
+int hash_stream_init(struct hash_stream *hs, const char *algo_name);
+
+/**
+ * hash_stream_update() - Add the next piece of data to a streaming hash
+ *
+ * @hs: Stream to update
+ * @buf: Data to hash
+ * @size: Number of bytes in @buf
+ * @is_last: true if this is the last piece of data
+ * Return: 0 if ok, -EIO on error, after which the stream is finished
+ */
+int hash_stream_update(struct hash_stream *hs, const void *buf, uint size,
+		       bool is_last);
+
+/**
+ * hash_stream_finish() - Finish a streaming hash and obtain the result
+ *
+ * The stream is finished even if an error is returned. Passing a NULL
+ * @output discards the result, which is useful on error paths.
+ *
+ * @hs: Stream to finish
+ * @output: Place to put the hash value, or NULL
+ * @output_size: On entry, the number of bytes available in @output. On
+ *	exit, the number of bytes used. Ignored if @output is NULL
+ * Return: 0 if ok, -ENOSPC if @output is too small, -EIO on other error
+ */
+int hash_stream_finish(struct hash_stream *hs, uint8_t *output,
+		       int *output_size);
+
 /**
  * hash_parse_string() - Parse hash string into a binary array
  *
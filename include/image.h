@@ -365,6 +365,7 @@ struct bootm_headers {
 	void		*fit_hdr_os;	/* os FIT image header */
 	const char	*fit_uname_os;	/* os subimage node unit name */
 	int		fit_noffset_os;	/* os subimage node offset */
+	bool		fit_verify_os;	/* os hashes to be checked on load */
 
 	void		*fit_hdr_rd;	/* init ramdisk FIT image header */
 	const char	*fit_uname_rd;	/* init ramdisk subimage node unit name */
@@ -704,12 +705,47 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
  * @param datap		Returns address of loaded image
  * @param lenp		Returns length of loaded image
  * Return: node offset of image, or -ve error code on error
+ *
+ * With CONFIG_FIT_VERIFY_ON_LOAD, hashes are checked while the image is
+ * copied or decompressed to its load address, where possible. A kernel loaded
+ * with FIT_LOAD_IGNORED is not copied here, so its hashes are not checked
+ * either: images->fit_verify_os is set instead, and the caller must then load
+ * it with fit_image_decomp()
  */
 int fit_image_load(struct bootm_headers *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int image_ph_type, int bootstage_id,
 		   enum fit_load_op load_op, ulong *datap, ulong *lenp);
 
+/**
+ * fit_image_decomp() - load an image from a FIT, checking its hashes
+ *
+ * This copies or decompresses an image to its load address like
+ * image_decomp(), calculating the image's hashes from the data as it is used
+ * and checking them at the end. If that is not possible, e.g. because the
+ * image is signed, it is verified with fit_image_verify() first instead.
+ *
+ * If a hash does not match, the data at the load address must not be used.
+ *
+ * @fit:	FIT containing the image
+ * @noffset:	Offset of the image node
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load:	Destination load address in U-Boot memory
+ * @image_start Image start address (where we are decompressing from)
+ * @type:	OS type (IH_OS_...)
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address to decompress from
+ * @image_len:	Number of bytes in @image_buf to decompress
+ * @unc_len:	Available space for decompression
+ * @load_end:	Returns the end of the decompressed data
+ * Return: 0 if OK, -EACCES if the image failed verification, other -ve
+ * error from image_decomp()
+ */
+int fit_image_decomp(const void *fit, int noffset, int comp, ulong load,
+		     ulong image_start, int type, void *load_buf,
+		     void *image_buf, ulong image_len, uint unc_len,
+		     ulong *load_end);
+
 /**
  * image_locate_script() - Locate the raw script in an image
  *
@@ -944,6 +980,35 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		 void *load_buf, void *image_buf, ulong image_len,
 		 uint unc_len, ulong *load_end);
 
+/**
+ * image_decomp_fn() - decompress an image, showing the input to a function
+ *
+ * This is the same as image_decomp() except that all of the input is passed
+ * to @func, in order, as it is used. For uncompressed and gzip images each
+ * piece is passed just before it is copied or decompressed, so that a hash
+ * can be calculated without reading the data again.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load:	Destination load address in U-Boot memory
+ * @image_start Image start address (where we are decompressing from)
+ * @type:	OS type (IH_OS_...)
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address to decompress from
+ * @image_len:	Number of bytes in @image_buf to decompress
+ * @unc_len:	Available space for decompression
+ * @load_end:	Returns the end of the decompressed data
+ * @func:	Function to call with each piece of input, or NULL. It should
+ *		return 0 to continue, or -ve to stop
+ * @priv:	Private data for @func
+ * Return: 0 if OK, -ve on error, including any error from @func
+ */
+int image_decomp_fn(int comp, ulong load, ulong image_start, int type,
+		    void *load_buf, void *image_buf, ulong image_len,
+		    uint unc_len, ulong *load_end,
+		    int (*func)(void *priv, const void *buf, ulong size,
+				bool last),
+		    void *priv);
+
 /**
  * Set up properties in the FDT
  *
@@ -1231,11 +1296,14 @@ struct image_summary {
  * @engine_id:	Engine to use for signing
  * @cmdname:	Command name used when reporting errors
  * @algo_name:	Algorithm name, or NULL if to be read from FIT
+ * @threads:	Number of threads to use to calculate image hashes (0 or 1 to
+ *		calculate them one at a time)
  * @summary:	Returns information about what data was written
  *
  * Adds hash values for all component images in the FIT blob.
  * Hashes are calculated for all component images which have hash subnodes
  * with algorithm property set to one of the supported hash algorithms.
+ * The result does not depend on @threads.
  *
  * Also add signatures if signature nodes are present.
  *
@@ -1247,7 +1315,7 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary);
+			      int threads, struct image_summary *summary);
 
 /**
  * fit_image_verify_with_data() - Verify an image with given data
@@ -455,4 +455,78 @@ struct abuf;
  */
 int zstd_decompress(struct abuf *in, struct abuf *out);
 
+/**
+ * struct zstd_ctx - Reusable decompression context
+ *
+ * Allocating and initialising a context costs far more than decompressing a
+ * small block, so users which decompress many blocks should keep one of these
+ * around instead of calling zstd_decompress() each time.
+ *
+ * @dctx: Decompression context, inside @workspace
+ * @workspace: Memory holding the context and, for streaming, its buffers
+ * @max_window: Largest window supported for streaming, 0 if none
+ */
+struct zstd_ctx {
+	zstd_dctx *dctx;
+	void *workspace;
+	size_t max_window;
+};
+
+/**
+ * zstd_ctx_init() - Set up a reusable decompression context
+ *
+ * @ctx: Context to set up
+ * @max_window: Largest window size to support with zstd_stream_decompress(),
+ *	or 0 if the context is only used with zstd_decompress_ctx()
+ * Return: 0 if OK, -ENOMEM if out of memory, -EPERM if zstd failed
+ */
+int zstd_ctx_init(struct zstd_ctx *ctx, size_t max_window);
+
+/**
+ * zstd_ctx_uninit() - Free the memory used by a decompression context
+ *
+ * @ctx: Context to free, which may be uninitialised if zeroed
+ */
+void zstd_ctx_uninit(struct zstd_ctx *ctx);
+
+/**
+ * zstd_decompress_ctx() - Decompress Zstandard data using a context
+ *
+ * This is the same as zstd_decompress() but does not allocate anything.
+ *
+ * @ctx: Context set up by zstd_ctx_init()
+ * @in: Input buffer to decompress
+ * @out: Output buffer to hold the results (must be large enough)
+ * Return: size of the decompressed data, or -ve on error
+ */
+int zstd_decompress_ctx(struct zstd_ctx *ctx, struct abuf *in,
+			struct abuf *out);
+
+/**
+ * zstd_stream_start() - Prepare a context to decompress a new frame
+ *
+ * @ctx: Context set up by zstd_ctx_init() with a non-zero window
+ * Return: 0 if OK, -EINVAL if the context cannot stream
+ */
+int zstd_stream_start(struct zstd_ctx *ctx);
+
+/**
+ * zstd_stream_decompress() - Decompress part of a frame
+ *
+ * This consumes as much of @in as possible, starting at @in_pos, and writes
+ * to @out starting at @out_pos, updating both positions. Call it again with
+ * more input, or more space, until it returns 0.
+ *
+ * @ctx: Context prepared with zstd_stream_start()
+ * @in: Input buffer
+ * @in_pos: Position within @in, updated on return
+ * @out: Output buffer
+ * @out_pos: Position within @out, updated on return
+ * Return: 0 if the frame is complete and all its data written, 1 if more
+ *	input or output space is needed, -EINVAL if the data is corrupt or
+ *	needs a larger window than the context supports
+ */
+int zstd_stream_decompress(struct zstd_ctx *ctx, struct abuf *in,
+			   size_t *in_pos, struct abuf *out, size_t *out_pos);
+
 #endif  /* LINUX_ZSTD_H */
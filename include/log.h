@@ -418,6 +418,8 @@ enum log_device_flags {
  *
  * @name: Name of driver
  * @emit: Method to call to emit a log record via this device
+ * @emit_fmt: Method to call to emit an unformatted log record (optional)
+ * @probe: Method to call to set up the device (optional)
  * @flags: Initial value for flags (use LOGDF_ENABLE to enable on start-up)
  */
 struct log_driver {
@@ -430,6 +432,29 @@ struct log_driver {
 	 * for processing. The filter is checked before calling this function.
 	 */
 	int (*emit)(struct log_device *ldev, struct log_rec *rec);
+
+	/**
+	 * @emit_fmt: emit a log record without formatting its message
+	 *
+	 * If provided, this is called instead of @emit, which is then not
+	 * needed. The message is passed as a printf() format string and its
+	 * arguments, so the driver can put off formatting it. @rec->msg may be
+	 * NULL, or it may hold the message if another driver has already
+	 * formatted it.
+	 *
+	 * Format strings passed to log() are constant, so the driver may keep
+	 * a pointer to @fmt, but not to any of @args.
+	 */
+	int (*emit_fmt)(struct log_device *ldev, struct log_rec *rec,
+			const char *fmt, va_list args);
+
+	/**
+	 * @probe: set up a log device
+	 *
+	 * Called by log_init() after the device for this driver is created.
+	 * This runs both before and after relocation.
+	 */
+	int (*probe)(struct log_device *ldev);
 	unsigned short flags;
 };
 
@@ -447,6 +472,7 @@ struct log_driver {
  * @drv: Pointer to driver for this device
  * @filter_head: List of filters for this device
  * @sibling_node: Next device in the list of all devices
+ * @priv: Private data for the driver, or NULL if none
  */
 struct log_device {
 	unsigned short next_filter_num;
@@ -454,6 +480,7 @@ struct log_device {
 	struct log_driver *drv;
 	struct list_head filter_head;
 	struct list_head sibling_node;
+	void *priv;
 };
 
 enum {
@@ -686,4 +713,57 @@ static inline int log_get_default_format(void)
 	       (IS_ENABLED(CONFIG_LOGF_FUNC) ? BIT(LOGF_FUNC) : 0);
 }
 
+/**
+ * struct log_ring_stats - Information about the log ring
+ *
+ * @count: Number of records held in the ring
+ * @dropped: Number of records overwritten to make space for newer ones
+ * @used: Number of bytes used by the records
+ * @size: Size of the ring in bytes
+ */
+struct log_ring_stats {
+	ulong count;
+	ulong dropped;
+	ulong used;
+	ulong size;
+};
+
+/**
+ * log_ring_dump() - Show the records held in the log ring
+ *
+ * Each record is formatted and written to the console, oldest first, using
+ * the current log format (see 'log format')
+ *
+ * Return: 0 if OK, -ENOENT if there is no log ring
+ */
+int log_ring_dump(void);
+
+/**
+ * log_ring_clear() - Remove all records from the log ring
+ *
+ * Return: 0 if OK, -ENOENT if there is no log ring
+ */
+int log_ring_clear(void);
+
+/**
+ * log_ring_get_stats() - Get information about the log ring
+ *
+ * @stats: Returns the information
+ * Return: 0 if OK, -ENOENT if there is no log ring
+ */
+int log_ring_get_stats(struct log_ring_stats *stats);
+
+/**
+ * log_ring_handoff() - Pass the log ring to the OS
+ *
+ * This formats the records in the log ring into a bloblist record with the
+ * tag BLOBLISTT_U_BOOT_LOG, as a nul-terminated string with one line per
+ * record. If there is not room for them all, only the newest records which
+ * fit are included.
+ *
+ * Return: 0 if OK, -ENOENT if there is no log ring, -ENOSPC if there is no
+ * space in the bloblist
+ */
+int log_ring_handoff(void);
+
 #endif
@@ -74,6 +74,8 @@ struct bd_info;
 #define MMC_CAP_NONREMOVABLE	BIT(14)
 #define MMC_CAP_NEEDS_POLL	BIT(15)
 #define MMC_CAP_CD_ACTIVE_HIGH  BIT(16)
+#define MMC_CAP_CMD23		BIT(17)	/* host can do CMD23 (SET_BLOCK_COUNT) */
+#define MMC_CAP_CQE		BIT(18)	/* host has a command queue engine */
 
 #define MMC_MODE_8BIT		BIT(30)
 #define MMC_MODE_4BIT		BIT(29)
@@ -82,6 +84,7 @@ struct bd_info;
 
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_CMD23_SUPPORT	0x00000002
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -213,6 +216,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_CMDQ_MODE_EN		15	/* R/W */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -243,6 +247,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_SEC_FEATURE		231	/* RO */
 #define EXT_CSD_GENERIC_CMD6_TIME       248     /* RO */
+#define EXT_CSD_CMDQ_DEPTH		307	/* RO */
+#define EXT_CSD_CMDQ_SUPPORT		308	/* RO */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -429,6 +435,28 @@ struct mmc_data {
 	uint blocksize;
 };
 
+/* Largest command queue supported by eMMC */
+#define MMC_CQE_MAX_DEPTH	32
+
+/**
+ * struct mmc_cqe_task - a data transfer queued on a command queue engine
+ *
+ * @start:	First block to transfer
+ * @blkcnt:	Number of blocks to transfer, at most 65535
+ * @buf:	Buffer to read into or write from
+ * @write:	true to write to the card, false to read
+ * @tag:	Task ID, from 0 to the queue depth - 1
+ * @status:	Set on completion: 0 if OK, -ve on error
+ */
+struct mmc_cqe_task {
+	lbaint_t start;
+	uint blkcnt;
+	void *buf;
+	bool write;
+	int tag;
+	int status;
+};
+
 /* forward decl. */
 struct mmc;
 
@@ -542,6 +570,48 @@ struct dm_mmc_ops {
 	 * @return 0 if success, -ve on error
 	 */
 	int (*hs400_prepare_ddr)(struct udevice *dev);
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/**
+	 * cqe_present() - Check whether the host has a command queue engine
+	 *
+	 * Optional. Drivers which support several controllers, only some of
+	 * which have an engine, use this to report whether this one does.
+	 * If not provided, the engine is assumed to be present.
+	 *
+	 * @dev:	Device to check
+	 * @return true if present, false if not
+	 */
+	bool (*cqe_present)(struct udevice *dev);
+
+	/**
+	 * cqe_enable() - Turn the command queue engine on or off
+	 *
+	 * This is called after the card has been put in command queue mode
+	 * and before it is taken out of it. While the engine is on, the host
+	 * cannot send normal commands.
+	 *
+	 * @dev:	Device to update
+	 * @enable:	true to enable, false to disable
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cqe_enable)(struct udevice *dev, bool enable);
+
+	/**
+	 * cqe_run() - Queue data tasks and wait for all of them to complete
+	 *
+	 * All tasks are handed to the engine before waiting, so the device
+	 * may execute them in any order. The status of each task is updated
+	 * on completion.
+	 *
+	 * @dev:	Device to use
+	 * @tasks:	Tasks to run, each with a different tag
+	 * @count:	Number of tasks, at most the card's queue depth
+	 * @return 0 if all tasks completed, -ve if the engine failed
+	 */
+	int (*cqe_run)(struct udevice *dev, struct mmc_cqe_task *tasks,
+		       int count);
+#endif
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
@@ -558,6 +628,9 @@ int mmc_deferred_probe(struct mmc *mmc);
 int mmc_reinit(struct mmc *mmc);
 int mmc_get_b_max(struct mmc *mmc, void *dst, lbaint_t blkcnt);
 int mmc_hs400_prepare_ddr(struct mmc *mmc);
+bool mmc_cqe_present(struct mmc *mmc);
+int mmc_cqe_enable(struct mmc *mmc, bool enable);
+int mmc_cqe_run(struct mmc *mmc, struct mmc_cqe_task *tasks, int count);
 #else
 struct mmc_ops {
 	int (*send_cmd)(struct mmc *mmc,
@@ -735,6 +808,7 @@ struct mmc {
 				  */
 	u32 quirks;
 	u8 hs400_tuning;
+	u8 cmdq_depth;		/* 0 if the card has no command queue */
 
 	enum bus_mode user_speed_mode; /* input speed mode from user */
 };
@@ -124,6 +124,20 @@ unsigned int os_alarm(unsigned int seconds);
  */
 void os_set_alarm_handler(void (*handler)(int));
 
+/**
+ * os_set_sample_handler() - set handler for profiling samples
+ *
+ * This starts a timer which raises SIGPROF each time @interval_us of CPU time
+ * has been used. The handler is called from the signal handler with the code
+ * addresses on the stack, starting with the one which was executing.
+ *
+ * @interval_us:	Time between samples in microseconds
+ * @handler:	Function to call for each sample, or NULL to stop sampling
+ * Return: 0 if OK, -1 on error
+ */
+int os_set_sample_handler(unsigned int interval_us,
+			  void (*handler)(void *const *addrs, int count));
+
 /**
  * os_raise_sigalrm() - do raise(SIGALRM)
  */
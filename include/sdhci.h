@@ -123,6 +123,7 @@
 #define  SDHCI_INT_CARD_INSERT	BIT(6)
 #define  SDHCI_INT_CARD_REMOVE	BIT(7)
 #define  SDHCI_INT_CARD_INT	BIT(8)
+#define  SDHCI_INT_CQE		BIT(14)
 #define  SDHCI_INT_ERROR	BIT(15)
 #define  SDHCI_INT_TIMEOUT	BIT(16)
 #define  SDHCI_INT_CRC		BIT(17)
@@ -251,6 +252,8 @@
 #define SDHCI_QUIRK_SUPPORT_SINGLE	(1 << 10)
 /* Capability register bit-63 indicates HS400 support */
 #define SDHCI_QUIRK_CAPS_BIT63_FOR_HS400	BIT(11)
+/* Controller cannot send CMD23 ahead of multi-block transfers */
+#define SDHCI_QUIRK_NO_CMD23		BIT(12)
 
 /* to make gcc happy */
 struct sdhci_host;
@@ -355,6 +358,11 @@ struct sdhci_host {
 #if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
 	struct sdhci_adma_desc *adma_desc_table;
 #endif
+#if CONFIG_IS_ENABLED(MMC_SDHCI_CQE)
+	void *cqe_base;		/* CQHCI registers, set by the driver if present */
+	void *cqe_desc;		/* Task and link descriptor for each tag */
+	void *cqe_trans;	/* Transfer descriptors for each tag */
+#endif
 };
 
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
@@ -529,4 +537,24 @@ struct sdhci_adma_desc *sdhci_adma_init(void);
 void sdhci_prepare_adma_table(struct sdhci_adma_desc *table,
 			      struct mmc_data *data, dma_addr_t addr);
 
+/**
+ * sdhci_cqe_enable() - Switch the host between SDHCI and CQHCI operation
+ *
+ * @host:	SDHCI host structure, with @cqe_base set
+ * @enable:	true to hand the bus to the command queue engine
+ * Return: 0 if OK, -ENOSYS if the host has no CQHCI, other -ve on error
+ */
+int sdhci_cqe_enable(struct sdhci_host *host, bool enable);
+
+/**
+ * sdhci_cqe_run() - Issue a set of tasks to CQHCI and wait for them
+ *
+ * @host:	SDHCI host structure, with the command queue engine enabled
+ * @tasks:	Tasks to issue, one per tag
+ * @count:	Number of tasks
+ * Return: 0 if each task's status was updated, -ve if the engine failed
+ */
+int sdhci_cqe_run(struct sdhci_host *host, struct mmc_cqe_task *tasks,
+		  int count);
+
 #endif /* __SDHCI_HW_H */
@@ -151,6 +151,17 @@ enum {
  */
 struct udevice *testbus_get_clear_removed(void);
 
+/**
+ * testfdt_set_probe_delay() - Test function to slow down probing
+ *
+ * This is used to check the time recorded for probing a device. Each testfdt
+ * device probed after this call waits for the given time in its probe()
+ * method. Use 0 to stop waiting.
+ *
+ * @delay_us: Time to wait in microseconds
+ */
+void testfdt_set_probe_delay(ulong delay_us);
+
 #ifdef CONFIG_SANDBOX
 #include <asm/state.h>
 #include <asm/test.h>
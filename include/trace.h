@@ -29,11 +29,15 @@ enum {
 	FUNC_SITE_SIZE	= 16,	/* distance between function sites */
 
 	TRACE_VERSION	= 1,
+
+	/* Maximum number of stack frames recorded for each sample */
+	TRACE_SAMPLE_MAX_DEPTH	= 32,
 };
 
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_SAMPLES,
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -89,6 +93,66 @@ struct trace_call {
 
 int trace_list_calls(void *buff, size_t buff_size, size_t *needed);
 
+/*
+ * A program-counter sample, as written to the profile output file
+ *
+ * This is followed by @depth uint32_t values, each the offset of a code
+ * address into the text. The first is the address which was executing and
+ * the rest are return addresses, working outwards through the call stack.
+ */
+struct trace_sample {
+	uint32_t depth;		/* Number of addresses which follow */
+};
+
+/**
+ * trace_list_samples() - Dump the program-counter samples into a buffer
+ *
+ * The buffer receives a struct trace_output_hdr of type TRACE_CHUNK_SAMPLES
+ * followed by the samples, each a struct trace_sample and its addresses.
+ *
+ * @buff:	Buffer in which to place data, or NULL to count size
+ * @buff_size:	Size of buffer
+ * @needed:	Returns number of bytes used / needed
+ * Return: 0 if ok, -ENOSPC if space was exhausted
+ */
+int trace_list_samples(void *buff, size_t buff_size, size_t *needed);
+
+/**
+ * trace_sample_start() - Start sampling the program counter
+ *
+ * On sandbox this uses a timer based on the CPU time used. Elsewhere a
+ * sample is taken in schedule() once @interval_us has passed, recording
+ * only the caller of schedule().
+ *
+ * @interval_us:	Time between samples in microseconds
+ * Return: 0 if ok, -ENOSYS if trace is not set up, other -ve on error
+ */
+int trace_sample_start(unsigned int interval_us);
+
+/** trace_sample_stop() - Stop sampling the program counter */
+void trace_sample_stop(void);
+
+/**
+ * trace_sample_add() - Record a program-counter sample
+ *
+ * Addresses outside the U-Boot text are dropped. This may be called from a
+ * signal handler on sandbox.
+ *
+ * @addrs:	Code addresses, starting with the one executing
+ * @count:	Number of addresses
+ */
+void trace_sample_add(void *const *addrs, int count);
+
+/**
+ * trace_sample_poll() - Take a sample if one is due
+ *
+ * This is called from schedule() on boards which cannot sample from a timer
+ * interrupt.
+ *
+ * @pc:	Address of the code which called schedule()
+ */
+void trace_sample_poll(void *pc);
+
 /**
  * Turn function tracing on and off
  *
@@ -6,21 +6,120 @@
 #ifndef __LZ4_H
 #define __LZ4_H
 
+#include <linux/types.h>
+
+/**
+ * struct ulz4_stream - State of a streaming LZ4 decompression
+ *
+ * The output is written to a single contiguous buffer, so linked blocks can
+ * refer back into earlier output without keeping a separate history window.
+ * Input may be supplied in pieces of any size; a block which is split
+ * across pieces is gathered into @buf first. All members are private.
+ *
+ * @dst: Start of output buffer
+ * @out: Next byte to write
+ * @end: End of output buffer
+ * @frame: Start of the output of the current frame
+ * @state: Current position in the stream (enum ulz4_state)
+ * @flags: FLG byte of the current frame
+ * @legacy: true if the current frame uses the legacy format
+ * @frames: Number of frames started so far
+ * @block_max: Maximum size of a block in the current frame
+ * @block_header: Header of the current block
+ * @block_csum: Checksum of the current block data
+ * @need: Number of bytes needed to process the current field
+ * @have: Number of bytes of the current field gathered so far
+ * @hdr: Buffer for headers and checksums
+ * @buf: Buffer for block data, allocated when first needed
+ * @buf_size: Size of @buf
+ */
+struct ulz4_stream {
+	void *dst;
+	void *out;
+	void *end;
+	void *frame;
+	int state;
+	uint8_t flags;
+	bool legacy;
+	uint frames;
+	uint32_t block_max;
+	uint32_t block_header;
+	uint32_t block_csum;
+	uint32_t need;
+	uint32_t have;
+	uint8_t hdr[16];
+	uint8_t *buf;
+	size_t buf_size;
+};
+
 /**
  * ulz4fn() - Decompress LZ4 data
  *
+ * Decompresses one or more concatenated frames, which may use independent or
+ * linked blocks, or the legacy format generated by 'lz4 -l'. Skippable frames
+ * are ignored, as is any data following the last frame.
+ *
  * @src: Source data to decompress
  * @srcn: Length of source data
  * @dst: Destination for uncompressed data
  * @dstn: Returns length of uncompressed data
  * Return: 0 if OK, -EPROTONOSUPPORT if the magic number or version number are
- *	not recognised or independent blocks are used, -EINVAL if the reserved
- *	fields are non-zero, or input is overrun, -EENOBUFS if the destination
- *	buffer is overrun, -EEPROTO if the compressed data causes an error in
- *	the decompression algorithm
+ *	not recognised, -EINVAL if the reserved fields are non-zero, or input is
+ *	overrun, -ENOBUFS if the destination buffer is overrun, -EPROTO if the
+ *	compressed data causes an error in the decompression algorithm,
+ *	-EBADMSG if a header, block or content checksum does not match
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * ulz4_stream_init() - Start a streaming decompression
+ *
+ * @strm: Stream state to set up
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of destination buffer
+ */
+void ulz4_stream_init(struct ulz4_stream *strm, void *dst, size_t dstn);
+
+/**
+ * ulz4_stream_decompress() - Decompress the next piece of a stream
+ *
+ * All of the input is consumed. Blocks are decompressed as soon as they are
+ * complete, so the output grows as input is supplied.
+ *
+ * @strm: Stream state
+ * @src: Next piece of compressed data
+ * @srcn: Length of @src
+ * Return: 0 if the input ended at a point where the stream may be complete,
+ *	1 if more input is needed to finish the current frame, -ENOMEM if
+ *	there is no memory to gather a split block, otherwise an error as for
+ *	ulz4fn()
+ */
+int ulz4_stream_decompress(struct ulz4_stream *strm, const void *src,
+			   size_t srcn);
+
+/**
+ * ulz4_stream_want() - Get the input needed to finish the current field
+ *
+ * A caller which has all the input in memory, but passes it in pieces, can
+ * use this to supply each field (header, block or checksum) in one piece, so
+ * that it is used where it is rather than gathered into @buf.
+ *
+ * @strm: Stream state
+ * Return: number of bytes, or 0 if the stream has ended and any further input
+ *	is ignored
+ */
+size_t ulz4_stream_want(const struct ulz4_stream *strm);
+
+/**
+ * ulz4_stream_end() - Finish a streaming decompression
+ *
+ * This frees any memory used by the stream.
+ *
+ * @strm: Stream state
+ * Return: number of bytes written to the output buffer
+ */
+size_t ulz4_stream_end(struct ulz4_stream *strm);
+
 /**
  * LZ4_decompress_safe() - Decompression protected against buffer overflow
  * @source: source address of the compressed data
@@ -117,6 +117,17 @@ struct video_priv {
 	bool flush_dcache;
 	u8 fg_col_idx;
 	u8 bg_col_idx;
+	/*
+	 * Area changed since the last sync, in pixels, with the end being
+	 * exclusive. This is empty if @xend is 0. Only used with
+	 * CONFIG_VIDEO_DAMAGE
+	 */
+	struct {
+		int xstart;
+		int ystart;
+		int xend;
+		int yend;
+	} damage;
 };
 
 /**
@@ -126,9 +137,31 @@ struct video_priv {
  *		For these devices implement video_sync hook to call a sync
  *		function. vid is pointer to video device udevice. Function
  *		should return 0 on success video_sync and error code otherwise
+ *
+ * The remaining operations are optional and allow a driver to use a 2D
+ * engine (or DMA controller) to update the frame buffer (priv->fb). They are
+ * called with a rectangle which is within the display, measured in pixels.
+ * The uclass takes care of tracking damage and updating the copy frame
+ * buffer, if any, so the driver only needs to update priv->fb and make sure
+ * that the result is visible to the CPU when the operation returns. Each
+ * returns 0 if OK, -ENOSYS if the operation cannot be handled (in which case
+ * the uclass falls back to using the CPU), or other -ve error code
+ *
+ * @fill_rect:	Fill a rectangle with a colour, in the frame buffer's format
+ * @copy_rect:	Copy a rectangle from one place in the frame buffer to
+ *		another. The two areas may overlap
+ * @blit:	Copy a rectangle of pixels into the frame buffer from memory.
+ *		The pixels are in the frame buffer's format, with @stride
+ *		bytes between the start of each line
  */
 struct video_ops {
 	int (*video_sync)(struct udevice *vid);
+	int (*fill_rect)(struct udevice *vid, int x, int y, int width,
+			 int height, u32 colour);
+	int (*copy_rect)(struct udevice *vid, int dstx, int dsty, int srcx,
+			 int srcy, int width, int height);
+	int (*blit)(struct udevice *vid, int x, int y, int width, int height,
+		    const void *src, int stride);
 };
 
 #define video_get_ops(dev)        ((struct video_ops *)(dev)->driver->ops)
@@ -203,6 +236,60 @@ int video_clear(struct udevice *dev);
  */
 int video_fill(struct udevice *dev, u32 colour);
 
+/**
+ * video_fill_rect() - Fill a rectangle of the frame buffer with a colour
+ *
+ * This uses the driver's fill_rect() operation if available, otherwise it
+ * fills the rectangle a word at a time. The frame buffer is not synced.
+ *
+ * @dev:	Device to update
+ * @x:		X position of the left of the rectangle, in pixels
+ * @y:		Y position of the top of the rectangle, in pixels
+ * @width:	Width of the rectangle in pixels
+ * @height:	Height of the rectangle in pixels
+ * @colour:	Colour to use, in the frame buffer's format
+ * Return: 0 on success, -EINVAL if the rectangle is not within the display
+ */
+int video_fill_rect(struct udevice *dev, int x, int y, int width, int height,
+		    u32 colour);
+
+/**
+ * video_copy_rect() - Copy a rectangle to another place in the frame buffer
+ *
+ * This uses the driver's copy_rect() operation if available, otherwise a DMA
+ * engine (with CONFIG_VIDEO_DMA) or the CPU. The two rectangles may overlap.
+ * The frame buffer is not synced.
+ *
+ * @dev:	Device to update
+ * @dstx:	X position of the left of the destination, in pixels
+ * @dsty:	Y position of the top of the destination, in pixels
+ * @srcx:	X position of the left of the source, in pixels
+ * @srcy:	Y position of the top of the source, in pixels
+ * @width:	Width of the rectangle in pixels
+ * @height:	Height of the rectangle in pixels
+ * Return: 0 on success, -EINVAL if either rectangle is not within the display
+ */
+int video_copy_rect(struct udevice *dev, int dstx, int dsty, int srcx,
+		    int srcy, int width, int height);
+
+/**
+ * video_blit() - Copy pixels from memory into a rectangle of the frame buffer
+ *
+ * This uses the driver's blit() operation if available, otherwise the CPU.
+ * The frame buffer is not synced.
+ *
+ * @dev:	Device to update
+ * @x:		X position of the left of the rectangle, in pixels
+ * @y:		Y position of the top of the rectangle, in pixels
+ * @width:	Width of the rectangle in pixels
+ * @height:	Height of the rectangle in pixels
+ * @src:	Pixels to copy, in the frame buffer's format
+ * @stride:	Number of bytes between the start of each line in @src
+ * Return: 0 on success, -EINVAL if the rectangle is not within the display
+ */
+int video_blit(struct udevice *dev, int x, int y, int width, int height,
+	       const void *src, int stride);
+
 /**
  * video_sync() - Sync a device's frame buffer with its hardware
  *
@@ -214,10 +301,32 @@ int video_fill(struct udevice *dev, u32 colour);
  *
  * Some frame buffers are cached or have a secondary frame buffer. This
  * function syncs these up so that the current contents of the U-Boot frame
- * buffer are displayed to the user.
+ * buffer are displayed to the user. With CONFIG_VIDEO_DAMAGE only the area
+ * recorded by video_damage() is synced.
  */
 int video_sync(struct udevice *vid, bool force);
 
+#ifdef CONFIG_VIDEO_DAMAGE
+/**
+ * video_damage() - Record an area of the frame buffer as changed
+ *
+ * The next video_sync() flushes / copies this area, along with any others
+ * recorded since the last sync. The area is clipped to the display.
+ *
+ * @vid:	Video device which was updated
+ * @x:		X position of the area in pixels from the left
+ * @y:		Y position of the area in pixels from the top
+ * @width:	Width of the area in pixels
+ * @height:	Height of the area in pixels
+ */
+void video_damage(struct udevice *vid, int x, int y, int width, int height);
+#else
+static inline void video_damage(struct udevice *vid, int x, int y, int width,
+				int height)
+{
+}
+#endif
+
 /**
  * video_sync_all() - Sync all devices' frame buffers with there hardware
  *
@@ -306,6 +415,9 @@ int video_default_font_height(struct udevice *dev);
  *
  * @from and @to can be in either order. The region between them is synced.
  *
+ * With CONFIG_VIDEO_DAMAGE this does nothing, since video_sync() copies the
+ * area recorded by video_damage() instead.
+ *
  * @dev: Vidconsole device being updated
  * @from: Start/end address within the framebuffer (->fb)
  * @to: Other address within the frame buffer
@@ -71,6 +71,25 @@ struct vidfont_info {
 	const char *name;
 };
 
+/**
+ * struct vidconsole_cache_stats - statistics for a console's glyph cache
+ *
+ * @hits: Number of glyphs which were found in the cache
+ * @misses: Number of glyphs which had to be rendered
+ * @evictions: Number of glyphs dropped to keep within @budget
+ * @count: Number of glyphs currently in the cache
+ * @used: Number of bytes currently used by the cache
+ * @budget: Maximum number of bytes the cache may use
+ */
+struct vidconsole_cache_stats {
+	ulong hits;
+	ulong misses;
+	ulong evictions;
+	uint count;
+	ulong used;
+	ulong budget;
+};
+
 /**
  * struct vidconsole_ops - Video console operations
  *
@@ -178,6 +197,16 @@ struct vidconsole_ops {
 	 * Returns: 0 on success, -ENOENT if no such font
 	 */
 	int (*select_font)(struct udevice *dev, const char *name, uint size);
+
+	/**
+	 * get_cache_stats() - Get glyph-cache statistics (optional)
+	 *
+	 * @dev:	Device to check
+	 * @stats:	Returns the statistics
+	 * Returns: 0 on success, -ve on error
+	 */
+	int (*get_cache_stats)(struct udevice *dev,
+			       struct vidconsole_cache_stats *stats);
 };
 
 /* Get a pointer to the driver operations for a video console device */
@@ -204,6 +233,16 @@ int vidconsole_get_font(struct udevice *dev, int seq,
  */
 int vidconsole_select_font(struct udevice *dev, const char *name, uint size);
 
+/**
+ * vidconsole_get_cache_stats() - Get statistics for the glyph cache
+ *
+ * @dev:	Device to check
+ * @stats:	Returns the statistics
+ * Returns: 0 on success, -ENOSYS if the console does not cache glyphs
+ */
+int vidconsole_get_cache_stats(struct udevice *dev,
+			       struct vidconsole_cache_stats *stats);
+
 /**
  * vidconsole_putc_xy() - write a single character to a position
  *
@@ -342,40 +381,13 @@ int vidconsole_get_font_size(struct udevice *dev, const char **name, uint *sizep
  *	frame buffer start
  */
 int vidconsole_sync_copy(struct udevice *dev, void *from, void *to);
-
-/**
- * vidconsole_memmove() - Perform a memmove() within the frame buffer
- *
- * This handles a memmove(), e.g. for scrolling. It also updates the copy
- * framebuffer.
- *
- * @dev: Vidconsole device being updated
- * @dst: Destination address within the framebuffer (->fb)
- * @src: Source address within the framebuffer (->fb)
- * @size: Number of bytes to transfer
- * Return: 0 if OK, -EFAULT if the start address is before the start of the
- *	frame buffer start
- */
-int vidconsole_memmove(struct udevice *dev, void *dst, const void *src,
-		       int size);
 #else
-
-#include <string.h>
-
 static inline int vidconsole_sync_copy(struct udevice *dev, void *from,
 				       void *to)
 {
 	return 0;
 }
 
-static inline int vidconsole_memmove(struct udevice *dev, void *dst,
-				     const void *src, int size)
-{
-	memmove(dst, src, size);
-
-	return 0;
-}
-
 #endif
 
 #endif
@@ -35,6 +35,9 @@ struct file_handle {
 	int isdir;
 	u64 open_mode;
 
+	/* for reading a file: */
+	struct fs_file_stream *file;
+
 	/* for reading a directory: */
 	struct fs_dir_stream *dirs;
 	struct fs_dirent *dent;
@@ -58,6 +61,32 @@ static int set_blk_dev(struct file_handle *fh)
 	return fs_set_blk_dev_with_part(fh->fs->desc, fh->fs->part);
 }
 
+/**
+ * open_file() - open the file of a file handle for reading
+ *
+ * The file is kept open, so that it does not have to be looked up again and
+ * the file system does not have to be probed again for each read. It is opened
+ * again if any file has been written since.
+ *
+ * @fh:		file handle
+ * Return:	status code
+ */
+static efi_status_t open_file(struct file_handle *fh)
+{
+	if (fh->file && !fs_file_stale(fh->file))
+		return EFI_SUCCESS;
+
+	fs_closefile(fh->file);
+	fh->file = NULL;
+	if (set_blk_dev(fh))
+		return EFI_DEVICE_ERROR;
+	fh->file = fs_openfile(fh->path);
+	if (!fh->file)
+		return EFI_DEVICE_ERROR;
+
+	return EFI_SUCCESS;
+}
+
 /**
  * is_dir() - check if file handle points to directory
  *
@@ -364,6 +393,7 @@ out:
 
 static efi_status_t file_close(struct file_handle *fh)
 {
+	fs_closefile(fh->file);
 	fs_closedir(fh->dirs);
 	free(fh);
 	return EFI_SUCCESS;
@@ -406,6 +436,15 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 static efi_status_t efi_get_file_size(struct file_handle *fh,
 				      loff_t *file_size)
 {
+	efi_status_t ret;
+
+	if (!fh->isdir) {
+		ret = open_file(fh);
+		if (ret == EFI_SUCCESS)
+			*file_size = fh->file->size;
+		return ret;
+	}
+
 	if (set_blk_dev(fh))
 		return EFI_DEVICE_ERROR;
 
@@ -473,11 +512,11 @@ static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 		ret = EFI_DEVICE_ERROR;
 		return ret;
 	}
+	/* fs_readfile() reads the whole file if the length is 0 */
+	if (!*buffer_size)
+		return EFI_SUCCESS;
 
-	if (set_blk_dev(fh))
-		return EFI_DEVICE_ERROR;
-	if (fs_read(fh->path, map_to_sysmem(buffer), fh->offset,
-		    *buffer_size, &actread))
+	if (fs_readfile(fh->file, buffer, fh->offset, *buffer_size, &actread))
 		return EFI_DEVICE_ERROR;
 
 	*buffer_size = actread;
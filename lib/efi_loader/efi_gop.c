@@ -35,6 +35,7 @@ struct efi_gop_obj {
 	/* Fields we only have access to during init */
 	u32 bpix;
 	void *fb;
+	struct udevice *vdev;
 };
 
 static efi_status_t EFIAPI gop_query_mode(struct efi_gop *this, u32 mode_number,
@@ -451,6 +452,13 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this,
 	if (ret != EFI_SUCCESS)
 		return EFI_EXIT(ret);
 
+	if (operation != EFI_BLT_VIDEO_TO_BLT_BUFFER) {
+		struct efi_gop_obj *gopobj = container_of(this,
+							  struct efi_gop_obj,
+							  ops);
+
+		video_damage(gopobj->vdev, dx, dy, width, height);
+	}
 	video_sync_all();
 
 	return EFI_EXIT(EFI_SUCCESS);
@@ -524,6 +532,7 @@ efi_status_t efi_gop_register(void)
 
 	gopobj->mode.fb_base = fb_base;
 	gopobj->mode.fb_size = fb_size;
+	gopobj->vdev = vdev;
 
 	gopobj->info.version = 0;
 	gopobj->info.width = col;
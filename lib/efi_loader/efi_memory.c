@@ -16,7 +16,7 @@
 #include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -26,17 +26,22 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
-struct efi_mem_list {
-	struct list_head link;
+/**
+ * struct efi_mem_region - memory map item
+ *
+ * @node:	node in the tree of memory map items, ordered by start address
+ * @desc:	memory descriptor
+ */
+struct efi_mem_region {
+	struct rb_node node;
 	struct efi_mem_desc desc;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
+/* This tree contains all memory map items, which never overlap */
+static struct rb_root efi_mem = RB_ROOT;
 
-/* This list contains all memory map items */
-static LIST_HEAD(efi_mem);
+/* Number of items in the memory map */
+static int efi_mem_count;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -45,13 +50,14 @@ void *efi_bounce_buffer;
 /**
  * struct efi_pool_allocation - memory block allocated from pool
  *
- * @num_pages:	number of pages allocated
+ * @num_pages:	number of pages allocated, or 0 if the block was carved out of
+ *		a chunk (see struct efi_pool_chunk)
  * @checksum:	checksum
  * @data:	allocated pool memory
  *
- * U-Boot services each UEFI AllocatePool() request as a separate
- * (multiple) page allocation. We have to track the number of pages
- * to be able to free the correct amount later.
+ * Small AllocatePool() requests are served from chunks holding blocks of a
+ * single size class. Larger requests get their own pages and we have to track
+ * the number of pages to be able to free the correct amount later.
  *
  * The checksum calculated in function checksum() is used in FreePool() to avoid
  * freeing memory not allocated by AllocatePool() and duplicate freeing.
@@ -65,6 +71,41 @@ struct efi_pool_allocation {
 	char data[] __aligned(ARCH_DMA_MINALIGN);
 };
 
+/*
+ * Pool blocks are powers of two in size, from 1 << EFI_POOL_MIN_SHIFT to
+ * 1 << EFI_POOL_MAX_SHIFT bytes including the header
+ */
+#define EFI_POOL_MIN_SHIFT	6
+#define EFI_POOL_MAX_SHIFT	10
+#define EFI_POOL_CLASSES	(EFI_POOL_MAX_SHIFT - EFI_POOL_MIN_SHIFT + 1)
+
+/**
+ * struct efi_pool_chunk - page holding pool blocks of one size and memory type
+ *
+ * @link:	entry in the list of chunks with free blocks, see efi_pool_list()
+ * @checksum:	checksum calculated by chunk_checksum()
+ * @free:	first free block, each free block holding a pointer to the next
+ * @type:	memory type of the page
+ * @shift:	log2 of the size of each block
+ * @used:	number of blocks in use
+ * @data:	blocks
+ *
+ * A new chunk is only needed when all the chunks for a size class are full,
+ * so the memory map is updated once for many pool allocations.
+ */
+struct efi_pool_chunk {
+	struct list_head link;
+	u64 checksum;
+	struct efi_pool_allocation *free;
+	u32 type;
+	u16 shift;
+	u16 used;
+	char data[] __aligned(ARCH_DMA_MINALIGN);
+};
+
+/* Chunks with free blocks, for each memory type and size class */
+static struct list_head efi_pool_chunks[EFI_MAX_MEMORY_TYPE][EFI_POOL_CLASSES];
+
 /**
  * checksum() - calculate checksum for memory allocated from pool
  *
@@ -82,30 +123,19 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 }
 
 /**
- * efi_mem_cmp() - comparator function for sorting memory map
- *
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * chunk_checksum() - calculate checksum for a chunk of pool blocks
  *
- * @priv:	unused
- * @a:		first memory area
- * @b:		second memory area
- * Return:	1 if @a is before @b, -1 if @b is before @a, 0 if equal
+ * @chunk:	chunk
+ * Return:	checksum, always non-zero
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static u64 chunk_checksum(struct efi_pool_chunk *chunk)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
-
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+	u64 addr = (uintptr_t)chunk;
+	u64 ret = (addr >> 32) ^ (addr << 32) ^ chunk->type ^
+		  ((u64)chunk->shift << 32) ^ ~EFI_ALLOC_POOL_MAGIC;
+	if (!ret)
+		++ret;
+	return ret;
 }
 
 /**
@@ -119,137 +149,217 @@ static uint64_t desc_get_end(struct efi_mem_desc *desc)
 	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
 }
 
+static struct efi_mem_region *efi_mem_entry(struct rb_node *node)
+{
+	return rb_entry_safe(node, struct efi_mem_region, node);
+}
+
+static struct efi_mem_region *efi_mem_next(struct efi_mem_region *region)
+{
+	return efi_mem_entry(rb_next(&region->node));
+}
+
+static struct efi_mem_region *efi_mem_prev(struct efi_mem_region *region)
+{
+	return efi_mem_entry(rb_prev(&region->node));
+}
+
 /**
- * efi_mem_sort() - sort memory map
+ * efi_mem_find() - find the memory map item starting at or below an address
  *
- * Sort the memory map and then try to merge adjacent memory areas.
+ * @addr:	address
+ * Return:	item with the highest start address not above @addr, or NULL
+ *		if there is none
  */
-static void efi_mem_sort(void)
+static struct efi_mem_region *efi_mem_find(u64 addr)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
+	struct rb_node *node = efi_mem.rb_node;
+	struct efi_mem_region *found = NULL;
 
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	while (node) {
+		struct efi_mem_region *region = efi_mem_entry(node);
 
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
+		if (region->desc.physical_start <= addr) {
+			found = region;
+			node = node->rb_right;
+		} else {
+			node = node->rb_left;
+		}
+	}
 
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
+	return found;
+}
 
-			cur = &lmem->desc;
+/**
+ * efi_mem_first_overlap() - find the first memory map item above an address
+ *
+ * @start:	address
+ * Return:	item with the lowest start address which ends above @start,
+ *		or NULL if there is none
+ */
+static struct efi_mem_region *efi_mem_first_overlap(u64 start)
+{
+	struct efi_mem_region *region = efi_mem_find(start);
 
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
+	if (!region)
+		return efi_mem_entry(rb_first(&efi_mem));
+	if (desc_get_end(&region->desc) <= start)
+		return efi_mem_next(region);
 
-				merge_again = true;
-				break;
-			}
+	return region;
+}
 
-			prevmem = lmem;
-		}
+/**
+ * efi_mem_insert() - add an item to the memory map
+ *
+ * @region:	item to add, which must not overlap any other item
+ */
+static void efi_mem_insert(struct efi_mem_region *region)
+{
+	struct rb_node **link = &efi_mem.rb_node;
+	struct rb_node *parent = NULL;
+
+	while (*link) {
+		parent = *link;
+		if (region->desc.physical_start <
+		    efi_mem_entry(parent)->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&region->node, parent, link);
+	rb_insert_color(&region->node, &efi_mem);
+	efi_mem_count++;
+}
+
+/**
+ * efi_mem_remove() - remove an item from the memory map and free it
+ *
+ * @region:	item to remove
+ */
+static void efi_mem_remove(struct efi_mem_region *region)
+{
+	rb_erase(&region->node, &efi_mem);
+	efi_mem_count--;
+	free(region);
+}
+
+/**
+ * efi_mem_can_merge() - check whether two memory map items can be merged
+ *
+ * @lower:	item with the lower address
+ * @upper:	item with the higher address
+ * Return:	true if @upper follows straight after @lower and is the same
+ *		type of memory
+ */
+static bool efi_mem_can_merge(struct efi_mem_region *lower,
+			      struct efi_mem_region *upper)
+{
+	return desc_get_end(&lower->desc) == upper->desc.physical_start &&
+	       lower->desc.type == upper->desc.type &&
+	       lower->desc.attribute == upper->desc.attribute;
+}
+
+/**
+ * efi_mem_merge() - merge a memory map item with its neighbours
+ *
+ * Items are merged when they are added, so only the neighbours of a new item
+ * need to be checked.
+ *
+ * @region:	item to merge, which may be freed
+ */
+static void efi_mem_merge(struct efi_mem_region *region)
+{
+	struct efi_mem_region *prev = efi_mem_prev(region);
+	struct efi_mem_region *next = efi_mem_next(region);
+
+	if (prev && efi_mem_can_merge(prev, region)) {
+		prev->desc.num_pages += region->desc.num_pages;
+		efi_mem_remove(region);
+		region = prev;
+	}
+	if (next && efi_mem_can_merge(region, next)) {
+		region->desc.num_pages += next->desc.num_pages;
+		efi_mem_remove(next);
 	}
 }
 
 /**
  * efi_mem_carve_out() - unmap memory region
  *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return:		the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
- */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
-{
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+ * Removes the area from @start to @end from all memory map items which
+ * overlap it, shrinking or removing them. An item which covers the whole area
+ * and more is split in two, using @splitp for the upper part.
+ *
+ * @start:	start address of the area
+ * @end:	end address of the area + 1
+ * @splitp:	spare item to use for splitting; set to NULL if used
+ */
+static void efi_mem_carve_out(u64 start, u64 end,
+			      struct efi_mem_region **splitp)
+{
+	struct efi_mem_region *region, *next;
+
+	for (region = efi_mem_first_overlap(start);
+	     region && region->desc.physical_start < end; region = next) {
+		struct efi_mem_desc *desc = &region->desc;
+		u64 map_start = desc->physical_start;
+		u64 map_end = desc_get_end(desc);
+
+		next = efi_mem_next(region);
+		if (map_start < start) {
+			/* Shrink the item to [ map_start ... start ] */
+			desc->num_pages = (start - map_start) >> EFI_PAGE_SHIFT;
+			if (map_end > end) {
+				/* Add the rest as [ end ... map_end ] */
+				region = *splitp;
+				*splitp = NULL;
+				region->desc = *desc;
+				region->desc.physical_start = end;
+				region->desc.virtual_start = end;
+				region->desc.num_pages = (map_end - end) >>
+							 EFI_PAGE_SHIFT;
+				efi_mem_insert(region);
+				break;
+			}
+		} else if (map_end > end) {
+			/*
+			 * Move the start of the item to [ end ... map_end ].
+			 * This does not change its position in the tree.
+			 */
+			desc->physical_start = end;
+			desc->virtual_start = end;
+			desc->num_pages = (map_end - end) >> EFI_PAGE_SHIFT;
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			/* Full overlap, just remove the item */
+			efi_mem_remove(region);
 		}
-
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
 	}
+}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
-
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
-
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+/**
+ * efi_mem_only_ram() - check that an area is all free RAM
+ *
+ * @start:	start address of the area
+ * @end:	end address of the area + 1
+ * Return:	true if the area is completely covered by memory map items of
+ *		type EFI_CONVENTIONAL_MEMORY
+ */
+static bool efi_mem_only_ram(u64 start, u64 end)
+{
+	struct efi_mem_region *region;
+	u64 pos = start;
+
+	for (region = efi_mem_first_overlap(start);
+	     region && region->desc.physical_start < end;
+	     region = efi_mem_next(region)) {
+		if (region->desc.type != EFI_CONVENTIONAL_MEMORY ||
+		    region->desc.physical_start > pos)
+			return false;
+		pos = desc_get_end(&region->desc);
+	}
 
-	return EFI_CARVE_LOOP_AGAIN;
+	return pos >= end;
 }
 
 /**
@@ -265,10 +375,8 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_region *region, *split;
+	u64 end = start + (pages << EFI_PAGE_SHIFT);
 	struct efi_event *evt;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
@@ -280,80 +388,46 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 	if (!pages)
 		return EFI_SUCCESS;
 
+	/*
+	 * The payload wanted to have RAM overlaps, but we would overlap a
+	 * region which is not free RAM, or an unmapped region. Error out
+	 * before changing anything.
+	 */
+	if (overlap_only_ram && !efi_mem_only_ram(start, end))
+		return EFI_NO_MAPPING;
+
+	region = calloc(1, sizeof(*region));
+	split = calloc(1, sizeof(*split));
+	if (!region || !split) {
+		free(region);
+		free(split);
+		return EFI_OUT_OF_RESOURCES;
+	}
+
 	++efi_memory_map_key;
-	newlist = calloc(1, sizeof(*newlist));
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
+	region->desc.type = memory_type;
+	region->desc.physical_start = start;
+	region->desc.virtual_start = start;
+	region->desc.num_pages = pages;
 
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
+		region->desc.attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = EFI_MEMORY_RUNTIME;
+		region->desc.attribute = EFI_MEMORY_RUNTIME;
 		break;
 	default:
-		newlist->desc.attribute = EFI_MEMORY_WB;
+		region->desc.attribute = EFI_MEMORY_WB;
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return EFI_NO_MAPPING;
-	}
-
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Add our new map, merging it with its neighbours if possible */
+	efi_mem_carve_out(start, end, &split);
+	free(split);
+	efi_mem_insert(region);
+	efi_mem_merge(region);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -407,19 +481,14 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
-	struct efi_mem_list *item;
-
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
+	struct efi_mem_region *region = efi_mem_find(addr);
 
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
-		}
+	if (region && addr < desc_get_end(&region->desc)) {
+		if (must_be_allocated ^
+		    (region->desc.type == EFI_CONVENTIONAL_MEMORY))
+			return EFI_SUCCESS;
+		else
+			return EFI_NOT_FOUND;
 	}
 
 	return EFI_NOT_FOUND;
@@ -434,7 +503,7 @@ static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
  */
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
+	struct efi_mem_region *region;
 
 	/*
 	 * Prealign input max address, so we simplify our matching
@@ -442,10 +511,10 @@ static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
+	/* Start with the highest item which begins below max_addr */
+	for (region = efi_mem_find(max_addr - 1); region;
+	     region = efi_mem_prev(region)) {
+		struct efi_mem_desc *desc = &region->desc;
 		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
 		uint64_t desc_end = desc->physical_start + desc_len;
 		uint64_t curmax = min(max_addr, desc_end);
@@ -618,9 +687,140 @@ void *efi_alloc_aligned_pages(u64 len, int memory_type, size_t align)
 	return (void *)(uintptr_t)aligned_mem;
 }
 
+/**
+ * efi_pool_list() - get the list of chunks with free blocks
+ *
+ * @type:	memory type, less than EFI_MAX_MEMORY_TYPE
+ * @shift:	log2 of the block size
+ * Return:	list of chunks
+ */
+static struct list_head *efi_pool_list(u32 type, uint shift)
+{
+	struct list_head *head;
+
+	head = &efi_pool_chunks[type][shift - EFI_POOL_MIN_SHIFT];
+	if (!head->next)
+		INIT_LIST_HEAD(head);
+
+	return head;
+}
+
+/**
+ * efi_pool_new_chunk() - allocate a page and divide it into pool blocks
+ *
+ * @type:	memory type
+ * @shift:	log2 of the block size
+ * @chunkp:	returns the new chunk
+ * Return:	status code
+ */
+static efi_status_t efi_pool_new_chunk(enum efi_memory_type type, uint shift,
+				       struct efi_pool_chunk **chunkp)
+{
+	struct efi_pool_allocation **nextp;
+	struct efi_pool_chunk *chunk;
+	efi_status_t r;
+	u64 addr, pos, last;
+
+	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, type, 1, &addr);
+	if (r != EFI_SUCCESS)
+		return r;
+
+	chunk = (struct efi_pool_chunk *)(uintptr_t)addr;
+	chunk->type = type;
+	chunk->shift = shift;
+	chunk->used = 0;
+	chunk->checksum = chunk_checksum(chunk);
+	nextp = &chunk->free;
+	last = addr + EFI_PAGE_SIZE - (1 << shift);
+	for (pos = (uintptr_t)chunk->data; pos <= last; pos += 1 << shift) {
+		*nextp = (struct efi_pool_allocation *)(uintptr_t)pos;
+		nextp = (struct efi_pool_allocation **)(*nextp)->data;
+	}
+	*nextp = NULL;
+	*chunkp = chunk;
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_pool_alloc_block() - allocate a block from a chunk
+ *
+ * @type:	memory type, less than EFI_MAX_MEMORY_TYPE
+ * @shift:	log2 of the block size
+ * @allocp:	returns the block
+ * Return:	status code
+ */
+static efi_status_t efi_pool_alloc_block(enum efi_memory_type type, uint shift,
+					 struct efi_pool_allocation **allocp)
+{
+	struct list_head *head = efi_pool_list(type, shift);
+	struct efi_pool_allocation *alloc;
+	struct efi_pool_chunk *chunk;
+	efi_status_t r;
+
+	if (list_empty(head)) {
+		r = efi_pool_new_chunk(type, shift, &chunk);
+		if (r != EFI_SUCCESS)
+			return r;
+		list_add(&chunk->link, head);
+	}
+	chunk = list_first_entry(head, struct efi_pool_chunk, link);
+
+	alloc = chunk->free;
+	chunk->free = *(struct efi_pool_allocation **)alloc->data;
+	chunk->used++;
+	/* Only chunks with free blocks are kept in the list */
+	if (!chunk->free)
+		list_del_init(&chunk->link);
+	*allocp = alloc;
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_pool_free_block() - free a block allocated from a chunk
+ *
+ * The page holding the chunk is freed once none of its blocks are in use,
+ * unless it is the only chunk for its size class with free blocks.
+ *
+ * @alloc:	block to free
+ * Return:	status code
+ */
+static efi_status_t efi_pool_free_block(struct efi_pool_allocation *alloc)
+{
+	struct efi_pool_chunk *chunk;
+	struct list_head *head;
+	uintptr_t ofs;
+
+	chunk = (struct efi_pool_chunk *)((uintptr_t)alloc & ~EFI_PAGE_MASK);
+	ofs = (uintptr_t)alloc - (uintptr_t)chunk->data;
+	if (chunk->checksum != chunk_checksum(chunk) ||
+	    (uintptr_t)alloc < (uintptr_t)chunk->data ||
+	    (ofs & ((1 << chunk->shift) - 1)))
+		return EFI_INVALID_PARAMETER;
+
+	head = efi_pool_list(chunk->type, chunk->shift);
+	if (!chunk->free)
+		list_add(&chunk->link, head);
+	*(struct efi_pool_allocation **)alloc->data = chunk->free;
+	chunk->free = alloc;
+	chunk->used--;
+
+	if (!chunk->used && !list_is_singular(head)) {
+		list_del(&chunk->link);
+		chunk->checksum = 0;
+		return efi_free_pages((uintptr_t)chunk, 1);
+	}
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_allocate_pool - allocate memory from pool
  *
+ * Requests for up to 1 << EFI_POOL_MAX_SHIFT bytes, including the header, are
+ * carved out of a chunk. Larger ones are allocated as separate pages.
+ *
  * @pool_type:	type of the pool from which memory is to be allocated
  * @size:	number of bytes to be allocated
  * @buffer:	allocated memory
@@ -631,8 +831,7 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 	efi_status_t r;
 	u64 addr;
 	struct efi_pool_allocation *alloc;
-	u64 num_pages = efi_size_in_pages(size +
-					  sizeof(struct efi_pool_allocation));
+	u64 num_pages;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
@@ -642,6 +841,25 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 		return EFI_SUCCESS;
 	}
 
+	if ((u32)pool_type < EFI_PERSISTENT_MEMORY_TYPE &&
+	    size <= (1 << EFI_POOL_MAX_SHIFT) -
+		    sizeof(struct efi_pool_allocation)) {
+		uint shift = fls(size + sizeof(struct efi_pool_allocation) - 1);
+
+		r = efi_pool_alloc_block(pool_type,
+					 max(shift, (uint)EFI_POOL_MIN_SHIFT),
+					 &alloc);
+		if (r == EFI_SUCCESS) {
+			alloc->num_pages = 0;
+			alloc->checksum = checksum(alloc);
+			*buffer = alloc->data;
+		}
+
+		return r;
+	}
+
+	num_pages = efi_size_in_pages(size +
+				      sizeof(struct efi_pool_allocation));
 	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, num_pages,
 			       &addr);
 	if (r == EFI_SUCCESS) {
@@ -686,6 +904,7 @@ efi_status_t efi_free_pool(void *buffer)
 {
 	efi_status_t ret;
 	struct efi_pool_allocation *alloc;
+	bool in_chunk;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
@@ -696,16 +915,23 @@ efi_status_t efi_free_pool(void *buffer)
 
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
 
-	/* Check that this memory was allocated by efi_allocate_pool() */
-	if (((uintptr_t)alloc & EFI_PAGE_MASK) ||
-	    alloc->checksum != checksum(alloc)) {
+	/*
+	 * Check that this memory was allocated by efi_allocate_pool(). Only
+	 * separate page allocations start on a page boundary.
+	 */
+	in_chunk = (uintptr_t)alloc & EFI_PAGE_MASK;
+	if (alloc->checksum != checksum(alloc) ||
+	    in_chunk != !alloc->num_pages) {
 		printf("%s: illegal free 0x%p\n", __func__, buffer);
 		return EFI_INVALID_PARAMETER;
 	}
 	/* Avoid double free */
 	alloc->checksum = 0;
 
-	ret = efi_free_pages((uintptr_t)alloc, alloc->num_pages);
+	if (in_chunk)
+		ret = efi_pool_free_block(alloc);
+	else
+		ret = efi_free_pages((uintptr_t)alloc, alloc->num_pages);
 
 	return ret;
 }
@@ -728,8 +954,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	struct rb_node *node;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -737,10 +962,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_count * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -756,16 +978,9 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem;
-
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
-	}
+	/* Copy the tree into the array, in ascending order */
+	for (node = rb_first(&efi_mem); node; node = rb_next(node))
+		*memory_map++ = efi_mem_entry(node)->desc;
 
 	if (map_key)
 		*map_key = efi_memory_map_key;
@@ -26,6 +26,16 @@
 
 static const efi_guid_t shim_lock_guid = SHIM_LOCK_GUID;
 
+/*
+ * Offset in the variables file at which the next journal record is written,
+ * or 0 if the whole file must be written again, e.g. because the filesystem
+ * cannot write at an offset
+ */
+static loff_t efi_var_file_end;
+
+/* CRC32 of the last journal record, or of the variables if there is none */
+static u32 efi_var_file_crc;
+
 /**
  * efi_set_blk_dev_to_system_partition() - select EFI system partition
  *
@@ -117,6 +127,20 @@ efi_status_t __maybe_unused efi_var_collect(struct efi_var_file **bufp, loff_t *
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_var_file_can_append() - check if journal records can be appended
+ *
+ * Appending needs the filesystem to write at an offset, which ext4 cannot
+ * do. Checking this up front avoids a failing write on every change. The
+ * system partition must already be selected.
+ *
+ * Return:	true if records can be appended to the variables file
+ */
+static bool __maybe_unused efi_var_file_can_append(void)
+{
+	return fs_get_type() != FS_TYPE_EXT;
+}
+
 /**
  * efi_var_to_file() - save non-volatile variables as file
  *
@@ -131,8 +155,10 @@ efi_status_t efi_var_to_file(void)
 	struct efi_var_file *buf;
 	loff_t len;
 	loff_t actlen;
+	bool append;
 	int r;
 
+	efi_var_file_end = 0;
 	ret = efi_var_collect(&buf, &len, EFI_VARIABLE_NON_VOLATILE);
 	if (ret != EFI_SUCCESS)
 		goto error;
@@ -141,9 +167,15 @@ efi_status_t efi_var_to_file(void)
 	if (ret != EFI_SUCCESS)
 		goto error;
 
+	append = efi_var_file_can_append();
 	r = fs_write(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, len, &actlen);
-	if (r || len != actlen)
+	if (r || len != actlen) {
 		ret = EFI_DEVICE_ERROR;
+		goto error;
+	}
+	if (append)
+		efi_var_file_end = len;
+	efi_var_file_crc = buf->crc32;
 
 error:
 	if (ret != EFI_SUCCESS)
@@ -155,6 +187,164 @@ error:
 #endif
 }
 
+efi_status_t efi_var_file_append(const u16 *variable_name,
+				 const efi_guid_t *vendor)
+{
+#ifdef CONFIG_EFI_VARIABLE_FILE_STORE
+	struct efi_var_journal *rec;
+	struct efi_var_entry *var, *entry;
+	size_t name_size, len;
+	loff_t actlen;
+	efi_status_t ret;
+	int r;
+
+	if (!efi_var_file_end)
+		return efi_var_to_file();
+
+	var = efi_var_mem_find(vendor, variable_name, NULL);
+	name_size = (u16_strlen(variable_name) + 1) * sizeof(u16);
+	len = ALIGN(sizeof(*rec) + sizeof(*var) + name_size +
+		    (var ? var->length : 0), 8);
+
+	/* Write the whole file again if the journal would become too long */
+	if (efi_var_file_end + len > EFI_VAR_BUF_SIZE)
+		return efi_var_to_file();
+
+	rec = calloc(1, len);
+	if (!rec)
+		return EFI_OUT_OF_RESOURCES;
+	entry = (struct efi_var_entry *)(rec + 1);
+	if (var) {
+		memcpy(entry, var, sizeof(*var) + name_size + var->length);
+	} else {
+		/* A variable without data is deleted */
+		guidcpy(&entry->guid, vendor);
+		memcpy(entry->name, variable_name, name_size);
+	}
+	rec->length = len;
+	rec->crc32 = crc32(efi_var_file_crc, (u8 *)entry, len - sizeof(*rec));
+
+	ret = efi_set_blk_dev_to_system_partition();
+	if (ret == EFI_SUCCESS) {
+		r = fs_write(EFI_VAR_FILE_NAME, map_to_sysmem(rec),
+			     efi_var_file_end, len, &actlen);
+		if (r || actlen != len)
+			ret = EFI_DEVICE_ERROR;
+	}
+	if (ret == EFI_SUCCESS) {
+		efi_var_file_end += len;
+		efi_var_file_crc = rec->crc32;
+	}
+	free(rec);
+	if (ret != EFI_SUCCESS)
+		return efi_var_to_file();
+
+	return EFI_SUCCESS;
+#else
+	return EFI_SUCCESS;
+#endif
+}
+
+/**
+ * efi_var_buf_find() - find a variable in a variables file buffer
+ *
+ * @buf:	buffer
+ * @guid:	vendor GUID
+ * @name:	variable name
+ * @sizep:	returns the number of bytes taken up by the variable
+ * Return:	variable, or NULL if not found
+ */
+static struct efi_var_entry __maybe_unused *
+efi_var_buf_find(struct efi_var_file *buf, const efi_guid_t *guid,
+		 const u16 *name, size_t *sizep)
+{
+	struct efi_var_entry *var, *last_var;
+	u16 *data;
+
+	last_var = (struct efi_var_entry *)((u8 *)buf + buf->length);
+	for (var = buf->var; var < last_var;
+	     var = (struct efi_var_entry *)
+		   ALIGN((uintptr_t)data + var->length, 8)) {
+		data = var->name + u16_strlen(var->name) + 1;
+		if (!guidcmp(&var->guid, guid) && !u16_strcmp(var->name, name)) {
+			*sizep = ALIGN((uintptr_t)data + var->length, 8) -
+				 (uintptr_t)var;
+			return var;
+		}
+	}
+
+	return NULL;
+}
+
+loff_t efi_var_replay(struct efi_var_file *buf, loff_t len, u32 *crcp)
+{
+	struct efi_var_file *vars;
+	struct efi_var_journal *rec;
+	u32 crc = buf->crc32;
+	loff_t pos;
+
+	if (buf->reserved || buf->magic != EFI_VAR_FILE_MAGIC ||
+	    buf->length < sizeof(*buf) || buf->length > len ||
+	    buf->crc32 != crc32(0, (u8 *)buf->var,
+				buf->length - sizeof(struct efi_var_file)))
+		return 0;
+
+	vars = malloc(EFI_VAR_BUF_SIZE);
+	if (!vars)
+		return 0;
+	memcpy(vars, buf, buf->length);
+
+	for (pos = buf->length; pos + sizeof(*rec) <= len; pos += rec->length) {
+		struct efi_var_entry *entry, *var;
+		size_t size, space;
+
+		rec = (struct efi_var_journal *)((u8 *)buf + pos);
+		entry = (struct efi_var_entry *)(rec + 1);
+		if (rec->length < sizeof(*rec) + sizeof(*entry) ||
+		    rec->length > len - pos ||
+		    rec->crc32 != crc32(crc, (u8 *)entry,
+					rec->length - sizeof(*rec)))
+			break;
+		space = rec->length - sizeof(*rec) - sizeof(*entry);
+		size = u16_strnlen(entry->name, space / sizeof(u16));
+		if (size == space / sizeof(u16))
+			break;
+
+		/* Compare lengths without overflowing, even with 32-bit size_t */
+		space -= (size + 1) * sizeof(u16);
+		if (entry->length > space ||
+		    rec->length != ALIGN(rec->length - space + entry->length, 8))
+			break;
+
+		crc = rec->crc32;
+
+		var = efi_var_buf_find(vars, &entry->guid, entry->name, &size);
+		if (var) {
+			memmove(var, (u8 *)var + size,
+				(uintptr_t)vars + vars->length -
+				(uintptr_t)var - size);
+			vars->length -= size;
+		}
+		if (!entry->length)
+			continue;
+		size = rec->length - sizeof(*rec);
+		if (vars->length + size > EFI_VAR_BUF_SIZE) {
+			log_err("EFI variables journal too long\n");
+			break;
+		}
+		memcpy((u8 *)vars + vars->length, entry, size);
+		vars->length += size;
+	}
+
+	vars->crc32 = crc32(0, (u8 *)vars->var,
+			    vars->length - sizeof(struct efi_var_file));
+	memcpy(buf, vars, vars->length);
+	free(vars);
+	*crcp = crc;
+
+	return pos;
+}
+
 efi_status_t efi_var_restore(struct efi_var_file *buf, bool safe)
 {
 	struct efi_var_entry *var, *last_var;
@@ -215,6 +405,7 @@ efi_status_t efi_var_from_file(void)
 	struct efi_var_file *buf;
 	loff_t len;
 	efi_status_t ret;
+	bool append;
 	int r;
 
 	buf = calloc(1, EFI_VAR_BUF_SIZE);
@@ -226,14 +417,18 @@ efi_status_t efi_var_from_file(void)
 	ret = efi_set_blk_dev_to_system_partition();
 	if (ret != EFI_SUCCESS)
 		goto error;
+	append = efi_var_file_can_append();
 	r = fs_read(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, EFI_VAR_BUF_SIZE,
 		    &len);
 	if (r || len < sizeof(struct efi_var_file)) {
 		log_err("Failed to load EFI variables\n");
 		goto error;
 	}
-	if (buf->length != len || efi_var_restore(buf, false) != EFI_SUCCESS)
+	efi_var_file_end = efi_var_replay(buf, len, &efi_var_file_crc);
+	if (!efi_var_file_end || efi_var_restore(buf, false) != EFI_SUCCESS)
 		log_err("Invalid EFI variables file\n");
+	if (!append)
+		efi_var_file_end = 0;
 error:
 	free(buf);
 #endif
@@ -17,7 +17,126 @@
  * relocation during SetVirtualAddressMap().
  */
 static struct efi_var_file __efi_runtime_data *efi_var_buf;
-static struct efi_var_entry __efi_runtime_data *efi_current_var;
+static u32 __efi_runtime_data *efi_var_index;
+
+/*
+ * Number of slots in the hash index of variables. Each variable takes at
+ * least 40 bytes, so the index is never more than 40% full.
+ */
+#define EFI_VAR_INDEX_SLOTS (EFI_VAR_BUF_SIZE / 16)
+
+/**
+ * efi_var_hash() - get the index slot at which to start looking for a variable
+ *
+ * @guid:	vendor GUID
+ * @name:	variable name
+ * Return:	slot number
+ */
+static u32 __efi_runtime efi_var_hash(const efi_guid_t *guid, const u16 *name)
+{
+	const u8 *pos = (const u8 *)guid;
+	u32 hash = 2166136261U;
+	int i;
+
+	/* FNV-1a */
+	for (i = 0; i < sizeof(efi_guid_t); ++i)
+		hash = (hash ^ pos[i]) * 16777619;
+	for (; *name; ++name)
+		hash = (hash ^ *name) * 16777619;
+
+	return hash % EFI_VAR_INDEX_SLOTS;
+}
+
+/**
+ * efi_var_at() - get the variable at an offset in the variable buffer
+ *
+ * @offset:	offset from the start of efi_var_buf
+ * Return:	variable
+ */
+static struct efi_var_entry __efi_runtime *efi_var_at(u32 offset)
+{
+	return (struct efi_var_entry *)((uintptr_t)efi_var_buf + offset);
+}
+
+/**
+ * efi_var_index_add() - add a variable to the hash index
+ *
+ * The index holds offsets rather than pointers, so that it remains valid
+ * after SetVirtualAddressMap().
+ *
+ * @var:	variable in efi_var_buf
+ */
+static void __efi_runtime efi_var_index_add(struct efi_var_entry *var)
+{
+	u32 slot = efi_var_hash(&var->guid, var->name);
+
+	while (efi_var_index[slot])
+		slot = (slot + 1) % EFI_VAR_INDEX_SLOTS;
+	efi_var_index[slot] = (uintptr_t)var - (uintptr_t)efi_var_buf;
+}
+
+/**
+ * efi_var_index_del() - remove a variable from the hash index
+ *
+ * The variables after @var are expected to move down by @size bytes to fill
+ * the gap, so their offsets are updated.
+ *
+ * @var:	variable in efi_var_buf
+ * @size:	number of bytes taken up by the variable
+ */
+static void __efi_runtime efi_var_index_del(struct efi_var_entry *var,
+					    u32 size)
+{
+	u32 offset = (uintptr_t)var - (uintptr_t)efi_var_buf;
+	u32 slot, next, i;
+
+	slot = efi_var_hash(&var->guid, var->name);
+	while (efi_var_index[slot] != offset)
+		slot = (slot + 1) % EFI_VAR_INDEX_SLOTS;
+
+	/*
+	 * Fill the gap with any later entry in the same run of used slots
+	 * which could not have been placed at its own start slot or before it
+	 */
+	for (next = (slot + 1) % EFI_VAR_INDEX_SLOTS; efi_var_index[next];
+	     next = (next + 1) % EFI_VAR_INDEX_SLOTS) {
+		struct efi_var_entry *other = efi_var_at(efi_var_index[next]);
+		u32 home = efi_var_hash(&other->guid, other->name);
+
+		if (next > slot ? home <= slot || home > next :
+				  home <= slot && home > next) {
+			efi_var_index[slot] = efi_var_index[next];
+			slot = next;
+		}
+	}
+	efi_var_index[slot] = 0;
+
+	for (i = 0; i < EFI_VAR_INDEX_SLOTS; ++i) {
+		if (efi_var_index[i] > offset)
+			efi_var_index[i] -= size;
+	}
+}
+
+/**
+ * efi_var_index_build() - add all variables in efi_var_buf to the hash index
+ */
+static void efi_var_index_build(void)
+{
+	struct efi_var_entry *var, *last;
+	u16 *data;
+
+	memset(efi_var_index, 0, EFI_VAR_INDEX_SLOTS * sizeof(u32));
+	last = (struct efi_var_entry *)
+	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
+	for (var = efi_var_buf->var; var < last;
+	     var = (struct efi_var_entry *)
+		   ALIGN((uintptr_t)data + var->length, 8)) {
+		efi_var_index_add(var);
+		for (data = var->name; *data; ++data)
+			;
+		++data;
+	}
+}
 
 /**
  * efi_var_mem_compare() - compare GUID and name with a variable
@@ -56,9 +175,6 @@ efi_var_mem_compare(struct efi_var_entry *var, const efi_guid_t *guid,
 		*next = (struct efi_var_entry *)
 			ALIGN((uintptr_t)data + var->length, 8);
 
-	if (match)
-		efi_current_var = var;
-
 	return match;
 }
 
@@ -67,6 +183,7 @@ struct efi_var_entry __efi_runtime
 		  struct efi_var_entry **next)
 {
 	struct efi_var_entry *var, *last;
+	u32 slot;
 
 	last = (struct efi_var_entry *)
 	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
@@ -79,28 +196,16 @@ struct efi_var_entry __efi_runtime
 		}
 		return NULL;
 	}
-	if (efi_current_var &&
-	    efi_var_mem_compare(efi_current_var, guid, name, next)) {
-		if (next && *next >= last)
-			*next = NULL;
-		return efi_current_var;
-	}
 
-	var = efi_var_buf->var;
-	if (var < last) {
-		for (; var;) {
-			struct efi_var_entry *pos;
-			bool match;
-
-			match = efi_var_mem_compare(var, guid, name, &pos);
-			if (pos >= last)
-				pos = NULL;
-			if (match) {
-				if (next)
-					*next = pos;
-				return var;
-			}
-			var = pos;
+	for (slot = efi_var_hash(guid, name); efi_var_index[slot];
+	     slot = (slot + 1) % EFI_VAR_INDEX_SLOTS) {
+		struct efi_var_entry *pos;
+
+		var = efi_var_at(efi_var_index[slot]);
+		if (efi_var_mem_compare(var, guid, name, &pos)) {
+			if (next)
+				*next = pos < last ? pos : NULL;
+			return var;
 		}
 	}
 	if (next)
@@ -118,14 +223,13 @@ void __efi_runtime efi_var_mem_del(struct efi_var_entry *var)
 
 	last = (struct efi_var_entry *)
 	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
-	if (var <= efi_current_var)
-		efi_current_var = NULL;
 
 	for (data = var->name; *data; ++data)
 		;
 	++data;
 	next = (struct efi_var_entry *)
 	       ALIGN((uintptr_t)data + var->length, 8);
+	efi_var_index_del(var, (uintptr_t)next - (uintptr_t)var);
 	efi_var_buf->length -= (uintptr_t)next - (uintptr_t)var;
 
 	/* efi_memcpy_runtime() can be used because next >= var. */
@@ -164,6 +268,7 @@ efi_status_t __efi_runtime efi_var_mem_ins(
 			   sizeof(u16) * var_name_len);
 	efi_memcpy_runtime(data, data1, size1);
 	efi_memcpy_runtime((u8 *)data + size1, data2, size2);
+	efi_var_index_add(var);
 
 	var = (struct efi_var_entry *)
 	      ALIGN((uintptr_t)data + var->length, 8);
@@ -238,7 +343,7 @@ static void EFIAPI __efi_runtime
 efi_var_mem_notify_virtual_address_map(struct efi_event *event, void *context)
 {
 	efi_convert_pointer(0, (void **)&efi_var_buf);
-	efi_current_var = NULL;
+	efi_convert_pointer(0, (void **)&efi_var_index);
 }
 
 efi_status_t efi_var_mem_init(void)
@@ -260,6 +365,16 @@ efi_status_t efi_var_mem_init(void)
 			      (uintptr_t)efi_var_buf;
 	/* crc32 for 0 bytes = 0 */
 
+	ret = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+				 EFI_RUNTIME_SERVICES_DATA,
+				 efi_size_in_pages(EFI_VAR_INDEX_SLOTS *
+						   sizeof(u32)),
+				 &memory);
+	if (ret != EFI_SUCCESS)
+		return ret;
+	efi_var_index = (u32 *)(uintptr_t)memory;
+	memset(efi_var_index, 0, EFI_VAR_INDEX_SLOTS * sizeof(u32));
+
 	ret = efi_create_event(EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_CALLBACK,
 			       efi_var_mem_notify_exit_boot_services, NULL,
 			       NULL, &event);
@@ -350,4 +465,5 @@ efi_get_next_variable_name_mem(efi_uintn_t *variable_name_size,
 void efi_var_buf_update(struct efi_var_file *var_buf)
 {
 	memcpy(efi_var_buf, var_buf, EFI_VAR_BUF_SIZE);
+	efi_var_index_build();
 }
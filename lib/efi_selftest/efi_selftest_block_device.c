@@ -446,6 +446,26 @@ static int execute(void)
 			     (unsigned int)pos);
 		return EFI_ST_FAILURE;
 	}
+	/* Read the file again in small chunks through the same handle */
+	ret = file->setpos(file, 0);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("SetPosition failed\n");
+		return EFI_ST_FAILURE;
+	}
+	for (pos = 0; pos < 13; pos += buf_size) {
+		buf_size = 4;
+		ret = file->read(file, &buf_size, buf);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("Failed to read file\n");
+			return EFI_ST_FAILURE;
+		}
+		if (buf_size != min_t(u64, 4, 13 - pos) ||
+		    memcmp(buf, "Hello world!\n" + pos, buf_size)) {
+			efi_st_error("Unexpected file content at %u\n",
+				     (unsigned int)pos);
+			return EFI_ST_FAILURE;
+		}
+	}
 	ret = file->close(file);
 	if (ret != EFI_SUCCESS) {
 		efi_st_error("Failed to close file\n");
@@ -502,6 +522,19 @@ static int execute(void)
 			     (unsigned int)pos);
 		return EFI_ST_FAILURE;
 	}
+	/* Read back through the same handle, which must see the new data */
+	ret = file->setpos(file, 0);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("SetPosition failed\n");
+		return EFI_ST_FAILURE;
+	}
+	boottime->set_mem(buf, sizeof(buf), 0);
+	buf_size = sizeof(buf) - 1;
+	ret = file->read(file, &buf_size, buf);
+	if (ret != EFI_SUCCESS || buf_size != 7 || memcmp(buf, "U-Boot", 7)) {
+		efi_st_error("Failed to read back written file\n");
+		return EFI_ST_FAILURE;
+	}
 	ret = file->close(file);
 	if (ret != EFI_SUCCESS) {
 		efi_st_error("Failed to close file\n");
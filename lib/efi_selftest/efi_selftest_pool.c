@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_pool
+ *
+ * This unit test checks the following boottime services:
+ * AllocatePool, FreePool
+ *
+ * Many small blocks of different sizes and memory types are allocated and
+ * checked for alignment and overlap. Then the number of AllocatePool() and
+ * FreePool() calls which can be made in a fixed time is reported.
+ */
+
+#include <efi_selftest.h>
+
+/* Number of blocks allocated at once */
+#define EFI_ST_POOL_COUNT 512
+
+/* Largest block to allocate */
+#define EFI_ST_POOL_MAX_SIZE 2000
+
+/* Number of blocks allocated before freeing them, when measuring */
+#define EFI_ST_POOL_BATCH 64
+
+/* Time to measure throughput for, in units of 100ns */
+#define EFI_ST_POOL_TIME 1000000
+
+static struct efi_boot_services *boottime;
+static struct efi_event *timer;
+static u8 *blocks[EFI_ST_POOL_COUNT];
+
+/**
+ * block_size() - get the size of a block to allocate
+ *
+ * @i:		index of the block
+ * Return:	size in bytes
+ */
+static efi_uintn_t block_size(unsigned int i)
+{
+	return (i * 37) % EFI_ST_POOL_MAX_SIZE + 1;
+}
+
+/**
+ * setup() - setup unit test
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	efi_status_t ret;
+
+	boottime = systable->boottime;
+
+	ret = boottime->create_event(EVT_TIMER, TPL_CALLBACK, NULL, NULL,
+				     &timer);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("could not create event\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * teardown() - tear down unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int teardown(void)
+{
+	efi_status_t ret;
+
+	if (timer) {
+		ret = boottime->close_event(timer);
+		timer = NULL;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("could not close event\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * check_blocks() - allocate blocks, fill them and check their contents
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int check_blocks(void)
+{
+	efi_status_t ret;
+	unsigned int i;
+	efi_uintn_t j;
+
+	for (i = 0; i < EFI_ST_POOL_COUNT; ++i) {
+		ret = boottime->allocate_pool(i & 1 ? EFI_LOADER_DATA :
+					      EFI_BOOT_SERVICES_DATA,
+					      block_size(i),
+					      (void **)&blocks[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+		if ((uintptr_t)blocks[i] & 7) {
+			efi_st_error("Pool memory is not 8 byte aligned\n");
+			return EFI_ST_FAILURE;
+		}
+		boottime->set_mem(blocks[i], block_size(i), i);
+	}
+
+	/* Any overlap would overwrite part of an earlier block */
+	for (i = 0; i < EFI_ST_POOL_COUNT; ++i) {
+		for (j = 0; j < block_size(i); ++j) {
+			if (blocks[i][j] != (u8)i) {
+				efi_st_error("Pool blocks overlap\n");
+				return EFI_ST_FAILURE;
+			}
+		}
+	}
+
+	/* Free in a different order from allocation */
+	for (i = 0; i < EFI_ST_POOL_COUNT; ++i) {
+		unsigned int k = (i * 7) % EFI_ST_POOL_COUNT;
+
+		ret = boottime->free_pool(blocks[k]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * execute() - execute unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	unsigned int count = 0;
+	efi_status_t ret;
+	unsigned int i;
+
+	if (check_blocks() != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	ret = boottime->set_timer(timer, EFI_TIMER_RELATIVE, EFI_ST_POOL_TIME);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not set timer\n");
+		return EFI_ST_FAILURE;
+	}
+	do {
+		for (i = 0; i < EFI_ST_POOL_BATCH; ++i) {
+			efi_uintn_t size = block_size(count + i) / 4 + 1;
+
+			ret = boottime->allocate_pool(EFI_BOOT_SERVICES_DATA,
+						      size, (void **)&blocks[i]);
+			if (ret != EFI_SUCCESS) {
+				efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+				return EFI_ST_FAILURE;
+			}
+		}
+		for (i = 0; i < EFI_ST_POOL_BATCH; ++i) {
+			ret = boottime->free_pool(blocks[i]);
+			if (ret != EFI_SUCCESS) {
+				efi_st_error("FreePool did not return EFI_SUCCESS\n");
+				return EFI_ST_FAILURE;
+			}
+		}
+		count += EFI_ST_POOL_BATCH;
+	} while (boottime->check_event(timer) == EFI_NOT_READY);
+
+	efi_st_printf("%u pool allocations in %u ms\n", count,
+		      EFI_ST_POOL_TIME / 10000);
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(pool) = {
+	.name = "pool",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+	.teardown = teardown,
+};
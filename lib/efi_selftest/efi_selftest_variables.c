@@ -12,6 +12,7 @@
 
 #define EFI_ST_MAX_DATA_SIZE 16
 #define EFI_ST_MAX_VARNAME_SIZE 80
+#define EFI_ST_MANY_VARS 64
 
 static struct efi_boot_services *boottime;
 static struct efi_runtime_services *runtime;
@@ -37,6 +38,107 @@ static int setup(const efi_handle_t img_handle,
 	return EFI_ST_SUCCESS;
 }
 
+/*
+ * Set the name of one of many variables to efi_st_mNN.
+ *
+ * @varname	buffer for the variable name
+ * @i		number of the variable
+ */
+static void many_name(u16 *varname, unsigned int i)
+{
+	const char *name = "efi_st_m";
+
+	for (; *name; ++name)
+		*varname++ = *name;
+	*varname++ = '0' + i / 10;
+	*varname++ = '0' + i % 10;
+	*varname = 0;
+}
+
+/*
+ * Set, change and delete many variables and check that the right value is
+ * found for each of them. Changes to non-volatile variables are appended to
+ * the variables file.
+ *
+ * @attributes	attributes of the variables
+ */
+static int many_variables(u32 attributes)
+{
+	u16 varname[EFI_ST_MAX_VARNAME_SIZE];
+	efi_status_t ret;
+	efi_uintn_t len;
+	unsigned int i;
+	u32 attr;
+	u8 data;
+
+	for (i = 0; i < EFI_ST_MANY_VARS; ++i) {
+		many_name(varname, i);
+		data = i;
+		ret = runtime->set_variable(varname, i & 1 ? &guid_vendor1 :
+					    &guid_vendor0,
+					    attributes, 1, &data);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("SetVariable failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	/* Change every third variable and delete every fourth one */
+	for (i = 0; i < EFI_ST_MANY_VARS; ++i) {
+		many_name(varname, i);
+		data = ~i;
+		if (i % 3 == 0)
+			ret = runtime->set_variable(
+				varname, i & 1 ? &guid_vendor1 : &guid_vendor0,
+				attributes, 1, &data);
+		else if (i % 4 == 1)
+			ret = runtime->set_variable(
+				varname, i & 1 ? &guid_vendor1 : &guid_vendor0,
+				0, 0, NULL);
+		else
+			continue;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("SetVariable failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	for (i = 0; i < EFI_ST_MANY_VARS; ++i) {
+		many_name(varname, i);
+		len = 1;
+		ret = runtime->get_variable(varname, i & 1 ? &guid_vendor1 :
+					    &guid_vendor0, &attr, &len, &data);
+		if (i % 3 && i % 4 == 1) {
+			if (ret != EFI_NOT_FOUND) {
+				efi_st_error("Variable was not deleted\n");
+				return EFI_ST_FAILURE;
+			}
+			continue;
+		}
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("GetVariable failed\n");
+			return EFI_ST_FAILURE;
+		}
+		if (data != (u8)(i % 3 ? i : ~i) || attr != attributes) {
+			efi_st_error("GetVariable returned wrong value\n");
+			return EFI_ST_FAILURE;
+		}
+		/* The same name with the other GUID must not be found */
+		ret = runtime->get_variable(varname, i & 1 ? &guid_vendor0 :
+					    &guid_vendor1, &attr, &len, &data);
+		if (ret != EFI_NOT_FOUND) {
+			efi_st_error("GetVariable found wrong variable\n");
+			return EFI_ST_FAILURE;
+		}
+		ret = runtime->set_variable(varname, i & 1 ? &guid_vendor1 :
+					    &guid_vendor0, 0, 0, NULL);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("SetVariable failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
 /*
  * Execute unit test.
  */
@@ -236,7 +338,11 @@ static int execute(void)
 		return EFI_ST_FAILURE;
 	}
 
-	return EFI_ST_SUCCESS;
+	if (many_variables(EFI_VARIABLE_BOOTSERVICE_ACCESS) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	return many_variables(EFI_VARIABLE_BOOTSERVICE_ACCESS |
+			      EFI_VARIABLE_NON_VOLATILE);
 }
 
 EFI_UNIT_TEST(variables) = {
@@ -15,6 +15,7 @@
 #include <memalign.h>
 #include <u-boot/crc.h>
 #include <watchdog.h>
+#include <linux/sizes.h>
 #include <u-boot/zlib.h>
 
 #define HEADER0			'\x1f'
@@ -82,6 +83,67 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+/*
+ * Input is passed to inflate() in pieces of this size. Each call copies up to
+ * 32KiB of output into the sliding window, so this should not be too small.
+ */
+#define GUNZIP_FN_CHUNK		SZ_256K
+
+int gunzip_fn(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
+	      int (*func)(void *priv, const void *buf, ulong size, bool last),
+	      void *priv)
+{
+	ulong len = *lenp;
+	ulong pos, chunk, start;
+	z_stream s;
+	int offset, r, ret;
+
+	offset = gzip_parse_header(src, len);
+	if (offset < 0)
+		return offset;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		return -1;
+	}
+	s.next_out = dst;
+	s.avail_out = dstlen;
+
+	/* The trailer after the end of the stream is passed to @func too */
+	ret = 0;
+	for (pos = 0; pos < len; pos += chunk) {
+		chunk = min_t(ulong, len - pos, GUNZIP_FN_CHUNK);
+		ret = func(priv, src + pos, chunk, pos + chunk == len);
+		if (ret)
+			break;
+		if (r == Z_STREAM_END || pos + chunk <= offset)
+			continue;
+
+		start = max_t(ulong, pos, offset);
+		s.next_in = src + start;
+		s.avail_in = pos + chunk - start;
+		do {
+			r = inflate(&s, Z_NO_FLUSH);
+		} while (r == Z_OK && s.avail_in);
+		if (r != Z_OK && r != Z_STREAM_END) {
+			printf("Error: inflate() returned %d\n", r);
+			ret = -1;
+			break;
+		}
+	}
+	if (!ret && r != Z_STREAM_END) {
+		puts("Error: gunzip out of data\n");
+		ret = -1;
+	}
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+
+	return ret;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(ulong expectedsize)
@@ -6,8 +6,10 @@
 #include <common.h>
 #include <compiler.h>
 #include <image.h>
+#include <malloc.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
+#include <linux/xxhash.h>
 #include <asm/unaligned.h>
 #include <u-boot/lz4.h>
 
@@ -15,95 +17,342 @@
 #include "lz4.c"	/* #include for inlining, do not link! */
 
 #define LZ4F_BLOCKUNCOMPRESSED_FLAG 0x80000000U
+#define LZ4F_LEGACY_MAGIC	0x184C2102U
+#define LZ4F_SKIPPABLE_MAGIC	0x184D2A50U
+#define LZ4F_SKIPPABLE_MASK	0xFFFFFFF0U
 
-int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+/* Frame descriptor flags */
+#define LZ4F_INDEPENDENT_BLOCKS	BIT(5)
+#define LZ4F_BLOCK_CHECKSUM	BIT(4)
+#define LZ4F_CONTENT_SIZE	BIT(3)
+#define LZ4F_CONTENT_CHECKSUM	BIT(2)
+
+/* Legacy frames use fixed 8MiB blocks, compressed no larger than this */
+#define LZ4F_LEGACY_BLOCK	(8 << 20)
+#define LZ4F_LEGACY_BOUND	(LZ4F_LEGACY_BLOCK + LZ4F_LEGACY_BLOCK / 255 + 16)
+
+enum ulz4_state {
+	ULZ4_MAGIC,		/* magic number of the next frame */
+	ULZ4_DESC,		/* FLG and BD bytes */
+	ULZ4_DESC_REST,		/* content size and header checksum */
+	ULZ4_BLOCK,		/* block header, or end mark */
+	ULZ4_DATA,		/* block data */
+	ULZ4_BLOCK_CSUM,	/* block checksum */
+	ULZ4_CONTENT_CSUM,	/* content checksum, after the end mark */
+	ULZ4_SKIP_SIZE,		/* size of a skippable frame */
+	ULZ4_SKIP,		/* contents of a skippable frame */
+	ULZ4_DONE,		/* trailing data after the last frame */
+};
+
+static void ulz4_expect(struct ulz4_stream *strm, enum ulz4_state state,
+			u32 need)
 {
-	const void *end = dst + *dstn;
-	const void *in = src;
-	void *out = dst;
-	int has_block_checksum;
-	int ret;
-	*dstn = 0;
-
-	{ /* With in-place decompression the header may become invalid later. */
-		u32 magic;
-		u8 flags, version, independent_blocks, has_content_size;
-		u8 block_desc;
-
-		if (srcn < sizeof(u32) + 3*sizeof(u8))
-			return -EINVAL;	/* input overrun */
-
-		magic = get_unaligned_le32(in);
-		in += sizeof(u32);
-		flags = *(u8 *)in;
-		in += sizeof(u8);
-		block_desc = *(u8 *)in;
-		in += sizeof(u8);
-
-		version = (flags >> 6) & 0x3;
-		independent_blocks = (flags >> 5) & 0x1;
-		has_block_checksum = (flags >> 4) & 0x1;
-		has_content_size = (flags >> 3) & 0x1;
-
-		/* We assume there's always only a single, standard frame. */
-		if (magic != LZ4F_MAGIC || version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if ((flags & 0x03) || (block_desc & 0x8f))
-			return -EINVAL;	/* reserved bits must be zero */
-		if (!independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-
-		if (has_content_size) {
-			if (srcn < sizeof(u32) + 3*sizeof(u8) + sizeof(u64))
-				return -EINVAL;	/* input overrun */
-			in += sizeof(u64);
-		}
-		/* Header checksum byte */
-		in += sizeof(u8);
+	strm->state = state;
+	strm->need = need;
+}
+
+static int ulz4_magic(struct ulz4_stream *strm, u32 magic)
+{
+	if (magic == LZ4F_MAGIC) {
+		ulz4_expect(strm, ULZ4_DESC, 2);
+	} else if (magic == LZ4F_LEGACY_MAGIC) {
+		strm->legacy = true;
+		strm->block_max = LZ4F_LEGACY_BOUND;
+		strm->frame = strm->out;
+		strm->frames++;
+		ulz4_expect(strm, ULZ4_BLOCK, sizeof(u32));
+	} else if ((magic & LZ4F_SKIPPABLE_MASK) == LZ4F_SKIPPABLE_MAGIC) {
+		ulz4_expect(strm, ULZ4_SKIP_SIZE, sizeof(u32));
+	} else if (strm->frames) {
+		/* Padding or other data after the image */
+		ulz4_expect(strm, ULZ4_DONE, 0);
+	} else {
+		return -EPROTONOSUPPORT;	/* unknown format */
 	}
 
-	while (1) {
-		u32 block_header, block_size;
+	return 0;
+}
 
-		block_header = get_unaligned_le32(in);
-		in += sizeof(u32);
-		block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+static int ulz4_desc(struct ulz4_stream *strm, const u8 *data)
+{
+	u8 flags = data[0], block_desc = data[1];
+	uint block_id = (block_desc >> 4) & 0x7;
 
-		if (in - src + block_size > srcn) {
-			ret = -EINVAL;		/* input overrun */
-			break;
-		}
+	if ((flags >> 6) != 1)
+		return -EPROTONOSUPPORT;	/* unknown version */
+	if ((flags & 0x03) || (block_desc & 0x8f) || block_id < 4)
+		return -EINVAL;	/* reserved bits must be zero */
+
+	strm->flags = flags;
+	strm->legacy = false;
+	strm->block_max = 1 << (8 + 2 * block_id);
+	memcpy(strm->hdr, data, 2);
+	ulz4_expect(strm, ULZ4_DESC_REST,
+		    (flags & LZ4F_CONTENT_SIZE ? sizeof(u64) : 0) + 1);
+
+	return 0;
+}
+
+static int ulz4_desc_rest(struct ulz4_stream *strm, const u8 *data)
+{
+	u32 len = strm->need - 1;
+
+	/*
+	 * The checksum covers the descriptor, from the FLG byte onwards. If
+	 * the field was gathered, it is already in place after FLG and BD.
+	 */
+	if (data != strm->hdr + 2)
+		memcpy(strm->hdr + 2, data, len);
+	if (data[len] != ((xxh32(strm->hdr, 2 + len, 0) >> 8) & 0xff))
+		return -EBADMSG;
+
+	strm->frame = strm->out;
+	strm->frames++;
+	ulz4_expect(strm, ULZ4_BLOCK, sizeof(u32));
 
-		if (!block_size) {
-			ret = 0;	/* decompression successful */
-			break;
+	return 0;
+}
+
+static int ulz4_block(struct ulz4_stream *strm, u32 block_header)
+{
+	u32 block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+
+	if (strm->legacy) {
+		/*
+		 * Legacy frames have no end mark: the stream just ends, or
+		 * starts a new frame, or is followed by something else, such
+		 * as the uncompressed size which Linux appends to its images.
+		 */
+		if (block_header == LZ4F_LEGACY_MAGIC)
+			return ulz4_magic(strm, block_header);
+		if (!block_header || block_header > LZ4F_LEGACY_BOUND) {
+			ulz4_expect(strm, ULZ4_MAGIC, sizeof(u32));
+			return ulz4_magic(strm, block_header);
 		}
+		block_size = block_header;
+	} else if (!block_size) {
+		if (strm->flags & LZ4F_CONTENT_CHECKSUM)
+			ulz4_expect(strm, ULZ4_CONTENT_CSUM, sizeof(u32));
+		else
+			ulz4_expect(strm, ULZ4_MAGIC, sizeof(u32));
+		return 0;
+	}
+	if (block_size > strm->block_max)
+		return -EINVAL;
+
+	strm->block_header = block_header;
+	ulz4_expect(strm, ULZ4_DATA, block_size);
+
+	return 0;
+}
+
+static int ulz4_data(struct ulz4_stream *strm, const void *data)
+{
+	u32 block_size = strm->need;
+	void *out = strm->out;
+	int ret;
+
+	if (strm->block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
+		size_t size = min((ptrdiff_t)block_size,
+				  (ptrdiff_t)(strm->end - out));
+
+		memcpy(out, data, size);
+		strm->out += size;
+		if (size < block_size)
+			return -ENOBUFS;	/* output overrun */
+	} else {
+		const BYTE *prefix = out;
+
+		/*
+		 * Linked blocks refer back up to 64KiB into the output of
+		 * earlier blocks, which is still in the output buffer
+		 */
+		if (!strm->legacy &&
+		    !(strm->flags & LZ4F_INDEPENDENT_BLOCKS))
+			prefix = strm->frame;
+
+		/* constant folding essential, do not touch params! */
+		ret = LZ4_decompress_generic(data, out, block_size,
+				strm->end - out, endOnInputSize,
+				decode_full_block, noDict, prefix, NULL, 0);
+		if (ret < 0)
+			return -EPROTO;	/* decompression error */
+		strm->out += ret;
+	}
+
+	if (!strm->legacy && (strm->flags & LZ4F_BLOCK_CHECKSUM)) {
+		strm->block_csum = xxh32(data, block_size, 0);
+		ulz4_expect(strm, ULZ4_BLOCK_CSUM, sizeof(u32));
+	} else {
+		ulz4_expect(strm, ULZ4_BLOCK, sizeof(u32));
+	}
+
+	return 0;
+}
+
+/* Handle a complete field of strm->need bytes */
+static int ulz4_field(struct ulz4_stream *strm, const u8 *data)
+{
+	u32 val = strm->need == sizeof(u32) ? get_unaligned_le32(data) : 0;
+
+	switch (strm->state) {
+	case ULZ4_MAGIC:
+		return ulz4_magic(strm, val);
+	case ULZ4_DESC:
+		return ulz4_desc(strm, data);
+	case ULZ4_DESC_REST:
+		return ulz4_desc_rest(strm, data);
+	case ULZ4_BLOCK:
+		return ulz4_block(strm, val);
+	case ULZ4_DATA:
+		return ulz4_data(strm, data);
+	case ULZ4_BLOCK_CSUM:
+		if (val != strm->block_csum)
+			return -EBADMSG;
+		ulz4_expect(strm, ULZ4_BLOCK, sizeof(u32));
+		return 0;
+	case ULZ4_CONTENT_CSUM:
+		if (val != xxh32(strm->frame, strm->out - strm->frame, 0))
+			return -EBADMSG;
+		ulz4_expect(strm, ULZ4_MAGIC, sizeof(u32));
+		return 0;
+	case ULZ4_SKIP_SIZE:
+		if (val)
+			ulz4_expect(strm, ULZ4_SKIP, val);
+		else
+			ulz4_expect(strm, ULZ4_MAGIC, sizeof(u32));
+		return 0;
+	default:
+		return 0;
+	}
+}
+
+/* Get a buffer in which to gather a field which is split across pieces */
+static u8 *ulz4_gather_buf(struct ulz4_stream *strm)
+{
+	/* Keep FLG and BD, which the header checksum covers */
+	if (strm->state == ULZ4_DESC_REST)
+		return strm->hdr + 2;
+	if (strm->need <= sizeof(strm->hdr))
+		return strm->hdr;
+	if (strm->buf_size < strm->need) {
+		free(strm->buf);
+		strm->buf_size = 0;
+		strm->buf = malloc(strm->block_max);
+		if (!strm->buf)
+			return NULL;
+		strm->buf_size = strm->block_max;
+	}
+
+	return strm->buf;
+}
+
+void ulz4_stream_init(struct ulz4_stream *strm, void *dst, size_t dstn)
+{
+	memset(strm, '\0', sizeof(*strm));
+	strm->dst = dst;
+	strm->out = dst;
+	strm->end = dst + dstn;
+	strm->frame = dst;
+	ulz4_expect(strm, ULZ4_MAGIC, sizeof(u32));
+}
+
+int ulz4_stream_decompress(struct ulz4_stream *strm, const void *src,
+			   size_t srcn)
+{
+	const u8 *in = src, *end = src + srcn;
+	int ret;
+
+	while (in < end && strm->state != ULZ4_DONE) {
+		size_t avail = end - in;
+		const u8 *data;
+
+		if (strm->state == ULZ4_SKIP) {
+			size_t len = min_t(size_t, avail,
+					   strm->need - strm->have);
 
-		if (block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
-			size_t size = min((ptrdiff_t)block_size, (ptrdiff_t)(end - out));
-			memcpy(out, in, size);
-			out += size;
-			if (size < block_size) {
-				ret = -ENOBUFS;	/* output overrun */
+			/* Nothing to look at, so just count it */
+			strm->have += len;
+			in += len;
+			if (strm->have < strm->need)
 				break;
-			}
+			strm->have = 0;
+			ulz4_expect(strm, ULZ4_MAGIC, sizeof(u32));
+			continue;
+		}
+
+		if (!strm->have && avail >= strm->need) {
+			/* The whole field is here, so use it where it is */
+			data = in;
+			in += strm->need;
 		} else {
-			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, block_size,
-					end - out, endOnInputSize,
-					decode_full_block, noDict, out, NULL, 0);
-			if (ret < 0) {
-				ret = -EPROTO;	/* decompression error */
+			size_t len = min_t(size_t, avail,
+					   strm->need - strm->have);
+			u8 *buf = ulz4_gather_buf(strm);
+
+			if (!buf)
+				return -ENOMEM;
+			memcpy(buf + strm->have, in, len);
+			strm->have += len;
+			in += len;
+			if (strm->have < strm->need)
 				break;
-			}
-			out += ret;
+			strm->have = 0;
+			data = buf;
 		}
 
-		in += block_size;
-		if (has_block_checksum)
-			in += sizeof(u32);
+		ret = ulz4_field(strm, data);
+		if (ret)
+			return ret;
+	}
+
+	switch (strm->state) {
+	case ULZ4_MAGIC:
+	case ULZ4_DONE:
+		return 0;
+	case ULZ4_BLOCK:
+	case ULZ4_DATA:
+		/*
+		 * A legacy frame may end after any block, perhaps followed by
+		 * a trailing word which looks like the start of another block
+		 */
+		return strm->legacy && !strm->have ? 0 : 1;
+	default:
+		return 1;
 	}
+}
+
+size_t ulz4_stream_want(const struct ulz4_stream *strm)
+{
+	if (strm->state == ULZ4_DONE)
+		return 0;
+
+	return strm->need - strm->have;
+}
+
+size_t ulz4_stream_end(struct ulz4_stream *strm)
+{
+	free(strm->buf);
+	strm->buf = NULL;
+	strm->buf_size = 0;
+
+	return strm->out - strm->dst;
+}
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct ulz4_stream strm;
+	int ret;
+
+	/*
+	 * All the input is here, so every field is used in place and nothing
+	 * needs to be allocated. This also allows in-place decompression.
+	 */
+	ulz4_stream_init(&strm, dst, *dstn);
+	ret = ulz4_stream_decompress(&strm, src, srcn);
+	if (ret > 0 || (!ret && !strm.frames))
+		ret = -EINVAL;	/* input overrun */
+	*dstn = ulz4_stream_end(&strm);
 
-	*dstn = out - dst;
 	return ret;
 }
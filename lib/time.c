@@ -195,6 +195,7 @@ void udelay(unsigned long usec)
 {
 	ulong kv;
 
+	bootstage_add_delay(usec);
 	do {
 		schedule();
 		kv = usec > CFG_WD_PERIOD ? CFG_WD_PERIOD : usec;
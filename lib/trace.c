@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <mapmem.h>
+#include <os.h>
 #include <time.h>
 #include <trace.h>
 #include <asm/global_data.h>
@@ -15,6 +16,7 @@ DECLARE_GLOBAL_DATA_PTR;
 
 static char trace_enabled __section(".data");
 static char trace_inited __section(".data");
+static char trace_sampling __section(".data");
 
 /* The header block at the start of the trace memory area */
 struct trace_hdr {
@@ -40,13 +42,23 @@ struct trace_hdr {
 	int max_depth;		/* Maximum depth seen so far */
 	int min_depth;		/* Minimum depth seen so far */
 	bool trace_locked;	/* Used to detect recursive tracing */
+
+	/* Program-counter samples, each a struct trace_sample and addresses */
+	u32 *samples;		/* The sample records */
+	ulong sample_size;	/* Num. of words we have space for */
+	ulong sample_used;	/* Num. of words written */
+	ulong sample_count;	/* Num. of samples written */
+	ulong sample_dropped;	/* Samples dropped due to overflow */
+	ulong sample_untracked;	/* Samples with no address in U-Boot */
+	uint sample_interval;	/* Time between samples in us */
+	ulong sample_last;	/* Time of the last sample in us */
 };
 
 /* Pointer to start of trace buffer */
 static struct trace_hdr *hdr __section(".data");
 
 static inline uintptr_t __attribute__((no_instrument_function))
-		func_ptr_to_num(void *func_ptr)
+		func_ptr_to_offset(void *func_ptr)
 {
 	uintptr_t offset = (uintptr_t)func_ptr;
 
@@ -58,7 +70,13 @@ static inline uintptr_t __attribute__((no_instrument_function))
 	else
 		offset -= CONFIG_TEXT_BASE;
 #endif
-	return offset / FUNC_SITE_SIZE;
+	return offset;
+}
+
+static inline uintptr_t __attribute__((no_instrument_function))
+		func_ptr_to_num(void *func_ptr)
+{
+	return func_ptr_to_offset(func_ptr) / FUNC_SITE_SIZE;
 }
 
 #if defined(CONFIG_EFI_LOADER) && (defined(CONFIG_ARM) || defined(CONFIG_RISCV))
@@ -294,6 +312,130 @@ int trace_list_calls(void *buff, size_t buff_size, size_t *needed)
 	return 0;
 }
 
+/**
+ * trace_list_samples() - produce a list of program-counter samples
+ *
+ * The information is written into the supplied buffer - a header followed
+ * by the sample records.
+ *
+ * @buff:	buffer to place list into
+ * @buff_size:	size of buffer
+ * @needed:	returns size of buffer needed, which may be
+ *		greater than buff_size if we ran out of space.
+ * Return:	0 if ok, -ENOSPC if space was exhausted
+ */
+int trace_list_samples(void *buff, size_t buff_size, size_t *needed)
+{
+	struct trace_output_hdr *output_hdr = NULL;
+	void *end, *ptr = buff;
+	ulong pos, used;
+	size_t upto;
+
+	end = buff ? buff + buff_size : NULL;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) < end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	/* Add each sample, with its addresses */
+	used = trace_inited ? hdr->sample_used : 0;
+	for (pos = upto = 0; pos < used; pos += 1 + hdr->samples[pos]) {
+		size_t size = (1 + hdr->samples[pos]) * sizeof(u32);
+
+		if (ptr + size <= end) {
+			memcpy(ptr, &hdr->samples[pos], size);
+			upto++;
+		}
+		ptr += size;
+	}
+
+	/* Update the header */
+	if (output_hdr) {
+		memset(output_hdr, '\0', sizeof(*output_hdr));
+		output_hdr->rec_count = upto;
+		output_hdr->type = TRACE_CHUNK_SAMPLES;
+		output_hdr->version = TRACE_VERSION;
+		output_hdr->text_base = CONFIG_TEXT_BASE;
+	}
+
+	/* Work out how must of the buffer we used */
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -ENOSPC;
+
+	return 0;
+}
+
+void notrace trace_sample_add(void *const *addrs, int count)
+{
+	u32 *rec;
+	int i, depth;
+
+	if (!trace_sampling)
+		return;
+	count = min_t(int, count, TRACE_SAMPLE_MAX_DEPTH);
+	if (hdr->sample_used + 1 + count > hdr->sample_size) {
+		hdr->sample_dropped++;
+		return;
+	}
+
+	/* Drop addresses in the C library, etc. on sandbox */
+	rec = &hdr->samples[hdr->sample_used];
+	for (i = depth = 0; i < count; i++) {
+		uintptr_t offset = func_ptr_to_offset(addrs[i]);
+
+		if (offset < gd->mon_len)
+			rec[1 + depth++] = offset;
+	}
+	if (!depth) {
+		hdr->sample_untracked++;
+		return;
+	}
+	rec[0] = depth;
+	hdr->sample_used += 1 + depth;
+	hdr->sample_count++;
+}
+
+void notrace trace_sample_poll(void *pc)
+{
+	ulong now;
+
+	if (!trace_sampling)
+		return;
+	now = timer_get_us();
+	if (now - hdr->sample_last < hdr->sample_interval)
+		return;
+	hdr->sample_last = now;
+	trace_sample_add(&pc, 1);
+}
+
+int trace_sample_start(uint interval_us)
+{
+	if (!trace_inited || !hdr->sample_size)
+		return -ENOSYS;
+	if (!interval_us)
+		return -EINVAL;
+
+	hdr->sample_interval = interval_us;
+	hdr->sample_last = timer_get_us();
+	trace_sampling = 1;
+	if (IS_ENABLED(CONFIG_SANDBOX) &&
+	    os_set_sample_handler(interval_us, trace_sample_add)) {
+		trace_sampling = 0;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void trace_sample_stop(void)
+{
+	if (IS_ENABLED(CONFIG_SANDBOX))
+		os_set_sample_handler(0, NULL);
+	trace_sampling = 0;
+}
+
 /**
  * trace_print_stats() - print basic information about tracing
  */
@@ -331,6 +473,17 @@ void trace_print_stats(void)
 	puts(" calls not traced due to depth\n");
 	print_grouped_ull(hdr->ftrace_size, 10);
 	puts(" max function calls\n");
+	if (IS_ENABLED(CONFIG_TRACE_SAMPLE)) {
+		print_grouped_ull(hdr->sample_count, 10);
+		puts(" samples");
+		if (hdr->sample_dropped) {
+			printf(" (%lu dropped due to overflow)",
+			       hdr->sample_dropped);
+		}
+		puts("\n");
+		print_grouped_ull(hdr->sample_untracked, 10);
+		puts(" samples outside U-Boot\n");
+	}
 	printf("\ntrace buffer %lx call records %lx\n",
 	       (ulong)map_to_sysmem(hdr), (ulong)map_to_sysmem(hdr->ftrace));
 }
@@ -414,6 +567,18 @@ int notrace trace_init(void *buff, size_t buff_size)
 	hdr->func_count = func_count;
 	hdr->call_accum = (uintptr_t *)(hdr + 1);
 
+#ifdef CONFIG_TRACE_SAMPLE
+	/* Keep space for samples at the end of the buffer */
+	if (needed + CONFIG_TRACE_SAMPLE_BUFFER_SIZE > buff_size) {
+		printf("trace: buffer size %zx bytes: at least %zx needed\n",
+		       buff_size, needed + CONFIG_TRACE_SAMPLE_BUFFER_SIZE);
+		return -ENOSPC;
+	}
+	buff_size -= CONFIG_TRACE_SAMPLE_BUFFER_SIZE;
+	hdr->samples = buff + buff_size;
+	hdr->sample_size = CONFIG_TRACE_SAMPLE_BUFFER_SIZE / sizeof(u32);
+#endif
+
 	/* Use any remaining space for the timed function trace */
 	hdr->ftrace = (struct trace_call *)(buff + needed);
 	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
@@ -8,4 +8,13 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* Space needed by inflate_fast() to decode without checking as it goes */
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+#define INFLATE_FAST_MIN_INPUT 8
+#define INFLATE_FAST_MIN_OUTPUT (258 + 7)
+#else
+#define INFLATE_FAST_MIN_INPUT 6
+#define INFLATE_FAST_MIN_OUTPUT 258
+#endif
+
 void inflate_fast OF((z_streamp strm, unsigned start));
@@ -25,7 +25,11 @@
 #include "inflate.h"
 #include "inffast.h"
 #include "inffixed.h"
+#ifdef CONFIG_ZLIB_INFLATE_FAST
+#include "inffast_chunk.c"
+#else
 #include "inffast.c"
+#endif
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
@@ -11,27 +11,49 @@
 #include <malloc.h>
 #include <linux/zstd.h>
 
-int zstd_decompress(struct abuf *in, struct abuf *out)
+int zstd_ctx_init(struct zstd_ctx *ctx, size_t max_window)
 {
-	zstd_dctx *ctx;
-	size_t wsize, len;
-	void *workspace;
-	int ret;
+	size_t wsize;
 
-	wsize = zstd_dctx_workspace_bound();
-	workspace = malloc(wsize);
-	if (!workspace) {
+	if (max_window)
+		wsize = zstd_dstream_workspace_bound(max_window);
+	else
+		wsize = zstd_dctx_workspace_bound();
+	ctx->workspace = malloc(wsize);
+	if (!ctx->workspace) {
 		debug("%s: cannot allocate workspace of size %zu\n", __func__,
-			wsize);
+		      wsize);
 		return -ENOMEM;
 	}
 
-	ctx = zstd_init_dctx(workspace, wsize);
-	if (!ctx) {
-		log_err("%s: zstd_init_dctx() failed\n", __func__);
-		ret = -EPERM;
-		goto do_free;
+	/* A stream context can also decompress whole frames */
+	if (max_window)
+		ctx->dctx = zstd_init_dstream(max_window, ctx->workspace,
+					      wsize);
+	else
+		ctx->dctx = zstd_init_dctx(ctx->workspace, wsize);
+	if (!ctx->dctx) {
+		log_err("%s: cannot init context\n", __func__);
+		free(ctx->workspace);
+		ctx->workspace = NULL;
+		return -EPERM;
 	}
+	ctx->max_window = max_window;
+
+	return 0;
+}
+
+void zstd_ctx_uninit(struct zstd_ctx *ctx)
+{
+	free(ctx->workspace);
+	ctx->workspace = NULL;
+	ctx->dctx = NULL;
+}
+
+int zstd_decompress_ctx(struct zstd_ctx *ctx, struct abuf *in,
+			struct abuf *out)
+{
+	size_t len;
 
 	/*
 	 * Find out how large the frame actually is, there may be junk at
@@ -41,21 +63,67 @@ int zstd_decompress(struct abuf *in, struct abuf *out)
 	if (zstd_is_error(len)) {
 		log_err("%s: failed to detect compressed size: %d\n", __func__,
 			zstd_get_error_code(len));
-		ret = -EINVAL;
-		goto do_free;
+		return -EINVAL;
 	}
 
-	len = zstd_decompress_dctx(ctx, abuf_data(out), abuf_size(out),
+	len = zstd_decompress_dctx(ctx->dctx, abuf_data(out), abuf_size(out),
 				   abuf_data(in), len);
 	if (zstd_is_error(len)) {
 		log_err("%s: failed to decompress: %d\n", __func__,
 			zstd_get_error_code(len));
-		ret = -EINVAL;
-		goto do_free;
+		return -EINVAL;
+	}
+
+	return len;
+}
+
+int zstd_stream_start(struct zstd_ctx *ctx)
+{
+	if (!ctx->max_window)
+		return -EINVAL;
+	if (zstd_is_error(zstd_reset_dstream(ctx->dctx)))
+		return -EINVAL;
+
+	return 0;
+}
+
+int zstd_stream_decompress(struct zstd_ctx *ctx, struct abuf *in,
+			   size_t *in_pos, struct abuf *out, size_t *out_pos)
+{
+	zstd_in_buffer ibuf = {
+		.src = abuf_data(in),
+		.size = abuf_size(in),
+		.pos = *in_pos,
+	};
+	zstd_out_buffer obuf = {
+		.dst = abuf_data(out),
+		.size = abuf_size(out),
+		.pos = *out_pos,
+	};
+	size_t ret;
+
+	ret = zstd_decompress_stream(ctx->dctx, &obuf, &ibuf);
+	*in_pos = ibuf.pos;
+	*out_pos = obuf.pos;
+	if (zstd_is_error(ret)) {
+		log_debug("failed to decompress: %d\n",
+			  zstd_get_error_code(ret));
+		return -EINVAL;
 	}
 
-	ret = len;
-do_free:
-	free(workspace);
+	return ret ? 1 : 0;
+}
+
+int zstd_decompress(struct abuf *in, struct abuf *out)
+{
+	struct zstd_ctx ctx;
+	int ret;
+
+	ret = zstd_ctx_init(&ctx, 0);
+	if (ret)
+		return ret;
+	ret = zstd_decompress_ctx(&ctx, in, out);
+	zstd_ctx_uninit(&ctx);
+
 	return ret;
 }
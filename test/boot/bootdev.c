@@ -436,6 +436,58 @@ static int bootdev_test_hunt_scan(struct unit_test_state *uts)
 }
 BOOTSTD_TEST(bootdev_test_hunt_scan, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
 
+/* Check running the hunters ahead of the scan */
+static int bootdev_test_hunt_ahead(struct unit_test_state *uts)
+{
+	struct bootflow_iter iter;
+	struct bootstd_priv *std;
+	struct bootflow bflow;
+	int i, ret;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_HUNT_AHEAD))
+		return -EAGAIN;
+
+	/* get access to the used hunters */
+	ut_assertok(bootstd_get_priv(&std));
+
+	ut_assertok(bootstd_test_drop_bootdev_order(uts));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter,
+					BOOTFLOWIF_HUNT | BOOTFLOWIF_HUNT_AHEAD |
+					BOOTFLOWIF_SKIP_GLOBAL, &bflow));
+	ut_asserteq(BIT(MMC_HUNTER) | BIT(1), std->hunters_used);
+	ut_asserteq(0, std->hunters_ahead);
+	bootflow_free(&bflow);
+
+	/* moving to the next bootdev uses the first prio-4 hunter (nvme) */
+	do {
+		ret = bootflow_scan_next(&iter, &bflow);
+		bootflow_free(&bflow);
+	} while (!std->hunters_ahead && ret != -ENODEV);
+	ut_asserteq(BIT(4), std->hunters_ahead);
+	bootflow_iter_uninit(&iter);
+
+	/*
+	 * Each call uses one more hunter, lowest priority number first, so the
+	 * ethernet hunter (the only one with priority 6) is last
+	 */
+	for (i = 0; i <= MAX_HUNTER; i++) {
+		bootdev_hunt_ahead();
+		if (std->hunters_ahead & BIT(0))
+			break;
+	}
+	ut_asserteq(GENMASK(MAX_HUNTER, 0) & ~(BIT(MMC_HUNTER) | BIT(1)),
+		    std->hunters_ahead);
+	ut_asserteq(GENMASK(MAX_HUNTER, 0), std->hunters_used);
+
+	/* once all are used, there is nothing more to do */
+	bootdev_hunt_ahead();
+	ut_asserteq(GENMASK(MAX_HUNTER, 0), std->hunters_used);
+
+	return 0;
+}
+BOOTSTD_TEST(bootdev_test_hunt_ahead, UT_TESTF_DM | UT_TESTF_SCAN_FDT |
+	     UT_TESTF_ETH_BOOTDEV);
+
 /* Check that only bootable partitions are processed */
 static int bootdev_test_bootable(struct unit_test_state *uts)
 {
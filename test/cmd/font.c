@@ -69,6 +69,46 @@ static int font_test_base(struct unit_test_state *uts)
 FONT_TEST(font_test_base, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT |
 	  UT_TESTF_CONSOLE_REC | UT_TESTF_DM);
 
+/* Test 'font cache' and the glyph cache itself */
+static int font_test_cache(struct unit_test_state *uts)
+{
+	struct vidconsole_cache_stats before, stats;
+	struct udevice *dev;
+
+	if (!IS_ENABLED(CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE))
+		return -EAGAIN;
+
+	ut_assertok(uclass_first_device_err(UCLASS_VIDEO, &dev));
+	ut_assertok(uclass_first_device_err(UCLASS_VIDEO_CONSOLE, &dev));
+
+	/* Drawing the same character in the same place must hit the cache */
+	ut_assertok(vidconsole_get_cache_stats(dev, &before));
+	ut_assert(vidconsole_putc_xy(dev, 0, 0, 'a') > 0);
+	ut_assert(vidconsole_putc_xy(dev, 0, 0, 'a') > 0);
+	ut_assertok(vidconsole_get_cache_stats(dev, &stats));
+	ut_asserteq(before.hits + before.misses + 2, stats.hits + stats.misses);
+	ut_assert(stats.hits > before.hits);
+	ut_assert(stats.count > 0);
+	ut_asserteq(IF_ENABLED_INT(CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE,
+				   CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE_SIZE),
+		    stats.budget);
+
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("font cache", 0));
+	ut_assert_nextline("Glyphs:    %u", stats.count);
+	ut_assert_nextline("Memory:    %lx / %lx bytes", stats.used,
+			   stats.budget);
+	ut_assert_nextline("Hits:      %lu (%lu%%)", stats.hits,
+			   stats.hits * 100 / (stats.hits + stats.misses));
+	ut_assert_nextline("Misses:    %lu", stats.misses);
+	ut_assert_nextline("Evictions: %lu", stats.evictions);
+	ut_assertok(ut_check_console_end(uts));
+
+	return 0;
+}
+FONT_TEST(font_test_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT |
+	  UT_TESTF_CONSOLE_REC | UT_TESTF_DM);
+
 int do_ut_font(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	struct unit_test *tests = UNIT_TEST_SUITE_START(font_Test);
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for bootstage spans
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <malloc.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test that spans nest and record the time spent in udelay() */
+static int bootstage_test_spans(struct unit_test_state *uts)
+{
+	const struct bootstage_span *span;
+	int outer, inner;
+
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_SPANS))
+		return -EAGAIN;
+
+	ut_assertok(bootstage_span_clear());
+	outer = bootstage_span_start(BOOTSTAGE_SPAN_OTHER, "outer");
+	ut_asserteq(0, outer);
+	inner = bootstage_span_start(BOOTSTAGE_SPAN_FS_LOAD, "inner");
+	ut_asserteq(1, inner);
+	bootstage_add_delay(123);
+
+	/* spans cannot be cleared while open */
+	ut_asserteq(-EBUSY, bootstage_span_clear());
+	ut_assertnonnull(bootstage_get_span(inner));
+
+	/* ending the outer span also ends the inner one */
+	bootstage_span_end(outer);
+
+	span = bootstage_get_span(inner);
+	ut_assertnonnull(span);
+	ut_asserteq_str("inner", span->name);
+	ut_asserteq(BOOTSTAGE_SPAN_FS_LOAD, span->type);
+	ut_asserteq(outer, span->parent);
+	ut_asserteq(1, span->depth);
+	ut_asserteq(123, span->delay_us);
+	ut_assert(span->end_us >= span->start_us);
+
+	span = bootstage_get_span(outer);
+	ut_assertnonnull(span);
+	ut_asserteq(-1, span->parent);
+	ut_asserteq(0, span->depth);
+	ut_asserteq(0, span->delay_us);
+	ut_assert(span->end_us >= span->start_us);
+
+	/* a new span is not nested now that both are closed */
+	ut_asserteq(2, bootstage_span_start(BOOTSTAGE_SPAN_DECOMP, "next"));
+	bootstage_span_end(2);
+	ut_asserteq(-1, bootstage_get_span(2)->parent);
+	ut_assertnull(bootstage_get_span(3));
+
+	ut_assertok(bootstage_span_clear());
+	ut_assertnull(bootstage_get_span(0));
+
+	return 0;
+}
+COMMON_TEST(bootstage_test_spans, 0);
+
+/* Test writing a Chrome trace */
+static int bootstage_test_chrome(struct unit_test_state *uts)
+{
+	const char *tail = "\n],\"displayTimeUnit\":\"ms\"}\n";
+	const int size = 0x10000;
+	char *buf;
+	int len;
+
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_SPANS))
+		return -EAGAIN;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+
+	ut_assertok(bootstage_span_clear());
+	bootstage_span_end(bootstage_span_start(BOOTSTAGE_SPAN_FS_LOAD,
+						"a\"b"));
+	len = bootstage_chrome_trace(buf, size);
+	ut_assert(len > 0);
+	ut_asserteq(len, strlen(buf));
+	ut_asserteq_strn("{\"traceEvents\":[", buf);
+	ut_asserteq_str(tail, buf + len - strlen(tail));
+	ut_assertnonnull(strstr(buf,
+				"{\"name\":\"a\\\"b\",\"cat\":\"fs\",\"ph\":\"X\""));
+	ut_assertnonnull(strstr(buf, "\"cat\":\"mark\",\"ph\":\"i\""));
+
+	/* too small */
+	ut_asserteq(-ENOSPC, bootstage_chrome_trace(buf, len));
+
+	ut_assertok(bootstage_span_clear());
+	free(buf);
+
+	return 0;
+}
+COMMON_TEST(bootstage_test_chrome, 0);
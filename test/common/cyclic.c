@@ -6,6 +6,7 @@
 #include <common.h>
 #include <cyclic.h>
 #include <dm.h>
+#include <time.h>
 #include <test/common.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -33,3 +34,66 @@ static int dm_test_cyclic_running(struct unit_test_state *uts)
 	return 0;
 }
 COMMON_TEST(dm_test_cyclic_running, 0);
+
+/* Count the calls to a cyclic function */
+static void cyclic_count(void *ctx)
+{
+	int *count = ctx;
+
+	(*count)++;
+}
+
+/* Test that cyclic functions are called in order, only when due */
+static int dm_test_cyclic_order(struct unit_test_state *uts)
+{
+	struct cyclic_info *fast, *slow, *cyclic;
+	int fast_cnt = 0, slow_cnt = 0;
+	u64 next_call = 0;
+
+	slow = cyclic_register(cyclic_count, 50 * 1000, "cyclic_slow",
+			       &slow_cnt);
+	ut_assertnonnull(slow);
+	fast = cyclic_register(cyclic_count, 10 * 1000, "cyclic_fast",
+			       &fast_cnt);
+	ut_assertnonnull(fast);
+
+	/* Both are called straight away, then not until they are due */
+	schedule();
+	ut_asserteq(1, fast_cnt);
+	ut_asserteq(1, slow_cnt);
+	schedule();
+	ut_asserteq(1, fast_cnt);
+	ut_asserteq(1, slow_cnt);
+
+	/* The list is sorted by the time of the next call */
+	hlist_for_each_entry(cyclic, cyclic_get_list(), list) {
+		ut_assert(cyclic->next_call >= next_call);
+		next_call = cyclic->next_call;
+	}
+
+	timer_test_add_offset(20);
+	schedule();
+	ut_asserteq(2, fast_cnt);
+	ut_asserteq(1, slow_cnt);
+
+	timer_test_add_offset(40);
+	schedule();
+	ut_asserteq(3, fast_cnt);
+	ut_asserteq(2, slow_cnt);
+
+	/*
+	 * The fast function was about 10ms late, then 30ms late, so the
+	 * jitter is about 20ms
+	 */
+	ut_asserteq(1, fast->latency_hist[14]);
+	ut_asserteq(1, fast->latency_hist[15]);
+	ut_asserteq(1, fast->jitter_hist[15]);
+	ut_assert(fast->max_latency_us >= 30 * 1000);
+
+	/* The slow function was about 10ms late and has no jitter yet */
+	ut_asserteq(1, slow->latency_hist[14]);
+	ut_asserteq(0, slow->jitter_hist[15]);
+
+	return 0;
+}
+COMMON_TEST(dm_test_cyclic_order, 0);
@@ -12,6 +12,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <time.h>
 #include <asm/io.h>
 
 #include <u-boot/lz4.h>
@@ -23,6 +24,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
 #include <linux/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
@@ -123,6 +125,80 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = sizeof(lz4_compressed) - 1;
 
+/* Linked blocks with block and content checksums, made by hand */
+static const char lz4_linked[] =
+	"\x04\x22\x4d\x18\x54\x40\xae\x28\x00\x00\x80\x49\x20\x61\x6d\x20"
+	"\x61\x20\x68\x69\x67\x68\x6c\x79\x20\x63\x6f\x6d\x70\x72\x65\x73"
+	"\x73\x61\x62\x6c\x65\x20\x62\x69\x74\x20\x6f\x66\x20\x74\x65\x78"
+	"\x74\x2e\x0a\x96\xd9\x5b\xc5\xec\x00\x00\x00\x0f\x28\x00\x3d\xf0"
+	"\xd7\x54\x68\x65\x72\x65\x20\x61\x72\x65\x20\x6d\x61\x6e\x79\x20"
+	"\x6c\x69\x6b\x65\x20\x6d\x65\x2c\x20\x62\x75\x74\x20\x74\x68\x69"
+	"\x73\x20\x6f\x6e\x65\x20\x69\x73\x20\x6d\x69\x6e\x65\x2e\x0a\x49"
+	"\x66\x20\x49\x20\x77\x65\x72\x65\x20\x61\x6e\x79\x20\x73\x68\x6f"
+	"\x72\x74\x65\x72\x2c\x20\x74\x68\x65\x72\x65\x20\x77\x6f\x75\x6c"
+	"\x64\x6e\x27\x74\x20\x62\x65\x20\x6d\x75\x63\x68\x20\x73\x65\x6e"
+	"\x73\x65\x20\x69\x6e\x0a\x63\x6f\x6d\x70\x72\x65\x73\x73\x69\x6e"
+	"\x67\x20\x6d\x65\x20\x69\x6e\x20\x74\x68\x65\x20\x66\x69\x72\x73"
+	"\x74\x20\x70\x6c\x61\x63\x65\x2e\x20\x41\x74\x20\x6c\x65\x61\x73"
+	"\x74\x20\x77\x69\x74\x68\x20\x6c\x7a\x6f\x2c\x20\x61\x6e\x79\x77"
+	"\x61\x79\x2c\x0a\x77\x68\x69\x63\x68\x20\x61\x70\x70\x65\x61\x72"
+	"\x73\x20\x74\x6f\x20\x62\x65\x68\x61\x76\x65\x20\x70\x6f\x6f\x72"
+	"\x6c\x79\x20\x69\x6e\x20\x74\x68\x65\x20\x66\x61\x63\x65\x20\x6f"
+	"\x66\x20\x73\x68\x6f\x72\x74\x20\x74\x65\x78\x74\x0a\x6d\x65\x73"
+	"\x73\x61\x67\x65\x73\x2e\x0a\x61\xb1\x54\xf5\x00\x00\x00\x00\x9d"
+	"\x12\x8c\x9d";
+static const unsigned long lz4_linked_size = sizeof(lz4_linked) - 1;
+
+/* Legacy frame (lz4 -l) followed by the uncompressed size, as Linux appends */
+static const char lz4_legacy[] =
+	"\x02\x21\x4c\x18\x61\x01\x00\x00\xf0\xff\x50\x49\x20\x61\x6d\x20"
+	"\x61\x20\x68\x69\x67\x68\x6c\x79\x20\x63\x6f\x6d\x70\x72\x65\x73"
+	"\x73\x61\x62\x6c\x65\x20\x62\x69\x74\x20\x6f\x66\x20\x74\x65\x78"
+	"\x74\x2e\x0a\x49\x20\x61\x6d\x20\x61\x20\x68\x69\x67\x68\x6c\x79"
+	"\x20\x63\x6f\x6d\x70\x72\x65\x73\x73\x61\x62\x6c\x65\x20\x62\x69"
+	"\x74\x20\x6f\x66\x20\x74\x65\x78\x74\x2e\x0a\x49\x20\x61\x6d\x20"
+	"\x61\x20\x68\x69\x67\x68\x6c\x79\x20\x63\x6f\x6d\x70\x72\x65\x73"
+	"\x73\x61\x62\x6c\x65\x20\x62\x69\x74\x20\x6f\x66\x20\x74\x65\x78"
+	"\x74\x2e\x0a\x54\x68\x65\x72\x65\x20\x61\x72\x65\x20\x6d\x61\x6e"
+	"\x79\x20\x6c\x69\x6b\x65\x20\x6d\x65\x2c\x20\x62\x75\x74\x20\x74"
+	"\x68\x69\x73\x20\x6f\x6e\x65\x20\x69\x73\x20\x6d\x69\x6e\x65\x2e"
+	"\x0a\x49\x66\x20\x49\x20\x77\x65\x72\x65\x20\x61\x6e\x79\x20\x73"
+	"\x68\x6f\x72\x74\x65\x72\x2c\x20\x74\x68\x65\x72\x65\x20\x77\x6f"
+	"\x75\x6c\x64\x6e\x27\x74\x20\x62\x65\x20\x6d\x75\x63\x68\x20\x73"
+	"\x65\x6e\x73\x65\x20\x69\x6e\x0a\x63\x6f\x6d\x70\x72\x65\x73\x73"
+	"\x69\x6e\x67\x20\x6d\x65\x20\x69\x6e\x20\x74\x68\x65\x20\x66\x69"
+	"\x72\x73\x74\x20\x70\x6c\x61\x63\x65\x2e\x20\x41\x74\x20\x6c\x65"
+	"\x61\x73\x74\x20\x77\x69\x74\x68\x20\x6c\x7a\x6f\x2c\x20\x61\x6e"
+	"\x79\x77\x61\x79\x2c\x0a\x77\x68\x69\x63\x68\x20\x61\x70\x70\x65"
+	"\x61\x72\x73\x20\x74\x6f\x20\x62\x65\x68\x61\x76\x65\x20\x70\x6f"
+	"\x6f\x72\x6c\x79\x20\x69\x6e\x20\x74\x68\x65\x20\x66\x61\x63\x65"
+	"\x20\x6f\x66\x20\x73\x68\x6f\x72\x74\x20\x74\x65\x78\x74\x0a\x6d"
+	"\x65\x73\x73\x61\x67\x65\x73\x2e\x0a\x5e\x01\x00\x00";
+static const unsigned long lz4_legacy_size = sizeof(lz4_legacy) - 1;
+
+/* lz4 --content-size -z /tmp/plain.txt > /tmp/plain.lz4 */
+static const char lz4_content_size[] =
+	"\x04\x22\x4d\x18\x6c\x40\x5e\x01\x00\x00\x00\x00\x00\x00\x0c\x01"
+	"\x01\x00\x00\xff\x19\x49\x20\x61\x6d\x20\x61\x20\x68\x69\x67\x68"
+	"\x6c\x79\x20\x63\x6f\x6d\x70\x72\x65\x73\x73\x61\x62\x6c\x65\x20"
+	"\x62\x69\x74\x20\x6f\x66\x20\x74\x65\x78\x74\x2e\x0a\x28\x00\x3d"
+	"\xf1\x25\x54\x68\x65\x72\x65\x20\x61\x72\x65\x20\x6d\x61\x6e\x79"
+	"\x20\x6c\x69\x6b\x65\x20\x6d\x65\x2c\x20\x62\x75\x74\x20\x74\x68"
+	"\x69\x73\x20\x6f\x6e\x65\x20\x69\x73\x20\x6d\x69\x6e\x65\x2e\x0a"
+	"\x49\x66\x20\x49\x20\x77\x32\x00\xd1\x6e\x79\x20\x73\x68\x6f\x72"
+	"\x74\x65\x72\x2c\x20\x74\x45\x00\xf4\x0b\x77\x6f\x75\x6c\x64\x6e"
+	"\x27\x74\x20\x62\x65\x20\x6d\x75\x63\x68\x20\x73\x65\x6e\x73\x65"
+	"\x20\x69\x6e\x0a\xcf\x00\x50\x69\x6e\x67\x20\x6d\x12\x00\x00\x32"
+	"\x00\xf0\x11\x20\x66\x69\x72\x73\x74\x20\x70\x6c\x61\x63\x65\x2e"
+	"\x20\x41\x74\x20\x6c\x65\x61\x73\x74\x20\x77\x69\x74\x68\x20\x6c"
+	"\x7a\x6f\x2c\x63\x00\xf5\x14\x77\x61\x79\x2c\x0a\x77\x68\x69\x63"
+	"\x68\x20\x61\x70\x70\x65\x61\x72\x73\x20\x74\x6f\x20\x62\x65\x68"
+	"\x61\x76\x65\x20\x70\x6f\x6f\x72\x6c\x79\x4e\x00\x30\x61\x63\x65"
+	"\x27\x01\x01\x95\x00\x01\x2d\x01\xb0\x0a\x6d\x65\x73\x73\x61\x67"
+	"\x65\x73\x2e\x0a\x00\x00\x00\x00\x9d\x12\x8c\x9d";
+static const unsigned long lz4_content_size_size =
+	sizeof(lz4_content_size) - 1;
+
 /* zstd -19 -c /tmp/plain.txt > /tmp/plain.zst */
 static const char zstd_compressed[] =
 	"\x28\xb5\x2f\xfd\x64\x5e\x00\xbd\x05\x00\x02\x0e\x26\x1a\x70\x17"
@@ -315,6 +391,23 @@ static int uncompress_using_lz4(struct unit_test_state *uts,
 	return (ret != 0);
 }
 
+/* Decompress LZ4 data in pieces, as a streaming reader would */
+static int uncompress_lz4_stream(const char *in, size_t in_size, void *out,
+				 size_t *out_size, size_t piece)
+{
+	struct ulz4_stream strm;
+	size_t pos;
+	int ret = 0;
+
+	ulz4_stream_init(&strm, out, *out_size);
+	for (pos = 0; pos < in_size && ret >= 0; pos += piece)
+		ret = ulz4_stream_decompress(&strm, in + pos,
+					     min(piece, in_size - pos));
+	*out_size = ulz4_stream_end(&strm);
+
+	return ret;
+}
+
 static int compress_using_zstd(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -475,6 +568,66 @@ static int compression_test_gzip(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_gzip, 0);
 
+/*
+ * Measure gunzip throughput on a larger buffer, to compare the inflate loops
+ * selected by CONFIG_ZLIB_INFLATE_FAST
+ */
+static int compression_test_gzip_speed(struct unit_test_state *uts)
+{
+	const ulong plain_size = strlen(plain), size = SZ_1M;
+	const int count = 10;
+	ulong comp_size, out_size, pos, us;
+	u8 *in, *comp, *out;
+	uint seed = 1;
+	int i;
+
+	in = malloc(size);
+	comp = malloc(size);
+	out = malloc(size);
+	ut_assertnonnull(in);
+	ut_assertnonnull(comp);
+	ut_assertnonnull(out);
+
+	/* Pieces of the plain text with some noise, so there are many matches */
+	for (pos = 0; pos < size;) {
+		ulong len;
+
+		seed = seed * 1103515245 + 12345;
+		len = min_t(ulong, 1 + (seed >> 24) % 48, size - pos);
+		if (seed & 0x10) {
+			memcpy(in + pos, plain + (seed >> 8) % (plain_size - len),
+			       len);
+			pos += len;
+		} else {
+			in[pos++] = seed >> 12;
+		}
+	}
+
+	comp_size = size;
+	ut_assertok(gzip(comp, &comp_size, in, size));
+
+	us = timer_get_us();
+	for (i = 0; i < count; i++) {
+		out_size = comp_size;
+		ut_assertok(gunzip(out, size, comp, &out_size));
+	}
+	us = timer_get_us() - us;
+	ut_asserteq(size, out_size);
+	ut_asserteq_mem(in, out, size);
+
+	printf("gzip: inflated %lu KiB from %lu KiB %d times in %lu us (%lu MB/s, %s loop)\n",
+	       size >> 10, comp_size >> 10, count, us,
+	       us ? size * count / us : 0,
+	       IS_ENABLED(CONFIG_ZLIB_INFLATE_FAST) ? "fast" : "standard");
+
+	free(out);
+	free(comp);
+	free(in);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_speed, 0);
+
 static int compression_test_bzip2(struct unit_test_state *uts)
 {
 	return run_test(uts, "bzip2", compress_using_bzip2,
@@ -501,6 +654,132 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+/* The second block copies from the first, so needs linked-block support */
+static int compression_test_lz4_linked(struct unit_test_state *uts)
+{
+	const size_t plain_size = strlen(plain);
+	char out[sizeof(plain)], bad[sizeof(lz4_linked)];
+	size_t out_size = sizeof(out);
+
+	ut_assertok(ulz4fn(lz4_linked, lz4_linked_size, out, &out_size));
+	ut_asserteq(plain_size, out_size);
+	ut_asserteq_mem(plain, out, plain_size);
+
+	/* Check that the content checksum is verified */
+	memcpy(bad, lz4_linked, lz4_linked_size);
+	bad[lz4_linked_size - 1] ^= 1;
+	out_size = sizeof(out);
+	ut_asserteq(-EBADMSG, ulz4fn(bad, lz4_linked_size, out, &out_size));
+
+	/* ...and the block checksums */
+	memcpy(bad, lz4_linked, lz4_linked_size);
+	bad[51] ^= 1;
+	out_size = sizeof(out);
+	ut_asserteq(-EBADMSG, ulz4fn(bad, lz4_linked_size, out, &out_size));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_linked, 0);
+
+/* Concatenated frames of each kind, with a skippable frame in between */
+static int compression_test_lz4_multi(struct unit_test_state *uts)
+{
+	static const char skip[] = "\x5a\x2a\x4d\x18\x03\x00\x00\x00xyz";
+	const size_t plain_size = strlen(plain);
+	size_t in_size, out_size;
+	char *in, *out;
+
+	in_size = lz4_compressed_size + sizeof(skip) - 1 + lz4_linked_size +
+		lz4_legacy_size;
+	in = malloc(in_size);
+	out = malloc(plain_size * 3);
+	ut_assertnonnull(in);
+	ut_assertnonnull(out);
+	memcpy(in, lz4_compressed, lz4_compressed_size);
+	memcpy(in + lz4_compressed_size, skip, sizeof(skip) - 1);
+	memcpy(in + lz4_compressed_size + sizeof(skip) - 1, lz4_linked,
+	       lz4_linked_size);
+	memcpy(in + in_size - lz4_legacy_size, lz4_legacy, lz4_legacy_size);
+
+	out_size = plain_size * 3;
+	ut_assertok(ulz4fn(in, in_size, out, &out_size));
+	ut_asserteq(plain_size * 3, out_size);
+	ut_asserteq_mem(plain, out, plain_size);
+	ut_asserteq_mem(plain, out + plain_size, plain_size);
+	ut_asserteq_mem(plain, out + plain_size * 2, plain_size);
+
+	/* The same again, a few bytes at a time */
+	memset(out, '\0', plain_size * 3);
+	out_size = plain_size * 3;
+	ut_assertok(uncompress_lz4_stream(in, in_size, out, &out_size, 7));
+	ut_asserteq(plain_size * 3, out_size);
+	ut_asserteq_mem(plain, out + plain_size * 2, plain_size);
+
+	free(out);
+	free(in);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_multi, 0);
+
+static int compression_test_lz4_stream(struct unit_test_state *uts)
+{
+	const size_t plain_size = strlen(plain);
+	char out[sizeof(plain)];
+	size_t out_size = sizeof(out);
+
+	/* Pieces smaller than a header, so every field is split */
+	ut_assertok(uncompress_lz4_stream(lz4_linked, lz4_linked_size, out,
+					  &out_size, 3));
+	ut_asserteq(plain_size, out_size);
+	ut_asserteq_mem(plain, out, plain_size);
+
+	/*
+	 * One byte at a time, with a content size in the frame descriptor, so
+	 * the rest of the descriptor is gathered after FLG and BD
+	 */
+	memset(out, '\0', sizeof(out));
+	out_size = sizeof(out);
+	ut_assertok(uncompress_lz4_stream(lz4_content_size,
+					  lz4_content_size_size, out,
+					  &out_size, 1));
+	ut_asserteq(plain_size, out_size);
+	ut_asserteq_mem(plain, out, plain_size);
+
+	/* A truncated stream needs more input */
+	out_size = sizeof(out);
+	ut_asserteq(1, uncompress_lz4_stream(lz4_linked, lz4_linked_size - 6,
+					     out, &out_size, 64));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_stream, 0);
+
+/* Supply one whole field at a time, so nothing needs to be gathered */
+static int compression_test_lz4_want(struct unit_test_state *uts)
+{
+	const size_t plain_size = strlen(plain);
+	struct ulz4_stream strm;
+	char out[sizeof(plain)];
+	size_t pos, want;
+
+	memset(out, '\0', sizeof(out));
+	ulz4_stream_init(&strm, out, sizeof(out));
+	for (pos = 0; pos < lz4_linked_size; pos += want) {
+		want = ulz4_stream_want(&strm);
+		ut_assert(want);
+		ut_assert(pos + want <= lz4_linked_size);
+		ut_assert(ulz4_stream_decompress(&strm, lz4_linked + pos,
+						 want) >= 0);
+		ut_assertnull(strm.buf);
+	}
+	ut_asserteq(plain_size, ulz4_stream_end(&strm));
+	ut_asserteq_mem(plain, out, plain_size);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_want, 0);
+
 static int compression_test_zstd(struct unit_test_state *uts)
 {
 	return run_test(uts, "zstd", compress_using_zstd,
@@ -508,6 +787,85 @@ static int compression_test_zstd(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_zstd, 0);
 
+/* Decompress in small pieces, as a streaming reader would */
+static int compression_test_zstd_stream(struct unit_test_state *uts)
+{
+	const size_t plain_size = strlen(plain);
+	struct abuf in, out, in_part, out_part;
+	size_t in_pos = 0, out_pos = 0;
+	struct zstd_ctx ctx;
+	int ret = 1;
+
+	abuf_init_set(&in, (void *)zstd_compressed, zstd_compressed_size);
+	abuf_init(&out);
+	ut_assert(abuf_realloc(&out, plain_size));
+	ut_assertok(zstd_ctx_init(&ctx, 1 << 17));
+	ut_assertok(zstd_stream_start(&ctx));
+
+	/* Offer at most 7 bytes of input and 16 bytes of space at a time */
+	while (ret == 1) {
+		abuf_init_set(&in_part, abuf_data(&in),
+			      min(in.size, in_pos + 7));
+		abuf_init_set(&out_part, abuf_data(&out),
+			      min(out.size, out_pos + 16));
+		ret = zstd_stream_decompress(&ctx, &in_part, &in_pos,
+					     &out_part, &out_pos);
+		ut_assert(ret >= 0);
+	}
+	ut_asserteq(zstd_compressed_size, in_pos);
+	ut_asserteq(plain_size, out_pos);
+	ut_asserteq_mem(plain, abuf_data(&out), plain_size);
+
+	/* The same context can decompress a whole frame too */
+	memset(abuf_data(&out), '\0', plain_size);
+	ut_asserteq(plain_size, zstd_decompress_ctx(&ctx, &in, &out));
+	ut_asserteq_mem(plain, abuf_data(&out), plain_size);
+
+	zstd_ctx_uninit(&ctx);
+	abuf_uninit(&out);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_zstd_stream, 0);
+
+/*
+ * Filesystems decompress many small blocks, so compare setting up a context
+ * for each block against reusing one
+ */
+static int compression_test_zstd_blocks(struct unit_test_state *uts)
+{
+	const size_t plain_size = strlen(plain);
+	const int count = 1000;
+	ulong alloc_us, reuse_us;
+	struct zstd_ctx ctx;
+	struct abuf in, out;
+	int i;
+
+	abuf_init_set(&in, (void *)zstd_compressed, zstd_compressed_size);
+	abuf_init(&out);
+	ut_assert(abuf_realloc(&out, plain_size));
+
+	alloc_us = timer_get_us();
+	for (i = 0; i < count; i++)
+		ut_asserteq(plain_size, zstd_decompress(&in, &out));
+	alloc_us = timer_get_us() - alloc_us;
+
+	reuse_us = timer_get_us();
+	ut_assertok(zstd_ctx_init(&ctx, 0));
+	for (i = 0; i < count; i++)
+		ut_asserteq(plain_size, zstd_decompress_ctx(&ctx, &in, &out));
+	zstd_ctx_uninit(&ctx);
+	reuse_us = timer_get_us() - reuse_us;
+
+	ut_asserteq_mem(plain, abuf_data(&out), plain_size);
+	printf("zstd: %d blocks of %zu bytes: %lu us with a new context each time, %lu us reusing one\n",
+	       count, plain_size, alloc_us, reuse_us);
+	abuf_uninit(&out);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_zstd_blocks, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
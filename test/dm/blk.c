@@ -4,12 +4,15 @@
  */
 
 #include <common.h>
+#include <command.h>
 #include <dm.h>
+#include <fdtdec.h>
 #include <part.h>
 #include <sandbox_host.h>
 #include <usb.h>
 #include <asm/global_data.h>
 #include <asm/state.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -334,3 +337,106 @@ static int dm_test_blk_foreach(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_foreach, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that I/O statistics are collected for each block device */
+static int dm_test_blk_stats(struct unit_test_state *uts)
+{
+	char buf[8 * 512], fdt[4096];
+	const struct blk_op_stats *ost;
+	struct blk_stats *stats;
+	struct blk_desc *desc;
+	int node, len, i;
+	u64 total;
+
+	if (!CONFIG_IS_ENABLED(BLK_STATS))
+		return -EAGAIN;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	stats = blk_get_stats(desc->bdev);
+	ut_assertnonnull(stats);
+
+	/* Probing reads the partition table, so start afresh */
+	blk_stats_reset(desc->bdev);
+	ut_assert(!blk_stats_used(stats));
+
+	memset(buf, '\xa5', sizeof(buf));
+	ut_asserteq(4, blk_dwrite(desc, 0, 4, buf));
+	ut_asserteq(4, blk_dwrite(desc, 4, 4, buf));
+	ost = &stats->op[BLK_STATS_WRITE];
+	ut_asserteq(2, ost->ops);
+	ut_asserteq(8, ost->blocks);
+	ut_asserteq(8 * 512, ost->bytes);
+	ut_asserteq(1, ost->seq);
+	ut_asserteq(1, ost->random);
+	ut_asserteq(0, ost->errors);
+	for (total = 0, i = 0; i < BLK_STATS_HIST_BUCKETS; i++)
+		total += ost->lat_hist[i];
+	ut_asserteq(2, total);
+
+	/* The second read may come from the block cache */
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ut_asserteq(4, blk_dread(desc, 0, 4, buf));
+	ost = &stats->op[BLK_STATS_READ];
+	ut_asserteq(2, ost->ops + stats->cache_hits);
+	ut_asserteq(4 * ost->ops, ost->blocks);
+	ut_asserteq(0, ost->seq);
+	ut_asserteq(ost->ops, ost->random);
+
+	ut_asserteq(2, blk_derase(desc, 4, 2));
+	ost = &stats->op[BLK_STATS_ERASE];
+	ut_asserteq(1, ost->ops);
+	ut_asserteq(2, ost->blocks);
+	ut_asserteq(1, ost->seq);
+
+	/* Check that the statistics are added to the device tree */
+	ut_assertok(fdt_create_empty_tree(fdt, sizeof(fdt)));
+	ut_assertok(blk_stats_add_fdt(fdt, 0));
+	node = fdt_path_offset(fdt, "/blk/mmc0.blk");
+	ut_assert(node >= 0);
+	ut_asserteq(2, fdtdec_get_uint64(fdt, node, "write-ops", 0));
+	ut_asserteq(8 * 512, fdtdec_get_uint64(fdt, node, "write-bytes", 0));
+	ut_asserteq(1, fdtdec_get_uint64(fdt, node, "erase-sequential", 0));
+	ut_assertnonnull(fdt_getprop(fdt, node, "write-latency-hist", &len));
+	ut_asserteq(BLK_STATS_HIST_BUCKETS * sizeof(fdt32_t), len);
+
+	/* Adding the statistics again leaves them alone */
+	ut_assertok(blk_stats_add_fdt(fdt, 0));
+	ut_asserteq(node, fdt_path_offset(fdt, "/blk/mmc0.blk"));
+
+	/* Devices which do not fit are left out */
+	ut_assertok(fdt_create_empty_tree(fdt, 256));
+	ut_assertok(blk_stats_add_fdt(fdt, 0));
+	ut_assert(fdt_path_offset(fdt, "/blk/mmc0.blk") < 0);
+
+	ut_assertok(run_command("blk stats reset", 0));
+	ut_assert(!blk_stats_used(stats));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_stats, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that writes, erases and removals of block devices are counted */
+static int dm_test_blk_generation(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	char buf[512];
+	uint gen;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	gen = blk_get_generation();
+
+	/* Reading does not change anything */
+	ut_asserteq(1, blk_dread(desc, 0, 1, buf));
+	ut_asserteq(gen, blk_get_generation());
+
+	ut_asserteq(1, blk_dwrite(desc, 0, 1, buf));
+	ut_asserteq(gen + 1, blk_get_generation());
+	ut_asserteq(1, blk_derase(desc, 0, 1));
+	ut_asserteq(gen + 2, blk_get_generation());
+
+	ut_assertok(device_remove(desc->bdev, DM_REMOVE_NORMAL));
+	ut_asserteq(gen + 3, blk_get_generation());
+
+	return 0;
+}
+DM_TEST(dm_test_blk_generation, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
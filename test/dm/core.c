@@ -12,8 +12,10 @@
 #include <log.h>
 #include <malloc.h>
 #include <asm/global_data.h>
+#include <linux/delay.h>
 #include <dm/device-internal.h>
 #include <dm/root.h>
+#include <dm/timing.h>
 #include <dm/util.h>
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
@@ -1248,6 +1250,74 @@ static int dm_test_get_stats(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_get_stats, UT_TESTF_SCAN_FDT);
 
+#if CONFIG_IS_ENABLED(DM_TIMING)
+/* Test that driver model records the time taken by each device */
+static int dm_test_timing(struct unit_test_state *uts)
+{
+	const struct dm_dev_timing *timing, *parent_timing;
+	struct dm_timing_totals totals;
+	struct dm_timing_state state;
+	struct udevice *dev, *parent;
+	char fdt[4096];
+	int node, ret;
+
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "c-test@5",
+					       &dev));
+	parent = dev_get_parent(dev);
+	ut_assert(!device_active(parent));
+
+	/*
+	 * Probing the device probes its parent first. The time spent in the
+	 * device's probe() method is its own and not its parent's.
+	 */
+	testfdt_set_probe_delay(20000);
+	ret = device_probe(dev);
+	testfdt_set_probe_delay(0);
+	ut_assertok(ret);
+	timing = &dev->timing;
+	parent_timing = &parent->timing;
+	ut_assert(timing->probe_self_us >= 20000);
+	ut_assert(timing->probe_self_us <= timing->probe_us);
+	ut_assert(parent_timing->probe_us < 20000);
+	ut_assert(parent_timing->probe_self_us <= parent_timing->probe_us);
+	ut_assert(timing->probe_us >=
+		  timing->probe_self_us + parent_timing->probe_us);
+
+	/* Time spent in an operation is recorded against the device */
+	dm_timing_start(&state);
+	udelay(1000);
+	dm_timing_end(&state, dev, DM_TIMING_REMOVE);
+	ut_assert(timing->remove_us >= 1000);
+
+	dm_timing_get_uclass(dev->uclass, &totals);
+	ut_assert(totals.count > 1);
+	ut_assert(totals.remove_us >= 1000);
+
+	dm_timing_get_driver(dev->driver, &totals);
+	ut_assert(totals.remove_us >= 1000);
+
+	/* The slowest uclass comes first and adding it twice is harmless */
+	ut_assertok(fdt_create_empty_tree(fdt, sizeof(fdt)));
+	ut_assertok(dm_timing_add_fdt(fdt, 0));
+	ut_assertok(dm_timing_add_fdt(fdt, 0));
+	node = fdt_path_offset(fdt, "/dm/uclass/testfdt");
+	ut_assert(node >= 0);
+	ut_assert(fdtdec_get_int(fdt, node, "probe-self-us", 0) >= 20000);
+
+	/* Entries which do not fit are left out */
+	ut_assertok(fdt_create_empty_tree(fdt, 256));
+	ut_assertok(dm_timing_add_fdt(fdt, 0));
+	ut_assertok(fdt_check_header(fdt));
+
+	dm_timing_reset();
+	ut_asserteq(0, timing->remove_us);
+	ut_asserteq(0, timing->probe_us);
+
+	return 0;
+}
+DM_TEST(dm_test_timing, UT_TESTF_SCAN_FDT);
+#endif
+
 /* Test uclass_find_device_by_name() */
 static int dm_test_uclass_find_device(struct unit_test_state *uts)
 {
@@ -5,8 +5,10 @@
 
 #include <common.h>
 #include <dm.h>
+#include <malloc.h>
 #include <mmc.h>
 #include <part.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -52,3 +54,74 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that large transfers are queued on the command queue engine */
+static int dm_test_mmc_cqe(struct unit_test_state *uts)
+{
+	const int count = 4 * 256 + 17;
+	struct blk_desc *dev_desc;
+	uint tasks, max_queued;
+	struct udevice *dev;
+	char *write, *read;
+	struct mmc *mmc;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(MMC_CQE))
+		return -EAGAIN;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assert(mmc->host_caps & MMC_CAP_CQE);
+
+	/* The sandbox card is SD, so pretend it has an eMMC command queue */
+	mmc->cmdq_depth = 8;
+
+	write = malloc(count * 512);
+	read = malloc(count * 512);
+	ut_assertnonnull(write);
+	ut_assertnonnull(read);
+	for (i = 0; i < count * 512; i++)
+		write[i] = i ^ (i >> 9);
+
+	ut_asserteq(count, blk_dwrite(dev_desc, 3, count, write));
+	sandbox_mmc_get_cqe_stats(dev, &tasks, &max_queued);
+	ut_asserteq(5, tasks);
+	ut_asserteq(5, max_queued);
+
+	ut_asserteq(count, blk_dread(dev_desc, 3, count, read));
+	ut_asserteq_mem(write, read, count * 512);
+	sandbox_mmc_get_cqe_stats(dev, &tasks, &max_queued);
+	ut_asserteq(10, tasks);
+
+	/* A shallow queue needs several rounds */
+	mmc->cmdq_depth = 2;
+	memset(read, '\0', count * 512);
+	ut_asserteq(count, blk_dread(dev_desc, 3, count, read));
+	ut_asserteq_mem(write, read, count * 512);
+	sandbox_mmc_get_cqe_stats(dev, &tasks, &max_queued);
+	ut_asserteq(15, tasks);
+	ut_asserteq(5, max_queued);
+
+	/* Small transfers still use normal commands */
+	ut_asserteq(4, blk_dread(dev_desc, 3, 4, read));
+	ut_asserteq_mem(write, read, 4 * 512);
+	sandbox_mmc_get_cqe_stats(dev, &tasks, &max_queued);
+	ut_asserteq(15, tasks);
+
+	/* Nor do large ones if the host has no engine, despite its caps */
+	sandbox_mmc_set_cqe_present(dev, false);
+	memset(read, '\0', count * 512);
+	ut_asserteq(count, blk_dread(dev_desc, 3, count, read));
+	ut_asserteq_mem(write, read, count * 512);
+	sandbox_mmc_get_cqe_stats(dev, &tasks, &max_queued);
+	ut_asserteq(15, tasks);
+	sandbox_mmc_set_cqe_present(dev, true);
+
+	mmc->cmdq_depth = 0;
+	free(read);
+	free(write);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_cqe, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
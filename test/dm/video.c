@@ -83,6 +83,8 @@ static int compress_frame_buffer(struct unit_test_state *uts,
 
 	/* Check here that the copy frame buffer is working correctly */
 	if (IS_ENABLED(CONFIG_VIDEO_COPY)) {
+		/* With damage tracking the copy is only updated on sync */
+		video_sync(dev, false);
 		ut_assertf(!memcmp(uc_priv->fb, uc_priv->copy_fb,
 				   uc_priv->fb_size),
 				   "Copy framebuffer does not match fb");
@@ -213,6 +215,143 @@ static int dm_test_video_text_12x22(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_text_12x22, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test that drawing records the damaged area and that sync clears it */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+
+	if (!IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return -EAGAIN;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	ut_assertok(vidconsole_select_font(con, "8x16", 0));
+	priv = dev_get_uclass_priv(dev);
+
+	/* probing clears the display, so everything is damaged */
+	ut_assertok(video_sync(dev, true));
+	ut_asserteq(0, priv->damage.xend);
+
+	/* a character damages just its cell */
+	vidconsole_putc_xy(con, VID_TO_POS(16), 32, 'a');
+	ut_asserteq(16, priv->damage.xstart);
+	ut_asserteq(32, priv->damage.ystart);
+	ut_asserteq(24, priv->damage.xend);
+	ut_asserteq(48, priv->damage.yend);
+
+	/* a second one extends the area to cover both */
+	vidconsole_putc_xy(con, VID_TO_POS(40), 0, 'b');
+	ut_asserteq(16, priv->damage.xstart);
+	ut_asserteq(0, priv->damage.ystart);
+	ut_asserteq(48, priv->damage.xend);
+	ut_asserteq(48, priv->damage.yend);
+
+	/* syncing copies the area and clears it */
+	ut_assertok(video_sync(dev, true));
+	ut_asserteq(0, priv->damage.xend);
+	if (IS_ENABLED(CONFIG_VIDEO_COPY))
+		ut_assertok(memcmp(priv->fb, priv->copy_fb, priv->fb_size));
+
+	/* a row covers the full width */
+	vidconsole_set_row(con, 1, 0);
+	ut_asserteq(0, priv->damage.xstart);
+	ut_asserteq(16, priv->damage.ystart);
+	ut_asserteq(priv->xsize, priv->damage.xend);
+	ut_asserteq(32, priv->damage.yend);
+
+	/* areas are clipped to the display */
+	ut_assertok(video_sync(dev, true));
+	video_damage(dev, -10, priv->ysize - 4, 20, 100);
+	ut_asserteq(0, priv->damage.xstart);
+	ut_asserteq(priv->ysize - 4, priv->damage.ystart);
+	ut_asserteq(10, priv->damage.xend);
+	ut_asserteq(priv->ysize, priv->damage.yend);
+	video_damage(dev, priv->xsize, 0, 10, 10);
+	ut_asserteq(10, priv->damage.xend);
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Run some frame-buffer operations, for dm_test_video_accel() */
+static int run_rect_ops(struct unit_test_state *uts, struct udevice *dev)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	u16 pixels[32 * 16];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pixels); i++)
+		pixels[i] = i * 0x123;
+
+	/* odd positions and widths exercise the non-word-aligned paths */
+	ut_assertok(video_fill_rect(dev, 11, 21, 101, 51, 0xf00f));
+	ut_assertok(video_copy_rect(dev, 5, 7, 0, 0, 301, 203));
+	ut_assertok(video_copy_rect(dev, 0, 0, 3, 5, 301, 203));
+	ut_assertok(video_blit(dev, 401, 300, 32, 16, pixels, 32 * 2));
+
+	/* scroll the whole display */
+	ut_assertok(video_copy_rect(dev, 0, 0, 0, 16, priv->xsize,
+				    priv->ysize - 16));
+	ut_assertok(video_fill_rect(dev, 0, priv->ysize - 16, priv->xsize, 16,
+				    0));
+
+	return 0;
+}
+
+/* Test the fill / copy / blit operations, with and without the driver */
+static int dm_test_video_accel(struct unit_test_state *uts)
+{
+	struct sandbox_sdl_plat *plat;
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+	void *orig, *accel;
+	int count;
+
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	plat = dev_get_plat(dev);
+	priv = dev_get_uclass_priv(dev);
+	vidconsole_put_string(con, "Some text to move around the display");
+
+	orig = malloc(priv->fb_size);
+	ut_assertnonnull(orig);
+	accel = malloc(priv->fb_size);
+	ut_assertnonnull(accel);
+	memcpy(orig, priv->fb, priv->fb_size);
+
+	/* the driver does the work */
+	count = plat->accel_count;
+	ut_assertok(run_rect_ops(uts, dev));
+	ut_asserteq(count + 6, plat->accel_count);
+	memcpy(accel, priv->fb, priv->fb_size);
+	ut_assert(compress_frame_buffer(uts, dev) > 0);
+
+	/* the uclass does the same work, with the same result */
+	memcpy(priv->fb, orig, priv->fb_size);
+	ut_assertok(video_sync_copy_all(dev));
+	plat->no_accel = true;
+	count = plat->accel_count;
+	ut_assertok(run_rect_ops(uts, dev));
+	ut_asserteq(count, plat->accel_count);
+	ut_assertok(memcmp(accel, priv->fb, priv->fb_size));
+	ut_assert(compress_frame_buffer(uts, dev) > 0);
+
+	/* rectangles must be within the display */
+	ut_asserteq(-EINVAL, video_fill_rect(dev, priv->xsize - 1, 0, 2, 1, 0));
+	ut_asserteq(-EINVAL, video_copy_rect(dev, 0, 0, 0, 1, 1,
+					     priv->ysize));
+	ut_asserteq(-EINVAL, video_blit(dev, -1, 0, 1, 1, orig, 2));
+	plat->no_accel = false;
+
+	free(accel);
+	free(orig);
+
+	return 0;
+}
+DM_TEST(dm_test_video_accel, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Test handling of special characters in the console */
 static int dm_test_video_chars(struct unit_test_state *uts)
 {
@@ -603,3 +742,52 @@ static int dm_test_video_truetype_bs(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_video_truetype_bs, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Benchmark the TrueType glyph cache by drawing a block of text twice */
+static int dm_test_video_truetype_cache(struct unit_test_state *uts)
+{
+	struct vidconsole_cache_stats cold, warm;
+	struct udevice *dev, *con;
+	const char *test_string = "Criticism may not be agreeable, but it is necessary. It fulfils the same function as pain in the human body. It calls attention to an unhealthy state of things. Some see private enterprise as a predatory target to be shot, others as a cow to be milked, but few are those who see it as a sturdy horse pulling the wagon. The price of greatness is responsibility.\n";
+	ulong start, cold_us, warm_us;
+	int i, size;
+
+	if (!IS_ENABLED(CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE))
+		return -EAGAIN;
+
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+
+	/* Draw the text with an empty cache */
+	start = timer_get_us();
+	for (i = 0; i < 3; i++)
+		vidconsole_put_string(con, test_string);
+	cold_us = timer_get_us() - start;
+	ut_assertok(vidconsole_get_cache_stats(con, &cold));
+	ut_assert(cold.misses > 0);
+	size = compress_frame_buffer(uts, dev);
+
+	/* Draw it again in the same place, so the glyphs come from the cache */
+	ut_assertok(video_clear(dev));
+	vidconsole_position_cursor(con, 0, 0);
+	start = timer_get_us();
+	for (i = 0; i < 3; i++)
+		vidconsole_put_string(con, test_string);
+	warm_us = timer_get_us() - start;
+	ut_assertok(vidconsole_get_cache_stats(con, &warm));
+
+	printf("glyph cache: cold %lu us, warm %lu us, %u glyphs, %lx bytes, hits %lu, misses %lu, evictions %lu\n",
+	       cold_us, warm_us, warm.count, warm.used, warm.hits, warm.misses,
+	       warm.evictions);
+
+	/* The cache must not change what is drawn */
+	ut_asserteq(size, compress_frame_buffer(uts, dev));
+	ut_assert(warm.used <= warm.budget);
+	if (!warm.evictions)
+		ut_asserteq(cold.misses, warm.misses);
+	else
+		ut_assert(warm.hits > cold.hits);
+
+	return 0;
+}
+DM_TEST(dm_test_video_truetype_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test replaying the journal of changes in the UEFI variables file
+ */
+
+#include <common.h>
+#include <charset.h>
+#include <efi_loader.h>
+#include <efi_variable.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+static const efi_guid_t test_guid =
+	EFI_GUID(0x8e0c8e16, 0x5cd7, 0x4b85,
+		 0x94, 0x6e, 0x0a, 0x5f, 0x13, 0x2e, 0x61, 0xd4);
+
+/**
+ * add_var() - write a variable with one byte of data
+ *
+ * @ptr:	where to write the variable, must be zeroed
+ * @name:	name of the variable
+ * @val:	value of the data, or -1 for a variable without data
+ * Return:	number of bytes written, padded to a multiple of 8
+ */
+static size_t add_var(void *ptr, const u16 *name, int val)
+{
+	struct efi_var_entry *var = ptr;
+	size_t name_size = (u16_strlen(name) + 1) * sizeof(u16);
+
+	guidcpy(&var->guid, &test_guid);
+	var->attr = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS;
+	memcpy(var->name, name, name_size);
+	if (val >= 0) {
+		var->length = 1;
+		*((u8 *)var->name + name_size) = val;
+	}
+
+	return ALIGN(sizeof(*var) + name_size + var->length, 8);
+}
+
+/**
+ * add_rec() - append a journal record
+ *
+ * @buf:	variables file
+ * @pos:	offset at which to write the record
+ * @crcp:	CRC32 of the previous record, updated to that of this record
+ * @name:	name of the variable
+ * @val:	new value of the variable, or -1 to delete it
+ * Return:	offset of the end of the record
+ */
+static loff_t add_rec(struct efi_var_file *buf, loff_t pos, u32 *crcp,
+		      const u16 *name, int val)
+{
+	struct efi_var_journal *rec = (void *)buf + pos;
+
+	rec->length = sizeof(*rec) + add_var(rec + 1, name, val);
+	rec->crc32 = crc32(*crcp, (u8 *)(rec + 1), rec->length - sizeof(*rec));
+	*crcp = rec->crc32;
+
+	return pos + rec->length;
+}
+
+/**
+ * find_var() - get the value of a variable in a variables file
+ *
+ * @buf:	variables file
+ * @name:	name of the variable
+ * Return:	value of the variable, or -1 if not found
+ */
+static int find_var(struct efi_var_file *buf, const u16 *name)
+{
+	struct efi_var_entry *var = buf->var;
+	u8 *data;
+
+	while ((void *)var < (void *)buf + buf->length) {
+		data = (u8 *)(var->name + u16_strlen(var->name) + 1);
+		if (!u16_strcmp(var->name, name))
+			return *data;
+		var = (struct efi_var_entry *)ALIGN((uintptr_t)data +
+						    var->length, 8);
+	}
+
+	return -1;
+}
+
+/**
+ * make_file() - create a variables file with a journal of three records
+ *
+ * The file holds variables A=1 and B=2. The journal then sets A to 3, deletes
+ * B and adds C=4.
+ *
+ * @ends:	returns the offset of the end of each record
+ * @crcs:	returns the CRC32 of each record
+ * Return:	variables file, EFI_VAR_BUF_SIZE bytes
+ */
+static struct efi_var_file *make_file(loff_t ends[3], u32 crcs[3])
+{
+	struct efi_var_file *buf;
+	loff_t pos;
+	u32 crc;
+
+	buf = calloc(1, EFI_VAR_BUF_SIZE);
+	if (!buf)
+		return NULL;
+	pos = sizeof(*buf);
+	pos += add_var((void *)buf + pos, u"A", 1);
+	pos += add_var((void *)buf + pos, u"B", 2);
+	buf->magic = EFI_VAR_FILE_MAGIC;
+	buf->length = pos;
+	buf->crc32 = crc32(0, (u8 *)buf->var, pos - sizeof(*buf));
+
+	crc = buf->crc32;
+	ends[0] = add_rec(buf, pos, &crc, u"A", 3);
+	crcs[0] = crc;
+	ends[1] = add_rec(buf, ends[0], &crc, u"B", -1);
+	crcs[1] = crc;
+	ends[2] = add_rec(buf, ends[1], &crc, u"C", 4);
+	crcs[2] = crc;
+
+	return buf;
+}
+
+/* Test replaying a complete journal */
+static int lib_test_efi_var_replay(struct unit_test_state *uts)
+{
+	struct efi_var_file *buf;
+	loff_t ends[3];
+	u32 crcs[3];
+	u32 crc;
+
+	buf = make_file(ends, crcs);
+	ut_assertnonnull(buf);
+
+	/* Data left over from a longer file is ignored */
+	ut_asserteq(ends[2], efi_var_replay(buf, ends[2] + 0x40, &crc));
+	ut_asserteq(crcs[2], crc);
+	ut_asserteq(3, find_var(buf, u"A"));
+	ut_asserteq(-1, find_var(buf, u"B"));
+	ut_asserteq(4, find_var(buf, u"C"));
+	ut_asserteq(buf->crc32, crc32(0, (u8 *)buf->var,
+				      buf->length - sizeof(*buf)));
+	free(buf);
+
+	/* The variables themselves must be valid */
+	buf = make_file(ends, crcs);
+	ut_assertnonnull(buf);
+	buf->crc32 ^= 1;
+	ut_asserteq(0, efi_var_replay(buf, ends[2], &crc));
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_efi_var_replay, 0);
+
+/* Test that replay stops at a truncated or corrupted record */
+static int lib_test_efi_var_replay_bad(struct unit_test_state *uts)
+{
+	struct efi_var_journal *rec;
+	struct efi_var_entry *entry;
+	struct efi_var_file *buf;
+	loff_t ends[3];
+	u32 crcs[3];
+	u32 crc;
+
+	/* Record written partly, e.g. due to a power failure */
+	buf = make_file(ends, crcs);
+	ut_assertnonnull(buf);
+	ut_asserteq(ends[1], efi_var_replay(buf, ends[2] - 1, &crc));
+	ut_asserteq(crcs[1], crc);
+	ut_asserteq(3, find_var(buf, u"A"));
+	ut_asserteq(-1, find_var(buf, u"B"));
+	ut_asserteq(-1, find_var(buf, u"C"));
+	free(buf);
+
+	/* A corrupted record ends the journal */
+	buf = make_file(ends, crcs);
+	ut_assertnonnull(buf);
+	*((u8 *)buf + ends[1] - 1) ^= 0x80;
+	ut_asserteq(ends[0], efi_var_replay(buf, ends[2], &crc));
+	ut_asserteq(crcs[0], crc);
+	ut_asserteq(3, find_var(buf, u"A"));
+	ut_asserteq(2, find_var(buf, u"B"));
+	ut_asserteq(-1, find_var(buf, u"C"));
+	free(buf);
+
+	/*
+	 * With a 32-bit size_t the sum of the header, name and data lengths
+	 * wraps around to match the record length. Such a record is rejected
+	 * even though its CRC32 is correct.
+	 */
+	buf = make_file(ends, crcs);
+	ut_assertnonnull(buf);
+	rec = (void *)buf + ends[1];
+	entry = (struct efi_var_entry *)(rec + 1);
+	entry->length = (u32)-3;
+	rec->crc32 = crc32(crcs[1], (u8 *)entry, rec->length - sizeof(*rec));
+	ut_asserteq(ends[1], efi_var_replay(buf, ends[2], &crc));
+	ut_asserteq(-1, find_var(buf, u"C"));
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_efi_var_replay_bad, 0);
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test the log driver which records to a ring buffer
+ */
+
+#include <common.h>
+#include <bloblist.h>
+#include <command.h>
+#include <console.h>
+#include <log.h>
+#include <asm/global_data.h>
+#include <test/log.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Check the next line of 'log dump' output, skipping the timestamp */
+static int check_ring_line(struct unit_test_state *uts, const char *expect)
+{
+	char buf[256];
+	char *p;
+
+	ut_assert(console_record_readline(buf, sizeof(buf)) >= 0);
+	ut_asserteq('[', *buf);
+	p = strstr(buf, "] ");
+	ut_assertnonnull(p);
+	ut_asserteq_str(expect, p + 2);
+
+	return 0;
+}
+
+/* Skip lines of 'log dump' output until one holds the expected message */
+static bool find_ring_line(const char *expect)
+{
+	char buf[256];
+	char *p;
+
+	while (console_record_readline(buf, sizeof(buf)) >= 0) {
+		p = strstr(buf, "] ");
+		if (p && !strcmp(expect, p + 2))
+			return true;
+	}
+
+	return false;
+}
+
+/* Test that messages are formatted correctly when the ring is dumped */
+static int log_test_ring(struct unit_test_state *uts)
+{
+	char expect[3][100];
+	phys_addr_t addr = 0x1234;
+	int log_fmt = gd->log_fmt;
+	int log_level = gd->default_log_level;
+
+	/* Keep the messages off the console, which does not affect the ring */
+	ut_assertok(log_ring_clear());
+	gd->log_fmt = BIT(LOGF_CAT) | BIT(LOGF_LEVEL) | BIT(LOGF_MSG);
+	gd->default_log_level = LOGL_EMERG;
+	log(LOGC_ARCH, LOGL_DEBUG,
+	    "int %d %5u %-3x| long %ld size %zu ll %lld\n", -1, 2, 0xa, -3L,
+	    (size_t)4, 1LL << 40);
+	log(LOGC_EFI, LOGL_DEBUG_IO, "str %s %.2s %-4s| %*d %.*s %%\n", "abc",
+	    "def", "g", 3, 7, 1, "hi");
+
+	/* This cannot be stored unformatted, so is formatted straight away */
+	log(LOGC_DM, LOGL_INFO, "ptr %p ext %pa\n", (void *)0x5678, &addr);
+
+	/* Continuation of a message */
+	log(LOGC_ARCH, LOGL_ERR, "ea%d ", 1);
+	log(LOGC_CONT, LOGL_CONT, "cc%d\n", 2);
+	gd->default_log_level = log_level;
+
+	snprintf(expect[0], sizeof(expect[0]),
+		 "DEBUG.arch, int %d %5u %-3x| long %ld size %zu ll %lld", -1, 2,
+		 0xa, -3L, (size_t)4, 1LL << 40);
+	snprintf(expect[1], sizeof(expect[1]),
+		 "IO.efi, str %s %.2s %-4s| %*d %.*s %%", "abc", "def", "g", 3, 7,
+		 1, "hi");
+	snprintf(expect[2], sizeof(expect[2]), "INFO.dm, ptr %p ext %pa",
+		 (void *)0x5678, &addr);
+
+	console_record_reset_enable();
+	ut_assertok(log_ring_dump());
+	gd->log_fmt = log_fmt;
+	gd->flags &= ~GD_FLG_RECORD;
+	ut_assertok(check_ring_line(uts, expect[0]));
+	ut_assertok(check_ring_line(uts, expect[1]));
+	ut_assertok(check_ring_line(uts, expect[2]));
+	ut_assertok(check_ring_line(uts, "ERR.arch, ea1 cc2"));
+	ut_assertok(ut_check_console_end(uts));
+
+	return 0;
+}
+LOG_TEST(log_test_ring);
+
+/* Test that the oldest records are overwritten when the ring is full */
+static int log_test_ring_wrap(struct unit_test_state *uts)
+{
+	struct log_ring_stats stats;
+	int log_fmt = gd->log_fmt;
+	int log_level = gd->default_log_level;
+	char pad[200];
+	char expect[20];
+	ulong count, i;
+
+	ut_assertok(log_ring_clear());
+	ut_assertok(log_ring_get_stats(&stats));
+	ut_asserteq(0, stats.count);
+	ut_asserteq(0, stats.used);
+
+	/*
+	 * Use records of at least 256 bytes, so that the ring wraps when it
+	 * is written twice over but the dump fits in the console buffer
+	 */
+	memset(pad, 'x', sizeof(pad) - 1);
+	pad[sizeof(pad) - 1] = '\0';
+	count = stats.size / 128;
+	gd->log_fmt = BIT(LOGF_MSG);
+	gd->default_log_level = LOGL_EMERG;
+	for (i = 0; i < count; i++)
+		log(LOGC_CORE, LOGL_DEBUG, "rec %lu%.0s\n", i, pad);
+	gd->default_log_level = log_level;
+
+	ut_assertok(log_ring_get_stats(&stats));
+	ut_assert(stats.dropped > 0);
+	ut_asserteq(count, stats.count + stats.dropped);
+	ut_assert(stats.used <= stats.size);
+
+	/* The records left must be the newest ones, in order */
+	console_record_reset_enable();
+	ut_assertok(log_ring_dump());
+	gd->log_fmt = log_fmt;
+	gd->flags &= ~GD_FLG_RECORD;
+	for (i = stats.dropped; i < count; i++) {
+		snprintf(expect, sizeof(expect), "rec %lu", i);
+		ut_assertok(check_ring_line(uts, expect));
+	}
+	ut_assertok(ut_check_console_end(uts));
+
+	ut_assertok(log_ring_clear());
+
+	return 0;
+}
+LOG_TEST(log_test_ring_wrap);
+
+/* Test the 'log dump' command */
+static int log_test_ring_cmd(struct unit_test_state *uts)
+{
+	int log_fmt = gd->log_fmt;
+	int log_level = gd->default_log_level;
+
+	ut_assertok(log_ring_clear());
+	gd->log_fmt = BIT(LOGF_MSG);
+	gd->default_log_level = LOGL_EMERG;
+	log(LOGC_CORE, LOGL_DEBUG, "dump %d\n", 1);
+	log(LOGC_CORE, LOGL_DEBUG, "dump %d\n", 2);
+	gd->default_log_level = log_level;
+
+	/* Running the command may add records of its own */
+	console_record_reset_enable();
+	ut_assertok(run_command("log dump -s", 0));
+	ut_assert_nextlinen("Records:");
+	ut_assert_nextline("Overwritten: 0");
+	ut_assert_nextlinen("Memory:");
+	ut_assert_console_end();
+
+	/* Show the records, then remove them */
+	ut_assertok(run_command("log dump -c", 0));
+	ut_assert(find_ring_line("dump 1"));
+	ut_assert(find_ring_line("dump 2"));
+	console_record_reset();
+	ut_assertok(run_command("log dump", 0));
+	ut_assert(!find_ring_line("dump 1"));
+
+	console_record_reset();
+	ut_asserteq(CMD_RET_FAILURE, run_command("log dump extra", 0));
+	gd->log_fmt = log_fmt;
+	gd->flags &= ~GD_FLG_RECORD;
+
+	return 0;
+}
+LOG_TEST(log_test_ring_cmd);
+
+/* Test that the source location is kept after the caller's copy goes away */
+static int log_test_ring_names(struct unit_test_state *uts)
+{
+	int log_fmt = gd->log_fmt;
+	int log_level = gd->default_log_level;
+	char expect[100];
+
+	ut_assertok(log_ring_clear());
+	gd->log_fmt = BIT(LOGF_FILE) | BIT(LOGF_FUNC) | BIT(LOGF_MSG);
+	gd->default_log_level = LOGL_EMERG;
+
+	/* The command's arguments are freed once it has run */
+	ut_assertok(run_command("log rec core debug myfile 12 myfunc msg", 0));
+	ut_assertok(run_command("log rec core debug other 34 again more", 0));
+	gd->default_log_level = log_level;
+
+	console_record_reset_enable();
+	ut_assertok(log_ring_dump());
+	gd->log_fmt = log_fmt;
+	gd->flags &= ~GD_FLG_RECORD;
+	snprintf(expect, sizeof(expect), "myfile:%*s() msg",
+		 CONFIG_LOGF_FUNC_PAD, "myfunc");
+	ut_assert(find_ring_line(expect));
+	snprintf(expect, sizeof(expect), "other:%*s() more",
+		 CONFIG_LOGF_FUNC_PAD, "again");
+	ut_assert(find_ring_line(expect));
+
+	ut_assertok(log_ring_clear());
+
+	return 0;
+}
+LOG_TEST(log_test_ring_names);
+
+/* Test that only the newest records are passed on if they do not all fit */
+static int log_test_ring_handoff(struct unit_test_state *uts)
+{
+	int log_fmt = gd->log_fmt;
+	int log_level = gd->default_log_level;
+	const char *blob, *last;
+	ulong i;
+
+	if (!CONFIG_IS_ENABLED(BLOBLIST))
+		return -EAGAIN;
+
+	ut_assertok(log_ring_clear());
+	gd->log_fmt = BIT(LOGF_MSG);
+	gd->default_log_level = LOGL_EMERG;
+	for (i = 0; i < 1000; i++)
+		log(LOGC_CORE, LOGL_DEBUG, "handoff %lu\n", i);
+	gd->default_log_level = log_level;
+	ut_assertok(log_ring_handoff());
+	gd->log_fmt = log_fmt;
+
+	/* The text is far too large, so the oldest records are left out */
+	blob = bloblist_find(BLOBLISTT_U_BOOT_LOG, 0);
+	ut_assertnonnull(blob);
+	ut_assert(strlen(blob) < bloblist_get_size());
+	ut_assertnull(strstr(blob, "] handoff 0\n"));
+	last = strstr(blob, "] handoff 999\n");
+	ut_assertnonnull(last);
+	ut_asserteq_str("] handoff 999\n", last);
+
+	ut_assertok(log_ring_clear());
+
+	return 0;
+}
+LOG_TEST(log_test_ring_handoff);
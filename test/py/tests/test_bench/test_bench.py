@@ -0,0 +1,449 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""Boot-time benchmarks on sandbox
+
+Each test times one of the hot paths used while booting, using the spans and
+accumulated times recorded by bootstage, then checks the time against the
+threshold for that test in thresholds.json. The thresholds are deliberately
+loose, since sandbox timing depends on the host, so they catch large
+regressions rather than small ones.
+
+All results are written to bench-results.json in the result directory, so
+that CI can track them over time.
+"""
+
+import gzip
+import json
+import lzma
+import os
+import shutil
+
+import pytest
+
+import u_boot_utils as util
+from tests import fit_util
+
+# Number of times to run each measurement; the fastest run is used
+REPEAT = 3
+
+# Size of the data used for file loads, decompression and hashing
+DATA_SIZE = 4 << 20
+
+# Memory used by the tests
+DATA_ADDR = 0x1000000
+LOAD_ADDR = 0x4000000
+TRACE_ADDR = 0x8000000
+TRACE_SIZE = 0x100000
+
+# Shape of the synthetic devicetree used to time driver-model scanning
+BUS_COUNT = 200
+DEVS_PER_BUS = 10
+
+THRESHOLDS_FNAME = os.path.join(os.path.dirname(__file__), 'thresholds.json')
+
+with open(THRESHOLDS_FNAME, encoding='utf-8') as _inf:
+    THRESHOLDS = json.load(_inf)
+
+BASE_FDT = '''
+/dts-v1/;
+
+/ {
+        #address-cells = <1>;
+        #size-cells = <0>;
+
+        model = "Sandbox benchmark";
+};
+'''
+
+DECOMP_ITS = '''
+/dts-v1/;
+
+/ {
+        description = "FIT to time decompression";
+        #address-cells = <1>;
+
+        images {
+                kernel-1 {
+                        data = /incbin/("%(kernel)s");
+                        type = "kernel";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "%(compression)s";
+                        load = <%(load)#x>;
+                        entry = <%(load)#x>;
+                };
+                fdt-1 {
+                        data = /incbin/("%(fdt)s");
+                        type = "flat_dt";
+                        arch = "sandbox";
+                        compression = "none";
+                };
+        };
+        configurations {
+                default = "conf-1";
+                conf-1 {
+                        kernel = "kernel-1";
+                        fdt = "fdt-1";
+                };
+        };
+};
+'''
+
+VERIFY_ITS = '''
+/dts-v1/;
+
+/ {
+        description = "FIT to time verification";
+        #address-cells = <1>;
+
+        images {
+                kernel-1 {
+                        data = /incbin/("%(kernel)s");
+                        type = "kernel";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "none";
+                        load = <%(load)#x>;
+                        entry = <%(load)#x>;
+                        hash-1 {
+                                algo = "sha256";
+                        };
+                };
+                ramdisk-1 {
+                        data = /incbin/("%(ramdisk)s");
+                        type = "ramdisk";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "none";
+                        hash-1 {
+                                algo = "sha256";
+                        };
+                };
+                fdt-1 {
+                        data = /incbin/("%(fdt)s");
+                        type = "flat_dt";
+                        arch = "sandbox";
+                        compression = "none";
+                        hash-1 {
+                                algo = "crc32";
+                        };
+                };
+        };
+        configurations {
+                default = "conf-1";
+                conf-1 {
+                        kernel = "kernel-1";
+                        ramdisk = "ramdisk-1";
+                        fdt = "fdt-1";
+                };
+        };
+};
+'''
+
+
+@pytest.fixture(scope='module')
+def bench_results(u_boot_config):
+    """Collect the benchmark results and write them out at the end
+
+    Yields:
+        dict: Results, keyed by benchmark name
+    """
+    results = {}
+    yield results
+    fname = os.path.join(u_boot_config.result_dir, 'bench-results.json')
+    with open(fname, 'w', encoding='utf-8') as outf:
+        json.dump(results, outf, indent=4, sort_keys=True)
+
+
+def check_result(results, name, time_us):
+    """Record a benchmark result and check it against its threshold
+
+    Args:
+        results (dict): Results to update
+        name (str): Name of the benchmark, used to look up its threshold
+        time_us (int): Time taken, in microseconds
+    """
+    threshold = THRESHOLDS[name]
+    results[name] = {
+        'time_us': time_us,
+        'threshold_us': threshold,
+        'pass': time_us <= threshold,
+    }
+    assert time_us <= threshold, (
+        f'{name}: took {time_us} us, threshold is {threshold} us')
+
+
+def make_data(cons, basename):
+    """Make a compressible data file of DATA_SIZE bytes
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        basename (str): Base name of the file to create, or a full path
+
+    Returns:
+        str: Filename of the file created
+    """
+    fname = fit_util.make_fname(cons, basename)
+    lines = []
+    size = 0
+    while size < DATA_SIZE:
+        line = b'this benchmark kernel line %d is unlikely to boot\n' % len(lines)
+        lines.append(line)
+        size += len(line)
+    with open(fname, 'wb') as outf:
+        outf.write(b''.join(lines)[:DATA_SIZE])
+    return fname
+
+
+def get_spans(cons, cat):
+    """Get the spans of a particular type recorded by bootstage
+
+    This writes out a Chrome trace with 'bootstage chrome' and reads it back
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        cat (str): Type of span to return, e.g. 'fs'
+
+    Returns:
+        list of dict: Chrome trace events for the spans, each with 'name' and
+            'dur' (in microseconds)
+    """
+    fname = fit_util.make_fname(cons, 'bench-trace.json')
+    cons.run_command(f'bootstage chrome {TRACE_ADDR:x} {TRACE_SIZE:x}')
+    cons.run_command(f'host save hostfs - {TRACE_ADDR:x} {fname} ${{filesize}}')
+    with open(fname, encoding='utf-8') as inf:
+        trace = json.load(inf)
+    return [evt for evt in trace['traceEvents']
+            if evt['ph'] == 'X' and evt['cat'] == cat]
+
+
+def time_command(cons, cmd, cat):
+    """Run a command several times and find the fastest time for it
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        cmd (str or list of str): Command(s) to run; the last is timed
+        cat (str): Type of span recorded by the timed command, e.g. 'fs'
+
+    Returns:
+        int: Fastest time taken, in microseconds, totalling the spans of
+            the given type recorded by the timed command
+    """
+    if isinstance(cmd, str):
+        cmd = [cmd]
+    best = None
+    for _ in range(REPEAT):
+        for pre_cmd in cmd[:-1]:
+            cons.run_command(pre_cmd)
+        cons.run_command('bootstage clear')
+        output = cons.run_command(cmd[-1])
+        spans = get_spans(cons, cat)
+        assert spans, f"No '{cat}' spans from '{cmd[-1]}': {output}"
+        time_us = sum(evt['dur'] for evt in spans)
+        best = time_us if best is None else min(best, time_us)
+    return best
+
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.requiredtool('dtc')
+def test_bench_dm_scan(u_boot_console, bench_results):
+    """Time dm_init_and_scan() with a large devicetree"""
+    cons = u_boot_console
+    dts = fit_util.make_fname(cons, 'bench-dm.dts')
+    dtb = fit_util.make_fname(cons, 'bench-dm.dtb')
+    util.run_and_log(cons, ['dtc', '-I', 'dtb', '-O', 'dts', '-o', dts,
+                            cons.config.dtb])
+    with open(dts, 'a', encoding='utf-8') as outf:
+        print('/ {', file=outf)
+        for bus in range(BUS_COUNT):
+            print(f'\tbench-bus-{bus} {{', file=outf)
+            print('\t\tcompatible = "simple-bus";', file=outf)
+            for dev in range(DEVS_PER_BUS):
+                print(f'\t\tbench-dev-{dev} {{', file=outf)
+                print('\t\t\tcompatible = "u-boot,bench-none";', file=outf)
+                print('\t\t};', file=outf)
+            print('\t};', file=outf)
+        print('};', file=outf)
+    util.run_and_log(cons, ['dtc', '-q', '-I', 'dts', '-O', 'dtb', '-o', dtb,
+                            dts])
+
+    best = None
+    try:
+        for _ in range(REPEAT):
+            cons.restart_uboot_with_flags(['-d', dtb], use_dtb=False)
+            output = cons.run_command('bootstage report')
+
+            # Accumulated time:
+            #           19,104  dm_r
+            dm_r = [line.split()[0] for line in output.replace(',', '').splitlines()
+                    if line.endswith('dm_r')]
+            assert dm_r, output
+            time_us = int(dm_r[0])
+            best = time_us if best is None else min(best, time_us)
+    finally:
+        # Go back to the normal devicetree
+        cons.restart_uboot()
+    check_result(bench_results, 'dm_scan', best)
+
+
+def make_fs_image(cons, fs_type, src_dir):
+    """Make a filesystem image holding the contents of a directory
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        fs_type (str): Filesystem type, e.g. 'ext4'
+        src_dir (str): Directory to copy into the image
+
+    Returns:
+        str: Filename of the image
+    """
+    img = fit_util.make_fname(cons, f'bench.{fs_type}.img')
+    if os.path.exists(img):
+        os.remove(img)
+    size_mb = DATA_SIZE * 2 // (1 << 20)
+    if fs_type == 'ext4':
+        util.run_and_log(cons, ['mkfs.ext4', '-q', '-O', '^metadata_csum',
+                                '-d', src_dir, img, f'{size_mb}M'])
+    elif fs_type == 'fat':
+        util.run_and_log(cons, ['mkfs.vfat', '-C', img, str(size_mb << 10)])
+        for fname in os.listdir(src_dir):
+            util.run_and_log(cons, ['mcopy', '-i', img,
+                                    os.path.join(src_dir, fname), '::/'])
+    elif fs_type == 'squashfs':
+        util.run_and_log(cons, ['mksquashfs', src_dir, img, '-noappend'])
+    elif fs_type == 'erofs':
+        util.run_and_log(cons, ['mkfs.erofs', img, src_dir])
+    return img
+
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('bootstage_spans')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.parametrize('fs_type', [
+    pytest.param('ext4', marks=[pytest.mark.buildconfigspec('fs_ext4'),
+                                pytest.mark.requiredtool('mkfs.ext4')]),
+    pytest.param('fat', marks=[pytest.mark.buildconfigspec('fs_fat'),
+                               pytest.mark.requiredtool('mkfs.vfat'),
+                               pytest.mark.requiredtool('mcopy')]),
+    pytest.param('squashfs', marks=[pytest.mark.buildconfigspec('fs_squashfs'),
+                                    pytest.mark.requiredtool('mksquashfs')]),
+    pytest.param('erofs', marks=[pytest.mark.buildconfigspec('fs_erofs'),
+                                 pytest.mark.requiredtool('mkfs.erofs')]),
+])
+def test_bench_fs_load(u_boot_console, bench_results, fs_type):
+    """Time loading a file from a filesystem"""
+    cons = u_boot_console
+    src_dir = fit_util.make_fname(cons, 'bench-fs')
+    shutil.rmtree(src_dir, ignore_errors=True)
+    os.makedirs(src_dir)
+    data = make_data(cons, os.path.join(src_dir, 'bench.bin'))
+    img = make_fs_image(cons, fs_type, src_dir)
+
+    cons.run_command(f'host bind 0 {img}')
+    time_us = time_command(cons, f'load host 0:0 {DATA_ADDR:x} /bench.bin',
+                           'fs')
+    assert cons.run_command('echo $filesize') == f'{os.path.getsize(data):x}'
+    check_result(bench_results, f'fs_load_{fs_type}', time_us)
+
+
+def compress(cons, fname, comp):
+    """Compress a file
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        fname (str): File to compress
+        comp (str): Compression algorithm, e.g. 'gzip'
+
+    Returns:
+        str: Filename of the compressed file
+    """
+    out_fname = f'{fname}.{comp}'
+    with open(fname, 'rb') as inf:
+        data = inf.read()
+    if comp == 'gzip':
+        with open(out_fname, 'wb') as outf:
+            outf.write(gzip.compress(data))
+    elif comp == 'lzma':
+        with open(out_fname, 'wb') as outf:
+            outf.write(lzma.compress(data, format=lzma.FORMAT_ALONE))
+    elif comp == 'lz4':
+        util.run_and_log(cons, ['lz4', '-q', '-f', fname, out_fname])
+    elif comp == 'zstd':
+        util.run_and_log(cons, ['zstd', '-q', '-f', fname, '-o', out_fname])
+    return out_fname
+
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('bootstage_spans')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.parametrize('comp', [
+    pytest.param('gzip', marks=pytest.mark.buildconfigspec('gzip')),
+    pytest.param('lz4', marks=[pytest.mark.buildconfigspec('lz4'),
+                               pytest.mark.requiredtool('lz4')]),
+    pytest.param('zstd', marks=[pytest.mark.buildconfigspec('zstd'),
+                                pytest.mark.requiredtool('zstd')]),
+    pytest.param('lzma', marks=pytest.mark.buildconfigspec('lzma')),
+])
+def test_bench_decomp(u_boot_console, bench_results, comp):
+    """Time decompressing a kernel from a FIT"""
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    kernel = make_data(cons, 'bench-kernel.bin')
+    params = {
+        'kernel': compress(cons, kernel, comp),
+        'compression': comp,
+        'fdt': fit_util.make_dtb(cons, BASE_FDT, 'bench-fdt'),
+        'load': LOAD_ADDR,
+    }
+    fit = fit_util.make_fit(cons, mkimage, DECOMP_ITS, params,
+                            basename='bench-decomp.fit')
+
+    cons.run_command(f'host load hostfs - {DATA_ADDR:x} {fit}')
+    time_us = time_command(cons, [f'bootm start {DATA_ADDR:x}', 'bootm loados'],
+                           'decomp')
+    check_result(bench_results, f'decomp_{comp}', time_us)
+
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('bootstage_spans')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('cmd_hash')
+@pytest.mark.parametrize('algo', [
+    pytest.param('sha256', marks=pytest.mark.buildconfigspec('sha256')),
+    pytest.param('sha512', marks=pytest.mark.buildconfigspec('sha512')),
+    'crc32',
+])
+def test_bench_hash(u_boot_console, bench_results, algo):
+    """Time hashing a region of memory"""
+    cons = u_boot_console
+    time_us = time_command(cons, f'hash {algo} {DATA_ADDR:x} {DATA_SIZE:x}',
+                           'hash')
+    check_result(bench_results, f'hash_{algo}', time_us)
+
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('bootstage_spans')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.buildconfigspec('cmd_imi')
+@pytest.mark.requiredtool('dtc')
+def test_bench_fit_verify(u_boot_console, bench_results):
+    """Time verifying the hashes of all images in a FIT"""
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    params = {
+        'kernel': make_data(cons, 'bench-kernel.bin'),
+        'ramdisk': make_data(cons, 'bench-ramdisk.bin'),
+        'fdt': fit_util.make_dtb(cons, BASE_FDT, 'bench-fdt'),
+        'load': LOAD_ADDR,
+    }
+    fit = fit_util.make_fit(cons, mkimage, VERIFY_ITS, params,
+                            basename='bench-verify.fit')
+
+    cons.run_command(f'host load hostfs - {DATA_ADDR:x} {fit}')
+    time_us = time_command(cons, f'iminfo {DATA_ADDR:x}', 'verify')
+    check_result(bench_results, 'fit_verify', time_us)
@@ -5,6 +5,7 @@
 
 import os
 import pytest
+import shutil
 import struct
 import u_boot_utils as util
 import fit_util
@@ -400,3 +401,248 @@ def test_fit(u_boot_console):
         # Go back to the original U-Boot with the correct dtb.
         cons.config.dtb = old_dtb
         cons.restart_uboot()
+
+# A FIT whose kernel and FDT have hashes but no signatures, so that they can be
+# checked while they are loaded
+verify_its = '''
+/dts-v1/;
+
+/ {
+        description = "FIT with hashes checked on load";
+        #address-cells = <1>;
+
+        images {
+                kernel-1 {
+                        data = /incbin/("%(kernel)s");
+                        type = "kernel";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "%(compression)s";
+                        load = <0x40000>;
+                        entry = <0x8>;
+                        hash-1 {
+                                algo = "crc32";
+                        };
+                        hash-2 {
+                                algo = "sha256";
+                        };
+                };
+                fdt-1 {
+                        data = /incbin/("%(fdt)s");
+                        type = "flat_dt";
+                        arch = "sandbox";
+                        load = <0x80000>;
+                        compression = "none";
+                        hash-1 {
+                                algo = "sha1";
+                        };
+                };
+        };
+        configurations {
+                default = "conf-1";
+                conf-1 {
+                        kernel = "kernel-1";
+                        fdt = "fdt-1";
+                };
+        };
+};
+'''
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fit_verify_on_load')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.parametrize('compression', ['gzip', 'lz4'])
+def test_fit_verify_on_load(u_boot_console, compression):
+    """Test that hashes are checked while images are loaded from a FIT
+
+    The kernel is decompressed by 'bootm loados', which must check its hashes
+    at the same time, and refuse a kernel whose compressed data is corrupt.
+    """
+    cons = u_boot_console
+    if compression == 'lz4':
+        if not cons.config.buildconfig.get('config_lz4'):
+            pytest.skip('LZ4 is not enabled')
+        if not shutil.which('lz4'):
+            pytest.skip('lz4 tool is not available')
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    kernel = fit_util.make_kernel(cons, 'verify-kernel.bin', 'kernel')
+    if compression == 'lz4':
+        kernel_gz = kernel + '.lz4'
+        util.run_and_log(cons, ['lz4', '-f', '-q', kernel, kernel_gz])
+    else:
+        kernel_gz = kernel + '.gz'
+        util.run_and_log(cons, ['gzip', '-f', '-k', kernel])
+    fdt = fit_util.make_dtb(cons, base_fdt, 'verify-fdt')
+    kernel_out = fit_util.make_fname(cons, 'verify-kernel-out.bin')
+    params = {
+        'kernel': kernel_gz,
+        'fdt': fdt,
+        'compression': compression,
+    }
+    fit = fit_util.make_fit(cons, mkimage, verify_its, params,
+                            basename='verify.fit')
+    with open(kernel, 'rb') as inf:
+        kernel_data = inf.read()
+    with open(kernel_gz, 'rb') as inf:
+        gz_data = inf.read()
+    with open(fit, 'rb') as inf:
+        fit_data = inf.read()
+
+    fit_addr = 0x1000
+    cons.restart_uboot()
+    cons.run_command('host load hostfs 0 %x %s' % (fit_addr, fit))
+    output = cons.run_command('bootm start %x' % fit_addr)
+    assert 'Bad Data Hash' not in output
+    output = cons.run_command('bootm loados')
+    assert 'Uncompressing Kernel Image' in output
+    assert 'Verifying Hash Integrity ... crc32+ sha256+ OK' in output
+    cons.run_command('host save hostfs 0 40000 %s %x' %
+                     (kernel_out, len(kernel_data)))
+    with open(kernel_out, 'rb') as inf:
+        assert inf.read() == kernel_data
+
+    # Corrupt the compressed kernel in the middle
+    pos = fit_data.find(gz_data)
+    assert pos != -1
+    pos += len(gz_data) // 2
+    bad_fit = fit_util.make_fname(cons, 'verify-bad.fit')
+    with open(bad_fit, 'wb') as outf:
+        outf.write(fit_data[:pos] + bytes([fit_data[pos] ^ 0xff]) +
+                   fit_data[pos + 1:])
+
+    cons.restart_uboot()
+    cons.run_command('host load hostfs 0 %x %s' % (fit_addr, bad_fit))
+    cons.run_command('bootm start %x' % fit_addr)
+    with cons.disable_check('error_notification'):
+        output = cons.run_command('bootm loados')
+    assert 'Bad Data Hash' in output
+
+# The same FIT with its configuration signed, as with verified boot
+signed_verify_its = '''
+/dts-v1/;
+
+/ {
+        description = "Signed FIT whose hashes must be checked first";
+        #address-cells = <1>;
+
+        images {
+                kernel-1 {
+                        data = /incbin/("%(kernel)s");
+                        type = "kernel";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "gzip";
+                        load = <0x40000>;
+                        entry = <0x8>;
+                        hash-1 {
+                                algo = "sha256";
+                        };
+                };
+                fdt-1 {
+                        data = /incbin/("%(fdt)s");
+                        type = "flat_dt";
+                        arch = "sandbox";
+                        load = <0x80000>;
+                        compression = "none";
+                        hash-1 {
+                                algo = "sha256";
+                        };
+                };
+        };
+        configurations {
+                default = "conf-1";
+                conf-1 {
+                        kernel = "kernel-1";
+                        fdt = "fdt-1";
+                        signature-1 {
+                                algo = "sha256,rsa2048";
+                                key-name-hint = "dev";
+                                sign-images = "fdt", "kernel";
+                        };
+                };
+        };
+};
+'''
+
+# Control devicetree for U-Boot, to which the public key is added
+signed_control_dts = '''
+/dts-v1/;
+
+/ {
+        model = "Sandbox verify-on-load test";
+        compatible = "sandbox";
+};
+'''
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fit_verify_on_load')
+@pytest.mark.buildconfigspec('fit_signature')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.requiredtool('fdtget')
+@pytest.mark.requiredtool('openssl')
+def test_fit_verify_on_load_signed(u_boot_console):
+    """Test that a signed FIT is not decompressed before its hashes are good
+
+    The configuration signature covers the image hashes but not the image
+    data, so a kernel whose data has been changed still has a good signature.
+    Its hash must be checked before any of its data is decompressed.
+    """
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    keydir = cons.config.build_dir + '/'
+    util.run_and_log(cons, 'openssl genpkey -algorithm RSA -out %sdev.key '
+                     '-pkeyopt rsa_keygen_bits:2048' % keydir)
+    util.run_and_log(cons, 'openssl req -batch -new -x509 -key %sdev.key '
+                     '-out %sdev.crt' % (keydir, keydir))
+
+    kernel = fit_util.make_kernel(cons, 'signed-kernel.bin', 'kernel')
+    util.run_and_log(cons, ['gzip', '-f', '-k', kernel])
+    kernel_gz = kernel + '.gz'
+    fdt = fit_util.make_dtb(cons, base_fdt, 'signed-fdt')
+    dtb = fit_util.make_dtb(cons, signed_control_dts, 'signed-control')
+    params = {
+        'kernel': kernel_gz,
+        'fdt': fdt,
+    }
+    fit = fit_util.make_fit(cons, mkimage, signed_verify_its, params,
+                            basename='signed.fit')
+
+    # Sign the configuration and mark the key as required for it
+    util.run_and_log(cons, [mkimage, '-F', '-k', keydir, '-K', dtb, '-r',
+                            fit])
+    util.run_and_log(cons, ['fdtget', dtb, '/signature/key-dev', 'required'])
+
+    # Corrupt the compressed kernel, which the signature does not cover
+    with open(kernel_gz, 'rb') as inf:
+        gz_data = inf.read()
+    with open(fit, 'rb') as inf:
+        fit_data = inf.read()
+    pos = fit_data.find(gz_data)
+    assert pos != -1
+    pos += len(gz_data) // 2
+    bad_fit = fit_util.make_fname(cons, 'signed-bad.fit')
+    with open(bad_fit, 'wb') as outf:
+        outf.write(fit_data[:pos] + bytes([fit_data[pos] ^ 0xff]) +
+                   fit_data[pos + 1:])
+
+    fit_addr = 0x1000
+    old_dtb = cons.config.dtb
+    try:
+        cons.config.dtb = dtb
+        cons.restart_uboot()
+        cons.run_command('host load hostfs 0 %x %s' % (fit_addr, bad_fit))
+        cons.run_command('mw.b 40000 a5 1000')
+        with cons.disable_check('error_notification'):
+            output = cons.run_command_list(['bootm start %x' % fit_addr,
+                                            'bootm loados'])
+        output = ''.join(output)
+        assert 'dev+' in output
+        assert 'Bad Data Hash' in output
+        assert 'Uncompressing' not in output
+
+        # Nothing was written to the load address
+        output = cons.run_command('md.b 40000 10')
+        assert ' a5' * 16 in output
+    finally:
+        cons.config.dtb = old_dtb
+        cons.restart_uboot()
@@ -0,0 +1,73 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test and benchmark hashing FIT images in parallel with 'mkimage -j'
+
+This builds an auto-FIT with a large kernel and many device-tree files, with
+hashed images and signed configurations, once with a single thread and once
+with one thread per CPU. The two FITs must be identical, since only the image
+hashes are calculated in parallel. The wall time of each run is logged.
+
+The test does not run the sandbox. It only checks the host tool mkimage.
+"""
+
+import filecmp
+import os
+import time
+
+import pytest
+import u_boot_utils as util
+
+# Number of device-tree files and size of the kernel in the benchmark FIT
+DTB_COUNT = 48
+DTB_SIZE = 64 << 10
+KERNEL_SIZE = 64 << 20
+
+@pytest.mark.buildconfigspec('fit_signature')
+@pytest.mark.requiredtool('openssl')
+def test_fit_jobs(u_boot_console):
+    """Test that 'mkimage -j' produces the same FIT, and log the time taken"""
+    def make_fit(fit, jobs):
+        """Create a signed auto-FIT and return the wall time in seconds"""
+        start = time.monotonic()
+        util.run_and_log(cons, [mkimage, '-j', str(jobs), '-f', 'auto-conf',
+                                '-k', tmpdir, '-g', key_name, '-o',
+                                'sha256,rsa2048', '-d', kernel] + dtb_args +
+                         [fit], env=env)
+        return time.monotonic() - start
+
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    tmpdir = os.path.join(cons.config.result_dir, 'fit_jobs')
+    os.makedirs(tmpdir, exist_ok=True)
+    key_name = 'dev'
+    kernel = os.path.join(tmpdir, 'vmlinuz')
+
+    with open(kernel, 'wb') as outf:
+        outf.write(os.urandom(KERNEL_SIZE))
+    dtb_args = []
+    for seq in range(DTB_COUNT):
+        dtb = os.path.join(tmpdir, f'dt-{seq}.dtb')
+        with open(dtb, 'wb') as outf:
+            outf.write(os.urandom(DTB_SIZE))
+        dtb_args += ['-b', dtb]
+
+    util.run_and_log(cons, 'openssl genpkey -algorithm RSA -out %s/%s.key '
+                     '-pkeyopt rsa_keygen_bits:2048 '
+                     '-pkeyopt rsa_keygen_pubexp:65537' % (tmpdir, key_name))
+
+    # Use a fixed timestamp so that the two FITs can be compared
+    env = dict(os.environ, SOURCE_DATE_EPOCH='1690000000')
+    fit_serial = os.path.join(tmpdir, 'serial.fit')
+    fit_parallel = os.path.join(tmpdir, 'parallel.fit')
+    serial = make_fit(fit_serial, 1)
+    parallel = make_fit(fit_parallel, 0)
+
+    cons.log.info('%d images, %d CPUs: -j1 %.3fs, -j0 %.3fs (%.2fx)' %
+                  (DTB_COUNT + 1, os.cpu_count(), serial, parallel,
+                   serial / parallel))
+    assert filecmp.cmp(fit_serial, fit_parallel, shallow=False)
+
+    # The configurations must be signed
+    output = util.run_and_log(cons, [mkimage, '-l', fit_parallel])
+    assert 'Sign value' in output
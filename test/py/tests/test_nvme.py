@@ -0,0 +1,109 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+# Test U-Boot's "nvme read" command. The test reads data from an NVMe
+# namespace, checks that no errors occurred and that the expected data was
+# read if the test configuration contains a CRC of the expected data. Large
+# reads are split into several commands which are kept outstanding on the
+# I/O queue at the same time, so this also exercises command pipelining.
+#
+# This works with QEMU's emulated controller, e.g. for qemu_arm64:
+#
+#   -drive if=none,file=nvme.img,format=raw,id=nvme0 \
+#   -device nvme,drive=nvme0,serial=deadbeef
+
+import pytest
+import time
+import u_boot_utils
+
+"""
+This test relies on boardenv_* to contain configuration values to define
+which NVMe regions should be read. For example:
+
+env__nvme_rd_configs = (
+    {
+        'fixture_id': 'nvme-mbr',
+        'devid': 0,
+        'sector': 0,
+        'count': 1,
+        'crc32': '8f6ecf0d',
+    },
+    {
+        'fixture_id': 'nvme-large',
+        'devid': 0,
+        'sector': 0x800,
+        'count': 0x20000,
+        'crc32': '6a5a3bc2',
+        'read_duration_max': 1,
+    },
+)
+"""
+
+@pytest.mark.buildconfigspec('cmd_nvme')
+def test_nvme_rd(u_boot_console, env__nvme_rd_config):
+    """Test the "nvme read" command.
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        env__nvme_rd_config: The single NVMe configuration on which
+            to run the test. See the file-level comment above for details
+            of the format.
+
+    Returns:
+        Nothing.
+    """
+
+    devid = env__nvme_rd_config['devid']
+    sector = env__nvme_rd_config.get('sector', 0)
+    count_sectors = env__nvme_rd_config.get('count', 1)
+    expected_crc32 = env__nvme_rd_config.get('crc32', None)
+    read_duration_max = env__nvme_rd_config.get('read_duration_max', 0)
+
+    count_bytes = count_sectors * 512
+    bcfg = u_boot_console.config.buildconfig
+    has_cmd_memory = bcfg.get('config_cmd_memory', 'n') == 'y'
+    has_cmd_crc32 = bcfg.get('config_cmd_crc32', 'n') == 'y'
+    ram_base = u_boot_utils.find_ram_base(u_boot_console)
+    addr = '0x%08x' % ram_base
+
+    u_boot_console.run_command('nvme scan')
+    response = u_boot_console.run_command('nvme device %d' % devid)
+    assert 'is now current device' in response
+
+    # Clear target RAM
+    if expected_crc32:
+        if has_cmd_memory and has_cmd_crc32:
+            cmd = 'mw.b %s 0 0x%x' % (addr, count_bytes)
+            u_boot_console.run_command(cmd)
+
+            cmd = 'crc32 %s 0x%x' % (addr, count_bytes)
+            response = u_boot_console.run_command(cmd)
+            assert expected_crc32 not in response
+        else:
+            u_boot_console.log.warning(
+                'CONFIG_CMD_MEMORY or CONFIG_CMD_CRC32 != y: Skipping RAM clear')
+
+    # Read data
+    cmd = 'nvme read %s %x %x' % (addr, sector, count_sectors)
+    tstart = time.time()
+    response = u_boot_console.run_command(cmd)
+    tend = time.time()
+    good_response = 'nvme read: device %d block # %d, count %d ... %d blocks read: OK' % (
+        devid, sector, count_sectors, count_sectors)
+    assert good_response in response
+
+    # Check target RAM
+    if expected_crc32:
+        if has_cmd_crc32:
+            cmd = 'crc32 %s 0x%x' % (addr, count_bytes)
+            response = u_boot_console.run_command(cmd)
+            assert expected_crc32 in response
+        else:
+            u_boot_console.log.warning('CONFIG_CMD_CRC32 != y: Skipping check')
+
+    elapsed = tend - tstart
+    u_boot_console.log.info('Reading %d bytes took %f seconds' %
+                            (count_bytes, elapsed))
+
+    # Check if the command did not take too long
+    if read_duration_max:
+        assert elapsed <= (read_duration_max - 0.01)
@@ -303,3 +303,53 @@ def test_trace(u_boot_console):
     # This allows for CI being slow to run
     diff = abs(fg_time - dm_f_time)
     assert diff / dm_f_time < 0.3
+
+
+@pytest.mark.slow
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('trace_sample')
+def test_trace_sample(u_boot_console):
+    """Test that program-counter samples can be collected and processed"""
+    cons = u_boot_console
+
+    if not os.path.exists(TMPDIR):
+        os.mkdir(TMPDIR)
+    proftool = os.path.join(cons.config.build_dir, 'tools', 'proftool')
+    map_fname = os.path.join(cons.config.build_dir, 'System.map')
+    fname = os.path.join(TMPDIR, 'samples')
+    sample_fg = os.path.join(TMPDIR, 'samples.fg')
+
+    # Keep the function trace out of the way, then spend some CPU time
+    cons.run_command('trace pause')
+    cons.run_command('trace sample start 100')
+    for _ in range(4):
+        cons.run_command('crc32 0 4000000')
+    cons.run_command('trace sample stop')
+
+    out = cons.run_command('trace stats')
+    lines = [line.split(maxsplit=1) for line in out.splitlines() if line]
+    vals = {key: val.replace(',', '') for val, key in lines}
+    assert int(vals['samples']) > 100
+
+    addr = 0x02000000
+    size = 0x01000000
+    out = cons.run_command(f'trace sample dump {addr:x} {size:x}')
+    assert 'Sample list dumped' in out
+    cons.run_command(
+        'host save hostfs - %x %s ${profoffset}' % (addr, fname))
+
+    util.run_and_log(
+        cons, [proftool, '-t', fname, '-o', sample_fg, '-m', map_fname,
+               '-f', 'samples', 'dump-flamegraph'])
+
+    # Most of the samples should be in the CRC code, called from the command
+    total = 0
+    crc = 0
+    with open(sample_fg, 'r') as fd:
+        for line in fd:
+            stack, val = line.strip().rsplit(maxsplit=1)
+            total += int(val)
+            if 'crc32' in stack and 'do_mem_crc' in stack:
+                crc += int(val)
+    assert total > 100
+    assert crc > total / 2
@@ -57,6 +57,9 @@ class EfiStruct:
     # struct efi_var_entry
     var_entry_fmt = '<LLQ16s'
     var_entry_size = struct.calcsize(var_entry_fmt)
+    # struct efi_var_journal
+    var_journal_fmt = '<LL'
+    var_journal_size = struct.calcsize(var_journal_fmt)
     # struct efi_time
     var_time_fmt = '<H6BLh2B'
     var_time_size = struct.calcsize(var_time_fmt)
@@ -86,21 +89,43 @@ class EfiVariableStore:
         if os.path.exists(self.infile) and os.stat(self.infile).st_size > self.efi.var_file_size:
             with open(self.infile, 'rb') as f:
                 buf = f.read()
-                self._check_header(buf)
-                self.ents = buf[self.efi.var_file_size:]
+                length, crc32 = self._check_header(buf)
+                self.ents = buf[self.efi.var_file_size:length]
+                self._replay(buf[length:], crc32)
         else:
             self.ents = bytearray()
 
     def _check_header(self, buf):
         hdr = struct.unpack_from(self.efi.var_file_fmt, buf, 0)
-        magic, crc32 = hdr[1], hdr[3]
+        magic, length, crc32 = hdr[1], hdr[2], hdr[3]
 
         if magic != UBOOT_EFI_VAR_FILE_MAGIC:
             print("err: invalid magic number: %s"%hex(magic))
             exit(1)
-        if crc32 != calc_crc32(buf[self.efi.var_file_size:]):
+        if crc32 != calc_crc32(buf[self.efi.var_file_size:length]):
             print("err: invalid crc32: %s"%hex(crc32))
             exit(1)
+        return length, crc32
+
+    def _replay(self, buf, crc):
+        # apply the changes recorded in the journal after the variables
+        offs = 0
+        while offs + self.efi.var_journal_size <= len(buf):
+            length, rec_crc = struct.unpack_from(self.efi.var_journal_fmt, buf, offs)
+            rec = buf[offs + self.efi.var_journal_size:offs + length]
+            if (length < self.efi.var_journal_size + self.efi.var_entry_size or
+                    offs + length > len(buf) or
+                    rec_crc != zlib.crc32(rec, crc) & 0xffffffff):
+                break
+            crc = rec_crc
+            offs += length
+
+            size, attrs, tsec, guid = struct.unpack_from(self.efi.var_entry_fmt, rec)
+            name, namelen = self._get_var_name(rec[self.efi.var_entry_size:])
+            self._remove_var(uuid.UUID(bytes_le=guid), name)
+            # a variable without data is deleted
+            if size:
+                self.ents += rec
 
     def _get_var_name(self, buf):
         name = ''
@@ -145,6 +170,15 @@ class EfiVariableStore:
         ent += name_data
         self.ents += ent
 
+    def _remove_var(self, guid, name):
+        offs = 0
+        while offs < len(self.ents):
+            var, loffs = self._next_var(offs)
+            if var.name == name and var.guid == guid:
+                self.ents = self.ents[:offs] + self.ents[loffs:]
+                return
+            offs = loffs
+
     def del_var(self, guid, name, attrs):
         offs = 0
         while offs < len(self.ents):
@@ -13,6 +13,7 @@
 #include <fdt_region.h>
 #include <image.h>
 #include <version.h>
+#include <pthread.h>
 
 #include <openssl/pem.h>
 #include <openssl/evp.h>
@@ -47,6 +48,48 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
 	return 0;
 }
 
+/**
+ * struct fit_hash_job - A hash value calculated ahead of time
+ *
+ * @data:	Image data to hash
+ * @size:	Size of image data in bytes
+ * @algo:	Hash algorithm name
+ * @value:	Returns the hash value
+ * @value_len:	Returns the length of @value in bytes
+ * @ret:	Returns 0 if OK, -ve if the hash could not be calculated
+ */
+struct fit_hash_job {
+	const void *data;
+	size_t size;
+	char algo[32];
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+};
+
+/**
+ * struct fit_hash_jobs - Hash values for all image hash nodes in a FIT
+ *
+ * The jobs are in the order in which fit_add_verification_data() visits the
+ * hash nodes, so that fit_image_process_hash() can pick up each value in turn
+ * while the FIT is being updated.
+ *
+ * @job:	Array of jobs
+ * @sorted:	Jobs sorted by decreasing size, so the largest start first
+ * @count:	Number of jobs
+ * @next:	Next entry in @sorted for a worker thread to take
+ * @used:	Next entry in @job to be written to the FIT
+ * @lock:	Protects @next
+ */
+struct fit_hash_jobs {
+	struct fit_hash_job *job;
+	struct fit_hash_job **sorted;
+	int count;
+	int next;
+	int used;
+	pthread_mutex_t lock;
+};
+
 /**
  * fit_image_process_hash - Process a single subnode of the images/ node
  *
@@ -58,10 +101,13 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
  * @noffset:	subnode offset
  * @data:	data to process
  * @size:	size of data in bytes
+ * @jobs:	hash values calculated ahead of time, or NULL to calculate
+ *		the hash here
  * Return: 0 if ok, -1 on error
  */
 static int fit_image_process_hash(void *fit, const char *image_name,
-		int noffset, const void *data, size_t size)
+		int noffset, const void *data, size_t size,
+		struct fit_hash_jobs *jobs)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	const char *node_name;
@@ -77,7 +123,18 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (jobs && jobs->used < jobs->count) {
+		struct fit_hash_job *job = &jobs->job[jobs->used++];
+
+		ret = job->ret;
+		if (!ret) {
+			memcpy(value, job->value, job->value_len);
+			value_len = job->value_len;
+		}
+	} else {
+		ret = calculate_hash(data, size, algo, value, &value_len);
+	}
+	if (ret) {
 		printf("Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 		       algo, node_name, image_name);
 		return -EPROTONOSUPPORT;
@@ -610,12 +667,14 @@ int fit_image_cipher_data(const char *keydir, void *keydest,
  * @comment:	Comment to add to signature nodes
  * @require_keys: Mark all keys as 'required'
  * @engine_id:	Engine to use for signing
+ * @jobs:	Hash values calculated ahead of time, or NULL if none
  * @return: 0 on success, <0 on failure
  */
 int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 		void *keydest, void *fit, int image_noffset,
 		const char *comment, int require_keys, const char *engine_id,
-		const char *cmdname, const char* algo_name)
+		const char *cmdname, const char* algo_name,
+		struct fit_hash_jobs *jobs)
 {
 	const char *image_name;
 	const void *data;
@@ -646,7 +705,7 @@ int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 		if (!strncmp(node_name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
 			ret = fit_image_process_hash(fit, image_name, noffset,
-						data, size);
+						data, size, jobs);
 		} else if (IMAGE_ENABLE_SIGN && (keydir || keyfile) &&
 			   !strncmp(node_name, FIT_SIG_NODENAME,
 				strlen(FIT_SIG_NODENAME))) {
@@ -1263,12 +1322,148 @@ int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 	return 0;
 }
 
+static void *fit_hash_worker(void *arg)
+{
+	struct fit_hash_jobs *jobs = arg;
+	struct fit_hash_job *job;
+
+	for (;;) {
+		pthread_mutex_lock(&jobs->lock);
+		job = jobs->next < jobs->count ? jobs->sorted[jobs->next++] :
+			NULL;
+		pthread_mutex_unlock(&jobs->lock);
+		if (!job)
+			break;
+		job->ret = calculate_hash(job->data, job->size, job->algo,
+					  job->value, &job->value_len);
+	}
+
+	return NULL;
+}
+
+static int fit_hash_job_cmp(const void *a, const void *b)
+{
+	const struct fit_hash_job *ja = *(struct fit_hash_job **)a;
+	const struct fit_hash_job *jb = *(struct fit_hash_job **)b;
+
+	if (ja->size != jb->size)
+		return ja->size < jb->size ? 1 : -1;
+
+	return ja < jb ? -1 : 1;
+}
+
+static void fit_hash_jobs_free(struct fit_hash_jobs *jobs)
+{
+	free(jobs->job);
+	free(jobs->sorted);
+	memset(jobs, '\0', sizeof(*jobs));
+}
+
+/**
+ * fit_hash_jobs_run() - Calculate all image hash values using worker threads
+ *
+ * This collects the hash nodes of all images, in the order that
+ * fit_image_add_verification_data() processes them, then hashes the image
+ * data using up to @threads threads. Nothing is written to the FIT, so the
+ * data and property pointers stay valid while the threads run.
+ *
+ * Nodes which cannot be processed (e.g. with no 'algo' property) are skipped
+ * here, since fit_image_add_verification_data() reports the error and stops
+ * when it reaches them.
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @images_noffset: Offset of the /images node
+ * @threads:	Maximum number of threads to use
+ * @jobs:	Returns the calculated hash values
+ * Return: 0 if OK, -ENOMEM if out of memory, -EAGAIN if no threads could be
+ * created
+ */
+static int fit_hash_jobs_run(const void *fit, int images_noffset, int threads,
+			     struct fit_hash_jobs *jobs)
+{
+	pthread_t *tid;
+	int image_noffset, noffset;
+	int count, i, ret;
+
+	memset(jobs, '\0', sizeof(*jobs));
+	count = 0;
+	fdt_for_each_subnode(image_noffset, fit, images_noffset) {
+		fdt_for_each_subnode(noffset, fit, image_noffset) {
+			if (!strncmp(fit_get_name(fit, noffset, NULL),
+				     FIT_HASH_NODENAME,
+				     strlen(FIT_HASH_NODENAME)))
+				count++;
+		}
+	}
+	if (!count)
+		return 0;
+
+	jobs->job = calloc(count, sizeof(*jobs->job));
+	jobs->sorted = calloc(count, sizeof(*jobs->sorted));
+	if (!jobs->job || !jobs->sorted) {
+		fit_hash_jobs_free(jobs);
+		return -ENOMEM;
+	}
+
+	fdt_for_each_subnode(image_noffset, fit, images_noffset) {
+		const void *data;
+		size_t size;
+
+		if (fit_image_get_data(fit, image_noffset, &data, &size))
+			break;
+		fdt_for_each_subnode(noffset, fit, image_noffset) {
+			struct fit_hash_job *job = &jobs->job[jobs->count];
+			const char *algo;
+
+			if (strncmp(fit_get_name(fit, noffset, NULL),
+				    FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME)))
+				continue;
+			if (fit_image_hash_get_algo(fit, noffset, &algo))
+				goto done;
+
+			job->data = data;
+			job->size = size;
+			strncpy(job->algo, algo, sizeof(job->algo) - 1);
+			jobs->sorted[jobs->count] = job;
+			jobs->count++;
+		}
+	}
+done:
+	qsort(jobs->sorted, jobs->count, sizeof(*jobs->sorted),
+	      fit_hash_job_cmp);
+
+	if (threads > jobs->count)
+		threads = jobs->count;
+	tid = calloc(threads, sizeof(*tid));
+	if (!tid) {
+		fit_hash_jobs_free(jobs);
+		return -ENOMEM;
+	}
+	pthread_mutex_init(&jobs->lock, NULL);
+	for (i = 0; i < threads; i++) {
+		ret = pthread_create(&tid[i], NULL, fit_hash_worker, jobs);
+		if (ret)
+			break;
+	}
+	/* The threads we have (or this one) take over the remaining jobs */
+	if (!i)
+		fit_hash_worker(jobs);
+	while (i--)
+		pthread_join(tid[i], NULL);
+	pthread_mutex_destroy(&jobs->lock);
+	free(tid);
+
+	return 0;
+}
+
 int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary)
+			      int threads, struct image_summary *summary)
 {
+	struct fit_hash_jobs jobs, *jobsp = NULL;
 	int images_noffset, confs_noffset;
 	int noffset;
 	int ret;
@@ -1281,7 +1476,23 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		return images_noffset;
 	}
 
+	/*
+	 * Hash the images in parallel if requested. The values are written
+	 * below, in order, along with any image signatures; these and the
+	 * configuration signatures are created one at a time as before, so
+	 * the output does not depend on the number of threads.
+	 */
+	if (threads > 1) {
+		ret = fit_hash_jobs_run(fit, images_noffset, threads, &jobs);
+		if (ret) {
+			printf("Can't hash images (%s)\n", strerror(-ret));
+			return ret;
+		}
+		jobsp = &jobs;
+	}
+
 	/* Process its subnodes, print out component images details */
+	ret = 0;
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
 	     noffset = fdt_next_subnode(fit, noffset)) {
@@ -1291,14 +1502,18 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		 */
 		ret = fit_image_add_verification_data(keydir, keyfile, keydest,
 				fit, noffset, comment, require_keys, engine_id,
-				cmdname, algo_name);
+				cmdname, algo_name, jobsp);
 		if (ret) {
 			printf("Can't add verification data for node '%s' (%s)\n",
 			       fdt_get_name(fit, noffset, NULL),
 			       fdt_strerror(ret));
-			return ret;
+			break;
 		}
 	}
+	if (jobsp)
+		fit_hash_jobs_free(jobsp);
+	if (ret)
+		return ret;
 
 	/* If there are no keys, we can't sign configurations */
 	if (!IMAGE_ENABLE_SIGN || !(keydir || keyfile))
@@ -98,6 +98,7 @@ struct image_tool_params {
 	int bl_len;		/* Block length in byte for external data */
 	const char *engine_id;	/* Engine to use for signing */
 	bool reset_timestamp;	/* Reset the timestamp on an existing image */
+	int jobs;		/* Number of threads to use for hashing */
 	struct image_summary summary;	/* results of signing process */
 };
 
@@ -70,6 +70,8 @@ enum {
  * @OUT_FMT_FLAMEGRAPH_CALLS: Write a file suitable for flamegraph.pl
  * @OUT_FMT_FLAMEGRAPH_TIMING: Write a file suitable for flamegraph.pl with the
  * counts set to the number of microseconds used by each function
+ * @OUT_FMT_FLAMEGRAPH_SAMPLES: Write a file suitable for flamegraph.pl with the
+ * counts set to the number of program-counter samples in each call stack
  */
 enum out_format_t {
 	OUT_FMT_DEFAULT,
@@ -77,6 +79,7 @@ enum out_format_t {
 	OUT_FMT_FUNCGRAPH,
 	OUT_FMT_FLAMEGRAPH_CALLS,
 	OUT_FMT_FLAMEGRAPH_TIMING,
+	OUT_FMT_FLAMEGRAPH_SAMPLES,
 };
 
 /* Section types for v7 format (trace-cmd format) */
@@ -254,6 +257,8 @@ struct func_info *func_list;
 int func_count;			/* number of functions */
 struct trace_call *call_list;	/* list of all calls in the input trace file */
 int call_count;			/* number of calls */
+uint32_t *sample_list;		/* samples, each a struct trace_sample + addrs */
+int sample_count;		/* number of samples */
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 ulong text_offset;		/* text address of first function */
 ulong text_base;		/* CONFIG_TEXT_BASE from trace file */
@@ -301,7 +306,8 @@ static void usage(void)
 		"\n"
 		"Subtypes for dump-flamegraph\n"
 		"   calls - create a flamegraph of stack frames\n"
-		"   timing - create a flamegraph of microseconds for each stack frame\n");
+		"   timing - create a flamegraph of microseconds for each stack frame\n"
+		"   samples - create a flamegraph of program-counter samples\n");
 	exit(EXIT_FAILURE);
 }
 
@@ -483,6 +489,51 @@ static int read_calls(FILE *fin, size_t count)
 	return 0;
 }
 
+/**
+ * read_samples() - Read the list of program-counter samples from the trace data
+ *
+ * Each sample is a struct trace_sample followed by its addresses. These are
+ * stored consecutively in sample_list
+ *
+ * @fin: File to read from
+ * @count: Number of samples to read
+ * Returns: 0 if OK, -1 on error
+ */
+static int read_samples(FILE *fin, size_t count)
+{
+	struct trace_sample sample;
+	size_t used = 0, alloced = 0;
+	int i;
+
+	notice("sample count: %zu\n", count);
+	for (i = 0; i < count; i++) {
+		if (read_data(fin, &sample, sizeof(sample)))
+			return -1;
+		if (sample.depth > TRACE_SAMPLE_MAX_DEPTH) {
+			error("Sample %d has invalid depth %u\n", i,
+			      sample.depth);
+			return -1;
+		}
+		if (used + 1 + sample.depth > alloced) {
+			alloced += 4096;
+			sample_list = realloc(sample_list,
+					      alloced * sizeof(*sample_list));
+			if (!sample_list) {
+				error("Cannot allocate sample_list\n");
+				return -1;
+			}
+		}
+		sample_list[used] = sample.depth;
+		if (read_data(fin, &sample_list[used + 1],
+			      sample.depth * sizeof(*sample_list)))
+			return -1;
+		used += 1 + sample.depth;
+	}
+	sample_count = count;
+
+	return 0;
+}
+
 /**
  * read_trace() - Read the U-Boot trace file
  *
@@ -515,6 +566,11 @@ static int read_trace(FILE *fin)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -1606,6 +1662,37 @@ static struct flame_node *create_node(const char *msg)
 	return node;
 }
 
+/**
+ * get_child() - Find or create the node for a function called from a node
+ *
+ * @node: Node to look in
+ * @func: Function to look for
+ * @nodesp: Incremented if a new node is created
+ * Returns: Pointer to the child node, or NULL on error
+ */
+static struct flame_node *get_child(struct flame_node *node,
+				    struct func_info *func, int *nodesp)
+{
+	struct flame_node *child;
+
+	/* see if we have this as a child node already */
+	list_for_each_entry(child, &node->child_head, sibling_node) {
+		if (child->func == func)
+			return child;
+	}
+
+	/* create a new node */
+	child = create_node("child");
+	if (!child)
+		return NULL;
+	list_add_tail(&child->sibling_node, &node->child_head);
+	child->func = func;
+	child->parent = node;
+	(*nodesp)++;
+
+	return child;
+}
+
 /**
  * process_call(): Add a call to the flamegraph info
  *
@@ -1629,26 +1716,11 @@ static int process_call(struct flame_state *state, bool entry, ulong timestamp,
 	int stack_ptr = state->stack_ptr;
 
 	if (entry) {
-		struct flame_node *child, *chd;
-
-		/* see if we have this as a child node already */
-		child = NULL;
-		list_for_each_entry(chd, &node->child_head, sibling_node) {
-			if (chd->func == func) {
-				child = chd;
-				break;
-			}
-		}
-		if (!child) {
-			/* create a new node */
-			child = create_node("child");
-			if (!child)
-				return -1;
-			list_add_tail(&child->sibling_node, &node->child_head);
-			child->func = func;
-			child->parent = node;
-			state->nodes++;
-		}
+		struct flame_node *child;
+
+		child = get_child(node, func, &state->nodes);
+		if (!child)
+			return -1;
 		debug("entry %s: move from %s to %s\n", func->name,
 		      node->func ? node->func->name : "(root)",
 		      child->func->name);
@@ -1745,6 +1817,59 @@ static int make_flame_tree(enum out_format_t out_format,
 	return 0;
 }
 
+/**
+ * make_sample_tree() - Create a tree of stack traces from the samples
+ *
+ * This is like make_flame_tree() except that each node has a count of how
+ * many samples were taken with this call stack, i.e. in this function and not
+ * in a function it called
+ *
+ * @treep: Returns the resulting flamegraph tree
+ * Returns: 0 on success, -ve on error
+ */
+static int make_sample_tree(struct flame_node **treep)
+{
+	struct flame_node *tree, *node;
+	struct func_info *func;
+	uint32_t *rec;
+	int nodes = 0;
+	int i, j;
+
+	tree = create_node("tree");
+	if (!tree)
+		return -1;
+
+	for (i = 0, rec = sample_list; i < sample_count; i++, rec += 1 + *rec) {
+		/* Work inwards from the outermost caller */
+		node = tree;
+		for (j = *rec; j > 0; j--) {
+			uint offset = rec[j];
+
+			/*
+			 * Callers are recorded by their return address, which
+			 * may be just past the end of the calling function
+			 */
+			if (j > 1)
+				offset--;
+			func = find_caller_by_offset(offset);
+			if (!func) {
+				warn("Cannot find function at %lx\n",
+				     text_offset + offset);
+				continue;
+			}
+			node = get_child(node, func, &nodes);
+			if (!node)
+				return -1;
+		}
+		if (node != tree)
+			node->count++;
+	}
+	fprintf(stderr, "%d nodes\n", nodes);
+	*treep = tree;
+
+	return 0;
+}
+
 /**
  * output_tree() - Output a flamegraph tree
  *
@@ -1780,7 +1905,7 @@ static int output_tree(FILE *fout, enum out_format_t out_format,
 	int pos;
 
 	if (node->count) {
-		if (out_format == OUT_FMT_FLAMEGRAPH_CALLS) {
+		if (out_format != OUT_FMT_FLAMEGRAPH_TIMING) {
 			fprintf(fout, "%s %d\n", str, node->count);
 		} else {
 			/*
@@ -1832,8 +1957,12 @@ static int make_flamegraph(FILE *fout, enum out_format_t out_format)
 	struct flame_node *tree;
 	char str[500];
 
-	if (make_flame_tree(out_format, &tree))
+	if (out_format == OUT_FMT_FLAMEGRAPH_SAMPLES) {
+		if (make_sample_tree(&tree))
+			return -1;
+	} else if (make_flame_tree(out_format, &tree)) {
 		return -1;
+	}
 
 	*str = '\0';
 	if (output_tree(fout, out_format, tree, str, sizeof(str), 0))
@@ -1889,7 +2018,8 @@ static int prof_tool(int argc, char *const argv[],
 			FILE *fout;
 
 			if (out_format != OUT_FMT_FLAMEGRAPH_CALLS &&
-			    out_format != OUT_FMT_FLAMEGRAPH_TIMING)
+			    out_format != OUT_FMT_FLAMEGRAPH_TIMING &&
+			    out_format != OUT_FMT_FLAMEGRAPH_SAMPLES)
 				out_format = OUT_FMT_FLAMEGRAPH_CALLS;
 			fout = fopen(out_fname, "w");
 			if (!fout) {
@@ -1931,9 +2061,11 @@ int main(int argc, char *argv[])
 				out_format = OUT_FMT_FLAMEGRAPH_CALLS;
 			} else if (!strcmp("timing", optarg)) {
 				out_format = OUT_FMT_FLAMEGRAPH_TIMING;
+			} else if (!strcmp("samples", optarg)) {
+				out_format = OUT_FMT_FLAMEGRAPH_SAMPLES;
 			} else {
 				fprintf(stderr,
-					"Invalid format: use function, funcgraph, calls, timing\n");
+					"Invalid format: use function, funcgraph, calls, timing, samples\n");
 				exit(1);
 			}
 			break;